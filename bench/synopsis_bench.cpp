@@ -0,0 +1,586 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Microbenchmarks of the planner, similarity, rule evaluation, and ASDP DB
+ * I/O, and macrobenchmarks of end-to-end prioritization on synthetic
+ * databases and the MSL bundle fixture.
+ *
+ * Results can be written as JSON for tracking regressions between releases:
+ *
+ *     synopsis_bench --benchmark_out=results.json --benchmark_out_format=json
+ *
+ * Data files are read from `SYNOPSIS_TEST_DATA` if set, or otherwise from the
+ * repository's test data directory.
+ */
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sqlite3.h>
+#include <synopsis.hpp>
+#include <SqliteASDPDB.hpp>
+#include <MemoryASDPDB.hpp>
+#include <LinuxClock.hpp>
+#include <RuleAST.hpp>
+#include <Similarity.hpp>
+#include <AsdpTable.hpp>
+#include <MaxMarginalRelevanceDownlinkPlanner.hpp>
+
+
+/*
+ * Discards log messages, so that logging does not dominate timings
+ */
+class NullLogger : public Synopsis::Logger {
+
+    public:
+
+        void log(Synopsis::LogType type, const char* file, const int line, const char* fmt, ...) override {
+
+        }
+
+};
+
+
+std::string get_data_path(std::string relative_path_str) {
+    const char* env_p = std::getenv("SYNOPSIS_TEST_DATA");
+    std::string base_path = (env_p != nullptr) ? env_p : SYNOPSIS_BENCH_DATA;
+    if (base_path.empty() || base_path.back() != '/') {
+        base_path += '/';
+    }
+    return base_path + relative_path_str;
+}
+
+
+/*
+ * Copies a database fixture to a temporary file, so that benchmarks (and any
+ * schema migration on open) do not modify the fixture
+ */
+std::string copy_to_temp(std::string path, std::string name) {
+    const char* tmp_p = std::getenv("TMPDIR");
+    std::string copy_path = std::string((tmp_p != nullptr) ? tmp_p : "/tmp") +
+        "/synopsis_bench_" + name;
+    std::ifstream src(path, std::ios::binary);
+    std::ofstream dst(copy_path, std::ios::binary | std::ios::trunc);
+    dst << src.rdbuf();
+    return copy_path;
+}
+
+
+/*
+ * Copies the MSL bundle fixture to a temporary file. The fixture names its
+ * URI column `dp_uri`, so the copy's column is renamed to match the schema.
+ */
+std::string copy_msl_bundle(std::string name) {
+    std::string path = copy_to_temp(
+        get_data_path("mark_debug/msl_bundle_20230612.db"), name
+    );
+    sqlite3 *db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) == SQLITE_OK) {
+        sqlite3_exec(db, "ALTER TABLE ASDP RENAME COLUMN dp_uri TO uri;",
+            NULL, NULL, NULL);
+    }
+    sqlite3_close(db);
+    return path;
+}
+
+
+/*
+ * Synthetic ASDP generator. Produces pseudo-random ASDPs spread evenly across
+ * `n_bins` priority bins, with the OWLS/ACME descriptor fields used by the DD
+ * similarity configuration and the SFI context/zoom pairs used by the
+ * instrument pair rules.
+ */
+std::vector<Synopsis::DpDbMsg> generate_asdps(
+    int n_asdps, unsigned seed, int n_bins = 1
+) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int> size_dist(1, 5);
+    std::uniform_int_distribution<int> bin_dist(0, n_bins - 1);
+
+    std::vector<Synopsis::DpDbMsg> msgs;
+    msgs.reserve(n_asdps);
+    for (int i = 0; i < n_asdps; i++) {
+        Synopsis::AsdpEntry metadata;
+        std::string instrument = "OWLS";
+        std::string type = "ACME";
+        if (uniform(rng) < 0.3) {
+            instrument = "SFI";
+            type = (i % 2) ? "CTX" : "ZOOM";
+            metadata["context_image_id"] = Synopsis::DpMetadataValue(i / 2);
+        } else {
+            metadata["background_avg"] = Synopsis::DpMetadataValue(2.0 * uniform(rng));
+            metadata["unique_masses"] = Synopsis::DpMetadataValue(4.0 * uniform(rng));
+        }
+        msgs.emplace_back(
+            -1, instrument, type, "", size_dist(rng), uniform(rng),
+            bin_dist(rng), Synopsis::DownlinkState::UNTRANSMITTED, metadata
+        );
+    }
+    return msgs;
+}
+
+
+/*
+ * Populates a database with synthetic ASDPs, inserted as a single batch
+ */
+void populate_synthetic(
+    Synopsis::ASDPDB &db, int n_asdps, unsigned seed, int n_bins = 1
+) {
+    std::vector<Synopsis::DpDbMsg> msgs = generate_asdps(n_asdps, seed, n_bins);
+    db.insert_data_products(msgs);
+}
+
+
+/*
+ * Loads the ASDPs of a database in the planner's map-based representation
+ */
+Synopsis::AsdpList load_asdps(Synopsis::ASDPDB &db, int max_asdps = -1) {
+    std::vector<Synopsis::DpDbMsg> msgs;
+    db.list_undownlinked_data_products(msgs);
+    Synopsis::AsdpList asdps;
+    for (auto &msg : msgs) {
+        if ((max_asdps >= 0) && ((int)asdps.size() >= max_asdps)) { break; }
+        Synopsis::AsdpEntry asdp;
+        Synopsis::_populate_asdp(std::move(msg), asdp);
+        asdps.push_back(std::move(asdp));
+    }
+    return asdps;
+}
+
+
+/*
+ * Exhaustive greedy prioritization of a single bin, as a function of bin
+ * size, with maximum similarities found by linear search or a k-d tree index
+ */
+static void BM_PrioritizeBin(
+    benchmark::State& state, const char *similarity_config
+) {
+    int n_asdps = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    populate_synthetic(db, n_asdps, 1234);
+    Synopsis::AsdpList asdps = load_asdps(db);
+    Synopsis::RuleSet ruleset = Synopsis::parse_rule_config(
+        get_data_path("dd_example_rules.json"), &logger
+    );
+    Synopsis::Similarity similarity = Synopsis::parse_similarity_config(
+        get_data_path(similarity_config), &logger
+    );
+
+    for (auto _ : state) {
+        // Similarities cached by earlier iterations are discarded
+        Synopsis::Similarity bin_similarity = similarity.fork();
+        benchmark::DoNotOptimize(Synopsis::_prioritize_bin(
+            0, asdps, ruleset, bin_similarity
+        ));
+    }
+    state.SetComplexityN(n_asdps);
+    db.deinit();
+}
+BENCHMARK_CAPTURE(BM_PrioritizeBin, linear,
+        "dd_example_similarity_config.json")
+    ->RangeMultiplier(2)->Range(16, 128)
+    ->Unit(benchmark::kMillisecond)->Complexity();
+BENCHMARK_CAPTURE(BM_PrioritizeBin, kd_tree,
+        "dd_example_indexed_similarity_config.json")
+    ->RangeMultiplier(2)->Range(16, 128)
+    ->Unit(benchmark::kMillisecond)->Complexity();
+
+
+/*
+ * Incremental and lazy greedy prioritization of a single bin over the
+ * columnar ASDP table, as a function of bin size
+ */
+static void BM_PrioritizeBinTable(benchmark::State& state) {
+    int n_asdps = state.range(0);
+    Synopsis::MmrEngine engine = (Synopsis::MmrEngine)state.range(1);
+    NullLogger logger;
+    std::vector<Synopsis::DpDbMsg> msgs = generate_asdps(n_asdps, 1234);
+    Synopsis::AsdpTable table;
+    Synopsis::AsdpRowList rows;
+    for (auto &msg : msgs) {
+        rows.push_back(table.add_data_product(msg));
+    }
+    Synopsis::RuleSet ruleset = Synopsis::parse_rule_config(
+        get_data_path("dd_example_rules.json"), &logger
+    );
+    Synopsis::Similarity similarity = Synopsis::parse_similarity_config(
+        get_data_path("dd_example_similarity_config.json"), &logger
+    );
+    ruleset.bind(table);
+    similarity.bind(table);
+
+    for (auto _ : state) {
+        if (engine == Synopsis::LAZY_GREEDY) {
+            benchmark::DoNotOptimize(Synopsis::_prioritize_bin_lazy(
+                0, table, rows, ruleset, similarity
+            ));
+        } else {
+            benchmark::DoNotOptimize(Synopsis::_prioritize_bin_incremental(
+                0, table, rows, ruleset, similarity
+            ));
+        }
+    }
+    state.SetComplexityN(n_asdps);
+}
+BENCHMARK(BM_PrioritizeBinTable)
+    ->ArgsProduct({
+        benchmark::CreateRange(256, 2048, 2),
+        {Synopsis::INCREMENTAL_GREEDY, Synopsis::LAZY_GREEDY}
+    })
+    ->ArgNames({"n", "engine"})
+    ->Unit(benchmark::kMillisecond);
+
+
+/*
+ * Discount factor of a candidate against a queue, as a function of queue
+ * length
+ */
+static void BM_DiscountFactor(benchmark::State& state) {
+    int queue_length = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    populate_synthetic(db, queue_length + 64, 1234);
+    Synopsis::AsdpList asdps = load_asdps(db);
+    Synopsis::AsdpList queue(asdps.begin(), asdps.begin() + queue_length);
+    Synopsis::AsdpList candidates(asdps.begin() + queue_length, asdps.end());
+    Synopsis::Similarity config = Synopsis::parse_similarity_config(
+        get_data_path("dd_example_similarity_config.json"), &logger
+    );
+    Synopsis::Similarity similarity = config.fork();
+
+    size_t c = 0;
+    for (auto _ : state) {
+        // Each candidate is only evaluated once per fork, so similarities
+        // are computed rather than read from the cache
+        if ((c > 0) && (c % candidates.size() == 0)) {
+            state.PauseTiming();
+            similarity = config.fork();
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(similarity.get_discount_factor(
+            0, queue, candidates[c % candidates.size()]
+        ));
+        c++;
+    }
+    state.SetItemsProcessed(state.iterations() * queue_length);
+    db.deinit();
+}
+BENCHMARK(BM_DiscountFactor)->RangeMultiplier(4)->Range(16, 4096);
+
+
+/*
+ * Pairwise similarity kernels, as a function of descriptor length, with the
+ * compile-time specialization for that length and with the runtime-length
+ * loop
+ */
+static void BM_SimilarityKernel(benchmark::State& state) {
+    int n_dims = state.range(0);
+    Synopsis::SimilarityKernel kernel = (Synopsis::SimilarityKernel)state.range(1);
+    bool specialized = state.range(2);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> x(n_dims), y(n_dims), inv_variances(n_dims, 1.0);
+    for (int d = 0; d < n_dims; d++) {
+        x[d] = uniform(rng);
+        y[d] = uniform(rng);
+    }
+    Synopsis::KernelParams params = {1.0, inv_variances.data()};
+    Synopsis::KernelFunction function = Synopsis::specialize_kernel(
+        kernel, specialized ? n_dims : 0
+    );
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(function(x.data(), y.data(), n_dims, params));
+    }
+    state.SetItemsProcessed(state.iterations() * n_dims);
+}
+BENCHMARK(BM_SimilarityKernel)
+    ->ArgNames({"dims", "kernel", "specialized"})
+    ->ArgsProduct({
+        {2, 16, 128},
+        {Synopsis::GAUSSIAN_KERNEL, Synopsis::COSINE_KERNEL},
+        {0, 1}
+    });
+
+
+/*
+ * Rule and constraint evaluation over a queue, for the example rule sets
+ */
+static void BM_RuleSetApply(benchmark::State& state, std::string rules_file) {
+    int queue_length = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    populate_synthetic(db, queue_length, 1234);
+    Synopsis::AsdpList queue = load_asdps(db);
+    Synopsis::RuleSet ruleset = Synopsis::parse_rule_config(
+        get_data_path(rules_file), &logger
+    );
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ruleset.apply(0, queue));
+    }
+    state.SetItemsProcessed(state.iterations() * queue_length);
+    db.deinit();
+}
+BENCHMARK_CAPTURE(BM_RuleSetApply, dd_example, "dd_example_rules.json")
+    ->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(BM_RuleSetApply, instrument_pair, "instrument_pair_rules.json")
+    ->RangeMultiplier(4)->Range(16, 1024);
+
+
+/*
+ * Rule evaluation of the MSL rule set over a prefix of the MSL bundle
+ */
+static void BM_RuleSetApplyMsl(benchmark::State& state) {
+    int queue_length = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(copy_msl_bundle("rules_msl.db"));
+    if (db.init(0, NULL, &logger) != Synopsis::SUCCESS) {
+        state.SkipWithError("MSL bundle not opened");
+        return;
+    }
+    Synopsis::AsdpList queue = load_asdps(db, queue_length);
+    Synopsis::RuleSet ruleset = Synopsis::parse_rule_config(
+        get_data_path("mark_debug/dd_rules_msl.json"), &logger
+    );
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ruleset.apply(0, queue));
+    }
+    state.SetItemsProcessed(state.iterations() * queue_length);
+    db.deinit();
+}
+BENCHMARK(BM_RuleSetApplyMsl)->RangeMultiplier(4)->Range(16, 1024);
+
+
+/*
+ * SQLite ASDP DB insert throughput, one product per transaction and in
+ * batches
+ */
+static void BM_SqliteInsert(benchmark::State& state) {
+    int batch_size = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    std::vector<Synopsis::DpDbMsg> msgs = generate_asdps(batch_size, 1234);
+
+    for (auto _ : state) {
+        std::vector<Synopsis::DpDbMsg> batch = msgs;
+        if (batch_size == 1) {
+            db.insert_data_product(batch[0]);
+        } else {
+            db.insert_data_products(batch);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+    db.deinit();
+}
+BENCHMARK(BM_SqliteInsert)->Arg(1)->Arg(100)->Arg(1000);
+
+
+/*
+ * SQLite ASDP DB lookup throughput, as a function of database size
+ */
+static void BM_SqliteGet(benchmark::State& state) {
+    int n_asdps = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    populate_synthetic(db, n_asdps, 1234);
+    std::vector<int> ids = db.list_data_product_ids();
+    std::mt19937 rng(4321);
+    std::uniform_int_distribution<size_t> id_dist(0, ids.size() - 1);
+
+    Synopsis::DpDbMsg msg;
+    for (auto _ : state) {
+        db.get_data_product(ids[id_dist(rng)], msg);
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetItemsProcessed(state.iterations());
+    db.deinit();
+}
+BENCHMARK(BM_SqliteGet)->RangeMultiplier(10)->Range(1000, 100000);
+
+
+/*
+ * Listing all undownlinked products, as loaded by the planner, as a function
+ * of database size
+ */
+static void BM_SqliteListUndownlinked(benchmark::State& state) {
+    int n_asdps = state.range(0);
+    NullLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    populate_synthetic(db, n_asdps, 1234);
+
+    for (auto _ : state) {
+        std::vector<Synopsis::DpDbMsg> msgs;
+        db.list_undownlinked_data_products(msgs);
+        benchmark::DoNotOptimize(msgs);
+    }
+    state.SetItemsProcessed(state.iterations() * n_asdps);
+    db.deinit();
+}
+BENCHMARK(BM_SqliteListUndownlinked)
+    ->RangeMultiplier(10)->Range(1000, 100000)
+    ->Unit(benchmark::kMillisecond);
+
+
+/*
+ * End-to-end prioritization through the application on a synthetic database
+ * spread over four bins. A non-negative count budget plans only the manifest.
+ */
+static void BM_ApplicationPrioritizeSynthetic(benchmark::State& state) {
+    int n_asdps = state.range(0);
+    Synopsis::MmrEngine engine = (Synopsis::MmrEngine)state.range(1);
+    int max_count = state.range(2);
+    NullLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::SqliteASDPDB db(":memory:");
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    if (app.init(0, NULL) != Synopsis::SUCCESS) {
+        state.SkipWithError("Application not initialized");
+        return;
+    }
+    populate_synthetic(db, n_asdps, 1234, 4);
+    std::string rules_path = get_data_path("dd_example_rules.json");
+    std::string config_path = get_data_path("dd_example_similarity_config.json");
+
+    for (auto _ : state) {
+        std::vector<int> prioritized_list;
+        int cut_asdp_id = -1;
+        if (max_count < 0) {
+            app.prioritize(rules_path, config_path, 1e9, prioritized_list);
+        } else {
+            app.prioritize_with_budget(
+                rules_path, config_path, 1e9, -1, max_count,
+                prioritized_list, cut_asdp_id
+            );
+        }
+        benchmark::DoNotOptimize(prioritized_list);
+    }
+    state.SetItemsProcessed(state.iterations() * n_asdps);
+    app.deinit();
+}
+BENCHMARK(BM_ApplicationPrioritizeSynthetic)
+    ->ArgNames({"n", "engine", "max_count"})
+    ->Args({1000, Synopsis::EXHAUSTIVE_GREEDY, -1})
+    ->Args({1000, Synopsis::INCREMENTAL_GREEDY, -1})
+    ->Args({1000, Synopsis::LAZY_GREEDY, -1})
+    ->Args({10000, Synopsis::INCREMENTAL_GREEDY, -1})
+    ->Args({10000, Synopsis::LAZY_GREEDY, -1})
+    ->Args({10000, Synopsis::LAZY_GREEDY, 100})
+    ->Args({100000, Synopsis::LAZY_GREEDY, 100})
+    ->Unit(benchmark::kMillisecond);
+
+
+/*
+ * Parameter sweep over a synthetic database, either with `sweep` (loading
+ * ASDPs and accumulating kernel sums once) or, as a baseline, with one
+ * prioritization per variant
+ */
+static void BM_Sweep(benchmark::State& state) {
+    int n_asdps = state.range(0);
+    int n_variants = state.range(1);
+    bool use_sweep = state.range(2);
+    NullLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::SqliteASDPDB db(":memory:");
+    db.init(0, NULL, &logger);
+    populate_synthetic(db, n_asdps, 1234, 4);
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+        Synopsis::LAZY_GREEDY
+    );
+    planner.set_database(&db);
+    planner.set_clock(&clock);
+    planner.init(0, NULL, &logger);
+    std::string rules_path = get_data_path("dd_example_rules.json");
+    std::string config_path = get_data_path("dd_example_similarity_config.json");
+
+    std::vector<Synopsis::SweepVariant> variants(n_variants);
+    for (int v = 0; v < n_variants; v++) {
+        variants[v].sigma = 0.5 + (0.1 * v);
+    }
+
+    for (auto _ : state) {
+        std::vector<std::vector<int>> prioritized_lists;
+        if (use_sweep) {
+            planner.sweep(
+                rules_path, config_path, variants, 1e9, prioritized_lists
+            );
+        } else {
+            prioritized_lists.resize(n_variants);
+            for (int v = 0; v < n_variants; v++) {
+                planner.prioritize(
+                    rules_path, config_path, 1e9, prioritized_lists[v]
+                );
+            }
+        }
+        benchmark::DoNotOptimize(prioritized_lists);
+    }
+    state.SetItemsProcessed(state.iterations() * n_variants);
+    planner.deinit();
+    db.deinit();
+}
+BENCHMARK(BM_Sweep)
+    ->ArgNames({"n", "variants", "sweep"})
+    ->Args({1000, 16, 0})
+    ->Args({1000, 16, 1})
+    ->Unit(benchmark::kMillisecond);
+
+
+/*
+ * End-to-end prioritization through the application on the MSL bundle
+ * fixture (28,631 products in a single bin). A non-negative count budget
+ * plans only the manifest; a full prioritization of the bundle takes far
+ * longer, so only a budgeted run is registered by default.
+ */
+static void BM_ApplicationPrioritizeMsl(benchmark::State& state) {
+    Synopsis::MmrEngine engine = (Synopsis::MmrEngine)state.range(0);
+    int max_count = state.range(1);
+    NullLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::SqliteASDPDB db(copy_msl_bundle("prioritize_msl.db"));
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    if (app.init(0, NULL) != Synopsis::SUCCESS) {
+        state.SkipWithError("Application not initialized");
+        return;
+    }
+    std::string rules_path = get_data_path("mark_debug/dd_rules_msl.json");
+    std::string config_path = get_data_path("mark_debug/dd_similarity_config_msl.json");
+
+    for (auto _ : state) {
+        std::vector<int> prioritized_list;
+        int cut_asdp_id = -1;
+        if (max_count < 0) {
+            app.prioritize(rules_path, config_path, 1e9, prioritized_list);
+        } else {
+            app.prioritize_with_budget(
+                rules_path, config_path, 1e9, -1, max_count,
+                prioritized_list, cut_asdp_id
+            );
+        }
+        benchmark::DoNotOptimize(prioritized_list);
+    }
+    app.deinit();
+}
+BENCHMARK(BM_ApplicationPrioritizeMsl)
+    ->ArgNames({"engine", "max_count"})
+    ->Args({Synopsis::LAZY_GREEDY, 100})
+    ->Unit(benchmark::kSecond)->Iterations(1);
+
+
+BENCHMARK_MAIN();
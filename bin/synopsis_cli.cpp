@@ -9,6 +9,9 @@
 #include <StdLogger.hpp>
 #include <LinuxClock.hpp>
 #include <MaxMarginalRelevanceDownlinkPlanner.hpp>
+#include <PlannerRegistry.hpp>
+#include <PlanningService.hpp>
+#include <DpBundle.hpp>
 
 #include <nlohmann/json.hpp>
 
@@ -26,7 +29,7 @@ void get_json_message(Synopsis::Application &app, std::vector<int>&prioritized_l
         double science_utility_estimate = msg.get_science_utility_estimate();
         int priority_bin = msg.get_priority_bin();
         Synopsis::DownlinkState downlink_state = msg.get_downlink_state();
-        Synopsis::AsdpEntry metadata = msg.get_metadata();
+        const Synopsis::AsdpEntry &metadata = msg.get_metadata();
 
         // json_msg[std::to_string(i)] = {
         //     {"dp_id", i},
@@ -75,6 +78,75 @@ void get_json_message(Synopsis::Application &app, std::vector<int>&prioritized_l
     }
 }
 
+/*
+ * Runs a persistent planning service over stdin/stdout, keeping the
+ * application, its parsed configurations, and its caches warm across requests
+ * @see PlanningService.hpp
+ */
+int serve(const std::string &asdpdb_file, Synopsis::DownlinkPlanner &planner, Synopsis::StdLogger &logger) {
+    Synopsis::StdLogger *logger_ptr = &logger;
+    Synopsis::SqliteASDPDB db(asdpdb_file);
+    Synopsis::LinuxClock clock;
+
+    // Prioritization responses are formatted from the entries the planner
+    // loaded, rather than fetching each data product again
+    planner.set_keep_entries(true);
+
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    Synopsis::Status status;
+
+    status = app.init(0, NULL);
+    if (status != Synopsis::Status::SUCCESS) {
+        LOG(logger_ptr, Synopsis::LogType::ERROR, "Initialization failed");
+        return status;
+    }
+
+    Synopsis::PlanningService service(&app, &logger);
+    int n_handled = service.serve(std::cin, std::cout);
+    LOG(logger_ptr, Synopsis::LogType::INFO, "Handled %d requests", n_handled);
+
+    status = app.deinit();
+    if (status != Synopsis::Status::SUCCESS) {
+        LOG(logger_ptr, Synopsis::LogType::ERROR, "De-initialization failed");
+        return status;
+    }
+    return 0;
+}
+
+/*
+ * Writes the undownlinked ASDPs of an ASDP DB to a bundle, for ground replays
+ * @see DpBundle.hpp
+ */
+int export_bundle(const std::string &asdpdb_file, const std::string &bundle_file, Synopsis::StdLogger &logger) {
+    Synopsis::StdLogger *logger_ptr = &logger;
+    Synopsis::SqliteASDPDB db(asdpdb_file);
+    Synopsis::Status status;
+
+    status = db.init(0, NULL, &logger);
+    if (status != Synopsis::Status::SUCCESS) {
+        LOG(logger_ptr, Synopsis::LogType::ERROR, "Initialization failed");
+        return status;
+    }
+
+    std::vector<Synopsis::DpDbMsg> msgs;
+    status = db.list_undownlinked_data_products(msgs);
+    if (status == Synopsis::Status::SUCCESS) {
+        Synopsis::DpBundleWriter writer;
+        for (const auto &msg : msgs) {
+            writer.add_data_product(msg);
+        }
+        status = writer.write(bundle_file, &logger);
+    }
+    if (status != Synopsis::Status::SUCCESS) {
+        LOG(logger_ptr, Synopsis::LogType::ERROR, "Bundle export failed");
+        db.deinit();
+        return status;
+    }
+    LOG(logger_ptr, Synopsis::LogType::INFO, "Exported %lu ASDPs", (unsigned long)msgs.size());
+
+    return db.deinit();
+}
+
 int main(int argc, char** argv) {
     // Example call: ./build/synopsis_cli test/data/dd_example.db test/data/dd_example_rules.json test/data/dd_example_similarity_config.json output
 
@@ -82,9 +154,34 @@ int main(int argc, char** argv) {
     Synopsis::StdLogger logger(output_all_to_stderr), *logger_ptr;
     logger_ptr = &logger;
 
+    // Example call: ./build/synopsis_cli --planner baseline test/data/dd_example.db test/data/dd_example_rules.json test/data/dd_example_similarity_config.json
+    // The planner is selected by name (see PlannerRegistry.hpp); the default is "mmr"
+    std::string planner_name = "mmr";
+    if (argc >= 3 && std::string(argv[1]) == "--planner") {
+        planner_name = argv[2];
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+    std::unique_ptr<Synopsis::DownlinkPlanner> planner = Synopsis::create_planner(planner_name);
+    if (!planner) {
+        LOG(logger_ptr, Synopsis::LogType::ERROR, "Unknown planner: %s", planner_name.c_str());
+        return Synopsis::Status::FAILURE;
+    }
+
+    // Example call: ./build/synopsis_cli --serve test/data/dd_example.db
+    if (argc == 3 && std::string(argv[1]) == "--serve") {
+        return serve(argv[2], *planner, logger);
+    }
+
+    // Example call: ./build/synopsis_cli --export-bundle test/data/dd_example.db dd_example.bundle
+    if (argc == 4 && std::string(argv[1]) == "--export-bundle") {
+        return export_bundle(argv[2], argv[3], logger);
+    }
+
     // TODO: see if we can do better argument parsing, e.g. rules and similarity config files could be optional, also the order shouldn't matter
     if (argc <4 ) {
-        LOG(logger_ptr, Synopsis::LogType::ERROR, "Not enough arguments. Usage (output file is optional): synopsis_cli <asdpdb_file>.db <rule_config_file>.json <similarity_config_file>.json <output>.json");
+        LOG(logger_ptr, Synopsis::LogType::ERROR, "Not enough arguments. Usage (output file is optional): synopsis_cli <asdpdb_file>.db <rule_config_file>.json <similarity_config_file>.json <output>.json, synopsis_cli --serve <asdpdb_file>.db, or synopsis_cli --export-bundle <asdpdb_file>.db <bundle_file>; the first two may be preceded by --planner <planner_name>");
         return 0;
     }
 
@@ -100,9 +197,8 @@ int main(int argc, char** argv) {
 
     Synopsis::SqliteASDPDB db(asdpdb_file);
     Synopsis::LinuxClock clock;
-    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
 
-    Synopsis::Application app(&db, &planner, &logger, &clock);
+    Synopsis::Application app(&db, planner.get(), &logger, &clock);
     Synopsis::Status status;
 
     status = app.init(0, NULL);
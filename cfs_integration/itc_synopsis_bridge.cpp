@@ -5,6 +5,7 @@
 #include "StdLogger.hpp"
 #include "LinuxClock.hpp"
 #include "MaxMarginalRelevanceDownlinkPlanner.hpp"
+#include "PlannerRegistry.hpp"
 #include "Timer.hpp"
 #include "RuleAST.hpp"
 #include "StdLogger.hpp"
@@ -20,7 +21,8 @@ using json = nlohmann::json;
  typedef enum {
     E_SUCCESS = 0,
     E_FAILURE = 1,
-    E_TIMEOUT = 2
+    E_TIMEOUT = 2,
+    E_BUSY = 3
  }ITC_STATUS_MESSAGE;
 
 //Owls Test
@@ -33,9 +35,15 @@ Synopsis::SqliteASDPDB db("/home/nos3/Desktop/github-nos3/fsw/build/exe/cpu1/dat
 
 Synopsis::StdLogger logger;
 Synopsis::LinuxClock clock2;
-Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
 
-Synopsis::Application app(&db, &planner, &logger, &clock2);
+// Planner selected by name from the registry (see PlannerRegistry.hpp), e.g.,
+// with -DSYNOPSIS_PLANNER=\"baseline\" for short or low-power passes
+#ifndef SYNOPSIS_PLANNER
+#define SYNOPSIS_PLANNER "mmr"
+#endif
+std::unique_ptr<Synopsis::DownlinkPlanner> planner = Synopsis::create_planner(SYNOPSIS_PLANNER);
+
+Synopsis::Application app(&db, planner.get(), &logger, &clock2);
 Synopsis::PassthroughASDS pt_asds;
 
 std::vector<std::string> prioritized_uris;
@@ -104,7 +112,7 @@ int owls_add_dpmsg(){
         
         Synopsis::DpMsg msg("owls", "helm", data_path, metadata_path, true);
 
-        status = app.accept_dp(msg);
+        status = app.accept_dp(std::move(msg));
     }    
     
     if (status != Synopsis::Status::SUCCESS){
@@ -299,6 +307,11 @@ size_t itc_app_get_memory_requiremennt(){
 */
 void itc_app_init(size_t bytes, void* memory){ 
     Synopsis::Status status;
+    // Downlink status updates between passes only replan the affected bins
+    auto *mmr_planner = dynamic_cast<Synopsis::MaxMarginalRelevanceDownlinkPlanner*>(planner.get());
+    if (mmr_planner != nullptr) {
+        mmr_planner->set_incremental(true);
+    }
     status = app.init(bytes, memory);
     ITC_STATUS_MESSAGE result = (ITC_STATUS_MESSAGE)status;
     if(result == E_SUCCESS){
@@ -17,6 +17,41 @@
 namespace Synopsis {
 
 
+    /**
+     * Interface for objects notified of changes to the data products within an
+     * ASDPDB (see `ASDPDB::add_listener`). Notifications are delivered on the
+     * thread that changes the database, and may be delivered for changes that
+     * are later rolled back.
+     */
+    class ASDPDBListener {
+
+
+        public:
+
+            /**
+             * Default virtual destructor
+             */
+            virtual ~ASDPDBListener() = default;
+
+            /**
+             * Called after a data product is inserted, or after its science
+             * utility estimate, priority bin, downlink state, or metadata is
+             * updated.
+             *
+             * @param[in] asdp_id: identifier of the changed ASDP
+             */
+            virtual void data_product_changed(int asdp_id) = 0;
+
+            /**
+             * Called when the contents of the database may have changed
+             * arbitrarily; e.g., when it is initialized or restored.
+             */
+            virtual void data_products_reset(void) = 0;
+
+
+    };
+
+
     /**
      * Base class for Autonomous Science Data Product Database (ASDPDB)
      * implementations
@@ -40,6 +75,46 @@ namespace Synopsis {
              */
             virtual Status insert_data_product(DpDbMsg& msg) = 0;
 
+            /**
+             * Inserts a batch of data products into the database within a
+             * single batch (see `begin_batch`). Either all products are
+             * inserted or, if any insertion fails, the batch is rolled back
+             * and none are.
+             *
+             * @param[in,out] msgs: messages containing data product
+             * information; their identifiers are set upon insertion
+             *
+             * @return: SUCCESS if all products were inserted, or error code
+             */
+            virtual Status insert_data_products(std::vector<DpDbMsg> &msgs);
+
+            /**
+             * Begins a batch of database operations, which are made durable
+             * together by `commit_batch` or undone together by
+             * `rollback_batch`. Batches do not nest. The default
+             * implementation, for databases without transactions, applies
+             * each operation immediately.
+             *
+             * @return: SUCCESS if the batch was started, or error code
+             */
+            virtual Status begin_batch(void);
+
+            /**
+             * Commits the current batch. If the commit fails, the batch is
+             * rolled back.
+             *
+             * @return: SUCCESS if the batch was committed, or error code
+             */
+            virtual Status commit_batch(void);
+
+            /**
+             * Rolls back all operations within the current batch.
+             *
+             * @return: SUCCESS if the batch was rolled back, or error code
+             * (including if rollback is not supported)
+             */
+            virtual Status rollback_batch(void);
+
             /**
              * Fetches data product information from the database corresponding
              * to a specific ASDP.
@@ -59,6 +134,35 @@ namespace Synopsis {
              */
             virtual std::vector<int> list_data_product_ids(void) = 0;
 
+            /**
+             * Fetches data product information for all ASDPs that have not
+             * been downlinked, in order of ASDP identifier. The default
+             * implementation fetches each ASDP individually; implementations
+             * should override it with a bulk query.
+             *
+             * @param[out] msgs: list that will be populated with ASDP
+             * information
+             *
+             * @return: SUCCESS if successfully fetched, or error code
+             */
+            virtual Status list_undownlinked_data_products(
+                std::vector<DpDbMsg> &msgs);
+
+            /**
+             * Fetches data product information for all ASDPs within a priority
+             * bin that have not been downlinked, in order of ASDP identifier.
+             * The default implementation filters the results of
+             * `list_undownlinked_data_products`; implementations should
+             * override it with a query on the bin.
+             *
+             * @param[in] priority_bin: priority bin of the ASDPs to fetch
+             * @param[out] msgs: list to which ASDP information is appended
+             *
+             * @return: SUCCESS if successfully fetched, or error code
+             */
+            virtual Status list_undownlinked_data_products_in_bin(
+                int priority_bin, std::vector<DpDbMsg> &msgs);
+
             /**
              * Manually update the science utility estimate of a specific data
              * product.
@@ -117,6 +221,45 @@ namespace Synopsis {
              */
             virtual bool is_initialized(void) = 0;
 
+            /**
+             * Registers a listener to be notified of changes to data products.
+             * The listener must be removed before it is destroyed.
+             *
+             * @param[in] listener: listener to register
+             */
+            void add_listener(ASDPDBListener *listener);
+
+            /**
+             * Removes a registered listener
+             *
+             * @param[in] listener: listener to remove
+             */
+            void remove_listener(ASDPDBListener *listener);
+
+
+        protected:
+
+            /**
+             * Notifies all listeners that a data product has changed
+             *
+             * @param[in] asdp_id: identifier of the changed ASDP
+             */
+            void _notify_changed(int asdp_id);
+
+            /**
+             * Notifies all listeners that the database contents may have
+             * changed arbitrarily
+             */
+            void _notify_reset(void);
+
+
+        private:
+
+            /**
+             * Registered listeners
+             */
+            std::vector<ASDPDBListener*> _listeners;
+
 
     };
 
@@ -23,7 +23,8 @@ namespace Synopsis {
      *
      * @param filename: ASDP file path
      *
-     * @return: file size in bytes
+     * @return: file size in bytes, or (size_t)-1 if the file cannot be
+     * accessed
      */
     size_t get_file_size(std::string filename);
 
@@ -79,7 +80,7 @@ namespace Synopsis {
              * @return: SUCCESS if the data product was successfully inserted
              * into the database, or error code
              */
-            Status submit_data_product(DpMsg msg);
+            Status submit_data_product(const DpMsg &msg);
 
             /**
              * Submits a data product to the ASDP database after it has been
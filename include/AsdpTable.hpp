@@ -0,0 +1,338 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a columnar (structure-of-arrays) representation of ASDPs used
+ * internally by the downlink planner. Field names and string values are
+ * interned to integer identifiers when the table is built, so that rule
+ * evaluation, similarity computation, and prioritization can access ASDP
+ * fields without string hashing or map traversal.
+ *
+ * @see: MaxMarginalRelevanceDownlinkPlanner.hpp
+ */
+#ifndef JPL_SYNOPSIS_AsdpTable
+#define JPL_SYNOPSIS_AsdpTable
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <unordered_map>
+
+#include "synopsis_types.hpp"
+#include "DpDbMsg.hpp"
+#include "MemoryArena.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Type alias for variable assignments used when evaluating expressions
+     * over an AsdpTable; the i-th element holds the table row assigned to the
+     * i-th variable in scope, in the order the variables were bound
+     */
+    using AsdpRowAssignments = std::vector<int>;
+
+    /**
+     * Type alias for a list of ASDPs represented by their AsdpTable rows
+     */
+    using AsdpRowList = std::vector<int>;
+
+
+    /**
+     * A metadata value stored within an ASDP table. This mirrors the fields
+     * of DpMetadataValue, except that string values are stored as interned
+     * identifiers of the owning table.
+     */
+    struct AsdpValue {
+
+        /**
+         * Value type
+         */
+        MetadataType type;
+
+        /**
+         * Whether the field is present for the ASDP
+         */
+        bool present;
+
+        /**
+         * Integer value
+         */
+        int int_value;
+
+        /**
+         * Float value
+         */
+        double float_value;
+
+        /**
+         * Interned string identifier, or -1 if not a string
+         */
+        int string_id;
+
+        /**
+         * @see: DpMetadataValue::is_numeric
+         */
+        bool is_numeric(void) const {
+            return (this->type == INT) || (this->type == FLOAT);
+        }
+
+        /**
+         * @see: DpMetadataValue::get_numeric
+         */
+        double get_numeric(void) const {
+            return (this->type == INT) ? (double)this->int_value : this->float_value;
+        }
+
+    };
+
+
+    /**
+     * Columnar table of ASDPs. Each row holds one ASDP; each column (slot)
+     * holds the values of one field across all ASDPs. First-class fields are
+     * additionally stored in contiguous typed arrays.
+     */
+    class AsdpTable {
+
+
+        public:
+
+            /**
+             * Slots of first-class fields, which are interned in this order
+             * when the table is constructed
+             */
+            static const int ID_SLOT = 0;
+            static const int INSTRUMENT_NAME_SLOT = 1;
+            static const int TYPE_SLOT = 2;
+            static const int SIZE_SLOT = 3;
+            static const int SUE_SLOT = 4;
+            static const int PRIORITY_BIN_SLOT = 5;
+            static const int FINAL_SUE_SLOT = 6;
+
+            /**
+             * Constructs an empty table
+             *
+             * @param[in] arena: arena from which the field columns and
+             * first-class field arrays are allocated, or null to use the heap
+             */
+            AsdpTable(MemoryArena *arena = nullptr);
+
+            /**
+             * Default destructor
+             */
+            ~AsdpTable() = default;
+
+            AsdpTable(const AsdpTable&) = delete;
+            AsdpTable &operator=(const AsdpTable&) = delete;
+
+            /**
+             * Appends an ASDP to the table. First-class fields take precedence
+             * over metadata fields of the same name.
+             *
+             * @param[in] msg: ASDP information in ASDPDB message format
+             *
+             * @return: row index of the new ASDP
+             */
+            int add_data_product(const DpDbMsg &msg);
+
+            /**
+             * Reserves storage for a number of rows in the first-class field
+             * arrays and existing columns, so that adding that many ASDPs
+             * does not reallocate them
+             *
+             * @param[in] n_rows: expected number of rows
+             */
+            void reserve(int n_rows);
+
+            /**
+             * @return: number of rows (ASDPs) in the table
+             */
+            int size(void) const { return this->_ids.size(); }
+
+            /**
+             * @return: number of field slots in the table
+             */
+            int num_fields(void) const { return this->_columns.size(); }
+
+            /**
+             * Returns the slot for a field name, adding an empty column if the
+             * field does not yet exist.
+             *
+             * @param[in] field_name: field name
+             *
+             * @return: field slot
+             */
+            int intern_field(const std::string &field_name);
+
+            /**
+             * Returns the slot for a field name.
+             *
+             * @param[in] field_name: field name
+             *
+             * @return: field slot, or -1 if no such field exists
+             */
+            int find_field(const std::string &field_name) const;
+
+            /**
+             * @param[in] slot: field slot
+             *
+             * @return: name of the field stored in the slot
+             */
+            const std::string &get_field_name(int slot) const;
+
+            /**
+             * Returns the identifier of an interned string, interning it if
+             * needed. Equal strings have equal identifiers.
+             *
+             * @param[in] value: string value
+             *
+             * @return: interned string identifier
+             */
+            int intern_string(const std::string &value);
+
+            /**
+             * @param[in] string_id: interned string identifier
+             *
+             * @return: string value
+             */
+            const std::string &get_string(int string_id) const;
+
+            /**
+             * @return: number of distinct instrument/type keys in the table
+             */
+            int num_keys(void) const { return this->_keys.size(); }
+
+            /**
+             * @param[in] key_id: instrument/type key identifier
+             *
+             * @return: instrument name and type of the key
+             */
+            std::pair<std::string, std::string> get_key(int key_id) const;
+
+            /**
+             * Converts a metadata value to a table value, interning any string
+             *
+             * @param[in] value: metadata value
+             *
+             * @return: table value
+             */
+            AsdpValue make_value(const DpMetadataValue &value);
+
+            /**
+             * Converts a table value to a metadata value
+             *
+             * @param[in] value: table value
+             *
+             * @return: metadata value
+             */
+            DpMetadataValue to_metadata_value(const AsdpValue &value) const;
+
+            /**
+             * Materializes a row as an ASDP entry mapping, equivalent to
+             * _populate_asdp applied to the original ASDPDB message.
+             *
+             * @param[in] row: row index
+             *
+             * @return: ASDP entry
+             */
+            AsdpEntry get_entry(int row) const;
+
+            /**
+             * @param[in] row: row index
+             * @param[in] slot: field slot
+             *
+             * @return: value of the field for the given row
+             */
+            const AsdpValue &get_value(int row, int slot) const {
+                return this->_columns[slot][row];
+            }
+
+            /**
+             * Sets the value of a field for the given row.
+             *
+             * @param[in] row: row index
+             * @param[in] slot: field slot
+             * @param[in] value: new field value
+             */
+            void set_value(int row, int slot, const AsdpValue &value) {
+                this->_columns[slot][row] = value;
+            }
+
+            /**
+             * First-class field accessors
+             *
+             * @param[in] row: row index
+             */
+            int get_id(int row) const { return this->_ids[row]; }
+            int get_size(int row) const { return this->_sizes[row]; }
+            double get_sue(int row) const { return this->_sues[row]; }
+            int get_priority_bin(int row) const { return this->_bins[row]; }
+            int get_key_id(int row) const { return this->_key_ids[row]; }
+            DownlinkState get_downlink_state(int row) const {
+                return this->_states[row];
+            }
+
+
+        private:
+
+            /**
+             * Interns an instrument/type key
+             */
+            int _intern_key(int instrument_id, int type_id);
+
+            /**
+             * Mapping of field names to slots, and slots to field names
+             */
+            std::unordered_map<std::string, int> _field_slots;
+            std::vector<std::string> _field_names;
+
+            /**
+             * Mapping of strings to interned identifiers, and vice versa.
+             * Strings may be interned while rules are evaluated concurrently,
+             * so access is guarded and interned strings are never moved.
+             */
+            std::unordered_map<std::string, int> _string_ids;
+            std::deque<std::string> _strings;
+            mutable std::mutex _string_mutex;
+
+            /**
+             * Interned instrument/type keys, stored as string identifier pairs
+             */
+            std::vector<std::pair<int, int>> _keys;
+
+            /**
+             * Allocator for row-indexed storage
+             */
+            ArenaAllocator<AsdpValue> _allocator;
+
+            /**
+             * Number of rows reserved for each column
+             */
+            int _reserved_rows;
+
+            /**
+             * Field values indexed by slot, then row
+             */
+            ArenaVector<ArenaVector<AsdpValue>> _columns;
+
+            /**
+             * Contiguous first-class field arrays indexed by row
+             */
+            ArenaVector<int> _ids;
+            ArenaVector<int> _sizes;
+            ArenaVector<double> _sues;
+            ArenaVector<int> _bins;
+            ArenaVector<int> _key_ids;
+            ArenaVector<DownlinkState> _states;
+
+
+    };
+
+
+};
+
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a logger that queues messages in a fixed-size ring buffer and
+ * writes them to another logger on a background thread, so that callers
+ * (e.g., the planner's greedy loop) never block on console or file output.
+ */
+#ifndef JPL_SYNOPSIS_AsyncLogger
+#define JPL_SYNOPSIS_AsyncLogger
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Logger.hpp"
+
+
+namespace Synopsis {
+
+
+    class AsyncLogger : public Logger {
+
+
+        public:
+
+            /**
+             * Maximum length of a queued message; longer messages are
+             * truncated
+             */
+            static const size_t MAX_MESSAGE_LENGTH = 256;
+
+            /**
+             * Constructs an AsyncLogger and starts its writer thread
+             *
+             * @param[in] sink: logger to which queued messages are written;
+             * must outlive this logger
+             * @param[in] capacity: number of messages the ring buffer holds;
+             * messages logged while it is full are dropped
+             */
+            AsyncLogger(Logger *sink, size_t capacity = 1024);
+
+            /**
+             * Writes all queued messages, then stops and joins the writer
+             * thread
+             */
+            virtual ~AsyncLogger();
+
+            AsyncLogger(const AsyncLogger&) = delete;
+            AsyncLogger &operator=(const AsyncLogger&) = delete;
+
+            /**
+             * Formats the message into the ring buffer without blocking on
+             * output; the writer thread passes it to the sink
+             *
+             * @see: Logger:log
+             */
+            void log(LogType type, const char* file, const int line, const char* fmt,  ...);
+
+            /**
+             * Blocks until all messages queued so far have been written to
+             * the sink
+             */
+            void flush(void);
+
+            /**
+             * @return: number of messages dropped because the ring buffer was
+             * full
+             */
+            size_t dropped(void);
+
+
+        private:
+
+            /**
+             * A queued message; the file name is a string literal from the
+             * LOG macro, so only its pointer is kept
+             */
+            struct Entry {
+                LogType type;
+                const char *file;
+                int line;
+                char message[MAX_MESSAGE_LENGTH];
+            };
+
+            /**
+             * Main loop of the writer thread
+             */
+            void _write(void);
+
+            /**
+             * Logger to which messages are written
+             */
+            Logger *_sink;
+
+            /**
+             * Ring buffer of queued messages, the index of the oldest, and
+             * the number queued
+             */
+            std::vector<Entry> _ring;
+            size_t _head = 0;
+            size_t _count = 0;
+
+            /**
+             * Whether the writer thread is passing a message to the sink
+             */
+            bool _writing = false;
+
+            /**
+             * Number of messages dropped in total, and the number already
+             * reported to the sink
+             */
+            size_t _n_dropped = 0;
+            size_t _n_dropped_reported = 0;
+
+            /**
+             * Whether the logger is being destroyed
+             */
+            bool _stop = false;
+
+            /**
+             * Guards the ring buffer, counters, and flags
+             */
+            std::mutex _mutex;
+
+            /**
+             * Signalled when a message is queued or the logger is stopped
+             */
+            std::condition_variable _message_available;
+
+            /**
+             * Signalled when the ring buffer has been drained
+             */
+            std::condition_variable _drained;
+
+            /**
+             * Writer thread
+             */
+            std::thread _writer;
+
+    };
+
+
+};
+
+
+#endif
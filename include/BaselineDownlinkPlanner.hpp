@@ -0,0 +1,82 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a fast downlink planner that orders each priority bin by science
+ * utility per byte, for short or low-power passes in which the maximum
+ * marginal relevance planner would not complete in time.
+ */
+#ifndef JPL_SYNOPSIS_BaselineDownlinkPlanner
+#define JPL_SYNOPSIS_BaselineDownlinkPlanner
+
+#include <string>
+#include <vector>
+
+#include "DownlinkPlanner.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Baseline downlink planner. Within each priority bin, untransmitted ASDPs
+     * are sorted by their ratio of science utility estimate to size (ties
+     * keep ASDPDB order, and ASDPs without a positive size come first), which
+     * takes O(n log n) time. The sorted ASDPs are then queued in a single
+     * pass, skipping any that would violate one of the bin's constraints;
+     * constraints are checked against running aggregates of the queue, as by
+     * the incremental MMR engine, so a skipped ASDP is not reconsidered.
+     *
+     * Similarity-based discounts and utility-adjusting rules are not applied,
+     * so each ASDP's final SUE is its science utility estimate.
+     */
+    class BaselineDownlinkPlanner : public DownlinkPlanner {
+
+
+        public:
+
+            /**
+             * Default constructor
+             */
+            BaselineDownlinkPlanner() = default;
+
+            /**
+             * Default destructor
+             */
+            virtual ~BaselineDownlinkPlanner() = default;
+
+            /**
+             * @see: ApplicationModule::memory_requirement
+             */
+            size_t memory_requirement(void);
+
+            /**
+             * @see: ApplicationModule::init
+             */
+            Status init(size_t bytes, void* memory, Logger *logger);
+
+            /**
+             * @see: ApplicationModule::deinit
+             */
+            Status deinit(void);
+
+            /**
+             * The similarity configuration is not used.
+             *
+             * @see: DownlinkPlanner::prioritize
+             */
+            Status prioritize(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                std::vector<int> &prioritized_list
+            );
+
+
+    };
+
+
+};
+
+
+#endif
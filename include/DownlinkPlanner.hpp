@@ -7,17 +7,30 @@
 #ifndef JPL_SYNOPSIS_DownlinkPlanner
 #define JPL_SYNOPSIS_DownlinkPlanner
 
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 #include "synopsis_types.hpp"
 #include "ApplicationModule.hpp"
 #include "ASDPDB.hpp"
 #include "Clock.hpp"
+#include "PlannerStats.hpp"
 
 
 namespace Synopsis {
 
 
+    /**
+     * Receives the final ordering of one priority bin during a streaming
+     * prioritization; the ordering is only valid during the call
+     *
+     * @param[in] bin: priority bin
+     * @param[in] bin_order: prioritized ASDP identifiers of the bin
+     */
+    using BinCallback = std::function<void(int bin, const std::vector<int> &bin_order)>;
+
+
     /**
      * Abstarct base class for a downlink planner algorithm
      */
@@ -49,6 +62,43 @@ namespace Synopsis {
              */
             void set_clock(Clock *clock);
 
+            /**
+             * Enables or disables the collection of timings and counters
+             * during prioritization. Statistics are disabled by default, in
+             * which case the planner reads the clock no more than it would
+             * otherwise and does not record per-bin statistics.
+             *
+             * @param[in] enabled: whether statistics are collected
+             */
+            void set_stats_enabled(bool enabled);
+
+            /**
+             * @return: statistics of the last call to `prioritize` (or
+             * `prioritize_with_budget`) made with statistics enabled
+             */
+            const PlannerStats &get_stats(void) const {
+                return this->_stats;
+            }
+
+            /**
+             * Enables or disables keeping the ASDPDB entries loaded by each
+             * prioritization, so that the entries of prioritized ASDPs can be
+             * read back without querying the ASDPDB again. Entries are not
+             * kept by default.
+             *
+             * @param[in] enabled: whether loaded entries are kept
+             */
+            void set_keep_entries(bool enabled);
+
+            /**
+             * @param[in] asdp_id: ASDP identifier
+             *
+             * @return: ASDPDB entry of the ASDP as loaded by the last
+             * prioritization, or null if entries are not kept or the ASDP was
+             * not loaded; valid until the next prioritization
+             */
+            const DpDbMsg *get_planned_entry(int asdp_id) const;
+
             /**
              * Abstract prioritization algorithm interface to be implemented by
              * a child class. This function is invoked by the SYNOPSIS
@@ -66,7 +116,9 @@ namespace Synopsis {
              * prioritized list of ASDPs, specified using their IDs
              *
              * @return: SUCCESS if prioritization completed, TIMEOUT if the
-             * time expired, or other error code upon failure
+             * time expired (in which case the list holds the ASDPs prioritized
+             * so far, a prefix of the full ordering), or other error code upon
+             * failure
              */
             virtual Status prioritize(
                 std::string rule_configuration_id,
@@ -75,6 +127,79 @@ namespace Synopsis {
                 std::vector<int> &prioritized_list
             ) = 0;
 
+            /**
+             * Prioritization within a downlink budget. The resulting manifest
+             * is the longest prefix of the full prioritization (as returned by
+             * `prioritize`) that fits within the byte and count budgets, and
+             * the cut point is the first ASDP of the full prioritization that
+             * does not fit. The default implementation prioritizes all ASDPs
+             * and truncates the result; planners may override it to stop
+             * prioritizing once the budget is filled.
+             *
+             * @see DownlinkPlanner::prioritize
+             *
+             * @param[in] rule_configuration_id: rule and constraint
+             * configuration (e.g., URI of JSON on filesystem)
+             * @param[in] similarity_configuration_id: similarity-based
+             * discount configuration (e.g., URI of JSON on filesystem)
+             * @param[in] max_processing_time_sec: the prioritization algorithm
+             * should time-out after this amount of time has passed
+             * @param[in] max_bytes: total size of the ASDPs in the manifest,
+             * or a negative value for no byte budget
+             * @param[in] max_count: number of ASDPs in the manifest, or a
+             * negative value for no count budget
+             * @param[out] prioritized_list: this list will be populated with
+             * the manifest, specified using ASDP IDs
+             * @param[out] cut_asdp_id: set to the ID of the first ASDP that
+             * did not fit within the budget, or -1 if all ASDPs fit
+             *
+             * @return: SUCCESS if the manifest is complete, TIMEOUT if the
+             * time expired before the budget was filled (in which case the
+             * manifest is a prefix of the budgeted manifest and the cut point
+             * is -1), or other error code upon failure
+             */
+            virtual Status prioritize_with_budget(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                long max_bytes, int max_count,
+                std::vector<int> &prioritized_list,
+                int &cut_asdp_id
+            );
+
+            /**
+             * Streaming prioritization. Each bin's ordering is passed to the
+             * callback as soon as it is final and all earlier bins have been
+             * passed, so that bins are received in bin order (the same order
+             * in which `prioritize` concatenates them) and downlink packaging
+             * of the highest-priority bins can begin while later bins are
+             * still being prioritized. Calls are serialized, but may be made
+             * from planner worker threads. The default implementation
+             * prioritizes all ASDPs and then splits the result by bin;
+             * planners may override it to pass bins as they complete.
+             *
+             * @see DownlinkPlanner::prioritize
+             *
+             * @param[in] rule_configuration_id: rule and constraint
+             * configuration (e.g., URI of JSON on filesystem)
+             * @param[in] similarity_configuration_id: similarity-based
+             * discount configuration (e.g., URI of JSON on filesystem)
+             * @param[in] max_processing_time_sec: the prioritization algorithm
+             * should time-out after this amount of time has passed
+             * @param[in] on_bin: callback receiving each bin's ordering
+             *
+             * @return: SUCCESS if prioritization completed, TIMEOUT if the
+             * time expired (in which case the last bin received holds a prefix
+             * of its ordering, and no later bins are received), or other
+             * error code upon failure
+             */
+            virtual Status prioritize_streaming(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                const BinCallback &on_bin
+            );
+
 
         protected:
 
@@ -90,6 +215,48 @@ namespace Synopsis {
              */
             Clock *_clock = nullptr;
 
+            /**
+             * Whether statistics are collected, and the statistics of the last
+             * prioritization
+             */
+            bool _stats_enabled = false;
+            PlannerStats _stats;
+
+            /**
+             * Resets the statistics at the start of a prioritization
+             *
+             * @return: statistics to be populated, or null if disabled
+             */
+            PlannerStats *_begin_stats(void);
+
+            /**
+             * Whether loaded entries are kept, and the entries kept by the
+             * last prioritization
+             */
+            bool _keep_entries = false;
+            std::unordered_map<int, DpDbMsg> _planned_entries;
+
+            /**
+             * Keeps the entries loaded by a prioritization, if enabled
+             *
+             * @param[in] msgs: loaded entries
+             * @param[in] replace: whether entries kept by earlier
+             * prioritizations are dropped; planners that reload only some
+             * ASDPs keep the others
+             */
+            void _keep_loaded(const std::vector<DpDbMsg> &msgs, bool replace);
+
+            /**
+             * Gets the entry of an ASDP as kept by the last prioritization, or
+             * from the ASDPDB if it was not kept
+             *
+             * @param[in] asdp_id: ASDP identifier
+             * @param[out] msg: ASDPDB entry
+             *
+             * @return: SUCCESS, or error code if the ASDPDB query failed
+             */
+            Status _get_entry(int asdp_id, DpDbMsg &msg);
+
 
     };
 
@@ -0,0 +1,248 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a compact, versioned binary container of already-processed data
+ * products and their metadata, for bulk ingest and ground replays of whole
+ * mission bundles. A bundle is read through a memory mapping, so products are
+ * decoded directly from the mapped file, without opening per-product data or
+ * metadata files or parsing JSON.
+ *
+ * Layout (native byte order and alignment; all offsets are from the start of
+ * the file and are multiples of 8 bytes):
+ *
+ *  - A fixed header (BundleHeader) with a magic string, format version,
+ *    product and field counts, and section offsets
+ *  - A string table of NUL-terminated strings, in which each distinct string
+ *    (instrument names, types, URIs, field names, and string values) is
+ *    interned once and referred to by its offset
+ *  - A product table with one fixed-size record per product
+ *  - A field table with one record per metadata column; a column holds the
+ *    values of one field name and one metadata type
+ *  - For each column, one presence byte per product (padded to 8 bytes),
+ *    followed by one 8-byte value per product: an integer, a float, or a
+ *    string table offset
+ */
+#ifndef JPL_SYNOPSIS_DpBundle
+#define JPL_SYNOPSIS_DpBundle
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "synopsis_types.hpp"
+#include "DpDbMsg.hpp"
+#include "Logger.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Read-only view of a bundle file, mapped into memory
+     */
+    class DpBundle {
+
+
+        public:
+
+            /**
+             * Version of the bundle format read by this class and written by
+             * DpBundleWriter
+             */
+            static const int VERSION = 1;
+
+            /**
+             * Product record; strings are string table offsets
+             */
+            struct ProductRecord {
+                int64_t dp_id;
+                uint64_t instrument_name;
+                uint64_t type;
+                uint64_t uri;
+                uint64_t size;
+                double science_utility_estimate;
+                int64_t priority_bin;
+                int64_t downlink_state;
+            };
+
+            /**
+             * Field record, describing the metadata column holding the values
+             * of one field name with one metadata type
+             */
+            struct FieldRecord {
+                uint64_t name;
+                int64_t type;
+                uint64_t column_offset;
+            };
+
+            /**
+             * Constructs a bundle with no file
+             *
+             * @param[in] logger: logger for errors, or null
+             */
+            DpBundle(Logger *logger = nullptr);
+
+            /**
+             * Unmaps the file, if any
+             */
+            ~DpBundle();
+
+            DpBundle(const DpBundle&) = delete;
+            DpBundle &operator=(const DpBundle&) = delete;
+
+            /**
+             * Maps a bundle file into memory, replacing any file already
+             * open. The header and the bounds of all sections, string
+             * offsets, and metadata types are validated, so that products can
+             * then be decoded without further checks.
+             *
+             * @param[in] path: path of the bundle file
+             *
+             * @return: SUCCESS if the file was mapped, or FAILURE if it cannot
+             * be read or is not a valid bundle
+             */
+            Status open(const std::string &path);
+
+            /**
+             * Unmaps the file, if any
+             */
+            void close(void);
+
+            /**
+             * @return: number of products in the bundle, or zero if no file
+             * is open
+             */
+            int size(void) const { return this->_n_products; }
+
+            /**
+             * Decodes a product of the bundle
+             *
+             * @param[in] index: product index, between 0 and `size() - 1`
+             * @param[out] msg: product, including its metadata
+             *
+             * @return: SUCCESS, or FAILURE if the index is out of range
+             */
+            Status get_data_product(int index, DpDbMsg &msg) const;
+
+            /**
+             * Decodes all products of the bundle, in order
+             *
+             * @param[out] msgs: products; previous contents are replaced
+             *
+             * @return: SUCCESS, or FAILURE if no file is open
+             */
+            Status get_data_products(std::vector<DpDbMsg> &msgs) const;
+
+
+        private:
+
+            /**
+             * Mapped file and its size
+             */
+            const char *_data = nullptr;
+            size_t _n_bytes = 0;
+
+            /**
+             * Sections of the mapped file
+             */
+            int _n_products = 0;
+            int _n_fields = 0;
+            const char *_strings = nullptr;
+            const ProductRecord *_products = nullptr;
+            const FieldRecord *_fields = nullptr;
+
+            /**
+             * Reference to the logger instance
+             */
+            Logger *_logger;
+
+            /**
+             * Validates the sections of the mapped file
+             *
+             * @return: whether the file is a valid bundle
+             */
+            bool _validate(void);
+
+
+    };
+
+
+    /**
+     * Builds a bundle in memory and writes it to a file
+     */
+    class DpBundleWriter {
+
+
+        public:
+
+            /**
+             * Constructs an empty bundle
+             */
+            DpBundleWriter();
+
+            /**
+             * Default destructor
+             */
+            ~DpBundleWriter() = default;
+
+            /**
+             * Appends a product to the bundle; its identifier, downlink state,
+             * and metadata are kept
+             *
+             * @param[in] msg: product
+             */
+            void add_data_product(const DpDbMsg &msg);
+
+            /**
+             * @return: number of products in the bundle
+             */
+            int size(void) const { return this->_products.size(); }
+
+            /**
+             * Writes the bundle to a file. The bundle is first written to a
+             * temporary file (`path` with a ".tmp" suffix), which then
+             * replaces any existing file.
+             *
+             * @param[in] path: path of the bundle file
+             * @param[in] logger: logger for errors, or null
+             *
+             * @return: SUCCESS if the file was written, or error code
+             */
+            Status write(const std::string &path, Logger *logger = nullptr) const;
+
+
+        private:
+
+            /**
+             * Interns a string in the string table
+             *
+             * @param[in] value: string
+             *
+             * @return: offset of the string in the string table
+             */
+            uint64_t _intern(const std::string &value);
+
+            /**
+             * String table and the offset of each interned string
+             */
+            std::string _strings;
+            std::map<std::string, uint64_t> _string_offsets;
+
+            /**
+             * Products, and the value bits of each column (keyed by field
+             * name offset and metadata type) indexed by product
+             */
+            std::vector<DpBundle::ProductRecord> _products;
+            std::map<std::pair<uint64_t, int64_t>, std::map<int, uint64_t>> _columns;
+
+
+    };
+
+
+};
+
+
+#endif
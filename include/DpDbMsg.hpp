@@ -11,6 +11,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <utility>
 
 #include "synopsis_types.hpp"
 
@@ -24,6 +25,9 @@ namespace Synopsis {
      *   - INTEGER (int)
      *   - FLOAT (double)
      *   - STRING (std::string)
+     *
+     * Only the value of the stored type is held, in a tagged union; getters
+     * for any other type return zero or an empty string.
      */
     class DpMetadataValue {
 
@@ -36,9 +40,21 @@ namespace Synopsis {
             DpMetadataValue();
 
             /**
-             * Default destructor
+             * Destroys the string value, if any
+             */
+            ~DpMetadataValue();
+
+            /**
+             * Copy and move constructors
+             */
+            DpMetadataValue(const DpMetadataValue &other);
+            DpMetadataValue(DpMetadataValue &&other);
+
+            /**
+             * Copy and move assignment
              */
-            ~DpMetadataValue() = default;
+            DpMetadataValue &operator=(const DpMetadataValue &other);
+            DpMetadataValue &operator=(DpMetadataValue &&other);
 
             /**
              * INTEGER value constructor
@@ -62,9 +78,8 @@ namespace Synopsis {
             DpMetadataValue(std::string string_value);
 
             /**
-             * Generic value constructor. Each instance can store all three
-             * types; only the type corresponding to the `type` argument is
-             * valid.
+             * Generic value constructor. Only the value corresponding to the
+             * `type` argument is stored; the others are ignored.
              *
              * @param[in] type: metadata value type
              * @param[in] integer_value
@@ -77,40 +92,41 @@ namespace Synopsis {
             /**
              * @return: metadata value type
              */
-            MetadataType get_type(void);
+            MetadataType get_type(void) const;
 
             /**
              * Returns integer metadata value.
              *
              * Warning: the user must check the type of this value before
              * calling this function. If the value does not have an integer
-             * type, the behavior of this function is undefined.
+             * type, zero is returned.
              *
              * @return: integer metadata value
              */
-            int get_int_value(void);
+            int get_int_value(void) const;
 
             /**
              * Returns float metadata value.
              *
              * Warning: the user must check the type of this value before
              * calling this function. If the value does not have a float type,
-             * the behavior of this function is undefined.
+             * zero is returned.
              *
              * @return: float metadata value
              */
-            double get_float_value(void);
+            double get_float_value(void) const;
 
             /**
              * Returns string metadata value.
              *
              * Warning: the user must check the type of this value before
              * calling this function. If the value does not have a string type,
-             * the behavior of this function is undefined.
+             * an empty string is returned.
              *
-             * @return: string metadata value
+             * @return: reference to string metadata value, valid while this
+             * value is unmodified
              */
-            std::string get_string_value(void);
+            const std::string &get_string_value(void) const;
 
             /**
              * Checks if the metadata value has a numeric type; that is,
@@ -118,7 +134,7 @@ namespace Synopsis {
              *
              * @return: whether the metadata has a numeric type
              */
-            bool is_numeric(void);
+            bool is_numeric(void) const;
 
             /**
              * Returns numeric metadata value; integer values are cast to
@@ -130,7 +146,7 @@ namespace Synopsis {
              *
              * @return: numeric value as a double
              */
-            double get_numeric(void);
+            double get_numeric(void) const;
 
 
         private:
@@ -141,19 +157,27 @@ namespace Synopsis {
             MetadataType type;
 
             /**
-             * Stores integer-valued metadata
+             * Stores the value of the metadata type; `string_value` is
+             * constructed only for STRING values
              */
-            int int_value;
+            union {
+                int int_value;
+                double float_value;
+                std::string string_value;
+            };
 
             /**
-             * Stores float-valued metadata
+             * Constructs this (uninitialized) value from another value
+             *
+             * @param[in] other: value to copy or move from
              */
-            double float_value;
+            void _copy_from(const DpMetadataValue &other);
+            void _move_from(DpMetadataValue &&other);
 
             /**
-             * Stores string-valued metadata
+             * Destroys the string value, if any
              */
-            std::string string_value;
+            void _destroy(void);
 
 
     };
@@ -171,9 +195,11 @@ namespace Synopsis {
     using AsdpList = std::vector<AsdpEntry>;
 
     /**
-     * Alias for an assignment of ASDP entries to variable names
+     * Alias for an assignment of ASDP entries to variable names. Entries are
+     * bound by pointer in binding order; when a variable name is bound more
+     * than once, the last (inner-most) binding takes precedence.
      */
-    using AsdpAssignments = std::map<std::string, AsdpEntry>;
+    using AsdpAssignments = std::vector<std::pair<std::string, const AsdpEntry*>>;
 
 
     /**
@@ -218,47 +244,55 @@ namespace Synopsis {
             /**
              * @return: ASDP identifier
              */
-            int get_dp_id(void);
+            int get_dp_id(void) const;
 
             /**
              * @return: ASDP instrument name
              */
-            std::string get_instrument_name(void);
+            const std::string &get_instrument_name(void) const;
 
             /**
              * @return: ASDP type
              */
-            std::string get_type(void);
+            const std::string &get_type(void) const;
 
             /**
              * @return: ASDP URI
              */
-            std::string get_uri(void);
+            const std::string &get_uri(void) const;
 
             /**
              * @return: ASDP size in bytes
              */
-            size_t get_dp_size(void);
+            size_t get_dp_size(void) const;
 
             /**
              * @return: ASDP utility estimate
              */
-            double get_science_utility_estimate(void);
+            double get_science_utility_estimate(void) const;
 
             /**
              * @return: ASDP priority bin
              */
-            int get_priority_bin(void);
+            int get_priority_bin(void) const;
 
             /**
              * @return: ASDP downlink state
              */
-            DownlinkState get_downlink_state(void);
+            DownlinkState get_downlink_state(void) const;
 
             /**
              * @return: mapping of ASDP metadata field names to values
              */
-            AsdpEntry get_metadata(void);
+            const AsdpEntry &get_metadata(void) const;
+
+            /**
+             * Moves the ASDP metadata out of the message, leaving the message
+             * with no metadata
+             *
+             * @return: mapping of ASDP metadata field names to values
+             */
+            AsdpEntry take_metadata(void);
 
 
             /**
@@ -273,21 +307,24 @@ namespace Synopsis {
              *
              * @param[in] name: ASDP instrument name
              */
-            void set_instrument_name(std::string name);
+            void set_instrument_name(const std::string &name);
+            void set_instrument_name(std::string &&name);
 
             /**
              * Set ASDP type
              *
              * @param[in] type: ASDP type
              */
-            void set_type(std::string type);
+            void set_type(const std::string &type);
+            void set_type(std::string &&type);
 
             /**
              * Set ASDP URI
              *
              * @param[in] uri: ASDP URI
              */
-            void set_uri(std::string uri);
+            void set_uri(const std::string &uri);
+            void set_uri(std::string &&uri);
 
             /**
              * Set ASDP size
@@ -323,7 +360,8 @@ namespace Synopsis {
              * @param[in] metadata: mapping of ASDP metadata field names to
              * values
              */
-            void set_metadata(AsdpEntry metadata);
+            void set_metadata(const AsdpEntry &metadata);
+            void set_metadata(AsdpEntry &&metadata);
 
 
         private:
@@ -46,27 +46,27 @@ namespace Synopsis {
             /**
              * @return: data product instrument name
              */
-            std::string get_instrument_name(void);
+            const std::string &get_instrument_name(void) const;
 
             /**
              * @return: data product type
              */
-            std::string get_type(void);
+            const std::string &get_type(void) const;
 
             /**
              * @return: data product URI
              */
-            std::string get_uri(void);
+            const std::string &get_uri(void) const;
 
             /**
              * @return: data product metadata URI
              */
-            std::string get_metadata_uri(void);
+            const std::string &get_metadata_uri(void) const;
 
             /**
              * @return: data product metadata URI usage flag
              */
-            bool get_metadata_usage(void);
+            bool get_metadata_usage(void) const;
 
 
         private:
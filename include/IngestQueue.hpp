@@ -0,0 +1,144 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a bounded, lock-free queue of data product messages, used by the
+ * application to hand accepted data products to its ingest worker.
+ *
+ * @see: synopsis.hpp
+ */
+#ifndef JPL_SYNOPSIS_IngestQueue
+#define JPL_SYNOPSIS_IngestQueue
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "DpMsg.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Bounded multiple-producer, single-consumer queue of data product
+     * messages. Each slot carries a sequence number that tells producers
+     * and the consumer whether it is free or full, so neither side takes a
+     * lock; a full queue is reported to the producer rather than waited on.
+     * All slots are allocated when the queue is constructed.
+     */
+    class IngestQueue {
+
+
+        public:
+
+            /**
+             * Constructs a queue
+             *
+             * @param[in] capacity: minimum number of messages the queue can
+             * hold; rounded up to a power of two
+             */
+            IngestQueue(size_t capacity);
+
+            /**
+             * Default destructor
+             */
+            ~IngestQueue() = default;
+
+            IngestQueue(const IngestQueue&) = delete;
+            IngestQueue &operator=(const IngestQueue&) = delete;
+
+            /**
+             * @return: number of messages the queue can hold
+             */
+            size_t capacity(void) const { return this->_mask + 1; }
+
+            /**
+             * Appends a message to the queue; may be called concurrently by
+             * any number of threads.
+             *
+             * @param[in] msg: data product message
+             *
+             * @return: true if the message was queued, or false if the queue
+             * is full
+             */
+            bool try_push(const DpMsg &msg);
+
+            /**
+             * Appends a message to the queue, as with `try_push(const DpMsg&)`,
+             * moving it into the queue. The message is left unchanged if the
+             * queue is full.
+             *
+             * @param[in] msg: data product message
+             *
+             * @return: true if the message was queued, or false if the queue
+             * is full
+             */
+            bool try_push(DpMsg &&msg);
+
+            /**
+             * Removes the oldest message from the queue; must only be called
+             * by a single (consumer) thread at a time.
+             *
+             * @param[out] msg: data product message
+             *
+             * @return: true if a message was removed, or false if the queue is
+             * empty
+             */
+            bool try_pop(DpMsg &msg);
+
+            /**
+             * @return: number of positions claimed by producers so far; every
+             * message queued before this call is among them
+             */
+            size_t num_enqueued(void) const {
+                return this->_enqueue_position.load(std::memory_order_seq_cst);
+            }
+
+
+        private:
+
+            /**
+             * A queue slot. The sequence number equals the slot's next enqueue
+             * position when the slot is free, and that position plus one when
+             * it holds a message.
+             */
+            struct Slot {
+                std::atomic<size_t> sequence;
+                DpMsg msg;
+            };
+
+            /**
+             * Claims the next enqueue position for a producer
+             *
+             * @param[out] position: claimed position
+             *
+             * @return: slot of the claimed position, to be filled and then
+             * published by storing `position + 1` as its sequence number, or
+             * null if the queue is full
+             */
+            Slot *_claim(size_t &position);
+
+            /**
+             * Queue slots; the slot of each position is `position & _mask`
+             */
+            std::unique_ptr<Slot[]> _slots;
+            size_t _mask;
+
+            /**
+             * Next enqueue position, shared by producers, and next dequeue
+             * position, owned by the consumer; padded onto separate cache
+             * lines
+             */
+            std::atomic<size_t> _enqueue_position;
+            char _padding[64 - sizeof(std::atomic<size_t>)];
+            size_t _dequeue_position;
+
+
+    };
+
+
+};
+
+
+#endif
@@ -10,8 +10,10 @@
 #include <iostream>
 #include "synopsis_types.hpp"
 
-#define LOG_OBJECT(logger, type, fmt, ...) if(&logger != NULL){logger.log(type,  __FILE__, __LINE__, fmt, ## __VA_ARGS__);};
-#define LOG(logger, type, fmt, ...) if(logger != NULL){logger->log(type,  __FILE__, __LINE__, fmt, ## __VA_ARGS__);};
+// Messages below the logger's level are discarded before their arguments are
+// evaluated or formatted
+#define LOG_OBJECT(logger, type, fmt, ...) if(&logger != NULL && logger.is_enabled(type)){logger.log(type,  __FILE__, __LINE__, fmt, ## __VA_ARGS__);};
+#define LOG(logger, type, fmt, ...) if(logger != NULL && (logger)->is_enabled(type)){logger->log(type,  __FILE__, __LINE__, fmt, ## __VA_ARGS__);};
 
 namespace Synopsis {
 
@@ -31,7 +33,9 @@ namespace Synopsis {
 
             /**
              * Logs a message of the specified type, using a format string with
-             * arguments.
+             * arguments. Implementations may be called concurrently when the
+             * planner runs with multiple threads, and should emit each
+             * message atomically.
              *
              * @param[in] type: log message type
              * @param[in] fmt: C-style format string
@@ -40,6 +44,44 @@ namespace Synopsis {
             // virtual void log(LogType type, const char* file, const int line, FILE *out, const char* fmt,  ...) = 0;
             virtual void log(LogType type, const char* file, const int line, const char* fmt,  ...) = 0;
 
+
+            /**
+             * Sets the minimum type of message that is logged; the LOG
+             * macros discard less severe messages without formatting them
+             *
+             * @param[in] level: least severe log message type to be logged
+             */
+            void set_level(LogType level) {
+                this->_level = level;
+            }
+
+
+            /**
+             * @return: least severe log message type to be logged
+             */
+            LogType get_level(void) const {
+                return this->_level;
+            }
+
+
+            /**
+             * @param[in] type: log message type
+             *
+             * @return: whether messages of this type are logged
+             */
+            bool is_enabled(LogType type) const {
+                return type >= this->_level;
+            }
+
+
+        protected:
+
+            /**
+             * Least severe log message type to be logged; DEBUG messages are
+             * discarded by default
+             */
+            LogType _level = LogType::INFO;
+
     };
 
 
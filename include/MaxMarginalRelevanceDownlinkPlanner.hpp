@@ -14,9 +14,19 @@
 #ifndef JPL_SYNOPSIS_MaxMarginalRelevanceDownlinkPlanner
 #define JPL_SYNOPSIS_MaxMarginalRelevanceDownlinkPlanner
 
+#include <memory>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
 #include "DownlinkPlanner.hpp"
+#include "DpBundle.hpp"
+#include "MemoryArena.hpp"
 #include "RuleAST.hpp"
 #include "Similarity.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
 
 
 namespace Synopsis {
@@ -31,7 +41,40 @@ namespace Synopsis {
      *
      * @return: SUCCESS if the entry was successfully populated, or error code
      */
-    Status _populate_asdp(DpDbMsg msg, AsdpEntry &asdp);
+    Status _populate_asdp(const DpDbMsg &msg, AsdpEntry &asdp);
+
+    /**
+     * Populate a mapping of field names to values in the given ASDP from the
+     * ASDPDB message, as above, moving the metadata out of the message.
+     *
+     * @param[in] msg: ASDP information in ASDPDB message format
+     * @param[out] asdp: reference of ASDP mapping that will be populated
+     *
+     * @return: SUCCESS if the entry was successfully populated, or error code
+     */
+    Status _populate_asdp(DpDbMsg &&msg, AsdpEntry &asdp);
+
+
+    /**
+     * Downlink budget available to a bin. A bin's greedy loop stops at the
+     * first selected ASDP that does not fit, which becomes the cut point.
+     */
+    struct BinBudget {
+
+        /**
+         * Remaining bytes and number of ASDPs, or negative values for no limit
+         */
+        long max_bytes = -1;
+        int max_count = -1;
+
+        /**
+         * Set by the bin's prioritization to the total size of the ASDPs it
+         * prioritized and to the first ASDP that did not fit, or -1
+         */
+        long used_bytes = 0;
+        int cut_asdp_id = -1;
+
+    };
 
 
     /**
@@ -43,30 +86,377 @@ namespace Synopsis {
      * to values
      * @param[in] ruleset: a set of rules/constraints to be used for
      * prioritization
-     * @param[in] similarity: similarity configuration to be used for
-     * prioritization
+     * @param[in,out] similarity: similarity configuration to be used for
+     * prioritization, whose similarity cache is updated; bins prioritized
+     * concurrently must use separate configurations (see Similarity::fork)
+     * @param[in] pool: thread pool used to split each step's candidate scan
+     * into chunks, or null to scan serially
+     * @param[in] scan_threshold: minimum number of remaining candidates for
+     * which a step's scan is split, or zero to always scan serially
      *
-     * @return: a prioritized list of ASDP identifiers
+     * @param[in] timer: processing deadline checked before each greedy step,
+     * or null for no deadline
+     * @param[out] expired: if non-null, set to whether the deadline expired
+     * before the bin was fully prioritized
+     * @param[in,out] budget: if non-null, the downlink budget at which the
+     * bin's prioritization stops
+     * @param[out] stats: if non-null, populated with the bin's counters
+     * @param[in] logger: if non-null, receives a DEBUG message per greedy
+     * step
+     * @param[in] transmitted: if non-null, the bin's transmitted ASDPs; each
+     * candidate's maximum similarity to the queue also covers those of the
+     * same instrument/type (see Similarity::set_transmitted_context)
+     *
+     * @return: a prioritized list of ASDP identifiers; if the deadline
+     * expired or the budget was filled, the ASDPs selected so far, which are
+     * a prefix of the full ordering
      */
     std::vector<int> _prioritize_bin(
         int bin,
         AsdpList asdps,
-        RuleSet ruleset, Similarity similarity
+        RuleSet &ruleset, Similarity &similarity,
+        ThreadPool *pool = nullptr, int scan_threshold = 0,
+        Timer *timer = nullptr, bool *expired = nullptr,
+        BinBudget *budget = nullptr, BinStats *stats = nullptr,
+        Logger *logger = nullptr, const AsdpList *transmitted = nullptr
+    );
+
+
+    /**
+     * Incremental variant of _prioritize_bin that produces an identical
+     * ordering. Rather than rebuilding and re-scoring a copy of the queue for
+     * every candidate, it maintains the running maximum similarity of each
+     * candidate to the queue, updating it only against the newest selection,
+     * and evaluates rules and constraints against a single shared queue
+     * buffer (skipping them entirely when the bin has none).
+     *
+     * @see: _prioritize_bin
+     *
+     * @param[in] bin: priority bin from which ASDPs are selected
+     * @param[in] table: columnar table of ASDPs; the final SUE column is
+     * updated during prioritization
+     * @param[in] rows: rows of the table holding the bin's ASDPs
+     * @param[in] ruleset: a set of rules/constraints, bound to the table
+     * @param[in] similarity: similarity configuration, bound to the table
+     * @param[in] matrix: precomputed similarities among `rows`, or null to
+     * compute similarities on demand
+     * @param[in] pool: thread pool used to split each step's candidate scan
+     * and similarity update into chunks, or null to run serially
+     * @param[in] scan_threshold: minimum number of remaining candidates for
+     * which a step is split, or zero to always run serially
+     *
+     * @param[in] timer: processing deadline checked before each greedy step,
+     * or null for no deadline
+     * @param[out] expired: if non-null, set to whether the deadline expired
+     * before the bin was fully prioritized
+     * @param[in,out] budget: if non-null, the downlink budget at which the
+     * bin's prioritization stops
+     * @param[out] stats: if non-null, populated with the bin's counters
+     * @param[in] initial_similarity: if non-null, the maximum similarity of
+     * each candidate (indexed as `rows`) before any ASDP is queued, such as
+     * that returned by _transmitted_similarity
+     *
+     * @return: a prioritized list of ASDP identifiers; if the deadline
+     * expired or the budget was filled, the ASDPs selected so far, which are
+     * a prefix of the full ordering
+     */
+    std::vector<int> _prioritize_bin_incremental(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &rows,
+        RuleSet &ruleset, Similarity &similarity,
+        const SimilarityMatrix *matrix = nullptr,
+        ThreadPool *pool = nullptr, int scan_threshold = 0,
+        Timer *timer = nullptr, bool *expired = nullptr,
+        BinBudget *budget = nullptr, BinStats *stats = nullptr,
+        const std::vector<double> *initial_similarity = nullptr
+    );
+
+
+    /**
+     * Lazy-greedy (CELF) variant of _prioritize_bin that produces an
+     * identical ordering. Because the MMR discount factor can only decrease
+     * as the queue grows, a candidate's previously computed final SUE is an
+     * upper bound on its current value. Candidates are kept in a max-heap of
+     * these stale bounds and only the top of the heap is re-scored until a
+     * freshly scored candidate remains on top.
+     *
+     * The bound only holds when the objective is monotone, i.e., when the bin
+     * has no utility-adjusting rules, alpha is non-negative, SUEs are finite
+     * and non-negative, and sizes are positive. Otherwise, this function
+     * falls back to _prioritize_bin_incremental. Constraints are supported,
+     * since they only restrict which candidates are feasible at each step.
+     *
+     * @see: _prioritize_bin
+     *
+     * @param[in] bin: priority bin from which ASDPs are selected
+     * @param[in] table: columnar table of ASDPs; the final SUE column is
+     * updated during prioritization
+     * @param[in] rows: rows of the table holding the bin's ASDPs
+     * @param[in] ruleset: a set of rules/constraints, bound to the table
+     * @param[in] similarity: similarity configuration, bound to the table
+     * @param[in] matrix: precomputed similarities among `rows`, or null to
+     * compute similarities on demand
+     *
+     * @param[in] timer: processing deadline checked before each greedy step,
+     * or null for no deadline
+     * @param[out] expired: if non-null, set to whether the deadline expired
+     * before the bin was fully prioritized
+     * @param[in,out] budget: if non-null, the downlink budget at which the
+     * bin's prioritization stops
+     * @param[out] stats: if non-null, populated with the bin's counters
+     * @param[in] initial_similarity: if non-null, the maximum similarity of
+     * each candidate (indexed as `rows`) before any ASDP is queued, such as
+     * that returned by _transmitted_similarity
+     *
+     * @return: a prioritized list of ASDP identifiers; if the deadline
+     * expired or the budget was filled, the ASDPs selected so far, which are
+     * a prefix of the full ordering
+     */
+    std::vector<int> _prioritize_bin_lazy(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &rows,
+        RuleSet &ruleset, Similarity &similarity,
+        const SimilarityMatrix *matrix = nullptr,
+        Timer *timer = nullptr, bool *expired = nullptr,
+        BinBudget *budget = nullptr, BinStats *stats = nullptr,
+        const std::vector<double> *initial_similarity = nullptr
+    );
+
+
+    /**
+     * Computes the maximum similarity of each of a bin's candidates to the
+     * bin's transmitted ASDPs of the same instrument/type. Candidates and
+     * transmitted ASDPs of each key are grouped into tiles whose similarities
+     * are computed with the block form of the key's similarity function, so
+     * values are identical to those of SimilarityFunction::get_similarity.
+     *
+     * @param[in] table: columnar table of ASDPs
+     * @param[in] rows: rows of the table holding the bin's candidates
+     * @param[in] transmitted: rows of the table holding the bin's
+     * transmitted ASDPs
+     * @param[in] functions: similarity functions of the bin for each key,
+     * bound to the table (see Similarity::get_functions)
+     *
+     * @return: maximum similarity of each candidate, indexed as `rows`; zero
+     * for candidates without a similar transmitted ASDP
+     */
+    std::vector<double> _transmitted_similarity(
+        const AsdpTable &table,
+        const AsdpRowList &rows,
+        const AsdpRowList &transmitted,
+        const std::vector<SimilarityFunction*> &functions
     );
 
 
+    /**
+     * Greedy selection engines available to the MMR downlink planner
+     */
+    typedef enum {
+        EXHAUSTIVE_GREEDY = 0,
+        INCREMENTAL_GREEDY = 1,
+        LAZY_GREEDY = 2
+    } MmrEngine;
+
+
+    /**
+     * A variant of a prioritization's parameters, evaluated by
+     * MaxMarginalRelevanceDownlinkPlanner::sweep
+     */
+    struct SweepVariant {
+
+        /**
+         * Rule and constraint configuration, or empty for the sweep's base
+         * rule configuration
+         */
+        std::string rule_configuration_id;
+
+        /**
+         * Alpha for bins without their own value, or a negative value to
+         * keep that of the base similarity configuration
+         */
+        double default_alpha = -1.0;
+
+        /**
+         * Alpha of individual bins, replacing those of the base similarity
+         * configuration
+         */
+        std::map<int, double> alphas;
+
+        /**
+         * Scale parameter of every Gaussian or Laplacian similarity
+         * function, or a non-positive value to keep those of the base
+         * similarity configuration
+         */
+        double sigma = -1.0;
+
+    };
+
+
     /**
      * Maximum Marginal Relevance downlink planner implementation
      */
-    class MaxMarginalRelevanceDownlinkPlanner : public DownlinkPlanner {
+    class MaxMarginalRelevanceDownlinkPlanner :
+        public DownlinkPlanner, public ASDPDBListener {
 
 
         public:
 
             /**
-             * Default virtual destructor
+             * Constructs a planner using the specified greedy selection
+             * engine. All engines produce the same prioritization; they
+             * differ only in how much work is performed per selection step.
+             *
+             * The incremental and lazy engines can precompute each bin's
+             * pairwise similarities into a SimilarityMatrix. The memory for
+             * these matrices is part of the planner's memory requirement and
+             * is provided to `init`; bins whose matrix exceeds the budget
+             * (or, when bins are prioritized concurrently, the budget
+             * remaining after earlier bins) compute similarities on demand.
+             *
+             * @param[in] engine: greedy selection engine
+             * @param[in] similarity_memory_bytes: memory budget for similarity
+             * matrices; zero disables precomputation
+             */
+            MaxMarginalRelevanceDownlinkPlanner(
+                MmrEngine engine = EXHAUSTIVE_GREEDY,
+                size_t similarity_memory_bytes = 0
+            );
+
+            /**
+             * Stops listening to the ASDPDB, if incremental replanning is
+             * enabled
+             */
+            virtual ~MaxMarginalRelevanceDownlinkPlanner();
+
+            /**
+             * Sets the number of threads used to prioritize bins. Bins are
+             * independent, so they are prioritized concurrently and their
+             * results are joined in bin order; the prioritization is the same
+             * as with a single thread. Must be called before `init`.
+             *
+             * @param[in] n_threads: number of threads, including the thread
+             * calling `prioritize`; values below 2 prioritize serially
+             */
+            void set_num_threads(int n_threads);
+
+            /**
+             * Sets the bin size from which the exhaustive and incremental
+             * engines also split each greedy step's candidate scan across the
+             * thread pool. Chunks are reduced in index order, so ties still go
+             * to the lowest-index candidate and the prioritization is
+             * unchanged. Chunk tasks share the pool with per-bin tasks, so no
+             * threads beyond `set_num_threads` are used. The lazy engine
+             * always scans serially.
+             *
+             * @param[in] n_candidates: minimum number of remaining candidates
+             * for a parallel scan; zero (the default) disables parallel scans
+             */
+            void set_parallel_scan_threshold(int n_candidates);
+
+            /**
+             * Removes all cached rule and similarity configurations, so that
+             * they are re-read by the next call to `prioritize`.
+             * Configurations are otherwise cached by identifier, and re-read
+             * only if the modification time or size of the configuration file
+             * changes. The pairwise similarities computed by the exhaustive
+             * engine are cached with the similarity configuration, and reused
+             * for ASDPs whose diversity descriptors have not changed.
+             */
+            void clear_config_cache(void);
+
+            /**
+             * Sets the size of the scratch arena, drawn from the memory block
+             * provided to `init`, from which the incremental and lazy engines
+             * allocate their ASDP tables. The arena is rewound at the start of
+             * each call to `prioritize`, so once it is large enough for the
+             * ASDPDB contents, table storage does not touch the heap; tables
+             * that do not fit fall back to the heap. Must be called before
+             * `init`.
+             *
+             * @param[in] bytes: scratch arena size; zero (the default) always
+             * allocates tables on the heap
+             */
+            void set_scratch_memory(size_t bytes);
+
+            /**
+             * @return: largest number of scratch bytes used by a single call
+             * to `prioritize` since `init`
+             */
+            size_t scratch_high_water(void) const {
+                return this->_scratch_high_water;
+            }
+
+            /**
+             * @return: number of table allocations since `init` that did not
+             * fit within the scratch arena and were served by the heap
+             */
+            size_t scratch_overflows(void) const {
+                return this->_scratch_overflows;
+            }
+
+            /**
+             * Enables incremental replanning. The planner then keeps the
+             * ordering of each bin from the last call to `prioritize` and
+             * listens for changes to the ASDPDB. A later call with the same
+             * (unchanged) configurations reloads and replans only the bins
+             * holding ASDPs inserted or updated since, and reuses the ordering
+             * of every other bin. Bins are prioritized independently, so the
+             * result is the same as a full replan. Calls that time out are not
+             * kept, so the next call replans all bins. Must be called before
+             * `init`; the ASDPDB must outlive the planner or `deinit`.
+             *
+             * @param[in] incremental: whether to replan incrementally
+             */
+            void set_incremental(bool incremental);
+
+            /**
+             * @return: number of bins prioritized by the last call to
+             * `prioritize`, rather than reused from the previous plan
+             */
+            int num_replanned_bins(void) const {
+                return this->_n_replanned_bins;
+            }
+
+            /**
+             * Sets a planner to which `prioritize` and
+             * `prioritize_with_budget` fall back when the estimated time to
+             * prioritize the loaded ASDPs exceeds the time left before
+             * `max_processing_time_sec`. The estimate is the number of
+             * candidate evaluations made by greedy selection, n (n + 1) / 2
+             * for a bin of n untransmitted ASDPs (or n (n + 1) (n + 2) / 6
+             * similarity comparisons with the exhaustive engine), times the
+             * given time per evaluation. The fallback planner is initialized
+             * and de-initialized with this planner and must not require
+             * memory (e.g., BaselineDownlinkPlanner). Must be called before
+             * `init`.
+             *
+             * @param[in] fallback: fallback planner, or null for none
+             * @param[in] sec_per_evaluation: estimated time per evaluation
+             */
+            void set_fallback_planner(
+                std::unique_ptr<DownlinkPlanner> fallback,
+                double sec_per_evaluation = 1e-7
+            );
+
+            /**
+             * @return: whether the last call to `prioritize` (or
+             * `prioritize_with_budget`) used the fallback planner
+             */
+            bool used_fallback(void) const {
+                return this->_used_fallback;
+            }
+
+            /**
+             * @see: ASDPDBListener::data_product_changed
              */
-            virtual ~MaxMarginalRelevanceDownlinkPlanner() = default;
+            void data_product_changed(int asdp_id) override;
+
+            /**
+             * @see: ASDPDBListener::data_products_reset
+             */
+            void data_products_reset(void) override;
 
             /**
              * @see: ApplicationModule::memory_requirement
@@ -93,6 +483,314 @@ namespace Synopsis {
                 std::vector<int> &prioritized_list
             );
 
+            /**
+             * Bins are prioritized in bin order, each with the budget left by
+             * earlier bins, and each bin's greedy loop stops once the budget
+             * is filled; bins after the cut point are not prioritized.
+             * Budgeted bins therefore run one at a time, though each step's
+             * candidate scan may still be split across the thread pool. With
+             * incremental replanning, the reused full plan is truncated
+             * instead.
+             *
+             * @see: DownlinkPlanner::prioritize_with_budget
+             */
+            Status prioritize_with_budget(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                long max_bytes, int max_count,
+                std::vector<int> &prioritized_list,
+                int &cut_asdp_id
+            ) override;
+
+            /**
+             * Each bin's ordering is passed as soon as its prioritization and
+             * that of all earlier bins is complete; with multiple threads,
+             * bins are prioritized concurrently and passed from the worker
+             * that completes them. With incremental replanning, the full plan
+             * is updated first and then passed by bin.
+             *
+             * @see: DownlinkPlanner::prioritize_streaming
+             */
+            Status prioritize_streaming(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                const BinCallback &on_bin
+            ) override;
+
+            /**
+             * Prioritizes the ASDPs once for each of several variants of the
+             * rule configuration, alphas, and similarity scale parameter, for
+             * parameter studies. ASDPs are loaded into a table once, and the
+             * kernel sums underlying each bin's similarity matrix (e.g.,
+             * squared distances between diversity descriptors) are computed
+             * once and transformed for each variant. Each ordering is the same
+             * as that of `prioritize` with the variant's configurations.
+             *
+             * Bins are prioritized concurrently as by `prioritize`, with the
+             * variants of a bin evaluated in turn by the incremental engine
+             * (or the lazy engine, if this planner uses it). Similarity
+             * matrices are allocated on the heap rather than from the memory
+             * provided to `init`, and plans are not kept for incremental
+             * replanning.
+             *
+             * @param[in] rule_configuration_id: base rule and constraint
+             * configuration
+             * @param[in] similarity_configuration_id: base similarity
+             * configuration; variants may only change its alphas and scale
+             * parameters
+             * @param[in] variants: parameter variants
+             * @param[in] max_processing_time_sec: time limit for the sweep
+             * @param[out] prioritized_lists: prioritized ASDP identifiers for
+             * each variant
+             *
+             * @return: SUCCESS, TIMEOUT if the time expired (in which case
+             * each list is a prefix of the variant's ordering), or error code
+             */
+            Status sweep(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                const std::vector<SweepVariant> &variants,
+                double max_processing_time_sec,
+                std::vector<std::vector<int>> &prioritized_lists
+            );
+
+            /**
+             * Prioritizes the ASDPs of a bundle rather than those of the ASDP
+             * DB, for ground replays. ASDPs are decoded directly from the
+             * mapped bundle; downlinked ASDPs are skipped. The ordering is the
+             * same as that of `prioritize` over an ASDP DB holding the
+             * bundle's ASDPs with their stored identifiers. Plans are not kept
+             * for incremental replanning.
+             *
+             * @param[in] bundle: open bundle
+             * @param[in] rule_configuration_id: rule and constraint
+             * configuration
+             * @param[in] similarity_configuration_id: similarity configuration
+             * @param[in] max_processing_time_sec: processing time limit
+             * @param[out] prioritized_list: prioritized ASDP identifiers, which
+             * are the stored identifiers, or the bundle index of ASDPs stored
+             * without one
+             *
+             * @return: SUCCESS, TIMEOUT if the time expired (in which case the
+             * list is a prefix of the ordering), or error code
+             */
+            Status prioritize_bundle(
+                const DpBundle &bundle,
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                std::vector<int> &prioritized_list
+            );
+
+
+        private:
+
+            /**
+             * Greedy selection engine used to prioritize each bin
+             */
+            MmrEngine _engine;
+
+            /**
+             * Memory budget for similarity matrices, and the memory block
+             * provided to `init` for them
+             */
+            size_t _similarity_memory_bytes;
+            void *_similarity_memory = nullptr;
+
+            /**
+             * Scratch arena size and arena for ASDP tables, with the
+             * high-water mark and overflow count accumulated across calls
+             */
+            size_t _scratch_bytes = 0;
+            MemoryArena _scratch;
+            size_t _scratch_high_water = 0;
+            size_t _scratch_overflows = 0;
+
+            /**
+             * Prioritizes each bin of the given ASDPs that holds untransmitted
+             * ASDPs.
+             *
+             * @param[in,out] msgs: ASDPs to prioritize, whose metadata may be
+             * moved out
+             * @param[in] ruleset: rule configuration
+             * @param[in] similarity: similarity configuration
+             * @param[in] timer: processing deadline
+             * @param[out] bin_orders: prioritized ASDP identifiers of each bin
+             * @param[out] expired_bins: bins whose prioritization did not
+             * complete before the deadline; their orderings are prefixes
+             * @param[in,out] budget: if non-null, the downlink budget shared
+             * by the bins in order; bins after the one holding the cut point
+             * (or after an expired bin) are omitted from `bin_orders`
+             * @param[in,out] stats: if non-null, statistics to which the
+             * loading time, planning time, and prioritized bins are added
+             * @param[in] on_bin: if non-null, called with each bin's ordering
+             * in bin order, as soon as it and all earlier bins are complete,
+             * through the first expired bin
+             *
+             * @return: SUCCESS, or TIMEOUT if the deadline expired while the
+             * ASDPs were loaded, or error code
+             */
+            Status _prioritize_bins(
+                std::vector<DpDbMsg> &msgs,
+                RuleSet &ruleset, Similarity &similarity, Timer &timer,
+                std::map<int, std::vector<int>> &bin_orders,
+                std::set<int> &expired_bins,
+                BinBudget *budget = nullptr,
+                PlannerStats *stats = nullptr,
+                const BinCallback *on_bin = nullptr
+            );
+
+            /**
+             * Estimates the time needed to prioritize the given ASDPs and, if
+             * it exceeds the time left, prepares the fallback planner
+             *
+             * @param[in] msgs: loaded ASDPs
+             * @param[in] timer: processing deadline
+             *
+             * @return: whether to use the fallback planner
+             */
+            bool _use_fallback(const std::vector<DpDbMsg> &msgs, Timer &timer);
+
+            /**
+             * Logs a summary of a prioritization's statistics
+             *
+             * @param[in] stats: statistics, or null if disabled
+             */
+            void _log_stats(const PlannerStats *stats);
+
+            /**
+             * Finds the bins of the last plan affected by ASDPs changed since,
+             * which are the bins that held them in the plan and those that
+             * hold them now. With transmitted context, transmitted ASDPs also
+             * affect the bins that held them and those that hold them now.
+             *
+             * @param[out] bins: affected bins
+             * @param[in] transmitted_context: whether the plan uses
+             * transmitted ASDPs as similarity context
+             *
+             * @return: whether the affected bins are known; if not, all bins
+             * must be replanned
+             */
+            bool _find_changed_bins(
+                std::set<int> &bins, bool transmitted_context
+            );
+
+            /**
+             * Runs prioritization tasks on the thread pool, or serially if
+             * there is none
+             *
+             * @param[in] tasks: tasks to run
+             */
+            void _run_tasks(std::vector<PoolTask> &tasks);
+
+            /**
+             * Number of prioritization threads, and the pool of worker
+             * threads created by `init`
+             */
+            int _num_threads = 1;
+            std::unique_ptr<ThreadPool> _pool;
+
+            /**
+             * Minimum number of candidates for a parallel scan, or zero
+             */
+            int _scan_threshold = 0;
+
+            /**
+             * Fallback planner, or null, its estimated time per candidate
+             * evaluation, and whether the last prioritization used it
+             */
+            std::unique_ptr<DownlinkPlanner> _fallback;
+            double _fallback_sec_per_evaluation = 1e-7;
+            bool _used_fallback = false;
+
+            /**
+             * Identifies the version of a configuration file; files that do
+             * not exist have a default stamp
+             */
+            struct ConfigStamp {
+                bool exists = false;
+                long mtime_sec = 0;
+                long mtime_nsec = 0;
+                long size = 0;
+
+                bool operator==(const ConfigStamp &other) const {
+                    return (this->exists == other.exists) &&
+                        (this->mtime_sec == other.mtime_sec) &&
+                        (this->mtime_nsec == other.mtime_nsec) &&
+                        (this->size == other.size);
+                }
+            };
+
+            /**
+             * @param[in] config_id: configuration identifier (file path)
+             *
+             * @return: current stamp of the configuration file
+             */
+            static ConfigStamp _get_config_stamp(const std::string &config_id);
+
+            /**
+             * Returns the cached rule configuration with the given identifier,
+             * parsing it if it is not cached or its file has changed
+             */
+            RuleSet &_get_rule_config(const std::string &config_id);
+
+            /**
+             * Returns the cached similarity configuration with the given
+             * identifier, parsing it if it is not cached or its file has
+             * changed
+             */
+            Similarity &_get_similarity_config(const std::string &config_id);
+
+            /**
+             * Parsed configurations and the stamps of the files from which
+             * they were parsed, indexed by configuration identifier
+             */
+            std::map<std::string, std::pair<ConfigStamp, std::unique_ptr<RuleSet>>> _rule_configs;
+            std::map<std::string, std::pair<ConfigStamp, std::unique_ptr<Similarity>>> _similarity_configs;
+
+            /**
+             * Incremented whenever a configuration is parsed or the cache is
+             * cleared, so that plans made with other configurations are not
+             * reused
+             */
+            unsigned long _config_generation = 0;
+
+            /**
+             * Whether incremental replanning is enabled, and the ASDPDB being
+             * listened to
+             */
+            bool _incremental = false;
+            ASDPDB *_listening_db = nullptr;
+
+            /**
+             * Last complete plan: its configurations, the ordering of each
+             * bin, the bin of each planned ASDP, and (with transmitted
+             * context) the bin of each transmitted ASDP
+             */
+            bool _plan_valid = false;
+            std::string _plan_rule_id;
+            std::string _plan_similarity_id;
+            unsigned long _plan_generation = 0;
+            std::map<int, std::vector<int>> _plan_bins;
+            std::map<int, int> _plan_asdp_bins;
+            std::map<int, int> _plan_transmitted_bins;
+
+            /**
+             * ASDPs changed since the last plan, and whether the ASDPDB was
+             * reset; guarded by the mutex, as notifications may arrive from
+             * other threads
+             */
+            std::mutex _changes_mutex;
+            std::set<int> _changed_ids;
+            bool _changes_reset = false;
+
+            /**
+             * Number of bins prioritized by the last call to `prioritize`
+             */
+            int _n_replanned_bins = 0;
+
 
     };
 
@@ -0,0 +1,382 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides an Autonomous Science Data Product Database (ASDPDB) implementation
+ * that stores all ASDPs in fixed-capacity tables within the memory block
+ * provided at initialization.
+ */
+#ifndef JPL_SYNOPSIS_MemoryASDPDB
+#define JPL_SYNOPSIS_MemoryASDPDB
+#include <string>
+#include <vector>
+
+#include "ASDPDB.hpp"
+#include "MemoryArena.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * In-memory ASDPDB Implementation. Capacities are fixed at construction,
+     * and all tables are allocated from the memory block provided to `init`,
+     * so no heap memory is used by the database itself. ASDP identifiers are
+     * assigned sequentially from 1, and each ASDP is found by identifier in
+     * constant time. The contents of the database are lost when it is
+     * de-initialized.
+     */
+    class MemoryASDPDB : public ASDPDB {
+
+
+        public:
+
+            /**
+             * Version of the snapshot image format written by `save_snapshot`
+             */
+            static const int SNAPSHOT_VERSION = 1;
+
+            /**
+             * Constructs an ASDPDB instance
+             *
+             * @param[in] max_asdps: maximum number of ASDPs
+             * @param[in] max_metadata: maximum number of metadata values,
+             * summed across all ASDPs
+             * @param[in] max_fields: maximum number of distinct metadata field
+             * names
+             * @param[in] string_bytes: capacity in bytes of storage for field
+             * names and string values (instrument names, types, URIs, and
+             * string metadata), including a terminator for each string
+             */
+            MemoryASDPDB(int max_asdps, int max_metadata, int max_fields,
+                size_t string_bytes);
+
+            /**
+             * Default virtual destructor
+             */
+            virtual ~MemoryASDPDB() = default;
+
+            /**
+             * Returns the number of bytes of memory required by the module to
+             * hold tables with the capacities given at construction.
+             *
+             * @return: memory required in bytes
+             */
+            size_t memory_requirement(void);
+
+            /**
+             * Initializes an empty ASDPDB within the provided memory block,
+             * which must be aligned to `MemoryArena::ALIGNMENT` bytes and
+             * contain at least the number of bytes returned by the
+             * `memory_requirement` function.
+             *
+             * @param[in] bytes: number of bytes in memory block
+             * @param[in] memory: pointer to memory block
+             * @param[in] logger: pointer to a logger instance to be used by
+             * the ASDPDB
+             *
+             * @return: SUCCESS if initialization was successful, or error code
+             */
+            Status init(size_t bytes, void* memory, Logger *logger);
+
+            /**
+             * De-initializes the ASDPDB; the provided memory block will no
+             * longer be used by the module, and all ASDPs are discarded.
+             *
+             * @return: SUCCESS if de-initialization was successful, or error
+             * code
+             */
+            Status deinit(void);
+
+            /**
+             * Inserts data product information; fails without modifying the
+             * database if any table capacity would be exceeded.
+             *
+             * @see ASDPDB::insert_data_product
+             */
+            Status insert_data_product(DpDbMsg& msg);
+
+            /**
+             * Begins a batch, recording the table sizes so that insertions
+             * can be undone.
+             *
+             * @see ASDPDB::begin_batch
+             */
+            Status begin_batch(void);
+
+            /**
+             * @see ASDPDB::commit_batch
+             */
+            Status commit_batch(void);
+
+            /**
+             * Removes all ASDPs inserted within the current batch. Updates of
+             * existing ASDPs are applied immediately and cannot be undone; if
+             * any were made within the batch, the insertions are still
+             * removed (though string storage used within the batch is not
+             * reclaimed) but FAILURE is returned.
+             *
+             * @see ASDPDB::rollback_batch
+             */
+            Status rollback_batch(void);
+
+            /**
+             * @see ASDPDB::get_data_product
+             */
+            Status get_data_product(int asdp_id, DpDbMsg& msg);
+
+            /**
+             * @see ASDPDB::list_data_product_ids
+             */
+            std::vector<int> list_data_product_ids(void);
+
+            /**
+             * Fetches all ASDPs in a single pass over the ASDP table.
+             *
+             * @see ASDPDB::list_undownlinked_data_products
+             */
+            Status list_undownlinked_data_products(std::vector<DpDbMsg> &msgs);
+
+            /**
+             * Fetches a bin's ASDPs in a single pass over the ASDP table.
+             *
+             * @see ASDPDB::list_undownlinked_data_products_in_bin
+             */
+            Status list_undownlinked_data_products_in_bin(
+                int priority_bin, std::vector<DpDbMsg> &msgs);
+
+            /**
+             * @see ASDPDB::update_science_utility
+             */
+            Status update_science_utility(int asdp_id, double sue);
+
+            /**
+             * @see ASDPDB::update_priority_bin
+             */
+            Status update_priority_bin(int asdp_id, int bin);
+
+            /**
+             * @see ASDPDB::update_downlink_state
+             */
+            Status update_downlink_state(int asdp_id, DownlinkState state);
+
+            /**
+             * Updates a metadata value; a new string value is written in place
+             * of the old value if it is no longer, and otherwise consumes
+             * additional string storage.
+             *
+             * @see ASDPDB::update_metadata
+             */
+            Status update_metadata(
+                int asdp_id, std::string fieldname, DpMetadataValue value);
+
+            /**
+             * @see ASDPDB::is_initialized
+             */
+            bool is_initialized(void);
+
+            /**
+             * Writes a binary image of the DB tables to a file. The image is
+             * first written to a temporary file (`path` with a ".tmp"
+             * suffix), which then replaces any existing image, so an
+             * interrupted snapshot leaves the previous image intact. Tables
+             * are written in their native layout, so an image can only be
+             * restored by a build for the same architecture. Snapshots cannot
+             * be saved within a batch.
+             *
+             * @param[in] path: path of the image file
+             *
+             * @return: SUCCESS if the image was written, or error code
+             */
+            Status save_snapshot(const std::string &path);
+
+            /**
+             * Replaces the contents of the DB with an image written by
+             * `save_snapshot`, restoring ASDP identifiers. Each table is read
+             * directly into the memory block, with no per-ASDP parsing. The
+             * image is validated with a checksum; if it is invalid or exceeds
+             * the capacities of this DB, the DB is left empty.
+             *
+             * @param[in] path: path of the image file
+             *
+             * @return: SUCCESS if the image was restored, or error code
+             */
+            Status load_snapshot(const std::string &path);
+
+            /**
+             * @return: number of ASDPs in the database
+             */
+            int num_data_products(void) const { return this->_n_asdps; }
+
+            /**
+             * @return: number of bytes of string storage in use
+             */
+            size_t string_bytes_used(void) const { return this->_string_used; }
+
+
+        private:
+
+            /**
+             * ASDP table row; strings are stored as offsets into string
+             * storage
+             */
+            struct AsdpRecord {
+                int instrument_name;
+                int type;
+                int uri;
+                size_t size;
+                double sue;
+                int priority_bin;
+                DownlinkState state;
+                int first_metadata;
+                int n_metadata;
+            };
+
+            /**
+             * Metadata table row; values of each ASDP are stored contiguously
+             */
+            struct MetadataRecord {
+                int fieldname_id;
+                MetadataType type;
+                int int_value;
+                double float_value;
+                int string_value;
+            };
+
+            /**
+             * Table sizes, recorded to undo insertions
+             */
+            struct TableMark {
+                int n_asdps;
+                int n_metadata;
+                int n_fields;
+                size_t string_used;
+            };
+
+            /**
+             * Logs an error and returns false if the DB is not initialized
+             *
+             * @param[in] operation: description of the attempted operation
+             *
+             * @return: whether the DB is initialized
+             */
+            bool _check_initialized(const std::string &operation);
+
+            /**
+             * @param[in] asdp_id: ASDP identifier
+             *
+             * @return: ASDP table row, or NULL if no such ASDP exists
+             */
+            AsdpRecord *_find(int asdp_id);
+
+            /**
+             * Copies a string into string storage
+             *
+             * @param[in] value: string value
+             * @param[out] offset: offset of the stored string
+             *
+             * @return: whether storage had sufficient capacity
+             */
+            bool _store_string(const std::string &value, int *offset);
+
+            /**
+             * Returns the identifier of a field name, adding it if needed
+             *
+             * @param[in] fieldname: field name
+             * @param[out] fieldname_id: field name identifier
+             *
+             * @return: whether the field table had sufficient capacity
+             */
+            bool _intern_fieldname(const std::string &fieldname, int *fieldname_id);
+
+            /**
+             * @param[in] fieldname: field name
+             *
+             * @return: field name identifier, or -1 if the field is unknown
+             */
+            int _find_fieldname(const std::string &fieldname) const;
+
+            /**
+             * @param[in] offset: offset of a stored string
+             *
+             * @return: stored string
+             */
+            const char *_string(int offset) const {
+                return this->_strings + offset;
+            }
+
+            /**
+             * Populates a message from an ASDP table row
+             *
+             * @param[in] asdp_id: ASDP identifier
+             * @param[in] record: ASDP table row
+             * @param[out] msg: message populated with ASDP information
+             */
+            void _populate_msg(int asdp_id, const AsdpRecord &record,
+                DpDbMsg &msg) const;
+
+            /**
+             * @return: current table sizes
+             */
+            TableMark _mark(void) const;
+
+            /**
+             * Truncates tables to previously recorded sizes
+             *
+             * @param[in] mark: recorded table sizes
+             */
+            void _restore(const TableMark &mark);
+
+            /**
+             * Checks that restored tables only reference stored strings,
+             * field names, and metadata values
+             *
+             * @return: whether the tables are consistent
+             */
+            bool _check_tables(void) const;
+
+            /**
+             * Table capacities
+             */
+            int _max_asdps;
+            int _max_metadata;
+            int _max_fields;
+            size_t _string_bytes;
+
+            /**
+             * Allocator over the memory block provided at initialization
+             */
+            MemoryArena _arena;
+
+            /**
+             * Tables allocated within the memory block, and their sizes
+             */
+            AsdpRecord *_asdps;
+            MetadataRecord *_metadata;
+            int *_fieldnames;
+            char *_strings;
+            int _n_asdps;
+            int _n_metadata;
+            int _n_fields;
+            size_t _string_used;
+
+            /**
+             * State of the current batch
+             */
+            bool _batch_open;
+            bool _batch_updated;
+            TableMark _batch_mark;
+
+            /**
+             * Whether the DB has been initialized
+             */
+            bool _initialized;
+
+
+    };
+
+
+};
+
+
+#endif
@@ -0,0 +1,257 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a bump allocator over a caller-provided memory block, used by
+ * modules that must allocate all of their storage within the memory block
+ * passed to `ApplicationModule::init`, and a standard allocator adapter so
+ * that containers can draw from such a block.
+ */
+#ifndef JPL_SYNOPSIS_MemoryArena
+#define JPL_SYNOPSIS_MemoryArena
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+namespace Synopsis {
+
+
+    /**
+     * Arena allocator over a fixed memory block. Allocations are aligned to
+     * `ALIGNMENT` bytes and are released all at once when the arena is
+     * reset; individual allocations cannot be freed.
+     */
+    class MemoryArena {
+
+
+        public:
+
+            /**
+             * Alignment in bytes of every allocation
+             */
+            static const size_t ALIGNMENT = 8;
+
+            /**
+             * Constructs an arena without a memory block; all allocations
+             * fail until the arena is reset with a block
+             */
+            MemoryArena();
+
+            /**
+             * Constructs an arena over a memory block
+             *
+             * @param[in] bytes: number of bytes in memory block
+             * @param[in] memory: pointer to memory block
+             */
+            MemoryArena(size_t bytes, void *memory);
+
+            /**
+             * Default destructor; the memory block is owned by the caller
+             */
+            ~MemoryArena() = default;
+
+            /**
+             * Releases all allocations and uses a new memory block
+             *
+             * @param[in] bytes: number of bytes in memory block
+             * @param[in] memory: pointer to memory block
+             */
+            void reset(size_t bytes, void *memory);
+
+            /**
+             * Releases all allocations made since `bytes_used` returned the
+             * given mark, so that the space can be reused
+             *
+             * @param[in] mark: earlier value of `bytes_used`
+             */
+            void rewind(size_t mark);
+
+            /**
+             * Allocates an aligned region from the memory block
+             *
+             * @param[in] n_bytes: number of bytes to allocate
+             *
+             * @return: pointer to the allocated region, or NULL if the memory
+             * block has insufficient remaining space
+             */
+            void *allocate(size_t n_bytes);
+
+            /**
+             * Allocates an uninitialized array from the memory block
+             *
+             * @param[in] n: number of array elements
+             *
+             * @return: pointer to the first element, or NULL if the memory
+             * block has insufficient remaining space
+             */
+            template <typename T>
+            T *allocate_array(size_t n) {
+                static_assert(alignof(T) <= ALIGNMENT,
+                    "Array element alignment exceeds arena alignment");
+                return static_cast<T*>(this->allocate(n * sizeof(T)));
+            }
+
+            /**
+             * Returns the number of bytes needed to allocate an array from an
+             * arena whose memory block is aligned to `ALIGNMENT` bytes
+             *
+             * @param[in] n: number of array elements
+             *
+             * @return: bytes required, including alignment padding
+             */
+            template <typename T>
+            static size_t array_requirement(size_t n) {
+                return MemoryArena::aligned_size(n * sizeof(T));
+            }
+
+            /**
+             * @param[in] n_bytes: allocation size in bytes
+             *
+             * @return: allocation size rounded up to a multiple of `ALIGNMENT`
+             */
+            static size_t aligned_size(size_t n_bytes);
+
+            /**
+             * @return: number of bytes allocated, including alignment padding
+             */
+            size_t bytes_used(void) const { return this->_used; }
+
+            /**
+             * @return: number of bytes remaining in the memory block
+             */
+            size_t bytes_available(void) const { return this->_bytes - this->_used; }
+
+            /**
+             * @return: largest number of bytes in use at any time since the
+             * arena was last reset
+             */
+            size_t bytes_high_water(void) const { return this->_high_water; }
+
+            /**
+             * @param[in] pointer: any pointer
+             *
+             * @return: whether the pointer lies within the memory block
+             */
+            bool contains(const void *pointer) const {
+                const char *p = static_cast<const char*>(pointer);
+                return (this->_memory != NULL) && (p >= this->_memory) &&
+                    (p < this->_memory + this->_bytes);
+            }
+
+            /**
+             * Records an allocation that could not be served by the arena,
+             * and was instead served by the heap
+             */
+            void record_overflow(void) { this->_n_overflows++; }
+
+            /**
+             * @return: number of allocations recorded as overflows since the
+             * arena was last reset
+             */
+            size_t num_overflows(void) const { return this->_n_overflows; }
+
+
+        private:
+
+            /**
+             * Memory block and its size in bytes
+             */
+            char *_memory;
+            size_t _bytes;
+
+            /**
+             * Offset of the next allocation within the memory block
+             */
+            size_t _used;
+
+            /**
+             * Largest offset reached, and number of recorded overflows
+             */
+            size_t _high_water;
+            size_t _n_overflows;
+
+
+    };
+
+
+    /**
+     * Standard allocator that allocates from an arena. Memory returned to
+     * the allocator is reclaimed only when the arena is rewound or reset.
+     * Without an arena, or once the arena is exhausted, allocations are served
+     * by the heap (and counted as arena overflows), so containers keep working
+     * when the memory block is too small.
+     */
+    template <typename T>
+    class ArenaAllocator {
+
+
+        public:
+
+            using value_type = T;
+
+            /**
+             * @param[in] arena: arena to allocate from, or null to use the heap
+             */
+            ArenaAllocator(MemoryArena *arena = nullptr) : _arena(arena) {}
+
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other.arena()) {}
+
+            T *allocate(size_t n) {
+                static_assert(alignof(T) <= MemoryArena::ALIGNMENT,
+                    "Element alignment exceeds arena alignment");
+                if (this->_arena != nullptr) {
+                    void *region = this->_arena->allocate(n * sizeof(T));
+                    if (region != NULL) {
+                        return static_cast<T*>(region);
+                    }
+                    this->_arena->record_overflow();
+                }
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T *pointer, size_t n) {
+                if ((this->_arena == nullptr) || !this->_arena->contains(pointer)) {
+                    ::operator delete(pointer);
+                }
+            }
+
+            /**
+             * @return: arena to allocate from, or null
+             */
+            MemoryArena *arena(void) const { return this->_arena; }
+
+
+        private:
+
+            MemoryArena *_arena;
+
+
+    };
+
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+        return a.arena() == b.arena();
+    }
+
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+        return a.arena() != b.arena();
+    }
+
+
+    /**
+     * Type alias for a vector whose storage may be drawn from an arena
+     */
+    template <typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+
+};
+
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a registry of downlink planners by name, so that applications can
+ * select a planner from their configuration rather than hard-coding one.
+ *
+ * The following planners are registered by default:
+ *
+ *  - "mmr": MaxMarginalRelevanceDownlinkPlanner with the exhaustive engine
+ *  - "mmr_incremental": MaxMarginalRelevanceDownlinkPlanner with the
+ *    incremental engine
+ *  - "mmr_lazy": MaxMarginalRelevanceDownlinkPlanner with the lazy engine
+ *  - "baseline": BaselineDownlinkPlanner
+ */
+#ifndef JPL_SYNOPSIS_PlannerRegistry
+#define JPL_SYNOPSIS_PlannerRegistry
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "synopsis_types.hpp"
+#include "DownlinkPlanner.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Constructs a new planner instance
+     */
+    using PlannerFactory = std::function<std::unique_ptr<DownlinkPlanner>(void)>;
+
+
+    /**
+     * Registers a planner under a name, replacing any planner already
+     * registered under that name
+     *
+     * @param[in] name: planner name
+     * @param[in] factory: constructs instances of the planner
+     *
+     * @return: SUCCESS, or FAILURE if the name is empty or the factory is
+     * null
+     */
+    Status register_planner(const std::string &name, PlannerFactory factory);
+
+
+    /**
+     * Constructs a registered planner
+     *
+     * @param[in] name: planner name
+     *
+     * @return: new planner instance, or null if no planner is registered under
+     * the name
+     */
+    std::unique_ptr<DownlinkPlanner> create_planner(const std::string &name);
+
+
+    /**
+     * @return: names of the registered planners, in sorted order
+     */
+    std::vector<std::string> list_planners(void);
+
+
+};
+
+
+#endif
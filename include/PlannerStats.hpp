@@ -0,0 +1,136 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides the timings and counters collected by a downlink planner during a
+ * prioritization, when enabled with `DownlinkPlanner::set_stats_enabled`.
+ */
+#ifndef JPL_SYNOPSIS_PlannerStats
+#define JPL_SYNOPSIS_PlannerStats
+
+#include <vector>
+#include <cstddef>
+
+
+namespace Synopsis {
+
+
+    /**
+     * Timings and counters of the prioritization of one priority bin
+     */
+    struct BinStats {
+
+        /**
+         * Priority bin
+         */
+        int bin = 0;
+
+        /**
+         * Number of candidate ASDPs in the bin, and number prioritized
+         */
+        int n_asdps = 0;
+        int n_prioritized = 0;
+
+        /**
+         * Time spent prioritizing the bin, including the precomputation of
+         * its similarity matrix
+         */
+        double planning_time_sec = 0.0;
+
+        /**
+         * Number of candidates evaluated against the bin's rules and
+         * constraints, and number rejected by a violated constraint
+         */
+        long n_rule_evaluations = 0;
+        long n_constraint_rejections = 0;
+
+        /**
+         * Number of pairwise similarities read from a cache or precomputed
+         * similarity matrix, and number computed on demand
+         */
+        long n_similarity_hits = 0;
+        long n_similarity_misses = 0;
+
+        /**
+         * Final (similarity-discounted) SUE of each prioritized ASDP, in
+         * priority order
+         */
+        std::vector<double> final_sues;
+
+    };
+
+
+    /**
+     * Timings and counters of one prioritization. Phase timings are measured
+     * with the planner's clock.
+     */
+    struct PlannerStats {
+
+        /**
+         * Time spent obtaining the rule and similarity configurations,
+         * including parsing them if they are not cached
+         */
+        double config_time_sec = 0.0;
+
+        /**
+         * Time spent loading ASDPs from the ASDPDB into the planner's
+         * representation
+         */
+        double load_time_sec = 0.0;
+
+        /**
+         * Time spent prioritizing bins; when bins are prioritized
+         * concurrently, this is less than the sum of per-bin times
+         */
+        double planning_time_sec = 0.0;
+
+        /**
+         * Time spent in the whole prioritization
+         */
+        double total_time_sec = 0.0;
+
+        /**
+         * Number of ASDPs loaded from the ASDPDB
+         */
+        size_t n_loaded = 0;
+
+        /**
+         * Totals of the per-bin counters
+         */
+        long n_rule_evaluations = 0;
+        long n_constraint_rejections = 0;
+        long n_similarity_hits = 0;
+        long n_similarity_misses = 0;
+
+        /**
+         * Statistics of each prioritized bin, in bin order
+         */
+        std::vector<BinStats> bins;
+
+        /**
+         * Resets all timings and counters
+         */
+        void clear(void) {
+            *this = PlannerStats();
+        }
+
+        /**
+         * Adds the statistics of a prioritized bin to the totals
+         *
+         * @param[in] bin_stats: statistics of the bin
+         */
+        void add_bin(const BinStats &bin_stats) {
+            this->n_rule_evaluations += bin_stats.n_rule_evaluations;
+            this->n_constraint_rejections += bin_stats.n_constraint_rejections;
+            this->n_similarity_hits += bin_stats.n_similarity_hits;
+            this->n_similarity_misses += bin_stats.n_similarity_misses;
+            this->bins.push_back(bin_stats);
+        }
+
+    };
+
+
+};
+
+
+#endif
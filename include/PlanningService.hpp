@@ -0,0 +1,130 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a persistent planning service that answers a stream of requests
+ * against one application instance, so that the ASDP DB connection, parsed
+ * configurations, and planner caches stay warm across requests.
+ *
+ * Requests and responses are single-line JSON objects. Each request has a
+ * "command" field, and each response has a "status" field holding a
+ * `Status` code (and an "error" field if the request failed):
+ *
+ *   {"command": "prioritize", "rule_config": <path>,
+ *    "similarity_config": <path>, "max_processing_time_sec": <number>,
+ *    "max_bytes": <integer>, "max_count": <integer>, "ids_only": <bool>}
+ *      -> {"status": 0, "prioritized_list": [...], "cut_asdp_id": <id>}
+ *   {"command": "ingest", "instrument_name": <str>, "type": <str>,
+ *    "uri": <str>, "size": <integer>, "science_utility_estimate": <number>,
+ *    "priority_bin": <integer>, "downlink_state": <integer>,
+ *    "metadata": {<field>: <number or string>, ...}}
+ *      -> {"status": 0, "asdp_id": <id>}
+ *   {"command": "update_science_utility", "asdp_id": <id>, "value": <number>}
+ *   {"command": "update_priority_bin", "asdp_id": <id>, "value": <integer>}
+ *   {"command": "update_downlink_state", "asdp_id": <id>, "value": <integer>}
+ *   {"command": "update_metadata", "asdp_id": <id>, "field": <str>,
+ *    "value": <number or string>}
+ *      -> {"status": 0}
+ *   {"command": "get", "asdp_id": <id>}
+ *      -> {"status": 0, "data_product": {...}}
+ *   {"command": "quit"}
+ *      -> {"status": 0}
+ *
+ * All prioritize fields other than the command are optional. Without a byte
+ * or count budget the full prioritization is returned; with one, the
+ * response also includes the first ASDP that did not fit ("cut_asdp_id").
+ * Data products are formatted as by `synopsis_cli`, or as identifiers only
+ * if "ids_only" is true. They are read from the entries the planner loaded
+ * when it keeps them (see DownlinkPlanner::set_keep_entries), and otherwise
+ * from the ASDP DB.
+ *
+ * A request that fails, including one that raises an exception (e.g., for a
+ * missing configuration or a busy ASDP DB), is answered with an error and
+ * does not stop the service.
+ */
+#ifndef JPL_SYNOPSIS_PlanningService
+#define JPL_SYNOPSIS_PlanningService
+
+#include <string>
+#include <iostream>
+
+#include "synopsis.hpp"
+#include "Logger.hpp"
+
+
+namespace Synopsis {
+
+
+    class PlanningService {
+
+
+        public:
+
+            /**
+             * Constructs a service for an initialized application
+             *
+             * @param[in] app: application that handles requests; must outlive
+             * the service
+             * @param[in] logger: logger for request errors, or null
+             */
+            PlanningService(Application *app, Logger *logger = nullptr);
+
+            /**
+             * Default destructor
+             */
+            ~PlanningService() = default;
+
+            /**
+             * Handles a single request
+             *
+             * @param[in] request: JSON request
+             * @param[out] response: single-line JSON response
+             *
+             * @return: status of the request, also given in the response
+             */
+            Status handle(const std::string &request, std::string &response);
+
+            /**
+             * Handles requests read one per line from an input stream, writing
+             * one response line per request (and flushing it) to an output
+             * stream, until the input ends or a "quit" request is handled.
+             * Blank lines are ignored.
+             *
+             * @param[in] input: request stream
+             * @param[in] output: response stream
+             *
+             * @return: number of requests handled
+             */
+            int serve(std::istream &input, std::ostream &output);
+
+            /**
+             * @return: whether a "quit" request has been handled
+             */
+            bool is_stopped(void) const { return this->_stopped; }
+
+
+        private:
+
+            /**
+             * Application that handles requests
+             */
+            Application *_app;
+
+            /**
+             * Reference to the logger instance to be used by this module
+             */
+            Logger *_logger;
+
+            /**
+             * Whether a "quit" request has been handled
+             */
+            bool _stopped = false;
+
+
+    };
+
+
+};
+
+
+#endif
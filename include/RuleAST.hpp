@@ -17,10 +17,13 @@
 
 #include "synopsis_types.hpp"
 #include "DpDbMsg.hpp"
+#include "AsdpTable.hpp"
+#include "RuleProgram.hpp"
 #include "Logger.hpp"
 
 namespace Synopsis {
 
+
     /**
      * An abstract generic expression within a rule or constraint definition.
      */
@@ -44,6 +47,32 @@ namespace Synopsis {
              */
             void set_logger( Logger* logger );
 
+            /**
+             * Resolves the variable and field names used by this expression
+             * (and its sub-expressions) against an ASDP table prior to
+             * evaluation over that table. The default implementation records
+             * the variable scope so that expressions without a table-specific
+             * implementation can still be evaluated by materializing ASDPs.
+             *
+             * @param[in] table: ASDP table to be used for evaluation
+             * @param[in] scope: names of variables in scope, in binding order
+             */
+            virtual void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * Lowers this expression (and its sub-expressions) to
+             * instructions appended to a rule program; `bind` must first be
+             * invoked. The default implementation returns -1, in which case
+             * the expression containing this one is evaluated as a tree.
+             *
+             * @param[in,out] program: program to which instructions are
+             * appended
+             *
+             * @return: register holding the value of the expression, or -1 if
+             * the expression cannot be compiled
+             */
+            virtual int compile(RuleProgram &program);
+
 
             // /**
             //  * Logs a message of the specified type, using a format string with
@@ -56,6 +85,33 @@ namespace Synopsis {
             // void log(LogType type, const char* fmt, ...); // declare log function to actually do the logging, this would do a null pointer check first, in which case don't do any logging. define it the same way as the log function in logger.h. See if this is easy to do otherwise just call the logger.h's log
             
         protected:
+
+            /**
+             * Materializes table rows as ASDP entries, for expressions that
+             * do not provide a table-specific implementation
+             *
+             * @param[in] table: ASDP table
+             * @param[in] assignments: row assignments of variables in scope
+             * @param[in] rows: rows of ASDPs in the downlink queue
+             * @param[out] assigned: storage for ASDPs assigned to variables
+             * @param[out] asdp_assignments: ASDPs assigned to variable names,
+             * pointing into `assigned`
+             * @param[out] asdps: list of ASDPs in the downlink queue
+             */
+            void _materialize(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &rows,
+                AsdpList &assigned,
+                AsdpAssignments &asdp_assignments,
+                AsdpList &asdps
+            );
+
+            /**
+             * Names of variables in scope recorded by the default `bind`
+             */
+            std::vector<std::string> _scope;
+
             /* Reference to the logger instance to be used by this module
             */
             Logger *_logger = nullptr; 
@@ -64,6 +120,16 @@ namespace Synopsis {
     };
 
 
+    class ValueExpression;
+
+
+    /**
+     * Type alias for an equality between a field of a variable, identified
+     * by its slot, and an expression
+     */
+    using FieldEquality = std::pair<int, ValueExpression*>;
+
+
     /**
      * An abstract expression within a rule or constraint definition that
      * returns a Boolean value upon evaluation.
@@ -87,10 +153,42 @@ namespace Synopsis {
              * @return: Boolean value
              */
             virtual bool get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
             ) = 0;
 
+            /**
+             * Returns the value of this expression for ASDPs stored in a
+             * table; `bind` must first be invoked with the same table. The
+             * default implementation materializes ASDP entries and invokes
+             * `get_value`.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] assignments: table rows assigned to variables
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             *
+             * @return: Boolean value
+             */
+            virtual bool evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * Finds equality comparisons between a field of a variable and
+             * another expression that must all hold for this expression to be
+             * true; `bind` must first be invoked. The default implementation
+             * finds none.
+             *
+             * @param[in] var_index: index of the variable in scope
+             * @param[out] equalities: equalities to which those found are
+             * appended
+             */
+            virtual void find_equalities(
+                int var_index, std::vector<FieldEquality> &equalities
+            );
+
 
     };
 
@@ -118,10 +216,39 @@ namespace Synopsis {
              * @return: metadata value
              */
             virtual DpMetadataValue get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
             ) = 0;
 
+            /**
+             * Returns the value of this expression for ASDPs stored in a
+             * table; `bind` must first be invoked with the same table. The
+             * default implementation materializes ASDP entries and invokes
+             * `get_value`.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] assignments: table rows assigned to variables
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             *
+             * @return: metadata value
+             */
+            virtual AsdpValue evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * Returns the slot of the field accessed by this expression if it
+             * is a field of the given variable; `bind` must first be invoked.
+             * The default implementation returns -1.
+             *
+             * @param[in] var_index: index of the variable in scope
+             *
+             * @return: field slot, or -1
+             */
+            virtual int get_field_slot(int var_index);
+
 
     };
 
@@ -171,11 +298,114 @@ namespace Synopsis {
              *
              * @return: total science utility adjustment
              */
-            double apply(AsdpList asdps);
+            double apply(const AsdpList &asdps);
+
+            /**
+             * Binds the rule's expressions to an ASDP table, and compiles the
+             * bound expressions to rule programs
+             *
+             * @see RuleExpression::bind
+             *
+             * @param[in] table: ASDP table to be used for evaluation
+             */
+            void bind(AsdpTable &table);
+
+            /**
+             * Returns the total SUE adjustment due to application of rule to a
+             * given downlink queue of ASDPs stored in a table.
+             *
+             * @param[in] table: ASDP table to which the rule is bound
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             * @param[in] index: optional index over a prefix of `asdps`
+             *
+             * @return: total science utility adjustment
+             */
+            double apply(
+                AsdpTable &table, const AsdpRowList &asdps,
+                const QueueIndex *index = nullptr
+            );
+
+            /**
+             * @return: whether the rule's expressions were compiled to rule
+             * programs when bound; otherwise, they are evaluated as trees
+             */
+            bool is_compiled(void) const;
+
+            /**
+             * Appends the field slots of the queue indexes used by the rule's
+             * compiled programs
+             *
+             * @param[in,out] slots: field slots
+             */
+            void add_index_slots(std::vector<int> &slots) const;
+
+            /**
+             * Returns whether the rule can be evaluated incrementally, by
+             * evaluating only the assignments that involve the most recently
+             * added ASDP. This requires one or two variables, a nonzero
+             * limit on applications (if any), and compiled expressions that do
+             * not quantify over the queue.
+             *
+             * @return: whether the rule is incremental
+             */
+            bool is_incremental(void) const { return this->_incremental; }
+
+            /**
+             * Updates the total SUE adjustment and number of applications of
+             * the rule for a queue extended by one ASDP. For incremental
+             * rules, only the assignments involving the new ASDP are
+             * evaluated: a single term for one-variable rules, and a row and
+             * column of pairs for two-variable rules. Other rules, and
+             * two-variable rules for which the maximum number of applications
+             * would change which pairs are applied, are evaluated over the
+             * entire queue.
+             *
+             * @param[in] table: ASDP table to which the rule is bound
+             * @param[in] asdps: table rows of ASDPs in the downlink queue, the
+             * last of which is the new ASDP
+             * @param[in,out] total: total adjustment for the queue without the
+             * new ASDP, updated to include it
+             * @param[in,out] n_applications: number of applications for the
+             * queue without the new ASDP, updated to include it
+             * @param[in] index: optional index over a prefix of `asdps`
+             */
+            void extend(
+                AsdpTable &table, const AsdpRowList &asdps,
+                double &total, int &n_applications,
+                const QueueIndex *index = nullptr
+            );
 
 
         private:
 
+            /**
+             * Returns the total SUE adjustment for a queue stored in a table,
+             * and the number of times the rule was applied
+             *
+             * @see Rule::apply
+             */
+            double _apply(
+                AsdpTable &table, const AsdpRowList &asdps,
+                int &n_applications, const QueueIndex *index
+            );
+
+            /**
+             * Adds the adjustment of the assigned ASDPs to a total, and counts
+             * the application, if the rule applies to them and the adjustment
+             * is numeric
+             *
+             * @return: whether the application expression holds
+             */
+            bool _accumulate(
+                AsdpTable &table,
+                AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps,
+                std::vector<AsdpValue> &registers,
+                const QueueIndex *index,
+                double &total,
+                int &n_applications
+            );
+
             /**
              * Stores the list of variable names in the rule definition
              */
@@ -196,6 +426,18 @@ namespace Synopsis {
              */
             int _max_applications;
 
+            /**
+             * Programs compiled from the application and adjustment
+             * expressions when bound
+             */
+            RuleProgram _application_program;
+            RuleProgram _adjustment_program;
+
+            /**
+             * Whether the bound rule can be evaluated incrementally
+             */
+            bool _incremental = false;
+
             /**
              * Reference to the logger instance to be used by this module
              */
@@ -251,11 +493,110 @@ namespace Synopsis {
              * @return: `true` if the constraint is satisfied, or `false` if
              * not
              */
-            bool apply(AsdpList asdps);
+            bool apply(const AsdpList &asdps);
+
+            /**
+             * Binds the constraint's expressions to an ASDP table, and
+             * compiles the bound expressions to rule programs
+             *
+             * @see RuleExpression::bind
+             *
+             * @param[in] table: ASDP table to be used for evaluation
+             */
+            void bind(AsdpTable &table);
+
+            /**
+             * Returns the constraint is satisfied for the given downlink
+             * queue of ASDPs stored in a table.
+             *
+             * @param[in] table: ASDP table to which the constraint is bound
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             * @param[in] index: optional index over a prefix of `asdps`
+             *
+             * @return: `true` if the constraint is satisfied, or `false` if
+             * not
+             */
+            bool apply(
+                AsdpTable &table, const AsdpRowList &asdps,
+                const QueueIndex *index = nullptr
+            );
+
+            /**
+             * @return: whether the constraint's expressions were compiled to
+             * rule programs when bound; otherwise, they are evaluated as
+             * trees
+             */
+            bool is_compiled(void) const;
+
+            /**
+             * Appends the field slots of the queue indexes used by the
+             * constraint's compiled programs
+             *
+             * @param[in,out] slots: field slots
+             */
+            void add_index_slots(std::vector<int> &slots) const;
+
+            /**
+             * Returns whether the constraint can be evaluated incrementally,
+             * as a running aggregate of per-ASDP contributions. This requires
+             * a single variable and compiled expressions that do not quantify
+             * over the queue, so that the contribution of an ASDP does not
+             * change as ASDPs are added to the queue.
+             *
+             * @return: whether the constraint is incremental
+             */
+            bool is_incremental(void) const { return this->_incremental; }
+
+            /**
+             * Returns the amount an ASDP contributes to the constraint's
+             * aggregate: the sum field value (or one, for a count) if the
+             * constraint applies to the ASDP, and zero otherwise.
+             *
+             * @param[in] table: ASDP table to which the constraint is bound
+             * @param[in] row: table row of the ASDP
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             * @param[in] index: optional index over a prefix of `asdps`
+             *
+             * @return: contribution to the aggregate
+             */
+            double contribution(
+                AsdpTable &table, int row, const AsdpRowList &asdps,
+                const QueueIndex *index = nullptr
+            );
+
+            /**
+             * @param[in] aggregate: aggregate value over a downlink queue
+             *
+             * @return: `true` if the constraint is satisfied by the aggregate,
+             * or `false` if not
+             */
+            bool is_satisfied(double aggregate) const {
+                return aggregate < this->_constraint_value;
+            }
 
 
         private:
 
+            /**
+             * Adds the contribution of the ASDP assigned to the constraint's
+             * variable to an aggregate
+             *
+             * @param[in] table: ASDP table to which the constraint is bound
+             * @param[in,out] assignments: variable assignments
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             * @param[in,out] registers: register file for compiled programs
+             * @param[in] index: optional index over a prefix of `asdps`
+             * @param[in,out] aggregate: aggregate value
+             */
+            void _accumulate(
+                AsdpTable &table,
+                AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps,
+                std::vector<AsdpValue> &registers,
+                const QueueIndex *index,
+                double &aggregate
+            );
+
             /**
              * Stores the list of variable names in the rule definition
              */
@@ -277,6 +618,18 @@ namespace Synopsis {
              */
             double _constraint_value;
 
+            /**
+             * Programs compiled from the application expression and sum
+             * field when bound
+             */
+            RuleProgram _application_program;
+            RuleProgram _sum_program;
+
+            /**
+             * Whether the bound constraint can be evaluated incrementally
+             */
+            bool _incremental = false;
+
             /**
              * Reference to the logger instance to be used by this module
              */
@@ -297,6 +650,36 @@ namespace Synopsis {
     using ConstraintList = std::vector<Constraint>;
 
 
+    /**
+     * Running aggregates of a priority bin's rules and constraints over a
+     * downlink queue that grows by one ASDP at a time.
+     *
+     * @see RuleSet::init_aggregates
+     */
+    struct QueueAggregates {
+
+        /**
+         * Aggregate value of each of the bin's constraints over the queue;
+         * entries for constraints that are not incremental are unused
+         */
+        std::vector<double> constraints;
+
+        /**
+         * Total adjustment and number of applications of each of the bin's
+         * rules over the queue
+         */
+        std::vector<double> rules;
+        std::vector<int> rule_applications;
+
+        /**
+         * Index over the queue of the fields that the bin's rules and
+         * constraints look up within existential expressions
+         */
+        QueueIndex index;
+
+    };
+
+
     /**
      * AST representation of a set of rules and constraints across all priority
      * bins.
@@ -401,11 +784,106 @@ namespace Synopsis {
              * constraints were satisfied, and if true, the second entry
              * specifies the total utility adjustment to apply.
              */
-            std::pair<bool, double> apply(int bin, AsdpList queue);
+            std::pair<bool, double> apply(int bin, const AsdpList &queue);
+
+            /**
+             * Binds all rules and constraints to an ASDP table
+             *
+             * @see RuleExpression::bind
+             *
+             * @param[in] table: ASDP table to be used for evaluation
+             */
+            void bind(AsdpTable &table);
+
+            /**
+             * Applies a set of rules and constraints to a queue of ASDPs
+             * stored in a table for a given priority bin.
+             *
+             * @see RuleSet::apply
+             *
+             * @param[in] bin: priority bin
+             * @param[in] table: ASDP table to which the rule set is bound
+             * @param[in] queue: table rows of the ASDP queue to which the
+             * rules/constraints should be applied
+             *
+             * @return: a pair of values; the first entry indicates whether all
+             * constraints were satisfied, and if true, the second entry
+             * specifies the total utility adjustment to apply.
+             */
+            std::pair<bool, double> apply(
+                int bin, AsdpTable &table, const AsdpRowList &queue
+            );
+
+            /**
+             * Initializes the running aggregates of a priority bin for an
+             * empty downlink queue
+             *
+             * @param[in] bin: priority bin
+             * @param[out] aggregates: running aggregates
+             */
+            void init_aggregates(int bin, QueueAggregates &aggregates);
+
+            /**
+             * Applies a set of rules and constraints to a queue extended by
+             * a candidate ASDP. Incremental constraints are checked against
+             * the running aggregates of the queue without the candidate, and
+             * rules are extended from their running totals; all other
+             * constraints are evaluated over the entire queue. The result is
+             * that of `apply` for the same queue, up to rounding of
+             * two-variable rule adjustments.
+             *
+             * @see RuleSet::apply
+             *
+             * @param[in] bin: priority bin
+             * @param[in] table: ASDP table to which the rule set is bound
+             * @param[in] queue: table rows of the ASDP queue, the last of
+             * which is the candidate
+             * @param[in] aggregates: running aggregates of the queue without
+             * the candidate
+             *
+             * @return: a pair of values; the first entry indicates whether all
+             * constraints were satisfied, and if true, the second entry
+             * specifies the total utility adjustment to apply.
+             */
+            std::pair<bool, double> apply_candidate(
+                int bin, AsdpTable &table, const AsdpRowList &queue,
+                const QueueAggregates &aggregates
+            );
+
+            /**
+             * Updates the running aggregates after an ASDP has been added to
+             * the queue. Field values of queued ASDPs must not change after
+             * they are committed.
+             *
+             * @param[in] bin: priority bin
+             * @param[in] table: ASDP table to which the rule set is bound
+             * @param[in] queue: table rows of the ASDP queue, the last of
+             * which was just added
+             * @param[in,out] aggregates: running aggregates
+             */
+            void commit(
+                int bin, AsdpTable &table, const AsdpRowList &queue,
+                QueueAggregates &aggregates
+            );
 
 
         private:
 
+            /**
+             * Returns a reference to the rules for the given priority bin
+             *
+             * @see RuleSet::get_rules
+             */
+            RuleList &_get_bin_rules(int bin);
+
+            /**
+             * Returns a reference to the constraints for the given priority
+             * bin
+             *
+             * @see RuleSet::get_constraints
+             */
+            ConstraintList &_get_bin_constraints(int bin);
+
             /**
              * Stores a list of bin-specific rules
              */
@@ -461,7 +939,21 @@ namespace Synopsis {
             /**
              * @see BoolValueExpression::get_value
              */
-            bool get_value(AsdpAssignments assignments, AsdpList asdps);
+            bool get_value(const AsdpAssignments &assignments, const AsdpList &asdps);
+
+            /**
+             * @see BoolValueExpression::evaluate
+             */
+            bool evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
 
 
         private:
@@ -499,10 +991,24 @@ namespace Synopsis {
              * @see ValueExpression::get_value
              */
             DpMetadataValue get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
+            );
+
+            /**
+             * @see ValueExpression::evaluate
+             */
+            AsdpValue evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
             );
 
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
 
         private:
 
@@ -538,7 +1044,27 @@ namespace Synopsis {
             /**
              * @see BoolValueExpression::get_value
              */
-            bool get_value(AsdpAssignments assignments, AsdpList asdps);
+            bool get_value(const AsdpAssignments &assignments, const AsdpList &asdps);
+
+            /**
+             * @see BoolValueExpression::evaluate
+             */
+            bool evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
 
         private:
 
@@ -581,7 +1107,33 @@ namespace Synopsis {
             /**
              * @see BoolValueExpression::get_value
              */
-            bool get_value(AsdpAssignments assignments, AsdpList asdps);
+            bool get_value(const AsdpAssignments &assignments, const AsdpList &asdps);
+
+            /**
+             * @see BoolValueExpression::evaluate
+             */
+            bool evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
+            /**
+             * @see BoolValueExpression::find_equalities
+             */
+            void find_equalities(
+                int var_index, std::vector<FieldEquality> &equalities
+            );
 
 
         private:
@@ -635,7 +1187,34 @@ namespace Synopsis {
             /**
              * @see BoolValueExpression::get_value
              */
-            bool get_value(AsdpAssignments assignments, AsdpList asdps);
+            bool get_value(const AsdpAssignments &assignments, const AsdpList &asdps);
+
+            /**
+             * @see BoolValueExpression::evaluate
+             */
+            bool evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
+            /**
+             * @see BoolValueExpression::find_equalities
+             */
+            void find_equalities(
+                int var_index, std::vector<FieldEquality> &equalities
+            );
+
 
         private:
 
@@ -684,10 +1263,29 @@ namespace Synopsis {
              * @see ValueExpression::get_value
              */
             DpMetadataValue get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
+            );
+
+            /**
+             * @see ValueExpression::evaluate
+             */
+            AsdpValue evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
             );
 
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
 
         private:
 
@@ -696,6 +1294,11 @@ namespace Synopsis {
              */
             DpMetadataValue _value;
 
+            /**
+             * Stores the interned identifier of the value in the bound table
+             */
+            int _string_id = -1;
+
 
     };
 
@@ -726,10 +1329,29 @@ namespace Synopsis {
              * @see ValueExpression::get_value
              */
             DpMetadataValue get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
             );
 
+            /**
+             * @see ValueExpression::evaluate
+             */
+            AsdpValue evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
 
         private:
 
@@ -772,10 +1394,29 @@ namespace Synopsis {
              * @see ValueExpression::get_value
              */
             DpMetadataValue get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
+            );
+
+            /**
+             * @see ValueExpression::evaluate
+             */
+            AsdpValue evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
             );
 
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
 
         private:
 
@@ -827,10 +1468,34 @@ namespace Synopsis {
              * @see ValueExpression::get_value
              */
             DpMetadataValue get_value(
-                AsdpAssignments assignments,
-                AsdpList asdps
+                const AsdpAssignments &assignments,
+                const AsdpList &asdps
+            );
+
+            /**
+             * @see ValueExpression::evaluate
+             */
+            AsdpValue evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
             );
 
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile
+             */
+            int compile(RuleProgram &program);
+
+            /**
+             * @see ValueExpression::get_field_slot
+             */
+            int get_field_slot(int var_index);
+
 
         private:
 
@@ -844,6 +1509,18 @@ namespace Synopsis {
              */
             std::string _field_name;
 
+            /**
+             * Stores the index of the variable among those in scope, or -1 if
+             * the variable is not in scope
+             */
+            int _var_index = -1;
+
+            /**
+             * Stores the field slot in the bound table, or -1 if no ASDP in
+             * the table has the field
+             */
+            int _slot = -1;
+
 
     };
 
@@ -877,7 +1554,29 @@ namespace Synopsis {
             /**
              * @see BoolValueExpression::get_value
              */
-            bool get_value(AsdpAssignments assignments, AsdpList asdps);
+            bool get_value(const AsdpAssignments &assignments, const AsdpList &asdps);
+
+            /**
+             * @see BoolValueExpression::evaluate
+             */
+            bool evaluate(
+                AsdpTable &table,
+                const AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps
+            );
+
+            /**
+             * @see RuleExpression::bind
+             */
+            void bind(AsdpTable &table, std::vector<std::string> &scope);
+
+            /**
+             * @see RuleExpression::compile. If the quantified expression
+             * requires a field of the quantified variable to equal an
+             * expression of the enclosing variables, the expression is
+             * evaluated first and the field is looked up in a queue index.
+             */
+            int compile(RuleProgram &program);
 
 
         private:
@@ -892,6 +1591,12 @@ namespace Synopsis {
              */
             BoolValueExpression *_expr;
 
+            /**
+             * Stores the index of the quantified variable among those in
+             * scope, recorded when bound
+             */
+            int _var_index = -1;
+
 
     };
 
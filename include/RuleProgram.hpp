@@ -0,0 +1,422 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a flat, register-based program representation of rule and
+ * constraint expressions. Expressions are lowered to a program after they
+ * are bound to an ASDP table, so operators, field slots, variable indices,
+ * and string constants are resolved once rather than on every evaluation.
+ *
+ * @see: RuleAST.hpp
+ */
+#ifndef JPL_SYNOPSIS_RuleProgram
+#define JPL_SYNOPSIS_RuleProgram
+
+#include <vector>
+#include <unordered_map>
+
+#include "AsdpTable.hpp"
+#include "Logger.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Rule program operations. Unless noted, each operation writes its
+     * result to the destination register `dst`, reading operands from
+     * registers `a` and `b`.
+     */
+    typedef enum {
+        OP_LOAD_BOOL,       // dst = (arg != 0)
+        OP_LOAD_NUMBER,     // dst = number
+        OP_LOAD_STRING,     // dst = interned string arg
+        OP_LOAD_NAN,        // dst = NaN
+        OP_LOAD_FIELD,      // dst = field in slot arg of variable a
+        OP_NEG,             // dst = -a
+        OP_ADD,             // dst = a + b
+        OP_SUB,             // dst = a - b
+        OP_MUL,             // dst = a * b
+        OP_EQ,              // dst = (a == b)
+        OP_NE,              // dst = (a != b)
+        OP_GT,              // dst = (a > b)
+        OP_GE,              // dst = (a >= b)
+        OP_LT,              // dst = (a < b)
+        OP_LE,              // dst = (a <= b)
+        OP_NOT,             // dst = !a
+        OP_MOVE,            // dst = a
+        OP_SKIP_IF_FALSE,   // if !a: dst = false, skip arg instructions
+        OP_SKIP_IF_TRUE,    // if a: dst = true, skip arg instructions
+        OP_EXISTS           // dst = whether the following arg instructions
+                            // set b to true for any ASDP assigned to
+                            // variable a; the instructions are then skipped.
+                            // If key >= 0, only ASDPs whose field in slot
+                            // key_slot equals register key are assigned
+    } RuleOpcode;
+
+
+    /**
+     * A single rule program instruction
+     */
+    struct RuleInstruction {
+
+        /**
+         * Operation
+         */
+        RuleOpcode op;
+
+        /**
+         * Destination and operand registers (or variable index)
+         */
+        int dst;
+        int a;
+        int b;
+
+        /**
+         * Integer argument (field slot, string identifier, or instruction
+         * count)
+         */
+        int arg;
+
+        /**
+         * Numeric constant
+         */
+        double number;
+
+        /**
+         * For EXISTS instructions, the register holding the value looked up
+         * in a queue index, or -1 if all ASDPs are assigned
+         */
+        int key;
+
+        /**
+         * For EXISTS instructions, the field slot of the queue index
+         */
+        int key_slot;
+
+    };
+
+
+    /**
+     * Hash indexes over the values of selected fields for ASDPs in a downlink
+     * queue, used to answer equality predicates within existential
+     * expressions without scanning the queue. The index covers a prefix of
+     * the queue, and is extended one ASDP at a time as the queue grows; ASDPs
+     * after the prefix (such as a candidate temporarily appended to the
+     * queue) are scanned.
+     */
+    class QueueIndex {
+
+
+        public:
+
+            /**
+             * Constructs an empty index over no fields
+             */
+            QueueIndex() = default;
+
+            /**
+             * Default destructor
+             */
+            ~QueueIndex() = default;
+
+            /**
+             * Sets the fields to be indexed and removes all ASDPs
+             *
+             * @param[in] slots: field slots to index
+             */
+            void set_slots(const std::vector<int> &slots);
+
+            /**
+             * Removes all ASDPs from the index
+             */
+            void clear(void);
+
+            /**
+             * Appends an ASDP to the indexed prefix of the queue. Field values
+             * of the ASDP must not change while it is indexed.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] row: table row of the ASDP
+             */
+            void add(const AsdpTable &table, int row);
+
+            /**
+             * @return: number of ASDPs in the indexed prefix of the queue
+             */
+            int size(void) const { return this->_size; }
+
+            /**
+             * @param[in] slot: field slot
+             *
+             * @return: whether the field is indexed
+             */
+            bool has_slot(int slot) const { return this->_find_slot(slot) >= 0; }
+
+            /**
+             * Returns the indexed ASDPs whose field equals a value, under the
+             * semantics of the `==` comparator
+             *
+             * @param[in] slot: indexed field slot
+             * @param[in] value: value to look up
+             *
+             * @return: matching table rows, or null if there are none
+             */
+            const AsdpRowList *find(int slot, const AsdpValue &value) const;
+
+
+        private:
+
+            /**
+             * Hash key of a field value; numeric values compare by value and
+             * strings by interned identifier
+             */
+            struct Key {
+                bool is_string;
+                double value;
+
+                bool operator==(const Key &other) const {
+                    return (this->is_string == other.is_string) &&
+                        (this->value == other.value);
+                }
+            };
+
+            struct KeyHash {
+                size_t operator()(const Key &key) const;
+            };
+
+            /**
+             * Computes the key of a value
+             *
+             * @return: `false` if the value is not equal to any value (NaN)
+             */
+            static bool _make_key(const AsdpValue &value, Key &key);
+
+            /**
+             * @return: position of an indexed field slot, or -1
+             */
+            int _find_slot(int slot) const;
+
+            /**
+             * Indexed field slots and the index of each
+             */
+            std::vector<int> _slots;
+            std::vector<std::unordered_map<Key, AsdpRowList, KeyHash>> _indexes;
+
+            /**
+             * Number of indexed ASDPs
+             */
+            int _size = 0;
+
+
+    };
+
+
+    /**
+     * A compiled expression: a flat list of instructions over a register
+     * file, evaluated with an ASDP table to which the expression was bound.
+     * Programs hold no evaluation state, so a program may be evaluated
+     * concurrently with separate register files.
+     */
+    class RuleProgram {
+
+
+        public:
+
+            /**
+             * Constructs an empty (uncompiled) program
+             */
+            RuleProgram();
+
+            /**
+             * Default destructor
+             */
+            ~RuleProgram() = default;
+
+            /**
+             * Removes all instructions and registers
+             */
+            void clear(void);
+
+            /**
+             * @return: a new register
+             */
+            int add_register(void);
+
+            /**
+             * Records that the variable with the given index is assigned
+             * during evaluation
+             *
+             * @param[in] var_index: index of the variable in scope
+             */
+            void use_variable(int var_index);
+
+            /**
+             * Appends an instruction
+             *
+             * @return: index of the instruction
+             */
+            int emit(RuleOpcode op, int dst, int a = -1, int b = -1,
+                int arg = 0, double number = 0.0);
+
+            /**
+             * Sets the instruction count argument of a skip or EXISTS
+             * instruction to skip all instructions emitted after it
+             *
+             * @param[in] index: index of the instruction
+             * @param[in] body_result: for EXISTS instructions, the register
+             * holding the result of the skipped instructions
+             */
+            void patch_skip(int index, int body_result = -1);
+
+            /**
+             * Sets an EXISTS instruction to assign only ASDPs found in a queue
+             * index
+             *
+             * @param[in] index: index of the instruction
+             * @param[in] key: register holding the value to look up
+             * @param[in] slot: field slot of the queue index
+             */
+            void set_index_key(int index, int key, int slot);
+
+            /**
+             * Completes the program
+             *
+             * @param[in] result: register holding the result of the program,
+             * or -1 if the expression could not be compiled
+             */
+            void set_result(int result);
+
+            /**
+             * @return: whether the program has been compiled successfully
+             */
+            bool is_compiled(void) const { return this->_result >= 0; }
+
+            /**
+             * @return: whether the program quantifies over the downlink
+             * queue, so that its value for an assignment may change as ASDPs
+             * are added to the queue
+             */
+            bool uses_queue(void) const;
+
+            /**
+             * @return: field slots of the queue indexes used by the program
+             */
+            const std::vector<int> &index_slots(void) const {
+                return this->_index_slots;
+            }
+
+            /**
+             * @return: number of instructions
+             */
+            int size(void) const { return this->_code.size(); }
+
+            /**
+             * @return: number of registers needed for evaluation
+             */
+            int num_registers(void) const { return this->_n_registers; }
+
+            /**
+             * @return: number of variable assignments needed for evaluation
+             */
+            int num_variables(void) const { return this->_n_variables; }
+
+            /**
+             * Sets the logger used to report evaluation errors
+             *
+             * @param[in] logger: pointer to a logger instance
+             */
+            void set_logger(Logger *logger) { this->_logger = logger; }
+
+            /**
+             * Evaluates the program
+             *
+             * @param[in] table: ASDP table to which the expression was bound
+             * @param[in,out] assignments: table rows assigned to variables;
+             * must hold at least `num_variables` entries, and entries for
+             * existentially quantified variables are overwritten
+             * @param[in] asdps: table rows of ASDPs in the downlink queue
+             * @param[in,out] registers: register file with at least
+             * `num_registers` entries
+             * @param[in] index: optional index over a prefix of `asdps`
+             *
+             * @return: result value
+             */
+            const AsdpValue &evaluate(
+                const AsdpTable &table,
+                AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps,
+                std::vector<AsdpValue> &registers,
+                const QueueIndex *index = nullptr
+            ) const;
+
+            /**
+             * Evaluates a program with a Boolean result
+             *
+             * @see RuleProgram::evaluate
+             */
+            bool evaluate_bool(
+                const AsdpTable &table,
+                AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps,
+                std::vector<AsdpValue> &registers,
+                const QueueIndex *index = nullptr
+            ) const {
+                return this->evaluate(
+                    table, assignments, asdps, registers, index
+                ).int_value != 0;
+            }
+
+
+        private:
+
+            /**
+             * Runs a range of instructions
+             *
+             * @param[in] begin: index of the first instruction
+             * @param[in] end: index after the last instruction
+             */
+            void _run(
+                int begin, int end,
+                const AsdpTable &table,
+                AsdpRowAssignments &assignments,
+                const AsdpRowList &asdps,
+                std::vector<AsdpValue> &registers,
+                const QueueIndex *index
+            ) const;
+
+            /**
+             * Program instructions
+             */
+            std::vector<RuleInstruction> _code;
+
+            /**
+             * Register holding the result, or -1 if not compiled
+             */
+            int _result;
+
+            /**
+             * Registers and variable assignments needed for evaluation
+             */
+            int _n_registers;
+            int _n_variables;
+
+            /**
+             * Field slots of the queue indexes used by EXISTS instructions
+             */
+            std::vector<int> _index_slots;
+
+            /**
+             * Reference to the logger instance used to report evaluation
+             * errors
+             */
+            Logger *_logger = nullptr;
+
+
+    };
+
+
+};
+
+
+#endif
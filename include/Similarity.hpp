@@ -18,6 +18,8 @@
 
 #include "synopsis_types.hpp"
 #include "DpDbMsg.hpp"
+#include "AsdpTable.hpp"
+#include "SimilarityKernels.hpp"
 #include "Logger.hpp"
 
 
@@ -34,7 +36,7 @@ namespace Synopsis {
      * @return: squared Euclidean distance
      */
     double _sq_euclidean_dist(
-        std::vector<double> dd1, std::vector<double> dd2
+        const std::vector<double> &dd1, const std::vector<double> &dd2
     );
 
 
@@ -53,16 +55,45 @@ namespace Synopsis {
      */
     double _gaussian_similarity(
         double sigma,
-        std::vector<double> dd1, std::vector<double> dd2
+        const std::vector<double> &dd1, const std::vector<double> &dd2
     );
 
 
+    /**
+     * Calculates the alpha-adjusted MMR discount factor:
+     *
+     *          DF_adj = (1.0 - alpha) + alpha * (1.0 - max_similarity)
+     *
+     * @param[in] alpha: MMR alpha parameter
+     * @param[in] max_similarity: maximum similarity between a candidate and
+     * already-queued ASDPs
+     *
+     * @return: discount factor
+     */
+    double _discount_factor(double alpha, double max_similarity);
+
+
     /**
      * Type alias for a map of named parameters used by a similarity function
      */
     using SimParamMap = std::map<std::string, double>;
 
 
+    /**
+     * Methods of finding the maximum similarity between a candidate ASDP and
+     * queued ASDPs
+     */
+    typedef enum {
+        // Compute the similarity to every queued ASDP
+        LINEAR_SEARCH = 0,
+        // Find the nearest queued ASDP with a spatial index
+        EXACT_INDEX_SEARCH = 1,
+        // Find a queued ASDP within a factor (1 + epsilon) of the nearest
+        // distance with a spatial index
+        APPROXIMATE_INDEX_SEARCH = 2
+    } MaxSimilaritySearch;
+
+
     /**
      * Implements a generic, configurable similarity function
      */
@@ -82,10 +113,15 @@ namespace Synopsis {
              * multiplied by each raw diversity descriptor value for rescaling;
              * should be the same length as `diversity_descriptors`
              * @param[in] similarity_type: the type of similarity function to
-             * compute (options: "gaussian")
+             * compute, resolved with the kernel registry (options: "gaussian",
+             * "cosine", "laplacian", "mahalanobis_diagonal")
              * @param[in] similarity_params: the parameters required by the
              * similarity function type:
              *    - Gaussian: {"sigma"}
+             *    - Cosine: {}
+             *    - Laplacian: {"sigma"}
+             *    - Mahalanobis (diagonal): the variance of each weighted
+             *      diversity descriptor element, keyed by field name
              */
             SimilarityFunction(
                 std::vector<std::string> diversity_descriptors,
@@ -107,7 +143,7 @@ namespace Synopsis {
              *
              * @return: vector diversity descriptor, with weights applied
              */
-            std::vector<double> _extract_dd(AsdpEntry asdp);
+            std::vector<double> _extract_dd(const AsdpEntry &asdp) const;
 
             /**
              * Compute the similarity function between two ASDPs.
@@ -117,11 +153,185 @@ namespace Synopsis {
              *
              * @return: similarity value between 0.0 and 1.0
              */
-            double get_similarity(AsdpEntry asdp1, AsdpEntry asdp2);
+            double get_similarity(const AsdpEntry &asdp1, const AsdpEntry &asdp2);
+
+            /**
+             * Resolves diversity descriptor fields and similarity parameters
+             * against an ASDP table, prior to computing similarities between
+             * rows of that table.
+             *
+             * @param[in] table: ASDP table
+             */
+            void bind(const AsdpTable &table);
+
+            /**
+             * Compute the similarity function between two ASDPs stored in a
+             * table to which this function is bound.
+             *
+             * @see SimilarityFunction::get_similarity
+             *
+             * @param[in] table: ASDP table
+             * @param[in] row1: table row of the first ASDP
+             * @param[in] row2: table row of the second ASDP
+             *
+             * @return: similarity value between 0.0 and 1.0
+             */
+            double get_similarity(const AsdpTable &table, int row1, int row2);
+
+            /**
+             * @return: number of diversity descriptor elements
+             */
+            int num_descriptors(void) const {
+                return this->_diversity_descriptors.size();
+            }
+
+            /**
+             * Sets how the maximum similarity to queued ASDPs is found. Index
+             * searches are only supported by the Gaussian similarity, which
+             * decreases monotonically with Euclidean distance between
+             * weighted diversity descriptors.
+             *
+             * @param[in] search: search method
+             * @param[in] epsilon: approximation factor of
+             * APPROXIMATE_INDEX_SEARCH; the distance to the queued ASDP found
+             * is at most (1 + epsilon) times the nearest distance
+             */
+            void set_max_similarity_search(
+                MaxSimilaritySearch search, double epsilon = 0.0
+            );
+
+            /**
+             * @return: whether the maximum similarity to queued ASDPs is
+             * found with a spatial index
+             */
+            bool is_indexed(void) const {
+                return this->_search != LINEAR_SEARCH;
+            }
+
+            /**
+             * @return: approximation factor of the index search, or zero for
+             * an exact search
+             */
+            double search_epsilon(void) const {
+                return (this->_search == APPROXIMATE_INDEX_SEARCH) ?
+                    this->_search_epsilon : 0.0;
+            }
+
+            /**
+             * Compute the similarity between two ASDPs whose weighted
+             * diversity descriptors are a given squared Euclidean distance
+             * apart
+             *
+             * @param[in] sq_dist: squared Euclidean distance
+             *
+             * @return: similarity value between 0.0 and 1.0
+             */
+            double similarity_from_sq_dist(double sq_dist) const;
+
+            /**
+             * Computes all pairwise similarities among a set of ASDPs stored
+             * in a table to which this function is bound. Weighted diversity
+             * descriptors are first extracted into a dense descriptor-major
+             * matrix, so that squared distances from one ASDP to all others
+             * are accumulated over contiguous memory. Each distance sums
+             * descriptor elements in the same order as
+             * SimilarityFunction::get_similarity, so values are identical.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] rows: table rows of the n ASDPs
+             * @param[out] descriptors: scratch buffer of at least n times
+             * `num_descriptors()` doubles
+             * @param[out] block: buffer of at least n * n doubles; entry
+             * `i * n + j` receives the similarity between `rows[i]` and
+             * `rows[j]`
+             */
+            void get_similarity_block(
+                const AsdpTable &table,
+                const std::vector<int> &rows,
+                double *descriptors,
+                double *block
+            );
+
+            /**
+             * First phase of `get_similarity_block`: accumulates the kernel's
+             * sums over descriptor elements (e.g., squared distances for the
+             * Gaussian kernel) into the upper triangle of the block. Sums do
+             * not depend on sigma.
+             *
+             * @see SimilarityFunction::get_similarity_block
+             * @see kernel_accumulate_block
+             */
+            void accumulate_block(
+                const AsdpTable &table,
+                const std::vector<int> &rows,
+                double *descriptors,
+                double *block
+            );
+
+            /**
+             * Second phase of `get_similarity_block`: converts the sums
+             * accumulated by `accumulate_block` (possibly by another function
+             * with the same descriptor and kernel) to similarities, in place
+             *
+             * @param[in] n: number of ASDPs
+             * @param[in,out] block: n * n block
+             */
+            void transform_block(int n, double *block);
+
+            /**
+             * Replaces the scale parameter of a Gaussian or Laplacian
+             * similarity; other similarities are unchanged
+             *
+             * @param[in] sigma: scale parameter
+             */
+            void set_sigma(double sigma);
 
 
         private:
 
+            /**
+             * Stores the table slots of diversity descriptor fields (or -1 for
+             * fields missing from the table) after binding
+             */
+            std::vector<int> _dd_slots;
+
+            /**
+             * Returns the kernel parameters of this function
+             */
+            KernelParams _kernel_params(void) const {
+                KernelParams params = {
+                    this->_sigma, this->_inv_variances.data()
+                };
+                return params;
+            }
+
+            /**
+             * Stores the similarity kernel and its pairwise form specialized
+             * for the number of diversity descriptor elements, resolved on
+             * construction
+             */
+            SimilarityKernel _kernel = UNKNOWN_KERNEL;
+            KernelFunction _kernel_function = nullptr;
+
+            /**
+             * Stores the Gaussian or Laplacian scale parameter, resolved on
+             * construction
+             */
+            double _sigma = 1.0;
+
+            /**
+             * Stores the inverse variance of each diversity descriptor element
+             * for the Mahalanobis kernel, resolved on construction
+             */
+            std::vector<double> _inv_variances;
+
+            /**
+             * Stores how the maximum similarity to queued ASDPs is found, and
+             * the approximation factor of an approximate index search
+             */
+            MaxSimilaritySearch _search = LINEAR_SEARCH;
+            double _search_epsilon = 0.0;
+
             /**
              * Stores field names to be used for extracting a diversity
              * descriptor
@@ -164,6 +374,199 @@ namespace Synopsis {
     using SimFuncMap = std::map<SimKey, SimilarityFunction>;
 
 
+    /**
+     * A k-d tree of points in a fixed number of dimensions, supporting
+     * insertion and nearest-neighbor distance queries. Points are not
+     * rebalanced, so insertion order should not be sorted along any
+     * dimension.
+     */
+    class KdTree {
+
+
+        public:
+
+            /**
+             * Constructs an empty tree
+             *
+             * @param[in] n_dims: number of dimensions of each point
+             */
+            KdTree(int n_dims = 0);
+
+            /**
+             * Default destructor
+             */
+            ~KdTree() = default;
+
+            /**
+             * Inserts a point
+             *
+             * @param[in] point: point with at least `n_dims` elements
+             */
+            void insert(const std::vector<double> &point);
+
+            /**
+             * Finds the squared Euclidean distance from a query point to its
+             * nearest point in the tree. An approximate search skips subtrees
+             * that cannot contain a point closer than the nearest distance
+             * divided by (1 + epsilon).
+             *
+             * @param[in] query: query point with at least `n_dims` elements
+             * @param[in] epsilon: approximation factor, or zero for an exact
+             * search
+             *
+             * @return: squared distance to the nearest point found, or
+             * infinity if the tree is empty
+             */
+            double nearest_sq_dist(
+                const std::vector<double> &query, double epsilon = 0.0
+            ) const;
+
+            /**
+             * @return: number of points in the tree
+             */
+            size_t size(void) const { return this->_nodes.size(); }
+
+
+        private:
+
+            /**
+             * A point and its children; each node splits on dimension
+             * (depth mod n_dims)
+             */
+            struct Node {
+                int left;
+                int right;
+            };
+
+            /**
+             * Searches the subtree rooted at a node
+             *
+             * @param[in] node: node index
+             * @param[in] depth: node depth
+             * @param[in] query: query point
+             * @param[in] shrink: squared factor by which the current best
+             * distance is divided when pruning
+             * @param[in,out] best: squared distance to the nearest point found
+             */
+            void _search(
+                int node, int depth, const std::vector<double> &query,
+                double shrink, double &best
+            ) const;
+
+            /**
+             * Number of dimensions of each point
+             */
+            int _n_dims;
+
+            /**
+             * Nodes in insertion order; node 0 is the root
+             */
+            std::vector<Node> _nodes;
+
+            /**
+             * Coordinates of each node's point, in node order
+             */
+            std::vector<double> _points;
+
+
+    };
+
+
+    /**
+     * Spatial index over the weighted diversity descriptors of ASDPs queued
+     * for downlink within one priority bin, with one tree per instrument/type
+     * key whose similarity function is indexed. ASDPs are added as they are
+     * queued, and maximum similarities to the queue are found in time
+     * sub-linear in the queue length. Queries do not modify the index, so
+     * they may run concurrently.
+     */
+    class MaxSimilarityIndex {
+
+
+        public:
+
+            /**
+             * Constructs an empty index; no ASDPs are indexed
+             */
+            MaxSimilarityIndex() = default;
+
+            /**
+             * Constructs an empty index for a priority bin
+             *
+             * @param[in] functions: similarity functions of the bin; must
+             * outlive the index
+             */
+            MaxSimilarityIndex(SimFuncMap &functions);
+
+            /**
+             * Default destructor
+             */
+            ~MaxSimilarityIndex() = default;
+
+            /**
+             * @return: whether any key is indexed
+             */
+            bool empty(void) const { return this->_trees.empty(); }
+
+            /**
+             * @param[in] asdp: ASDP
+             *
+             * @return: whether the maximum similarity of the ASDP to queued
+             * ASDPs is found with this index
+             */
+            bool is_indexed(const AsdpEntry &asdp) const;
+
+            /**
+             * Adds a queued ASDP; ASDPs whose key is not indexed are ignored
+             *
+             * @param[in] asdp: queued ASDP
+             */
+            void add(const AsdpEntry &asdp);
+
+            /**
+             * Computes the maximum similarity between a candidate ASDP and
+             * the queued ASDPs of the same key
+             *
+             * @see: Similarity::get_max_similarity
+             *
+             * @param[in] asdp: candidate ASDP, whose key is indexed
+             *
+             * @return: maximum similarity function value; with an approximate
+             * search, a lower bound within the approximation factor
+             */
+            double get_max_similarity(const AsdpEntry &asdp) const;
+
+
+        private:
+
+            /**
+             * The tree of one key and the similarity function that defines
+             * its points
+             */
+            struct KeyIndex {
+                const SimilarityFunction *function;
+                KdTree tree;
+            };
+
+            /**
+             * Looks up the index of an ASDP's key
+             *
+             * @param[in] asdp: ASDP
+             *
+             * @return: pointer to the key's index, or null if the key is not
+             * indexed
+             */
+            const KeyIndex *_find(const AsdpEntry &asdp) const;
+
+            /**
+             * Index of each indexed key
+             */
+            std::map<SimKey, KeyIndex> _trees;
+
+
+    };
+
+
     /**
      * Holds similarity configuration across priority bins
      */
@@ -213,8 +616,8 @@ namespace Synopsis {
              */
             double _get_cached_similarity(
                 SimilarityFunction &similarity_function,
-                AsdpEntry asdp1,
-                AsdpEntry asdp2
+                const AsdpEntry &asdp1,
+                const AsdpEntry &asdp2
             );
 
             /**
@@ -230,8 +633,8 @@ namespace Synopsis {
              */
             double get_max_similarity(
                 int bin,
-                AsdpList queue,
-                AsdpEntry asdp
+                const AsdpList &queue,
+                const AsdpEntry &asdp
             );
 
             /**
@@ -256,13 +659,199 @@ namespace Synopsis {
              */
             double get_discount_factor(
                 int bin,
-                AsdpList queue,
-                AsdpEntry asdp
+                const AsdpList &queue,
+                const AsdpEntry &asdp
             );
 
+            /**
+             * Computes the discount factor for a candidate ASDP given its
+             * maximum similarity to already-queued ASDPs. This allows callers
+             * that track the maximum similarity incrementally to avoid
+             * re-scanning the queue.
+             *
+             * @see: Similarity::get_discount_factor
+             *
+             * @param[in] bin: priority bin
+             * @param[in] max_similarity: maximum similarity between the
+             * candidate and any queued ASDP
+             *
+             * @return: ASDP discount factor
+             */
+            double get_discount_factor(int bin, double max_similarity);
+
+            /**
+             * Computes the similarity between a pair of ASDPs using the
+             * appropriate similarity function for the specified priority bin.
+             * ASDPs of differing instrument/type pairs, or those without a
+             * configured similarity function, have zero similarity.
+             *
+             * @param[in] bin: priority bin
+             * @param[in] asdp1: first ASDP
+             * @param[in] asdp2: second ASDP
+             *
+             * @return: similarity function value
+             */
+            double get_similarity(int bin, const AsdpEntry &asdp1, const AsdpEntry &asdp2);
+
+            /**
+             * Returns the alpha parameter used for the specified priority bin
+             *
+             * @param[in] bin: priority bin
+             *
+             * @return: alpha parameter value
+             */
+            double get_alpha(int bin);
+
+            /**
+             * Sets the alpha parameter used for the specified priority bin
+             *
+             * @param[in] bin: priority bin
+             * @param[in] alpha: alpha parameter value
+             */
+            void set_alpha(int bin, double alpha);
+
+            /**
+             * Sets the alpha parameter used for bins without their own value
+             *
+             * @param[in] alpha: alpha parameter value
+             */
+            void set_default_alpha(double alpha);
+
+            /**
+             * Replaces the scale parameter of every Gaussian or Laplacian
+             * similarity function, in every bin
+             *
+             * @see SimilarityFunction::set_sigma
+             *
+             * @param[in] sigma: scale parameter
+             */
+            void set_sigma(double sigma);
+
+            /**
+             * Enables or disables transmitted ASDPs as similarity context.
+             * When enabled, each candidate's maximum similarity starts from
+             * its maximum similarity to the already-transmitted ASDPs of the
+             * same priority bin and instrument/type, so that ASDPs similar to
+             * those already sent are discounted as if they were queued.
+             *
+             * @param[in] enabled: whether transmitted ASDPs are used
+             */
+            void set_transmitted_context(bool enabled) {
+                this->_transmitted_context = enabled;
+            }
+
+            /**
+             * @return: whether transmitted ASDPs are used as similarity context
+             */
+            bool uses_transmitted_context(void) const {
+                return this->_transmitted_context;
+            }
+
+            /**
+             * Binds all similarity functions to an ASDP table
+             *
+             * @see SimilarityFunction::bind
+             *
+             * @param[in] table: ASDP table
+             */
+            void bind(const AsdpTable &table);
+
+            /**
+             * Returns the similarity functions to use within a priority bin
+             * for each instrument/type key of a table
+             *
+             * @param[in] bin: priority bin
+             * @param[in] table: ASDP table to which functions are bound
+             *
+             * @return: pointers to the similarity function used for each key
+             * identifier of the table, or null for keys without a similarity
+             * function
+             */
+            std::vector<SimilarityFunction*> get_functions(
+                int bin, const AsdpTable &table
+            );
+
+            /**
+             * Returns an empty spatial index for finding maximum similarities
+             * within a priority bin, covering keys whose similarity function
+             * is indexed. The index refers to this configuration's functions.
+             *
+             * @param[in] bin: priority bin
+             *
+             * @return: spatial index, which is empty if no key is indexed
+             */
+            MaxSimilarityIndex get_index(int bin);
+
+            /**
+             * Returns a copy of this configuration with an empty similarity
+             * cache that also reads similarities cached by this configuration,
+             * so that copies used concurrently share previously computed
+             * similarities without copying them. This configuration's cache
+             * must not change while the copy is in use.
+             *
+             * @return: similarity configuration
+             */
+            Similarity fork(void) const;
+
+            /**
+             * Adds the similarities cached by another configuration, such as
+             * one returned by `fork`, to this configuration's cache
+             *
+             * @param[in] other: similarity configuration
+             */
+            void merge_cache(const Similarity &other);
+
+            /**
+             * Prepares the similarity cache for reuse with a new set of ASDPs.
+             * Cached similarities are removed for ASDPs that are not in the
+             * set, or whose similarity function or weighted diversity
+             * descriptor has changed since the previous invocation.
+             *
+             * @param[in] binned_asdps: ASDPs to be prioritized in each
+             * priority bin
+             */
+            void refresh_cache(const std::map<int, AsdpList> &binned_asdps);
+
+            /**
+             * @return: number of similarities in this configuration's cache
+             */
+            size_t cache_size(void) const { return this->_cache.size(); }
+
+            /**
+             * @return: number of similarities found in the cache (or in that
+             * of the configuration this one was forked from) since this
+             * configuration was created; copies start from the same count
+             */
+            size_t cache_hits(void) const { return this->_n_cache_hits; }
+
+            /**
+             * @return: number of similarities computed and added to the cache
+             * since this configuration was created; copies start from the same
+             * count
+             */
+            size_t cache_misses(void) const { return this->_n_cache_misses; }
+
 
         private:
 
+            /**
+             * The similarity function and weighted diversity descriptor of an
+             * ASDP when its similarities were cached
+             */
+            struct CachedDescriptor {
+                const SimilarityFunction *function;
+                std::vector<double> dd;
+            };
+
+            /**
+             * Returns the similarity functions configured for a priority bin
+             *
+             * @param[in] bin: priority bin
+             *
+             * @return: reference to the bin-specific or default function map
+             */
+            SimFuncMap &_get_functions(int bin);
+
             /**
              * Stores a mapping of priority bins to similarity function maps
              */
@@ -283,12 +872,35 @@ namespace Synopsis {
              */
             double _default_alpha;
 
+            /**
+             * Whether transmitted ASDPs are used as similarity context
+             */
+            bool _transmitted_context = false;
+
             /**
              * A cache to store previously computed pairwise similarities,
              * indexed by ASDP ID pairs sorted in increasing order
              */
             std::map<std::pair<int, int>, double> _cache;
 
+            /**
+             * Cache of the configuration from which this one was forked, or
+             * null
+             */
+            const std::map<std::pair<int, int>, double> *_shared_cache = nullptr;
+
+            /**
+             * Number of cache lookups that found and did not find a similarity
+             */
+            size_t _n_cache_hits = 0;
+            size_t _n_cache_misses = 0;
+
+            /**
+             * Descriptors of ASDPs as of the last `refresh_cache`, indexed by
+             * ASDP ID
+             */
+            std::map<int, CachedDescriptor> _descriptors;
+
             /**
              * Reference to the logger instance to be used by this module
              */
@@ -298,6 +910,171 @@ namespace Synopsis {
     };
 
 
+    /**
+     * Precomputed pairwise similarities among the ASDPs of one priority bin.
+     * ASDPs are grouped by instrument/type key, and a dense similarity block
+     * is stored for each key that has a similarity function, so that lookups
+     * during selection are array reads.
+     */
+    class SimilarityMatrix {
+
+
+        public:
+
+            /**
+             * Default constructor; gives an empty matrix
+             */
+            SimilarityMatrix() = default;
+
+            /**
+             * Default destructor
+             */
+            ~SimilarityMatrix() = default;
+
+            /**
+             * Returns the number of bytes required to store the matrix for a
+             * set of ASDPs, including scratch space for descriptors.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] rows: table rows of the bin's ASDPs
+             * @param[in] functions: similarity function for each key of the
+             * table, as returned by Similarity::get_functions
+             *
+             * @return: memory requirement in bytes
+             */
+            static size_t memory_requirement(
+                const AsdpTable &table,
+                const std::vector<int> &rows,
+                const std::vector<SimilarityFunction*> &functions
+            );
+
+            /**
+             * Computes the matrix for a set of ASDPs. Storage is taken from
+             * the provided memory block, which must hold at least
+             * `memory_requirement` bytes for the same arguments and must
+             * outlive the matrix.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] rows: table rows of the bin's ASDPs
+             * @param[in] functions: similarity function for each key of the
+             * table, as returned by Similarity::get_functions
+             * @param[in] memory: memory block for storage
+             */
+            void compute(
+                const AsdpTable &table,
+                const std::vector<int> &rows,
+                const std::vector<SimilarityFunction*> &functions,
+                void *memory
+            );
+
+            /**
+             * Accumulates the kernel sums of a set of ASDPs (the first phase
+             * of `compute`), so that matrices for several variants of the
+             * similarity functions' scale parameters can be derived with
+             * `transform` without recomputing them. The result holds sums
+             * rather than similarities and is only used as input to
+             * `transform`.
+             *
+             * @see SimilarityMatrix::compute
+             */
+            void accumulate(
+                const AsdpTable &table,
+                const std::vector<int> &rows,
+                const std::vector<SimilarityFunction*> &functions,
+                void *memory
+            );
+
+            /**
+             * Computes the matrix from sums accumulated by another matrix,
+             * using the given functions' parameters. The functions must have
+             * the same descriptors and kernels as those passed to
+             * `accumulate`. Values are identical to those of `compute` with
+             * the given functions.
+             *
+             * @param[in] sums: matrix populated by `accumulate`
+             * @param[in] functions: similarity function for each key of the
+             * table
+             * @param[in] memory: memory block for storage, of the size used
+             * by `sums`
+             */
+            void transform(
+                const SimilarityMatrix &sums,
+                const std::vector<SimilarityFunction*> &functions,
+                void *memory
+            );
+
+            /**
+             * Returns the similarity between two ASDPs of the bin. ASDPs of
+             * differing instrument/type keys, or those without a similarity
+             * function, have zero similarity.
+             *
+             * @param[in] idx1: index of the first ASDP within `rows`
+             * @param[in] idx2: index of the second ASDP within `rows`
+             *
+             * @return: similarity function value
+             */
+            double get_similarity(int idx1, int idx2) const {
+                int group = this->_groups[idx1];
+                if ((group != this->_groups[idx2]) ||
+                        (this->_blocks[group] == nullptr)) {
+                    return 0.0;
+                }
+                return this->_blocks[group][
+                    this->_positions[idx1] * this->_group_sizes[group] +
+                    this->_positions[idx2]
+                ];
+            }
+
+
+        private:
+
+            /**
+             * Groups the bin's ASDPs by key.
+             *
+             * @param[in] table: ASDP table
+             * @param[in] rows: table rows of the bin's ASDPs
+             * @param[out] members: table rows of each group's ASDPs
+             */
+            void _group(
+                const AsdpTable &table,
+                const std::vector<int> &rows,
+                std::vector<std::vector<int>> &members
+            );
+
+            /**
+             * Assigns blocks from a memory block to each group with a
+             * function
+             *
+             * @param[in] members: table rows of each group's ASDPs
+             * @param[in] functions: similarity function for each key
+             * @param[in] memory: memory block for storage
+             *
+             * @return: scratch space following the blocks
+             */
+            double *_assign_blocks(
+                const std::vector<std::vector<int>> &members,
+                const std::vector<SimilarityFunction*> &functions,
+                void *memory
+            );
+
+            /**
+             * Group (key identifier) and position within the group of each
+             * ASDP, indexed like `rows`
+             */
+            std::vector<int> _groups;
+            std::vector<int> _positions;
+
+            /**
+             * Number of ASDPs and similarity block of each group; blocks are
+             * null for keys without a similarity function
+             */
+            std::vector<int> _group_sizes;
+            std::vector<double*> _blocks;
+
+
+    };
+
+
     /**
      * Parse a similarity configuration file.
      *
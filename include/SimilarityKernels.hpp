@@ -0,0 +1,289 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides the similarity kernels available to similarity functions, and a
+ * registry that resolves a kernel by name and specializes it for a number of
+ * diversity descriptor elements known when a configuration is parsed.
+ *
+ * Each kernel sums over descriptor elements in increasing order, in both its
+ * pairwise and block forms, so that every planner engine computes identical
+ * similarities. Block forms vectorize across pairs of ASDPs instead.
+ *
+ * @see: Similarity.hpp
+ */
+#ifndef JPL_SYNOPSIS_SimilarityKernels
+#define JPL_SYNOPSIS_SimilarityKernels
+
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+
+namespace Synopsis {
+
+
+    /**
+     * Similarity kernels between weighted diversity descriptors x and y
+     */
+    typedef enum {
+        // Not a known kernel; all similarities are zero
+        UNKNOWN_KERNEL = 0,
+        // exp(-||x - y||^2 / sigma^2)
+        GAUSSIAN_KERNEL = 1,
+        // max(0, x . y / (||x|| ||y||)), or zero if either norm is zero
+        COSINE_KERNEL = 2,
+        // exp(-||x - y||_1 / sigma)
+        LAPLACIAN_KERNEL = 3,
+        // exp(-sum_d (x_d - y_d)^2 / variance_d)
+        MAHALANOBIS_DIAGONAL_KERNEL = 4
+    } SimilarityKernel;
+
+
+    /**
+     * Kernel parameters resolved from a similarity function's parameter map
+     */
+    struct KernelParams {
+
+        /**
+         * Scale parameter (sigma) of the Gaussian and Laplacian kernels
+         */
+        double sigma;
+
+        /**
+         * Inverse variance of each descriptor element for the Mahalanobis
+         * kernel, or null
+         */
+        const double *inv_variances;
+
+    };
+
+
+    /**
+     * Type alias for a kernel specialized for a number of descriptor
+     * elements; arguments are two descriptors, the number of elements, and
+     * the kernel parameters
+     */
+    using KernelFunction = double (*)(
+        const double*, const double*, int, const KernelParams&
+    );
+
+
+    /**
+     * Looks up a kernel in the registry by its configuration name ("gaussian",
+     * "cosine", "laplacian", or "mahalanobis_diagonal")
+     *
+     * @param[in] name: kernel name
+     *
+     * @return: kernel, or UNKNOWN_KERNEL
+     */
+    SimilarityKernel find_kernel(const std::string &name);
+
+
+    /**
+     * Returns a kernel's pairwise form, specialized with a compile-time
+     * number of descriptor elements if one is available for `n_dims`
+     *
+     * @param[in] kernel: kernel
+     * @param[in] n_dims: number of descriptor elements
+     *
+     * @return: pairwise kernel function
+     */
+    KernelFunction specialize_kernel(SimilarityKernel kernel, int n_dims);
+
+
+    /**
+     * Converts a kernel's accumulated sum over descriptor elements to a
+     * similarity
+     *
+     * @param[in] acc: accumulated sum; the dot product for the cosine kernel,
+     * or the (weighted) distance for other kernels
+     * @param[in] norms: product of the descriptors' squared norms, for the
+     * cosine kernel
+     * @param[in] params: kernel parameters
+     *
+     * @return: similarity value between 0.0 and 1.0
+     */
+    template <SimilarityKernel K>
+    double kernel_transform(
+        double acc, double norms, const KernelParams &params
+    ) {
+        switch (K) {
+            case GAUSSIAN_KERNEL:
+                return exp(-(acc / (params.sigma * params.sigma)));
+            case COSINE_KERNEL:
+                if (norms <= 0.0) { return 0.0; }
+                return std::max(0.0, acc / sqrt(norms));
+            case LAPLACIAN_KERNEL:
+                return exp(-(acc / params.sigma));
+            case MAHALANOBIS_DIAGONAL_KERNEL:
+                return exp(-acc);
+            default:
+                return 0.0;
+        }
+    }
+
+
+    /**
+     * Pairwise form of a kernel. With N > 0, the number of descriptor
+     * elements is the compile-time constant N and `n` is ignored, so inner
+     * loops have constant trip counts and can be unrolled.
+     *
+     * @param[in] x: first descriptor
+     * @param[in] y: second descriptor
+     * @param[in] n: number of descriptor elements, if N is zero
+     * @param[in] params: kernel parameters
+     *
+     * @return: similarity value between 0.0 and 1.0
+     */
+    template <SimilarityKernel K, int N>
+    double kernel_similarity(
+        const double *x, const double *y, int n, const KernelParams &params
+    ) {
+        const int count = (N > 0) ? N : n;
+
+        if (K == COSINE_KERNEL) {
+            double dot = 0.0;
+            double norm_x = 0.0;
+            double norm_y = 0.0;
+            for (int d = 0; d < count; d++) {
+                dot += (x[d] * y[d]);
+                norm_x += (x[d] * x[d]);
+                norm_y += (y[d] * y[d]);
+            }
+            return kernel_transform<K>(dot, norm_x * norm_y, params);
+        }
+
+        double acc = 0.0;
+        for (int d = 0; d < count; d++) {
+            double diff = x[d] - y[d];
+            if (K == LAPLACIAN_KERNEL) {
+                acc += fabs(diff);
+            } else if (K == MAHALANOBIS_DIAGONAL_KERNEL) {
+                acc += ((diff * diff) * params.inv_variances[d]);
+            } else {
+                acc += (diff * diff);
+            }
+        }
+        return kernel_transform<K>(acc, 0.0, params);
+    }
+
+
+    /**
+     * First phase of a kernel's block form: accumulates the kernel's sum over
+     * descriptor elements (see `kernel_transform`) for all pairs among n
+     * descriptors stored in descriptor-major order. For each ASDP, the inner
+     * loop accumulates one descriptor element against all later ASDPs over
+     * contiguous memory and is independent across them, so it vectorizes.
+     *
+     * Only the upper triangle, including the diagonal, is written; for the
+     * cosine kernel the diagonal holds each descriptor's squared norm. Sums
+     * do not depend on the scale parameter sigma, so they may be transformed
+     * with several values of it.
+     *
+     * @param[in] descriptors: n_dims columns of n descriptor elements each
+     * @param[in] n: number of descriptors
+     * @param[in] n_dims: number of descriptor elements
+     * @param[in] params: kernel parameters
+     * @param[out] block: n * n sums; entry `i * n + j`, for i <= j, receives
+     * the sum for descriptors i and j
+     */
+    template <SimilarityKernel K>
+    void kernel_accumulate_block(
+        const double *descriptors, int n, int n_dims,
+        const KernelParams &params, double *block
+    ) {
+        for (int i = 0; i < n; i++) {
+            double *acc = block + (i * n);
+            for (int j = i; j < n; j++) {
+                acc[j] = 0.0;
+            }
+            for (int d = 0; d < n_dims; d++) {
+                const double *column = descriptors + (d * n);
+                double x = column[i];
+                if (K == COSINE_KERNEL) {
+                    for (int j = i; j < n; j++) {
+                        acc[j] += (x * column[j]);
+                    }
+                } else if (K == LAPLACIAN_KERNEL) {
+                    for (int j = i; j < n; j++) {
+                        acc[j] += fabs(x - column[j]);
+                    }
+                } else if (K == MAHALANOBIS_DIAGONAL_KERNEL) {
+                    double inv_variance = params.inv_variances[d];
+                    for (int j = i; j < n; j++) {
+                        double diff = x - column[j];
+                        acc[j] += ((diff * diff) * inv_variance);
+                    }
+                } else {
+                    for (int j = i; j < n; j++) {
+                        double diff = x - column[j];
+                        acc[j] += (diff * diff);
+                    }
+                }
+            }
+        }
+    }
+
+
+    /**
+     * Second phase of a kernel's block form: converts the sums accumulated by
+     * `kernel_accumulate_block` to similarities, in place
+     *
+     * @param[in] n: number of descriptors
+     * @param[in] params: kernel parameters
+     * @param[in,out] block: n * n entries, of which the upper triangle holds
+     * sums on input; on output, entry `i * n + j` holds the similarity
+     * between descriptors i and j
+     */
+    template <SimilarityKernel K>
+    void kernel_transform_block(
+        int n, const KernelParams &params, double *block
+    ) {
+        // The block is symmetric, and diagonal entries are converted last
+        // since cosine similarities read them
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                double norms = block[(i * n) + i] * block[(j * n) + j];
+                double similarity = kernel_transform<K>(
+                    block[(i * n) + j], norms, params
+                );
+                block[(i * n) + j] = similarity;
+                block[(j * n) + i] = similarity;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            double &diagonal = block[(i * n) + i];
+            diagonal = kernel_transform<K>(
+                diagonal, diagonal * diagonal, params
+            );
+        }
+    }
+
+
+    /**
+     * Block form of a kernel: computes all pairwise similarities among n
+     * descriptors stored in descriptor-major order. Values are identical to
+     * those of `kernel_similarity`.
+     *
+     * @param[in] descriptors: n_dims columns of n descriptor elements each
+     * @param[in] n: number of descriptors
+     * @param[in] n_dims: number of descriptor elements
+     * @param[in] params: kernel parameters
+     * @param[out] block: n * n similarities; entry `i * n + j` receives the
+     * similarity between descriptors i and j
+     */
+    template <SimilarityKernel K>
+    void kernel_similarity_block(
+        const double *descriptors, int n, int n_dims,
+        const KernelParams &params, double *block
+    ) {
+        kernel_accumulate_block<K>(descriptors, n, n_dims, params, block);
+        kernel_transform_block<K>(n, params, block);
+    }
+
+
+};
+
+
+#endif
@@ -8,29 +8,97 @@
 #ifndef JPL_SYNOPSIS_SqliteASDPDB
 #define JPL_SYNOPSIS_SqliteASDPDB
 #include <string>
+#include <memory>
+#include <cstdint>
 #include <sqlite3.h>
 
 #include "ASDPDB.hpp"
+#include "Sqlite3Statement.hpp"
 
 
 namespace Synopsis {
 
 
     /**
-     * SQLite ASDPDB Implementation
+     * SQLite synchronous levels, which trade durability upon power loss for
+     * write performance
+     *
+     * @see https://www.sqlite.org/pragma.html#pragma_synchronous
+     */
+    typedef enum {
+        SYNCHRONOUS_OFF = 0,
+        SYNCHRONOUS_NORMAL = 1,
+        SYNCHRONOUS_FULL = 2,
+        SYNCHRONOUS_EXTRA = 3
+    } SqliteSynchronous;
+
+
+    /**
+     * Durability/performance profile applied to a SQLite ASDPDB connection
+     * when it is initialized. The defaults match SQLite's own defaults.
+     */
+    struct SqliteProfile {
+
+        /**
+         * Whether to use write-ahead log journaling, which allows readers and
+         * a writer to proceed concurrently; this setting persists in the
+         * database file
+         */
+        bool wal_journal = false;
+
+        /**
+         * Maximum number of bytes of the database file to memory-map, or zero
+         * to disable memory-mapped I/O
+         */
+        int64_t mmap_size_bytes = 0;
+
+        /**
+         * Page cache size in KiB, or zero for SQLite's default
+         */
+        int cache_size_kib = 0;
+
+        /**
+         * Synchronous level
+         */
+        SqliteSynchronous synchronous = SYNCHRONOUS_FULL;
+
+    };
+
+
+    /**
+     * SQLite ASDPDB Implementation. Each query is prepared once when the
+     * database is initialized and reused by subsequent calls, so an instance
+     * must not be used concurrently from multiple threads.
      */
     class SqliteASDPDB : public ASDPDB {
 
 
         public:
 
+            /**
+             * Size in bytes of each lookaside memory slot used by SQLite for
+             * small allocations (e.g., of prepared statements)
+             */
+            static const int LOOKASIDE_SLOT_SIZE = 1200;
+
+            /**
+             * Version of the database schema, stored in the SQLite
+             * `user_version` header field; databases with older schemas are
+             * migrated in place when initialized
+             */
+            static const int SCHEMA_VERSION = 2;
+
             /**
              * Constructs an ASDPDB instance
              *
              * @param[in] asdpdb_file: path to database file on disk (it will
              * be created if it does not exist)
+             * @param[in] lookaside_bytes: size of the memory block, provided
+             * at initialization, that SQLite uses for small allocations of
+             * the connection such as prepared statements; if zero (the
+             * default), SQLite manages this memory itself
              */
-            SqliteASDPDB(std::string asdpdb_file);
+            SqliteASDPDB(std::string asdpdb_file, size_t lookaside_bytes = 0);
 
             /**
              * Default virtual destructor
@@ -38,7 +106,16 @@ namespace Synopsis {
             virtual ~SqliteASDPDB();
 
             /**
-             * Returns the number of bytes of memory required by the module.
+             * Sets the profile applied to the connection; must be called
+             * prior to initialization.
+             *
+             * @param[in] profile: durability/performance profile
+             */
+            void set_profile(const SqliteProfile &profile);
+
+            /**
+             * Returns the number of bytes of memory required by the module,
+             * which is the lookaside memory size given at construction.
              *
              * @return: memory required in bytes
              */
@@ -52,8 +129,10 @@ namespace Synopsis {
              * application at the time the application is initialized.
              *
              * During initialization, a connection to the database will be
-             * opened, and the database schema will be created if the file did
-             * not already exist.
+             * opened and configured according to the profile, the database
+             * schema will be created if the file did not already exist (or
+             * migrated if it has an older version), and all queries will be
+             * prepared.
              *
              * @param[in] bytes: number of bytes in memory block
              * @param[in] memory: pointer to memory block
@@ -66,8 +145,8 @@ namespace Synopsis {
 
             /**
              * De-initializes the ASDPDB; the provided memory block will no
-             * longer be used by the module, and the connection to the database
-             * will be closed.
+             * longer be used by the module, prepared queries will be
+             * finalized, and the connection to the database will be closed.
              *
              * @return: SUCCESS if de-initialization was successful, or error
              * code
@@ -79,6 +158,25 @@ namespace Synopsis {
              */
             Status insert_data_product(DpDbMsg& msg);
 
+            /**
+             * Begins a SQLite transaction; all operations until the batch is
+             * committed or rolled back, including inserts, are part of the
+             * same transaction and are made durable with a single commit.
+             *
+             * @see ASDPDB::begin_batch
+             */
+            Status begin_batch(void);
+
+            /**
+             * @see ASDPDB::commit_batch
+             */
+            Status commit_batch(void);
+
+            /**
+             * @see ASDPDB::rollback_batch
+             */
+            Status rollback_batch(void);
+
             /**
              * @see ASDPDB::get_data_product
              */
@@ -89,6 +187,23 @@ namespace Synopsis {
              */
             std::vector<int> list_data_product_ids(void);
 
+            /**
+             * Fetches all ASDPs and their metadata using two scans ordered
+             * by ASDP identifier, filtering downlinked ASDPs within SQL.
+             *
+             * @see ASDPDB::list_undownlinked_data_products
+             */
+            Status list_undownlinked_data_products(std::vector<DpDbMsg> &msgs);
+
+            /**
+             * Fetches a bin's ASDPs and their metadata as with
+             * `list_undownlinked_data_products`, using the priority bin index.
+             *
+             * @see ASDPDB::list_undownlinked_data_products_in_bin
+             */
+            Status list_undownlinked_data_products_in_bin(
+                int priority_bin, std::vector<DpDbMsg> &msgs);
+
             /**
              * @see ASDPDB::update_science_utility
              */
@@ -139,11 +254,85 @@ namespace Synopsis {
 
         private:
 
+            /**
+             * Prepares all queries, returning SUCCESS or error code
+             */
+            Status _prepare_statements(void);
+
+            /**
+             * Creates the schema for a new database, or migrates the schema
+             * of an existing database to the current version, returning
+             * SUCCESS or error code
+             */
+            Status _init_schema(void);
+
+            /**
+             * Applies the profile to the open connection, returning SUCCESS
+             * or error code
+             */
+            Status _apply_profile(void);
+
+            /**
+             * Logs an error if the database is not initialized
+             *
+             * @param[in] operation: description of the attempted operation
+             *
+             * @return: whether the database is initialized
+             */
+            bool _check_initialized(const std::string &operation);
+
+            /**
+             * Finalizes all prepared queries
+             */
+            void _finalize_statements(void);
+
+            /**
+             * Fetches ASDPs and their metadata from two bound queries, each
+             * ordered by ASDP identifier, returning SUCCESS or error code
+             *
+             * @param[in] stmt: query for ASDP fields
+             * @param[in] stmt2: query for the metadata of the same ASDPs
+             * @param[out] msgs: list to which ASDP information is appended
+             */
+            Status _fetch_data_products(
+                Sqlite3Statement &stmt, Sqlite3Statement &stmt2,
+                std::vector<DpDbMsg> &msgs);
+
             /**
              * ASDPDB file path
              */
             std::string asdpdb_file;
 
+            /**
+             * Size of the lookaside memory block, or zero
+             */
+            size_t _lookaside_bytes;
+
+            /**
+             * Durability/performance profile
+             */
+            SqliteProfile _profile;
+
+            /**
+             * Queries prepared at initialization
+             *
+             * @see synopsis_sql.hpp
+             */
+            std::unique_ptr<Sqlite3Statement> _asdp_insert;
+            std::unique_ptr<Sqlite3Statement> _fieldname_insert;
+            std::unique_ptr<Sqlite3Statement> _asdp_metadata_insert;
+            std::unique_ptr<Sqlite3Statement> _asdp_select;
+            std::unique_ptr<Sqlite3Statement> _asdp_get;
+            std::unique_ptr<Sqlite3Statement> _asdp_metadata_get;
+            std::unique_ptr<Sqlite3Statement> _asdp_select_state;
+            std::unique_ptr<Sqlite3Statement> _asdp_metadata_select_state;
+            std::unique_ptr<Sqlite3Statement> _asdp_select_bin_state;
+            std::unique_ptr<Sqlite3Statement> _asdp_metadata_select_bin_state;
+            std::unique_ptr<Sqlite3Statement> _update_sue;
+            std::unique_ptr<Sqlite3Statement> _update_bin;
+            std::unique_ptr<Sqlite3Statement> _update_dl_state;
+            std::unique_ptr<Sqlite3Statement> _update_metadata;
+
             /**
              * Holds an open SQLite DB connection after initialization
              */
@@ -0,0 +1,126 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a fixed-size pool of worker threads used to run independent
+ * prioritization tasks concurrently.
+ */
+#ifndef JPL_SYNOPSIS_ThreadPool
+#define JPL_SYNOPSIS_ThreadPool
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+namespace Synopsis {
+
+
+    /**
+     * Type alias for a task run by a thread pool
+     */
+    using PoolTask = std::function<void(void)>;
+
+
+    class ThreadPool {
+
+
+        public:
+
+            /**
+             * Constructs a pool and starts its worker threads
+             *
+             * @param[in] n_workers: number of worker threads; with zero
+             * workers, tasks are run by the calling thread
+             */
+            ThreadPool(int n_workers);
+
+            /**
+             * Stops and joins all worker threads
+             */
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool &operator=(const ThreadPool&) = delete;
+
+            /**
+             * @return: number of worker threads
+             */
+            int num_workers(void) const { return this->_workers.size(); }
+
+            /**
+             * Runs a batch of tasks and waits for all of them to complete.
+             * While waiting, the calling thread also runs queued tasks, so a
+             * task may itself call `run` without deadlocking the pool or
+             * starting additional threads.
+             *
+             * @param[in] tasks: tasks to run; tasks must not throw
+             */
+            void run(std::vector<PoolTask> &tasks);
+
+
+        private:
+
+            /**
+             * A queued task and the counter of its batch's remaining tasks
+             */
+            struct QueuedTask {
+                PoolTask *task;
+                int *remaining;
+            };
+
+            /**
+             * Main loop of each worker thread
+             */
+            void _work(void);
+
+            /**
+             * Runs a queued task with the lock released, then marks it done
+             *
+             * @param[in] lock: lock held on the pool mutex
+             * @param[in] queued: task to run
+             */
+            void _run_task(std::unique_lock<std::mutex> &lock, QueuedTask queued);
+
+            /**
+             * Guards the queue, batch counters, and stop flag
+             */
+            std::mutex _mutex;
+
+            /**
+             * Signalled when tasks are queued or the pool is stopped
+             */
+            std::condition_variable _task_available;
+
+            /**
+             * Signalled when a task completes, or when tasks are queued that
+             * waiting callers may help with
+             */
+            std::condition_variable _task_done;
+
+            /**
+             * Tasks waiting to be run
+             */
+            std::deque<QueuedTask> _queue;
+
+            /**
+             * Worker threads
+             */
+            std::vector<std::thread> _workers;
+
+            /**
+             * Whether the pool is being destroyed
+             */
+            bool _stop = false;
+
+
+    };
+
+
+};
+
+
+#endif
@@ -49,6 +49,12 @@ namespace Synopsis {
              */
             bool is_expired(void);
 
+            /**
+             * @return: time left before the timer expires (negative once it
+             * has expired), or the full duration if it has not been started
+             */
+            double remaining(void);
+
 
         private:
 
@@ -72,6 +78,59 @@ namespace Synopsis {
     };
 
 
+    /**
+     * Measures a phase of processing, adding the time elapsed between
+     * construction and `stop` (or destruction) to an accumulator. A null
+     * accumulator disables the timer, in which case the clock is never read.
+     */
+    class PhaseTimer {
+
+
+        public:
+
+            /**
+             * Constructs and starts a phase timer
+             *
+             * @param[in] clock: clock instance to use for timing
+             * @param[out] elapsed_sec: accumulator to which the elapsed time
+             * is added, or null to disable the timer
+             */
+            PhaseTimer(Clock *clock, double *elapsed_sec);
+
+            /**
+             * Stops the timer, if it has not been stopped
+             */
+            ~PhaseTimer();
+
+            /**
+             * Stops the timer and adds the elapsed time to the accumulator;
+             * subsequent calls have no effect
+             */
+            void stop(void);
+
+
+        private:
+
+            /**
+             * Holds a pointer to the clock instance
+             */
+            Clock *_clock;
+
+            /**
+             * Accumulator for the elapsed time, or null once stopped or if
+             * disabled
+             */
+            double *_elapsed_sec;
+
+            /**
+             * The start time of the phase, as provided by the clock instance
+             */
+            double _start_time = 0.0;
+
+
+    };
+
+
 };
 
 
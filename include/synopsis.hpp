@@ -11,6 +11,12 @@
 #include <string>
 #include <tuple>
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
 
 #include "synopsis_types.hpp"
 #include "DpMsg.hpp"
@@ -22,11 +28,20 @@
 #include "Logger.hpp"
 #include "Clock.hpp"
 #include "DownlinkPlanner.hpp"
+#include "IngestQueue.hpp"
+#include "DpBundle.hpp"
 
 /**
- * Maximum number of ASDSs that can be registered to an application instance
+ * Maximum number of ASDSs that can be registered to an application instance,
+ * or zero for no limit. With a limit, `add_asds` fails beyond it, and the
+ * registration list and dispatch index are sized for it when the application
+ * is constructed or an instrument or type is first registered, so they do
+ * not grow afterward. This storage comes from the heap, not from the memory
+ * block passed to `init`.
  */
-#define MAX_SYNOPSIS_APP_ASDS 32
+#ifndef MAX_SYNOPSIS_APP_ASDS
+#define MAX_SYNOPSIS_APP_ASDS 0
+#endif
 
 /**
  * Word size for memory alignment
@@ -55,9 +70,12 @@ namespace Synopsis {
             Application(ASDPDB *db, DownlinkPlanner *planner, Logger *logger, Clock *clock);
 
             /**
-             * Default destructor
+             * Destructor; stops the ingest worker if it is running
              */
-            ~Application() = default;
+            ~Application();
+
+            Application(const Application&) = delete;
+            Application &operator=(const Application&) = delete;
 
             /**
              * Returns the number of bytes of memory required by the
@@ -127,11 +145,127 @@ namespace Synopsis {
              * name and data product type in the message will be used to route
              * the data product to the appropriate ASDS.
              *
+             * With asynchronous ingest enabled (see `set_async_ingest`), the
+             * message is only queued for the ingest worker, and processing
+             * errors are reported by `flush_dp_queue`.
+             *
+             * @param[in] msg: data product message instance
+             *
+             * @return: SUCCESS if message was successfully accepted, BUSY if
+             * the ingest queue is full, or error
+             */
+            Status accept_dp(const DpMsg &msg);
+
+            /**
+             * Accepts an incoming data product message, as with
+             * `accept_dp(const DpMsg&)`, moving the message into the ingest
+             * queue or the last ASDS that processes it rather than copying it.
+             * If BUSY is returned, the message is left unchanged.
+             *
              * @param[in] msg: data product message instance
              *
-             * @return: SUCCESS if message was successfully accepted, or error
+             * @return: SUCCESS if message was successfully accepted, BUSY if
+             * the ingest queue is full, or error
+             */
+            Status accept_dp(DpMsg &&msg);
+
+            /**
+             * Accepts a batch of incoming data product messages, as with
+             * `accept_dp`, within a single database batch so that all
+             * resulting ASDPs are committed together. If any message is not
+             * successfully accepted, the batch is rolled back and none of the
+             * messages' ASDPs are kept. Any pending group commit is committed
+             * first.
+             *
+             * @param[in] msgs: data product message instances
+             *
+             * @return: SUCCESS if all messages were accepted and committed, or
+             * error
+             */
+            Status accept_dp_batch(const std::vector<DpMsg> &msgs);
+
+            /**
+             * Enables group commit for data products accepted via
+             * `accept_dp`. Accepted products are buffered in an open database
+             * batch, which is committed once `max_products` are pending, upon
+             * the first arrival at least `max_delay_sec` after the batch was
+             * opened, or when `commit_dp_batch`, `prioritize`, or `deinit` is
+             * called. A product that fails to be accepted is rolled back
+             * individually; if a commit fails, all pending products of that
+             * batch are rolled back.
+             *
+             * @param[in] max_products: maximum number of pending products;
+             * zero (the default) disables group commit
+             * @param[in] max_delay_sec: maximum age of a batch, checked upon
+             * arrival of each product; zero for no time bound
+             */
+            void set_group_commit(int max_products, double max_delay_sec);
+
+            /**
+             * Commits any data products pending due to group commit.
+             *
+             * @return: SUCCESS if no products were pending or they were
+             * successfully committed, or error
+             */
+            Status commit_dp_batch(void);
+
+            /**
+             * Enables asynchronous ingest, to be called prior to
+             * initialization. Messages passed to `accept_dp` are then placed
+             * in a bounded, lock-free queue, and a worker thread started by
+             * `init` routes them to the ASDSs, committing all products queued
+             * at the time (at most the group commit size, if set) within one
+             * database batch.
+             *
+             * Products accepted asynchronously are visible to the other
+             * functions of the application once `flush_dp_queue` returns;
+             * `prioritize`, `accept_dp_batch`, and `deinit` flush the queue
+             * first.
+             *
+             * @param[in] queue_capacity: minimum number of messages the queue
+             * holds before `accept_dp` returns BUSY; zero (the default)
+             * disables asynchronous ingest
+             */
+            void set_async_ingest(size_t queue_capacity);
+
+            /**
+             * Waits until all messages queued by `accept_dp` have been
+             * processed and committed.
+             *
+             * @return: SUCCESS if all products processed since the previous
+             * flush were accepted and committed, or the error of the latest
+             * that was not
+             */
+            Status flush_dp_queue(void);
+
+            /**
+             * Inserts an already-processed ASDP directly into the ASDP DB,
+             * bypassing ASDS routing, to be called in response to a
+             * ground-commanded ingest.
+             *
+             * @param[in,out] msg: ASDP information; its identifier is set to
+             * that of the inserted ASDP
+             *
+             * @return: SUCCESS if successfully inserted, or error
              */
-            Status accept_dp(DpMsg msg);
+            Status insert_data_product(DpDbMsg &msg);
+
+            /**
+             * Inserts all already-processed ASDPs of a bundle directly into
+             * the ASDP DB within a single database batch, bypassing ASDS
+             * routing, for bulk ingest and ground replays. Either all ASDPs
+             * are inserted or none are; they are assigned new identifiers.
+             * Any pending group commit or queued messages are committed first.
+             *
+             * @param[in] bundle: open bundle
+             * @param[out] asdp_ids: if non-null, identifiers of the inserted
+             * ASDPs, in bundle order
+             *
+             * @return: SUCCESS if all ASDPs were inserted, or error
+             */
+            Status ingest_bundle(
+                const DpBundle &bundle, std::vector<int> *asdp_ids = nullptr
+            );
 
             /**
              * Updates the science utility estimate of an ASDP, to be called in
@@ -199,6 +333,20 @@ namespace Synopsis {
              */
             Status get_data_product(int asdp_id, DpDbMsg& msg);
 
+            /**
+             * Fetches data product information as loaded by the last
+             * prioritization, if the planner keeps loaded entries (see
+             * DownlinkPlanner::set_keep_entries), or otherwise from the
+             * database.
+             *
+             * @param[in] asdp_id: ASDP for which information should be fetched
+             * @param[out] msg: message that will be populated with ASDP
+             * information
+             *
+             * @return: SUCCESS if successfully fetched, or error code
+             */
+            Status get_planned_data_product(int asdp_id, DpDbMsg& msg);
+
             /**
              * Prioritize the data products in the ASDP DB, given a set of
              * rules and configuration for similarity-based discounts.
@@ -213,7 +361,9 @@ namespace Synopsis {
              * prioritized list of ASDPs, specified using their IDs
              *
              * @return: SUCCESS if prioritization completed, TIMEOUT if the
-             * time expired, or other error code upon failure
+             * time expired (in which case the list holds the ASDPs prioritized
+             * so far, a prefix of the full ordering), or other error code upon
+             * failure
              */
             Status prioritize(
                 std::string rule_configuration_id,
@@ -222,6 +372,71 @@ namespace Synopsis {
                 std::vector<int> &prioritized_list
             );
 
+            /**
+             * Prioritize the data products in the ASDP DB within a downlink
+             * budget, producing the manifest of ASDPs to downlink and the cut
+             * point, the first ASDP that does not fit.
+             *
+             * @see DownlinkPlanner::prioritize_with_budget
+             *
+             * @param[in] rule_configuration_id: rule and constraint
+             * configuration (e.g., URI of JSON on filesystem)
+             * @param[in] similarity_configuration_id: similarity-based
+             * discount configuration (e.g., URI of JSON on filesystem)
+             * @param[in] max_processing_time_sec: the prioritization algorithm
+             * should time-out after this amount of time has passed
+             * @param[in] max_bytes: total size of the ASDPs in the manifest,
+             * or a negative value for no byte budget
+             * @param[in] max_count: number of ASDPs in the manifest, or a
+             * negative value for no count budget
+             * @param[out] prioritized_list: this list will be populated with
+             * the manifest, a prefix of the full prioritization
+             * @param[out] cut_asdp_id: set to the ID of the first ASDP that
+             * did not fit within the budget, or -1 if all ASDPs fit
+             *
+             * @return: SUCCESS if the manifest is complete, TIMEOUT if the
+             * time expired before the budget was filled, or other error code
+             * upon failure
+             */
+            Status prioritize_with_budget(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                long max_bytes, int max_count,
+                std::vector<int> &prioritized_list,
+                int &cut_asdp_id
+            );
+
+            /**
+             * Prioritize the data products in the ASDP DB, passing each
+             * priority bin's ordering to a callback as soon as it is final, in
+             * bin order. Prioritization runs on a separate thread that locks
+             * the ASDP DB until it completes; the callback is called from the
+             * calling thread without the lock, so it may call other functions
+             * of this application, though those that access the ASDP DB wait
+             * for prioritization to complete.
+             *
+             * @see DownlinkPlanner::prioritize_streaming
+             *
+             * @param[in] rule_configuration_id: rule and constraint
+             * configuration (e.g., URI of JSON on filesystem)
+             * @param[in] similarity_configuration_id: similarity-based
+             * discount configuration (e.g., URI of JSON on filesystem)
+             * @param[in] max_processing_time_sec: the prioritization algorithm
+             * should time-out after this amount of time has passed
+             * @param[in] on_bin: callback receiving each bin's ordering
+             *
+             * @return: SUCCESS if prioritization completed, TIMEOUT if the
+             * time expired (in which case the last bin received holds a prefix
+             * of its ordering), or other error code upon failure
+             */
+            Status prioritize_streaming(
+                std::string rule_configuration_id,
+                std::string similarity_configuration_id,
+                double max_processing_time_sec,
+                const BinCallback &on_bin
+            );
+
 
         private:
 
@@ -258,15 +473,134 @@ namespace Synopsis {
             Clock *_clock;
 
             /**
-             * The number of ASDS instances registered to the application.
+             * Tuples holding pointers to the ASDSs associated with each
+             * instrument and data type pair, in registration order.
+             */
+            std::vector<std::tuple<std::string, std::string, ASDS*>> asds;
+
+            /**
+             * The ASDSs registered for one instrument: those registered for
+             * any data type, and for each registered data type, those that
+             * process it (including those for any type), in registration
+             * order
+             */
+            struct AsdsDispatch {
+                std::vector<ASDS*> any_type;
+                std::unordered_map<std::string, std::vector<ASDS*>> by_type;
+            };
+
+            /**
+             * Dispatch index of registered ASDSs by instrument name
+             */
+            std::unordered_map<std::string, AsdsDispatch> _dispatch;
+
+            /**
+             * Maximum number of pending products for group commit, or zero
+             */
+            int _group_commit_size;
+
+            /**
+             * Maximum age of a group commit batch, or zero
+             */
+            double _group_commit_delay;
+
+            /**
+             * Whether a group commit batch is open, the number of products it
+             * holds, and the time it was opened
+             */
+            bool _group_open;
+            int _n_pending_dps;
+            double _group_start_time;
+
+            /**
+             * Minimum ingest queue capacity, or zero for synchronous ingest
+             */
+            size_t _ingest_capacity;
+
+            /**
+             * Queue of messages accepted asynchronously, and the worker that
+             * processes them
+             */
+            std::unique_ptr<IngestQueue> _ingest_queue;
+            std::thread _ingest_worker;
+
+            /**
+             * Guards database access by the ingest worker and by this
+             * application while the worker runs, along with the ingest
+             * counters below
+             */
+            std::mutex _db_mutex;
+
+            /**
+             * Number of messages processed by the ingest worker, and the
+             * latest error since the queue was last flushed
+             */
+            size_t _n_ingested;
+            Status _ingest_status;
+
+            /**
+             * Signalled when the ingest worker has processed a batch
+             */
+            std::condition_variable _ingest_done;
+
+            /**
+             * Guards waiting by the ingest worker for new messages, and the
+             * flag that stops it; kept separate from the database mutex so
+             * that waking the worker never waits for database access
+             */
+            std::mutex _wake_mutex;
+            std::condition_variable _ingest_wake;
+            std::atomic<bool> _ingest_waiting;
+            bool _ingest_stop;
+
+            /**
+             * Routes an incoming data product message to the ASDSs registered
+             * for its instrument and type. The message is moved into the last
+             * ASDS, so it must not be used afterwards.
+             *
+             * @see accept_dp
+             */
+            Status _route_dp(DpMsg &msg);
+
+            /**
+             * Commits any data products pending due to group commit; the
+             * caller must hold the database mutex if the ingest worker runs
+             *
+             * @see commit_dp_batch
+             */
+            Status _commit_dp_batch(void);
+
+            /**
+             * Wakes the ingest worker, if it is waiting, after a message has
+             * been queued
+             */
+            void _notify_ingest_worker(void);
+
+            /**
+             * Main loop of the ingest worker
+             */
+            void _run_ingest_worker(void);
+
+            /**
+             * Processes and commits a batch of queued messages, starting with
+             * one already removed from the queue; the caller must hold the
+             * database mutex
+             *
+             * @param[in] msg: first message of the batch
+             */
+            void _ingest_batch(DpMsg &msg);
+
+            /**
+             * Waits until all queued messages have been processed
+             *
+             * @param[in] lock: lock held on the database mutex
              */
-            int n_asds;
+            void _wait_for_ingest(std::unique_lock<std::mutex> &lock);
 
             /**
-             * An array of tuples holding pointers to the ASDSs associated with
-             * each instrument and data type pair.
+             * Stops the ingest worker after it processes all queued messages
              */
-            std::tuple<std::string, std::string, ASDS*> asds[MAX_SYNOPSIS_APP_ASDS];
+            void _stop_ingest_worker(void);
 
             /**
              * Returns the number of padding bytes needed to word-align
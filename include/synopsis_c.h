@@ -0,0 +1,135 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * Provides a C interface to a SYNOPSIS application backed by a SQLite ASDPDB
+ * and the maximum marginal relevance downlink planner, for use in-process
+ * from other languages (e.g., Python via ctypes; see
+ * python/synopsis/native.py).
+ *
+ * A session owns the application and its modules, so the ASDPDB stays open
+ * and configurations stay cached between prioritizations. Results of the
+ * last prioritization are held by the session in parallel arrays of ASDP
+ * identifiers, final (similarity-discounted) science utility estimates, and
+ * sizes, which remain valid until the next prioritization or until the
+ * session is closed; callers may wrap them without copying. Final SUEs and
+ * sizes come from the planner's own state, so no ASDPDB queries are made
+ * after planning.
+ *
+ * Functions returning `int` return a Synopsis::Status value (0 on success).
+ * No C++ exceptions escape the interface; a function that raises one
+ * internally returns FAILURE (or NULL when opening a session).
+ */
+#ifndef JPL_SYNOPSIS_synopsis_c
+#define JPL_SYNOPSIS_synopsis_c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Opaque session handle
+ */
+typedef struct synopsis_session synopsis_session_t;
+
+
+/**
+ * Opens a session and initializes its application
+ *
+ * @param[in] asdpdb_file: path to the SQLite ASDPDB
+ * @param[in] engine: greedy selection engine (Synopsis::MmrEngine)
+ * @param[in] n_threads: number of threads used to prioritize bins
+ * @param[in] log_level: lowest logged message type (Synopsis::LogType);
+ * messages are written to stderr
+ *
+ * @return: session, or NULL if initialization failed
+ */
+synopsis_session_t *synopsis_session_open(
+    const char *asdpdb_file, int engine, int n_threads, int log_level
+);
+
+
+/**
+ * De-initializes the application and frees the session and its results
+ *
+ * @param[in] session: session, or NULL
+ */
+void synopsis_session_close(synopsis_session_t *session);
+
+
+/**
+ * Prioritizes the ASDPs in the session's ASDPDB, replacing the session's
+ * results
+ *
+ * @see Synopsis::Application::prioritize_with_budget
+ *
+ * @param[in] session: session
+ * @param[in] rule_config: rule and constraint configuration
+ * @param[in] similarity_config: similarity-based discount configuration
+ * @param[in] max_processing_time_sec: processing time limit
+ * @param[in] max_bytes: byte budget, or a negative value for none
+ * @param[in] max_count: count budget, or a negative value for none
+ *
+ * @return: prioritization status; on TIMEOUT, the results hold the ASDPs
+ * prioritized so far, and on FAILURE (e.g., for a missing or malformed
+ * configuration), the results are empty
+ */
+int synopsis_session_prioritize(
+    synopsis_session_t *session,
+    const char *rule_config, const char *similarity_config,
+    double max_processing_time_sec, long max_bytes, int max_count
+);
+
+
+/**
+ * Results of the last prioritization, in priority order
+ *
+ * @param[in] session: session
+ *
+ * @return: number of prioritized ASDPs, or arrays of their identifiers,
+ * final science utility estimates, and sizes
+ */
+int synopsis_session_result_count(const synopsis_session_t *session);
+const int *synopsis_session_result_ids(const synopsis_session_t *session);
+const double *synopsis_session_result_sues(const synopsis_session_t *session);
+const long *synopsis_session_result_sizes(const synopsis_session_t *session);
+
+
+/**
+ * @param[in] session: session
+ *
+ * @return: first ASDP that did not fit within the last prioritization's
+ * budget, or -1
+ */
+int synopsis_session_result_cut_asdp_id(const synopsis_session_t *session);
+
+
+/**
+ * Updates an ASDP in the session's ASDPDB
+ *
+ * @see Synopsis::Application::update_science_utility
+ *
+ * @param[in] session: session
+ * @param[in] asdp_id: ASDP identifier
+ * @param[in] value: new value
+ *
+ * @return: update status
+ */
+int synopsis_session_update_science_utility(
+    synopsis_session_t *session, int asdp_id, double value
+);
+int synopsis_session_update_priority_bin(
+    synopsis_session_t *session, int asdp_id, int value
+);
+int synopsis_session_update_downlink_state(
+    synopsis_session_t *session, int asdp_id, int value
+);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -14,7 +14,11 @@ namespace Synopsis {
 
 
     /**
-     * ASDPDB schema; defines two tables to hold ASDPs and associated metadata
+     * ASDPDB schema (version 2); defines tables to hold ASDPs, metadata
+     * field names, and associated metadata. Field names are interned so that
+     * each metadata row refers to its field by identifier, and metadata rows
+     * are clustered by ASDP. ASDPs are indexed by downlink state and priority
+     * bin for the planner's queries.
      *
      * @see SqliteASDPDB::init
      */
@@ -31,19 +35,140 @@ namespace Synopsis {
         downlink_state INTEGER
     );
 
+    CREATE TABLE IF NOT EXISTS FIELDNAME (
+        fieldname_id INTEGER PRIMARY KEY,
+        fieldname TEXT NOT NULL UNIQUE
+    );
+
     CREATE TABLE IF NOT EXISTS METADATA (
         asdp_id INTEGER,
-        fieldname TEXT NOT NULL,
+        fieldname_id INTEGER,
         type INTEGER,
         value_int INTEGER,
         value_float REAL,
         value_string TEXT,
-        FOREIGN KEY(asdp_id) REFERENCES ASDP(asdp_id)
-        CONSTRAINT UNIQUE_META UNIQUE (asdp_id,fieldname)
+        FOREIGN KEY(asdp_id) REFERENCES ASDP(asdp_id),
+        FOREIGN KEY(fieldname_id) REFERENCES FIELDNAME(fieldname_id),
+        PRIMARY KEY (asdp_id, fieldname_id)
+    ) WITHOUT ROWID;
+
+    CREATE INDEX IF NOT EXISTS ASDP_STATE_INDEX ON ASDP (downlink_state);
+
+    CREATE INDEX IF NOT EXISTS ASDP_BIN_INDEX ON ASDP (
+        priority_bin, downlink_state
     );
 
     )";
 
+    /**
+     * Migrates a version 1 schema, in which each metadata row holds its
+     * field name, to version 2; run within a transaction. Field names
+     * written by version 1 include a trailing NUL byte, which is removed.
+     *
+     * @see SQL_SCHEMA
+     * @see SqliteASDPDB::init
+     */
+    static constexpr const char* SQL_MIGRATE_V1_V2 = R"(
+
+    CREATE TABLE FIELDNAME (
+        fieldname_id INTEGER PRIMARY KEY,
+        fieldname TEXT NOT NULL UNIQUE
+    );
+
+    CREATE TEMP TABLE METADATA_FIELDNAME AS
+    SELECT rowid AS metadata_rowid, CASE
+        WHEN substr(CAST(fieldname AS BLOB), -1) = x'00'
+        THEN CAST(substr(
+            CAST(fieldname AS BLOB), 1, length(CAST(fieldname AS BLOB)) - 1
+        ) AS TEXT)
+        ELSE fieldname
+    END AS fieldname
+    FROM METADATA;
+
+    INSERT INTO FIELDNAME (fieldname)
+    SELECT DISTINCT fieldname FROM METADATA_FIELDNAME ORDER BY fieldname;
+
+    CREATE TABLE METADATA_V2 (
+        asdp_id INTEGER,
+        fieldname_id INTEGER,
+        type INTEGER,
+        value_int INTEGER,
+        value_float REAL,
+        value_string TEXT,
+        FOREIGN KEY(asdp_id) REFERENCES ASDP(asdp_id),
+        FOREIGN KEY(fieldname_id) REFERENCES FIELDNAME(fieldname_id),
+        PRIMARY KEY (asdp_id, fieldname_id)
+    ) WITHOUT ROWID;
+
+    INSERT OR REPLACE INTO METADATA_V2
+    SELECT
+        METADATA.asdp_id, FIELDNAME.fieldname_id, METADATA.type,
+        value_int, value_float, value_string
+    FROM METADATA
+        JOIN METADATA_FIELDNAME ON METADATA.rowid=METADATA_FIELDNAME.metadata_rowid
+        JOIN FIELDNAME ON METADATA_FIELDNAME.fieldname=FIELDNAME.fieldname
+    ORDER BY METADATA.rowid;
+
+    DROP TABLE METADATA_FIELDNAME;
+
+    DROP TABLE METADATA;
+
+    ALTER TABLE METADATA_V2 RENAME TO METADATA;
+
+    CREATE INDEX ASDP_STATE_INDEX ON ASDP (downlink_state);
+
+    CREATE INDEX ASDP_BIN_INDEX ON ASDP (priority_bin, downlink_state);
+
+    )";
+
+    /**
+     * Defines queries to read the schema version and to check whether the
+     * database contains a (version 1) schema without a version number; the
+     * new version number is appended to the pragma that sets it
+     *
+     * @see SqliteASDPDB::init
+     */
+    static constexpr const char* SQL_GET_SCHEMA_VERSION = "PRAGMA user_version;";
+    static constexpr const char* SQL_SET_SCHEMA_VERSION = "PRAGMA user_version=";
+    static constexpr const char* SQL_ASDP_TABLE_EXISTS = R"(
+
+    SELECT count(*) FROM sqlite_master WHERE type='table' AND name='ASDP';
+
+    )";
+
+    /**
+     * Define pragmas used to configure a connection; numeric arguments are
+     * appended to the latter three
+     *
+     * @see SqliteASDPDB::init
+     * @see SqliteProfile
+     */
+    static constexpr const char* SQL_PRAGMA_JOURNAL_MODE_WAL = "PRAGMA journal_mode=WAL;";
+    static constexpr const char* SQL_PRAGMA_MMAP_SIZE = "PRAGMA mmap_size=";
+    static constexpr const char* SQL_PRAGMA_CACHE_SIZE = "PRAGMA cache_size=";
+    static constexpr const char* SQL_PRAGMA_SYNCHRONOUS = "PRAGMA synchronous=";
+
+    /**
+     * Define statements to insert an ASDP and its metadata atomically; when
+     * no transaction is open, the savepoint acts as its own transaction
+     *
+     * @see SqliteASDPDB::insert_data_product
+     */
+    static constexpr const char* SQL_INSERT_SAVEPOINT = "SAVEPOINT asdp_insert;";
+    static constexpr const char* SQL_INSERT_RELEASE = "RELEASE asdp_insert;";
+    static constexpr const char* SQL_INSERT_ROLLBACK = (
+        "ROLLBACK TO asdp_insert; RELEASE asdp_insert;"
+    );
+
+    /**
+     * Define statements to begin, commit, and roll back a batch
+     *
+     * @see SqliteASDPDB::begin_batch
+     */
+    static constexpr const char* SQL_BEGIN = "BEGIN;";
+    static constexpr const char* SQL_COMMIT = "COMMIT;";
+    static constexpr const char* SQL_ROLLBACK = "ROLLBACK;";
+
     /**
      * Defines query to insert a new ASDP
      *
@@ -58,6 +183,17 @@ namespace Synopsis {
 
     )";
 
+    /**
+     * Defines query to intern a metadata field name
+     *
+     * @see SqliteASDPDB::insert_data_product
+     */
+    static constexpr const char* SQL_FIELDNAME_INSERT = R"(
+
+    INSERT OR IGNORE INTO FIELDNAME (fieldname) VALUES (?);
+
+    )";
+
     /**
      * Defines query to insert new ASDP metadata
      *
@@ -66,8 +202,11 @@ namespace Synopsis {
     static constexpr const char* SQL_ASDP_METADATA_INSERT = R"(
 
     INSERT INTO METADATA (
-        asdp_id, fieldname, type, value_int, value_float, value_string
-    ) VALUES (?, ?, ?, ?, ?, ?);
+        asdp_id, fieldname_id, type, value_int, value_float, value_string
+    ) VALUES (
+        ?, (SELECT fieldname_id FROM FIELDNAME WHERE fieldname=?),
+        ?, ?, ?, ?
+    );
 
     )";
 
@@ -78,7 +217,7 @@ namespace Synopsis {
      */
     static constexpr const char* SQL_ASDP_SELECT = R"(
 
-    SELECT asdp_id FROM ASDP;
+    SELECT asdp_id FROM ASDP ORDER BY asdp_id;
 
     )";
 
@@ -105,7 +244,77 @@ namespace Synopsis {
 
     SELECT
         fieldname, type, value_int, value_float, value_string
-    FROM METADATA WHERE asdp_id=?;
+    FROM METADATA JOIN FIELDNAME ON METADATA.fieldname_id=FIELDNAME.fieldname_id
+    WHERE asdp_id=?;
+
+    )";
+
+    /**
+     * Defines query to fetch all ASDPs in either of the given downlink states
+     *
+     * @see SqliteASDPDB::list_undownlinked_data_products
+     */
+    static constexpr const char* SQL_ASDP_SELECT_STATE = R"(
+
+    SELECT
+        asdp_id, instrument_name, type, uri, size,
+        science_utility_estimate, priority_bin, downlink_state
+    FROM ASDP WHERE downlink_state IN (?, ?)
+    ORDER BY asdp_id;
+
+    )";
+
+    /**
+     * Defines query to fetch metadata for all ASDPs in either of the given
+     * downlink states
+     *
+     * @see SqliteASDPDB::list_undownlinked_data_products
+     */
+    static constexpr const char* SQL_ASDP_METADATA_SELECT_STATE = R"(
+
+    SELECT
+        METADATA.asdp_id, fieldname, METADATA.type,
+        value_int, value_float, value_string
+    FROM METADATA
+        JOIN ASDP ON METADATA.asdp_id=ASDP.asdp_id
+        JOIN FIELDNAME ON METADATA.fieldname_id=FIELDNAME.fieldname_id
+    WHERE ASDP.downlink_state IN (?, ?)
+    ORDER BY METADATA.asdp_id;
+
+    )";
+
+    /**
+     * Defines query to fetch all ASDPs in a priority bin that are in either of
+     * the given downlink states
+     *
+     * @see SqliteASDPDB::list_undownlinked_data_products_in_bin
+     */
+    static constexpr const char* SQL_ASDP_SELECT_BIN_STATE = R"(
+
+    SELECT
+        asdp_id, instrument_name, type, uri, size,
+        science_utility_estimate, priority_bin, downlink_state
+    FROM ASDP WHERE priority_bin=? AND downlink_state IN (?, ?)
+    ORDER BY asdp_id;
+
+    )";
+
+    /**
+     * Defines query to fetch metadata for all ASDPs in a priority bin that are
+     * in either of the given downlink states
+     *
+     * @see SqliteASDPDB::list_undownlinked_data_products_in_bin
+     */
+    static constexpr const char* SQL_ASDP_METADATA_SELECT_BIN_STATE = R"(
+
+    SELECT
+        METADATA.asdp_id, fieldname, METADATA.type,
+        value_int, value_float, value_string
+    FROM METADATA
+        JOIN ASDP ON METADATA.asdp_id=ASDP.asdp_id
+        JOIN FIELDNAME ON METADATA.fieldname_id=FIELDNAME.fieldname_id
+    WHERE ASDP.priority_bin=? AND ASDP.downlink_state IN (?, ?)
+    ORDER BY METADATA.asdp_id;
 
     )";
 
@@ -157,7 +366,9 @@ namespace Synopsis {
 
     UPDATE METADATA
     SET type=?, value_int=?, value_float=?, value_string=?
-    WHERE asdp_id=? AND fieldname=?;
+    WHERE asdp_id=? AND fieldname_id=(
+        SELECT fieldname_id FROM FIELDNAME WHERE fieldname=?
+    );
 
     )";
 
@@ -20,7 +20,8 @@ namespace Synopsis {
     typedef enum {
         SUCCESS = 0,
         FAILURE = 1,
-        TIMEOUT = 2
+        TIMEOUT = 2,
+        BUSY = 3
     } Status;
 
 
@@ -45,12 +46,13 @@ namespace Synopsis {
 
 
     /**
-     * SYNOPSIS Log Message Types
+     * SYNOPSIS Log Message Types, in increasing order of severity
      */
     typedef enum {
-        INFO = 0,
-        WARN = 1,
-        ERROR = 2
+        DEBUG = 0,
+        INFO = 1,
+        WARN = 2,
+        ERROR = 3
     } LogType;
 
 
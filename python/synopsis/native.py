@@ -0,0 +1,192 @@
+#!/usr/bin/env python
+'''
+In-process bindings to the SYNOPSIS shared library (libsynopsis) through its C
+interface (include/synopsis_c.h), as an alternative to running synopsis_cli
+and parsing its output
+
+Example:
+
+    with Session('build/libsynopsis.so', 'test/data/dd_example.db') as s:
+        result = s.prioritize(
+            'test/data/dd_example_rules.json',
+            'test/data/dd_example_similarity_config.json'
+        )
+        print(result.ids, result.sues, result.sizes)
+
+Result arrays are views of memory held by the session, not copies; they are
+NumPy arrays if NumPy is installed, and ctypes arrays otherwise. They remain
+valid until the next call to `prioritize` or until the session is closed;
+copy them to keep them longer.
+'''
+import ctypes
+from collections import namedtuple
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+# Synopsis::MmrEngine
+EXHAUSTIVE_GREEDY = 0
+INCREMENTAL_GREEDY = 1
+LAZY_GREEDY = 2
+
+# Synopsis::LogType
+DEBUG = 0
+INFO = 1
+WARN = 2
+ERROR = 3
+
+# Synopsis::Status
+SUCCESS = 0
+FAILURE = 1
+TIMEOUT = 2
+
+# Synopsis::DownlinkState
+UNTRANSMITTED = 0
+TRANSMITTED = 1
+DOWNLINKED = 2
+
+
+PrioritizationResult = namedtuple('PrioritizationResult',
+    ['status', 'ids', 'sues', 'sizes', 'cut_asdp_id']
+)
+
+
+def load_library(library_path):
+    '''
+    Loads libsynopsis and declares the C interface
+
+    Parameters
+    ----------
+    library_path: str
+        Path to the shared library (e.g., build/libsynopsis.so)
+
+    Returns
+    -------
+    lib: ctypes.CDLL
+    '''
+    lib = ctypes.CDLL(library_path)
+    session_p = ctypes.c_void_p
+
+    lib.synopsis_session_open.restype = session_p
+    lib.synopsis_session_open.argtypes = [
+        ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.c_int
+    ]
+    lib.synopsis_session_close.restype = None
+    lib.synopsis_session_close.argtypes = [session_p]
+    lib.synopsis_session_prioritize.restype = ctypes.c_int
+    lib.synopsis_session_prioritize.argtypes = [
+        session_p, ctypes.c_char_p, ctypes.c_char_p,
+        ctypes.c_double, ctypes.c_long, ctypes.c_int
+    ]
+    lib.synopsis_session_result_count.restype = ctypes.c_int
+    lib.synopsis_session_result_count.argtypes = [session_p]
+    lib.synopsis_session_result_ids.restype = ctypes.POINTER(ctypes.c_int)
+    lib.synopsis_session_result_ids.argtypes = [session_p]
+    lib.synopsis_session_result_sues.restype = ctypes.POINTER(ctypes.c_double)
+    lib.synopsis_session_result_sues.argtypes = [session_p]
+    lib.synopsis_session_result_sizes.restype = ctypes.POINTER(ctypes.c_long)
+    lib.synopsis_session_result_sizes.argtypes = [session_p]
+    lib.synopsis_session_result_cut_asdp_id.restype = ctypes.c_int
+    lib.synopsis_session_result_cut_asdp_id.argtypes = [session_p]
+    lib.synopsis_session_update_science_utility.restype = ctypes.c_int
+    lib.synopsis_session_update_science_utility.argtypes = [
+        session_p, ctypes.c_int, ctypes.c_double
+    ]
+    lib.synopsis_session_update_priority_bin.restype = ctypes.c_int
+    lib.synopsis_session_update_priority_bin.argtypes = [
+        session_p, ctypes.c_int, ctypes.c_int
+    ]
+    lib.synopsis_session_update_downlink_state.restype = ctypes.c_int
+    lib.synopsis_session_update_downlink_state.argtypes = [
+        session_p, ctypes.c_int, ctypes.c_int
+    ]
+    return lib
+
+
+def _view(pointer, ctype, count):
+    '''
+    Wraps `count` elements at `pointer` without copying
+    '''
+    array = (ctype * count).from_address(
+        ctypes.addressof(pointer.contents)
+    ) if count > 0 else (ctype * 0)()
+    if numpy is not None:
+        return numpy.ctypeslib.as_array(array)
+    return array
+
+
+class Session(object):
+    '''
+    SYNOPSIS application over a SQLite ASDP DB, kept open (with configurations
+    cached) across prioritizations
+    '''
+
+    def __init__(self, library_path, asdpdb_file, engine=EXHAUSTIVE_GREEDY,
+            n_threads=1, log_level=WARN):
+        self.lib = load_library(library_path)
+        self.session = self.lib.synopsis_session_open(
+            asdpdb_file.encode(), engine, n_threads, log_level
+        )
+        if not self.session:
+            raise RuntimeError('Could not open ASDP DB: ' + str(asdpdb_file))
+
+    def prioritize(self, rule_config_file, similarity_config_file,
+            max_processing_time_sec=1e9, max_bytes=-1, max_count=-1):
+        '''
+        Prioritizes the ASDPs in the ASDP DB
+
+        Returns
+        -------
+        result: PrioritizationResult
+            Status, and views of the prioritized ASDP identifiers, final
+            (similarity-discounted) science utility estimates, and sizes, in
+            priority order
+        '''
+        status = self.lib.synopsis_session_prioritize(
+            self.session,
+            rule_config_file.encode(), similarity_config_file.encode(),
+            max_processing_time_sec, max_bytes, max_count
+        )
+        count = self.lib.synopsis_session_result_count(self.session)
+        return PrioritizationResult(
+            status,
+            _view(self.lib.synopsis_session_result_ids(self.session),
+                ctypes.c_int, count),
+            _view(self.lib.synopsis_session_result_sues(self.session),
+                ctypes.c_double, count),
+            _view(self.lib.synopsis_session_result_sizes(self.session),
+                ctypes.c_long, count),
+            self.lib.synopsis_session_result_cut_asdp_id(self.session)
+        )
+
+    def update_science_utility(self, asdp_id, value):
+        return self.lib.synopsis_session_update_science_utility(
+            self.session, asdp_id, value
+        )
+
+    def update_priority_bin(self, asdp_id, value):
+        return self.lib.synopsis_session_update_priority_bin(
+            self.session, asdp_id, value
+        )
+
+    def update_downlink_state(self, asdp_id, value):
+        return self.lib.synopsis_session_update_downlink_state(
+            self.session, asdp_id, value
+        )
+
+    def close(self):
+        if self.session:
+            self.lib.synopsis_session_close(self.session)
+            self.session = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,107 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see ASDPDB.hpp
+ */
+#include <algorithm>
+#include <utility>
+
+#include "ASDPDB.hpp"
+
+
+namespace Synopsis {
+
+
+    Status ASDPDB::insert_data_products(std::vector<DpDbMsg> &msgs) {
+        Status status = this->begin_batch();
+        if (status != SUCCESS) { return status; }
+
+        for (auto &msg : msgs) {
+            status = this->insert_data_product(msg);
+            if (status != SUCCESS) {
+                this->rollback_batch();
+                return status;
+            }
+        }
+
+        return this->commit_batch();
+    }
+
+
+    Status ASDPDB::begin_batch(void) {
+        return SUCCESS;
+    }
+
+
+    Status ASDPDB::commit_batch(void) {
+        return SUCCESS;
+    }
+
+
+    Status ASDPDB::rollback_batch(void) {
+        return FAILURE;
+    }
+
+
+    Status ASDPDB::list_undownlinked_data_products(std::vector<DpDbMsg> &msgs) {
+        DpDbMsg msg;
+        for (int dp_id : this->list_data_product_ids()) {
+            Status status = this->get_data_product(dp_id, msg);
+            if (status != SUCCESS) { return status; }
+            if (msg.get_downlink_state() == DOWNLINKED) { continue; }
+            msgs.push_back(msg);
+        }
+        return SUCCESS;
+    }
+
+
+    Status ASDPDB::list_undownlinked_data_products_in_bin(
+            int priority_bin, std::vector<DpDbMsg> &msgs) {
+        std::vector<DpDbMsg> all_msgs;
+        Status status = this->list_undownlinked_data_products(all_msgs);
+        if (status != SUCCESS) { return status; }
+        for (auto &msg : all_msgs) {
+            if (msg.get_priority_bin() == priority_bin) {
+                msgs.push_back(std::move(msg));
+            }
+        }
+        return SUCCESS;
+    }
+
+
+    void ASDPDB::add_listener(ASDPDBListener *listener) {
+        auto found = std::find(
+            this->_listeners.begin(), this->_listeners.end(), listener
+        );
+        if (found == this->_listeners.end()) {
+            this->_listeners.push_back(listener);
+        }
+    }
+
+
+    void ASDPDB::remove_listener(ASDPDBListener *listener) {
+        this->_listeners.erase(
+            std::remove(
+                this->_listeners.begin(), this->_listeners.end(), listener
+            ),
+            this->_listeners.end()
+        );
+    }
+
+
+    void ASDPDB::_notify_changed(int asdp_id) {
+        for (ASDPDBListener *listener : this->_listeners) {
+            listener->data_product_changed(asdp_id);
+        }
+    }
+
+
+    void ASDPDB::_notify_reset(void) {
+        for (ASDPDBListener *listener : this->_listeners) {
+            listener->data_products_reset();
+        }
+    }
+
+
+};
@@ -5,7 +5,9 @@
  * @see ASDS.hpp
  */
 #include <nlohmann/json.hpp>
-#include <fstream>
+#include <cstdio>
+#include <utility>
+#include <sys/stat.h>
 
 #include "ASDS.hpp"
 
@@ -13,11 +15,197 @@ namespace Synopsis {
 
 
     size_t get_file_size(std::string filename) {
-        std::ifstream file(filename, std::ios::binary | std::ios::ate);
-        return file.tellg();
+        struct stat info;
+        if (stat(filename.c_str(), &info) != 0) {
+            return static_cast<size_t>(-1);
+        }
+        return info.st_size;
     }
 
 
+    /**
+     * Streaming (SAX) handler for ASDP metadata JSON files, which extracts
+     * the SUE, priority bin, and scalar metadata fields as they are parsed,
+     * without constructing a JSON document. As with the document, a repeated
+     * key takes the last value given for it.
+     */
+    class _MetadataHandler : public nlohmann::json_sax<nlohmann::json> {
+
+        public:
+
+            _MetadataHandler(AsdpEntry &metadata) : _metadata(metadata) {}
+
+            bool null() override {
+                return this->_scalar(false, false, false, DpMetadataValue());
+            }
+
+            bool boolean(bool val) override {
+                return this->_scalar(false, false, false, DpMetadataValue());
+            }
+
+            bool number_integer(number_integer_t val) override {
+                return this->_scalar(true, true, true, DpMetadataValue((int)val));
+            }
+
+            bool number_unsigned(number_unsigned_t val) override {
+                return this->_scalar(true, true, true, DpMetadataValue((int)val));
+            }
+
+            bool number_float(number_float_t val, const string_t &s) override {
+                return this->_scalar(true, false, true, DpMetadataValue((double)val));
+            }
+
+            bool string(string_t &val) override {
+                return this->_scalar(false, false, true, DpMetadataValue(val));
+            }
+
+            bool binary(binary_t &val) override {
+                return this->_scalar(false, false, false, DpMetadataValue());
+            }
+
+            bool start_object(std::size_t elements) override {
+                if (this->_depth == 0) {
+                    this->is_object = true;
+                } else if (this->_depth == 1) {
+                    this->_container(true);
+                }
+                this->_depth++;
+                return true;
+            }
+
+            bool end_object() override {
+                this->_depth--;
+                if (this->_depth == 1) {
+                    this->_in_metadata = false;
+                }
+                return true;
+            }
+
+            bool start_array(std::size_t elements) override {
+                if (this->_depth == 1) {
+                    this->_container(false);
+                }
+                this->_depth++;
+                return true;
+            }
+
+            bool end_array() override {
+                this->_depth--;
+                return true;
+            }
+
+            bool key(string_t &val) override {
+                if (this->_depth == 1) {
+                    this->_key.swap(val);
+                } else if ((this->_depth == 2) && this->_in_metadata) {
+                    this->_metadata_key.swap(val);
+                }
+                return true;
+            }
+
+            bool parse_error(
+                std::size_t position, const std::string &last_token,
+                const nlohmann::detail::exception &ex
+            ) override {
+                return false;
+            }
+
+            /**
+             * Whether the document is an object
+             */
+            bool is_object = false;
+
+            /**
+             * Extracted SUE and priority bin, and whether each has a value of
+             * the required type
+             */
+            double sue = 0.0;
+            bool has_sue = false;
+            int priority_bin = 0;
+            bool has_priority_bin = false;
+
+            /**
+             * Whether the metadata value is an object
+             */
+            bool has_metadata = false;
+
+        private:
+
+            /**
+             * Handles a scalar value at the current position
+             *
+             * @param[in] numeric: whether the value is a number
+             * @param[in] integer: whether the value is an integer
+             * @param[in] supported: whether the value is a supported metadata
+             * field type (number or string)
+             * @param[in] value: value
+             */
+            bool _scalar(bool numeric, bool integer, bool supported,
+                    DpMetadataValue value) {
+                if (this->_depth == 1) {
+                    if (this->_key == "science_utility_estimate") {
+                        this->has_sue = numeric;
+                        if (numeric) { this->sue = value.get_numeric(); }
+                    } else if (this->_key == "priority_bin") {
+                        this->has_priority_bin = integer;
+                        if (integer) { this->priority_bin = value.get_int_value(); }
+                    } else if (this->_key == "metadata") {
+                        this->_metadata_value(false);
+                    }
+                } else if ((this->_depth == 2) && this->_in_metadata && supported) {
+                    this->_metadata[this->_metadata_key] = std::move(value);
+                }
+                return true;
+            }
+
+            /**
+             * Handles the start of an object or array value for a top-level
+             * key; only the metadata value may be a container
+             */
+            void _container(bool object) {
+                if (this->_key == "science_utility_estimate") {
+                    this->has_sue = false;
+                } else if (this->_key == "priority_bin") {
+                    this->has_priority_bin = false;
+                } else if (this->_key == "metadata") {
+                    this->_metadata_value(object);
+                }
+            }
+
+            /**
+             * Handles a new value for the metadata key
+             */
+            void _metadata_value(bool object) {
+                this->_metadata.clear();
+                this->has_metadata = object;
+                this->_in_metadata = object;
+            }
+
+            /**
+             * Metadata fields extracted from the metadata object
+             */
+            AsdpEntry &_metadata;
+
+            /**
+             * Nesting depth of the current position; top-level keys are at
+             * depth one, and metadata fields at depth two
+             */
+            int _depth = 0;
+
+            /**
+             * Most recent top-level and metadata keys
+             */
+            std::string _key;
+            std::string _metadata_key;
+
+            /**
+             * Whether the current position is within the metadata object
+             */
+            bool _in_metadata = false;
+
+    };
+
+
     void ASDS::set_database(ASDPDB *db) {
         this->_db = db;
     }
@@ -33,7 +221,7 @@ namespace Synopsis {
     }
 
 
-    Status ASDS::submit_data_product(DpMsg msg) {
+    Status ASDS::submit_data_product(const DpMsg &msg) {
 
         size_t dp_size = get_file_size(msg.get_uri());
 
@@ -43,54 +231,37 @@ namespace Synopsis {
         AsdpEntry metadata;
 
         if (msg.get_metadata_usage()) {
-            // Parse metadata JSON
-            std::ifstream file_input(msg.get_metadata_uri());
-            auto j = nlohmann::json::parse(file_input);
+            // Parse metadata JSON as it is read
+            std::FILE *file_input = std::fopen(msg.get_metadata_uri().c_str(), "r");
+            if (file_input == nullptr) {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "Could not open metadata file in submit_data_product");
+                return FAILURE;
+            }
+            _MetadataHandler handler(metadata);
+            bool parsed = nlohmann::json::sax_parse(file_input, &handler);
+            std::fclose(file_input);
+            if (!parsed || !handler.is_object) {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "Invalid metadata JSON in submit_data_product");
+                return FAILURE;
+            }
 
             // Extract SUE
-            auto j_sue = j["science_utility_estimate"];
-            if (j_sue.is_number()) {
-                sue = j_sue.get<double>();
+            if (handler.has_sue) {
+                sue = handler.sue;
             } else {
                 LOG(this->_logger, Synopsis::LogType::ERROR, "Non-numeric ASDP SUE metadata value in submit_data_product");
                 return FAILURE;
             }
 
             // Extract Priority Bin
-            auto j_bin = j["priority_bin"];
-            if (j_bin.is_number_integer()) {
-                priority_bin = j_bin.get<int>();
+            if (handler.has_priority_bin) {
+                priority_bin = handler.priority_bin;
             } else {
                 LOG(this->_logger, Synopsis::LogType::ERROR,"Bin is not an integer in submit_data_product");
                 return FAILURE;
             }
 
-            auto j_meta = j["metadata"];
-            if (j_meta.is_object()) {
-                for (auto& el : j_meta.items()) {
-
-                    std::string key = el.key();
-                    auto val = el.value();
-
-                    if (val.is_number_integer()) {
-                        DpMetadataValue value(val.get<int>());
-                        metadata.insert({key, value});
-
-                    } else if (val.is_number()) {
-                        DpMetadataValue value(val.get<double>());
-                        metadata.insert({key, value});
-
-                    } else if (val.is_string()) {
-                        DpMetadataValue value(val.get<std::string>());
-                        metadata.insert({key, value});
-
-                    } else {
-                        // Log unsupported metadata type
-                        
-                    }
-
-                }
-            } else {
+            if (!handler.has_metadata) {
                 LOG(this->_logger, Synopsis::LogType::ERROR, "Metadata JSON value is not a (key, value) pair in submit_data_product");
                 return FAILURE;
             }
@@ -107,10 +278,10 @@ namespace Synopsis {
             sue,
             priority_bin,
             DownlinkState::UNTRANSMITTED,
-            metadata
+            std::move(metadata)
         );
 
-        return this->submit_data_product(db_msg);
+        return this->submit_data_product(std::move(db_msg));
     }
 
 
@@ -0,0 +1,230 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see AsdpTable.hpp
+ */
+#include <algorithm>
+
+#include "AsdpTable.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Value stored for fields that are not present for an ASDP
+     */
+    static const AsdpValue ABSENT_VALUE = {INT, false, 0, 0.0, -1};
+
+
+    const int AsdpTable::ID_SLOT;
+    const int AsdpTable::INSTRUMENT_NAME_SLOT;
+    const int AsdpTable::TYPE_SLOT;
+    const int AsdpTable::SIZE_SLOT;
+    const int AsdpTable::SUE_SLOT;
+    const int AsdpTable::PRIORITY_BIN_SLOT;
+    const int AsdpTable::FINAL_SUE_SLOT;
+
+
+    AsdpTable::AsdpTable(MemoryArena *arena) :
+        _allocator(arena),
+        _reserved_rows(0),
+        _columns(_allocator),
+        _ids(_allocator),
+        _sizes(_allocator),
+        _sues(_allocator),
+        _bins(_allocator),
+        _key_ids(_allocator),
+        _states(_allocator)
+    {
+        // Intern first-class fields in slot order
+        this->intern_field("id");
+        this->intern_field("instrument_name");
+        this->intern_field("type");
+        this->intern_field("size");
+        this->intern_field("science_utility_estimate");
+        this->intern_field("priority_bin");
+        this->intern_field("final_science_utility_estimate");
+    }
+
+
+    int AsdpTable::add_data_product(const DpDbMsg &msg) {
+        int row = this->size();
+
+        // Intern any new fields before the row is added, so that all columns
+        // are extended together
+        const AsdpEntry &metadata = msg.get_metadata();
+        for (auto &entry : metadata) {
+            this->intern_field(entry.first);
+        }
+        for (auto &column : this->_columns) {
+            column.push_back(ABSENT_VALUE);
+        }
+
+        // Initialize with existing metadata
+        for (auto &entry : metadata) {
+            int slot = this->_field_slots[entry.first];
+            this->_columns[slot][row] = this->make_value(entry.second);
+        }
+
+        // Add "first class" metadata fields
+        int instrument_id = this->intern_string(msg.get_instrument_name());
+        int type_id = this->intern_string(msg.get_type());
+        this->_columns[ID_SLOT][row] = this->make_value(
+            DpMetadataValue(msg.get_dp_id())
+        );
+        this->_columns[INSTRUMENT_NAME_SLOT][row] = this->make_value(
+            DpMetadataValue(msg.get_instrument_name())
+        );
+        this->_columns[TYPE_SLOT][row] = this->make_value(
+            DpMetadataValue(msg.get_type())
+        );
+        this->_columns[SIZE_SLOT][row] = this->make_value(
+            DpMetadataValue((int)msg.get_dp_size())
+        );
+        this->_columns[SUE_SLOT][row] = this->make_value(
+            DpMetadataValue(msg.get_science_utility_estimate())
+        );
+        this->_columns[PRIORITY_BIN_SLOT][row] = this->make_value(
+            DpMetadataValue(msg.get_priority_bin())
+        );
+
+        this->_ids.push_back(msg.get_dp_id());
+        this->_sizes.push_back((int)msg.get_dp_size());
+        this->_sues.push_back(msg.get_science_utility_estimate());
+        this->_bins.push_back(msg.get_priority_bin());
+        this->_key_ids.push_back(this->_intern_key(instrument_id, type_id));
+        this->_states.push_back(msg.get_downlink_state());
+
+        return row;
+    }
+
+
+    void AsdpTable::reserve(int n_rows) {
+        if (n_rows <= this->_reserved_rows) { return; }
+        this->_reserved_rows = n_rows;
+        this->_ids.reserve(n_rows);
+        this->_sizes.reserve(n_rows);
+        this->_sues.reserve(n_rows);
+        this->_bins.reserve(n_rows);
+        this->_key_ids.reserve(n_rows);
+        this->_states.reserve(n_rows);
+        for (auto &column : this->_columns) {
+            column.reserve(n_rows);
+        }
+    }
+
+
+    int AsdpTable::intern_field(const std::string &field_name) {
+        auto found = this->_field_slots.find(field_name);
+        if (found != this->_field_slots.end()) {
+            return found->second;
+        }
+        int slot = this->_columns.size();
+        this->_field_slots[field_name] = slot;
+        this->_field_names.push_back(field_name);
+        this->_columns.push_back(
+            ArenaVector<AsdpValue>(this->_allocator)
+        );
+        auto &column = this->_columns.back();
+        column.reserve(std::max(this->size(), this->_reserved_rows));
+        column.resize(this->size(), ABSENT_VALUE);
+        return slot;
+    }
+
+
+    int AsdpTable::find_field(const std::string &field_name) const {
+        auto found = this->_field_slots.find(field_name);
+        if (found != this->_field_slots.end()) {
+            return found->second;
+        }
+        return -1;
+    }
+
+
+    const std::string &AsdpTable::get_field_name(int slot) const {
+        return this->_field_names[slot];
+    }
+
+
+    int AsdpTable::intern_string(const std::string &value) {
+        std::lock_guard<std::mutex> lock(this->_string_mutex);
+        auto found = this->_string_ids.find(value);
+        if (found != this->_string_ids.end()) {
+            return found->second;
+        }
+        int string_id = this->_strings.size();
+        this->_string_ids[value] = string_id;
+        this->_strings.push_back(value);
+        return string_id;
+    }
+
+
+    const std::string &AsdpTable::get_string(int string_id) const {
+        std::lock_guard<std::mutex> lock(this->_string_mutex);
+        return this->_strings[string_id];
+    }
+
+
+    std::pair<std::string, std::string> AsdpTable::get_key(int key_id) const {
+        std::lock_guard<std::mutex> lock(this->_string_mutex);
+        auto &key = this->_keys[key_id];
+        return std::make_pair(
+            this->_strings[key.first], this->_strings[key.second]
+        );
+    }
+
+
+    int AsdpTable::_intern_key(int instrument_id, int type_id) {
+        auto key = std::make_pair(instrument_id, type_id);
+        int n_keys = this->_keys.size();
+        for (int k = 0; k < n_keys; k++) {
+            if (this->_keys[k] == key) { return k; }
+        }
+        this->_keys.push_back(key);
+        return n_keys;
+    }
+
+
+    AsdpValue AsdpTable::make_value(const DpMetadataValue &value) {
+        AsdpValue result;
+        result.type = value.get_type();
+        result.present = true;
+        result.int_value = value.get_int_value();
+        result.float_value = value.get_float_value();
+        std::string string_value = value.get_string_value();
+        if ((result.type == STRING) || (string_value.size() > 0)) {
+            result.string_id = this->intern_string(string_value);
+        } else {
+            result.string_id = -1;
+        }
+        return result;
+    }
+
+
+    DpMetadataValue AsdpTable::to_metadata_value(const AsdpValue &value) const {
+        std::string string_value;
+        if (value.string_id >= 0) {
+            string_value = this->get_string(value.string_id);
+        }
+        return DpMetadataValue(
+            value.type, value.int_value, value.float_value, string_value
+        );
+    }
+
+
+    AsdpEntry AsdpTable::get_entry(int row) const {
+        AsdpEntry asdp;
+        int n_fields = this->num_fields();
+        for (int slot = 0; slot < n_fields; slot++) {
+            const AsdpValue &value = this->_columns[slot][row];
+            if (value.present) {
+                asdp[this->_field_names[slot]] = this->to_metadata_value(value);
+            }
+        }
+        return asdp;
+    }
+
+
+};
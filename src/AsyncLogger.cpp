@@ -0,0 +1,117 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see AsyncLogger.hpp
+ */
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "AsyncLogger.hpp"
+
+
+namespace Synopsis {
+
+
+    AsyncLogger::AsyncLogger(Logger *sink, size_t capacity) :
+        _sink(sink),
+        _ring(capacity > 0 ? capacity : 1)
+    {
+        this->_writer = std::thread(&AsyncLogger::_write, this);
+    }
+
+
+    AsyncLogger::~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_stop = true;
+        }
+        this->_message_available.notify_all();
+        this->_writer.join();
+    }
+
+
+    void AsyncLogger::log(LogType type, const char* file, const int line, const char* fmt,  ...) {
+        // Format outside the lock; only the in-memory copy is serialized
+        char message[MAX_MESSAGE_LENGTH];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(message, MAX_MESSAGE_LENGTH, fmt, args);
+        va_end(args);
+
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            if (this->_count == this->_ring.size()) {
+                this->_n_dropped++;
+                return;
+            }
+            size_t tail = (this->_head + this->_count) % this->_ring.size();
+            Entry &entry = this->_ring[tail];
+            entry.type = type;
+            entry.file = file;
+            entry.line = line;
+            memcpy(entry.message, message, MAX_MESSAGE_LENGTH);
+            this->_count++;
+        }
+        this->_message_available.notify_one();
+    }
+
+
+    void AsyncLogger::flush(void) {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        while (this->_count > 0 || this->_writing) {
+            this->_drained.wait(lock);
+        }
+    }
+
+
+    size_t AsyncLogger::dropped(void) {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        return this->_n_dropped;
+    }
+
+
+    void AsyncLogger::_write(void) {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        while (true) {
+            if (this->_count > 0) {
+                Entry entry = this->_ring[this->_head];
+                this->_head = (this->_head + 1) % this->_ring.size();
+                this->_count--;
+                this->_writing = true;
+
+                lock.unlock();
+                if (this->_sink != nullptr && this->_sink->is_enabled(entry.type)) {
+                    this->_sink->log(entry.type, entry.file, entry.line, "%s", entry.message);
+                }
+                lock.lock();
+
+                this->_writing = false;
+                continue;
+            }
+
+            // Report drops once the backlog that caused them is written
+            if (this->_n_dropped > this->_n_dropped_reported) {
+                size_t n_new = this->_n_dropped - this->_n_dropped_reported;
+                this->_n_dropped_reported = this->_n_dropped;
+                this->_writing = true;
+
+                lock.unlock();
+                LOG(this->_sink, LogType::WARN,
+                    "AsyncLogger dropped %lu messages", (unsigned long)n_new
+                );
+                lock.lock();
+
+                this->_writing = false;
+                continue;
+            }
+
+            this->_drained.notify_all();
+            if (this->_stop) { break; }
+            this->_message_available.wait(lock);
+        }
+    }
+
+
+};
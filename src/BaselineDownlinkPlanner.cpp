@@ -0,0 +1,164 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see BaselineDownlinkPlanner.hpp
+ */
+#include <algorithm>
+#include <limits>
+#include <map>
+
+#include "BaselineDownlinkPlanner.hpp"
+#include "AsdpTable.hpp"
+#include "RuleAST.hpp"
+#include "Timer.hpp"
+
+
+namespace Synopsis {
+
+
+    size_t BaselineDownlinkPlanner::memory_requirement(void) {
+        return 0;
+    }
+
+
+    Status BaselineDownlinkPlanner::init(
+        size_t bytes, void* memory, Logger *logger
+    ) {
+        this->_logger = logger;
+        return SUCCESS;
+    }
+
+
+    Status BaselineDownlinkPlanner::deinit(void) {
+        this->_planned_entries.clear();
+        return SUCCESS;
+    }
+
+
+    Status BaselineDownlinkPlanner::prioritize(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        std::vector<int> &prioritized_list
+    ) {
+        Status status;
+
+        PlannerStats *stats = this->_begin_stats();
+        PhaseTimer total_timer(
+            this->_clock, stats ? &stats->total_time_sec : nullptr
+        );
+
+        Timer timer(this->_clock, max_processing_time_sec);
+        timer.start();
+
+        PhaseTimer config_timer(
+            this->_clock, stats ? &stats->config_time_sec : nullptr
+        );
+        RuleSet ruleset = parse_rule_config(
+            rule_configuration_id, this->_logger
+        );
+        config_timer.stop();
+
+        PhaseTimer load_timer(
+            this->_clock, stats ? &stats->load_time_sec : nullptr
+        );
+        std::vector<DpDbMsg> msgs;
+        status = this->_db->list_undownlinked_data_products(msgs);
+        if (status != SUCCESS) { return status; }
+        if (stats != nullptr) { stats->n_loaded = msgs.size(); }
+        this->_keep_loaded(msgs, true);
+
+        AsdpTable table;
+        table.reserve(msgs.size());
+        std::map<int, AsdpRowList> binned_rows;
+        for (auto &msg : msgs) {
+            int row = table.add_data_product(msg);
+            if (msg.get_downlink_state() != TRANSMITTED) {
+                binned_rows[msg.get_priority_bin()].push_back(row);
+            }
+        }
+        msgs.clear();
+        ruleset.bind(table);
+        load_timer.stop();
+
+        PhaseTimer planning_timer(
+            this->_clock, stats ? &stats->planning_time_sec : nullptr
+        );
+        LOG(this->_logger, Synopsis::LogType::INFO, "Baseline prioritization of %lu ASDPs in %lu bins", (unsigned long)table.size(), (unsigned long)binned_rows.size());
+        for (auto &entry : binned_rows) {
+            int bin = entry.first;
+            AsdpRowList &rows = entry.second;
+
+            BinStats bin_stats;
+            bin_stats.bin = bin;
+            bin_stats.n_asdps = rows.size();
+            PhaseTimer bin_timer(
+                this->_clock, stats ? &bin_stats.planning_time_sec : nullptr
+            );
+
+            // Sort by utility per byte; a stable sort keeps ties in order
+            auto ratio = [&](int row) {
+                int size = table.get_size(row);
+                if (size <= 0) {
+                    return std::numeric_limits<double>::infinity();
+                }
+                return table.get_sue(row) / size;
+            };
+            std::stable_sort(rows.begin(), rows.end(), [&](int a, int b) {
+                return ratio(a) > ratio(b);
+            });
+
+            bool has_constraints = !ruleset.get_constraints(bin).empty();
+            QueueAggregates aggregates;
+            ruleset.init_aggregates(bin, aggregates);
+            AsdpRowList queue;
+            queue.reserve(rows.size());
+
+            bool expired = false;
+            for (int row : rows) {
+                if (timer.is_expired()) {
+                    expired = true;
+                    break;
+                }
+
+                double sue = table.get_sue(row);
+                AsdpValue final_value = {FLOAT, true, 0, sue, -1};
+                table.set_value(row, AsdpTable::FINAL_SUE_SLOT, final_value);
+
+                queue.push_back(row);
+                if (has_constraints) {
+                    bin_stats.n_rule_evaluations++;
+                    auto applied = ruleset.apply_candidate(
+                        bin, table, queue, aggregates
+                    );
+                    if (!applied.first) {
+                        bin_stats.n_constraint_rejections++;
+                        queue.pop_back();
+                        continue;
+                    }
+                    ruleset.commit(bin, table, queue, aggregates);
+                }
+                prioritized_list.push_back(table.get_id(row));
+                if (stats != nullptr) { bin_stats.final_sues.push_back(sue); }
+            }
+
+            bin_timer.stop();
+            if (stats != nullptr) {
+                bin_stats.n_prioritized = queue.size();
+                stats->add_bin(bin_stats);
+            }
+
+            // As with the MMR planner, the list is kept through the first
+            // incomplete bin, so it is a prefix of the full ordering
+            if (expired) {
+                LOG(this->_logger, Synopsis::LogType::WARN, "Prioritization time expired; returning %lu ASDPs", (unsigned long)prioritized_list.size());
+                return TIMEOUT;
+            }
+        }
+
+        return SUCCESS;
+    }
+
+
+};
@@ -19,4 +19,142 @@ namespace Synopsis {
     }
 
 
+    void DownlinkPlanner::set_stats_enabled(bool enabled) {
+        this->_stats_enabled = enabled;
+    }
+
+
+    PlannerStats *DownlinkPlanner::_begin_stats(void) {
+        if (!this->_stats_enabled) {
+            return nullptr;
+        }
+        this->_stats.clear();
+        return &this->_stats;
+    }
+
+
+    void DownlinkPlanner::set_keep_entries(bool enabled) {
+        this->_keep_entries = enabled;
+        if (!enabled) {
+            this->_planned_entries.clear();
+        }
+    }
+
+
+    const DpDbMsg *DownlinkPlanner::get_planned_entry(int asdp_id) const {
+        auto found = this->_planned_entries.find(asdp_id);
+        if (found == this->_planned_entries.end()) {
+            return nullptr;
+        }
+        return &found->second;
+    }
+
+
+    void DownlinkPlanner::_keep_loaded(
+        const std::vector<DpDbMsg> &msgs, bool replace
+    ) {
+        if (!this->_keep_entries) {
+            return;
+        }
+        if (replace) {
+            this->_planned_entries.clear();
+        }
+        for (const auto &msg : msgs) {
+            this->_planned_entries[msg.get_dp_id()] = msg;
+        }
+    }
+
+
+    Status DownlinkPlanner::_get_entry(int asdp_id, DpDbMsg &msg) {
+        const DpDbMsg *entry = this->get_planned_entry(asdp_id);
+        if (entry != nullptr) {
+            msg = *entry;
+            return SUCCESS;
+        }
+        return this->_db->get_data_product(asdp_id, msg);
+    }
+
+
+    Status DownlinkPlanner::prioritize_with_budget(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        long max_bytes, int max_count,
+        std::vector<int> &prioritized_list,
+        int &cut_asdp_id
+    ) {
+        cut_asdp_id = -1;
+        std::vector<int> full_list;
+        Status status = this->prioritize(
+            rule_configuration_id, similarity_configuration_id,
+            max_processing_time_sec, full_list
+        );
+        if ((status != SUCCESS) && (status != TIMEOUT)) {
+            return status;
+        }
+
+        long total_bytes = 0;
+        DpDbMsg msg;
+        for (int asdp_id : full_list) {
+            Status get_status = this->_get_entry(asdp_id, msg);
+            if (get_status != SUCCESS) {
+                return get_status;
+            }
+            long size = (long)msg.get_dp_size();
+            bool over_count = (max_count >= 0) &&
+                ((int)prioritized_list.size() >= max_count);
+            bool over_bytes = (max_bytes >= 0) &&
+                (total_bytes + size > max_bytes);
+            if (over_count || over_bytes) {
+                cut_asdp_id = asdp_id;
+                return SUCCESS;
+            }
+            prioritized_list.push_back(asdp_id);
+            total_bytes += size;
+        }
+
+        return status;
+    }
+
+
+
+    Status DownlinkPlanner::prioritize_streaming(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        const BinCallback &on_bin
+    ) {
+        std::vector<int> full_list;
+        Status status = this->prioritize(
+            rule_configuration_id, similarity_configuration_id,
+            max_processing_time_sec, full_list
+        );
+        if ((status != SUCCESS) && (status != TIMEOUT)) {
+            return status;
+        }
+
+        // Bins are contiguous in the prioritized list
+        std::vector<int> bin_order;
+        int bin = 0;
+        DpDbMsg msg;
+        for (int asdp_id : full_list) {
+            Status get_status = this->_get_entry(asdp_id, msg);
+            if (get_status != SUCCESS) {
+                return get_status;
+            }
+            if (!bin_order.empty() && (msg.get_priority_bin() != bin)) {
+                on_bin(bin, bin_order);
+                bin_order.clear();
+            }
+            bin = msg.get_priority_bin();
+            bin_order.push_back(asdp_id);
+        }
+        if (!bin_order.empty()) {
+            on_bin(bin, bin_order);
+        }
+
+        return status;
+    }
+
+
 };
@@ -0,0 +1,421 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see DpBundle.hpp
+ */
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DpBundle.hpp"
+
+
+namespace Synopsis {
+
+
+    const int DpBundle::VERSION;
+
+
+    /**
+     * Identifies a bundle file
+     */
+    static const char BUNDLE_MAGIC[8] = {'S', 'Y', 'N', 'D', 'P', 'B', 'N', '\0'};
+
+
+    /**
+     * Bundle file header, followed by the string table, product table, field
+     * table, and metadata columns at the given offsets
+     */
+    struct BundleHeader {
+        char magic[8];
+        int32_t version;
+        int32_t product_record_size;
+        int32_t field_record_size;
+        int32_t reserved;
+        int64_t n_products;
+        int64_t n_fields;
+        uint64_t strings_offset;
+        uint64_t strings_bytes;
+        uint64_t products_offset;
+        uint64_t fields_offset;
+        uint64_t file_bytes;
+    };
+
+
+    /**
+     * @param[in] n_bytes: size of a section
+     *
+     * @return: size of the section padded to a multiple of 8 bytes
+     */
+    static uint64_t _pad8(uint64_t n_bytes) {
+        return (n_bytes + 7) & ~(uint64_t)7;
+    }
+
+
+    /**
+     * @param[in] n_products: number of products
+     *
+     * @return: size of a metadata column, including its presence bytes
+     */
+    static uint64_t _column_bytes(uint64_t n_products) {
+        return _pad8(n_products) + n_products * sizeof(uint64_t);
+    }
+
+
+    DpBundle::DpBundle(Logger *logger) :
+        _logger(logger)
+    {
+
+    }
+
+
+    DpBundle::~DpBundle() {
+        this->close();
+    }
+
+
+    Status DpBundle::open(const std::string &path) {
+        this->close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Bundle %s not opened", path.c_str());
+            return FAILURE;
+        }
+
+        struct stat st;
+        void *data = MAP_FAILED;
+        if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+            data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Bundle %s not mapped", path.c_str());
+            return FAILURE;
+        }
+
+        this->_data = (const char*)data;
+        this->_n_bytes = st.st_size;
+        if (!this->_validate()) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Bundle %s has an unsupported format or is corrupt", path.c_str());
+            this->close();
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+    void DpBundle::close(void) {
+        if (this->_data != nullptr) {
+            munmap((void*)this->_data, this->_n_bytes);
+        }
+        this->_data = nullptr;
+        this->_n_bytes = 0;
+        this->_n_products = 0;
+        this->_n_fields = 0;
+        this->_strings = nullptr;
+        this->_products = nullptr;
+        this->_fields = nullptr;
+    }
+
+
+    bool DpBundle::_validate(void) {
+        if (this->_n_bytes < sizeof(BundleHeader)) { return false; }
+        const BundleHeader *header = (const BundleHeader*)this->_data;
+        if ((std::memcmp(header->magic, BUNDLE_MAGIC, sizeof(header->magic)) != 0) ||
+                (header->version != VERSION) ||
+                (header->product_record_size != (int32_t)sizeof(ProductRecord)) ||
+                (header->field_record_size != (int32_t)sizeof(FieldRecord)) ||
+                (header->file_bytes != this->_n_bytes)) {
+            return false;
+        }
+
+        // Sections are bounded before their sizes are computed, so the
+        // computations cannot overflow
+        uint64_t n_bytes = this->_n_bytes;
+        auto in_file = [n_bytes](uint64_t offset, uint64_t size) {
+            return (offset % 8 == 0) && (offset <= n_bytes) &&
+                (size <= n_bytes - offset);
+        };
+        if ((header->n_products < 0) || (header->n_products > INT_MAX) ||
+                (header->n_fields < 0) || (header->n_fields > INT_MAX)) {
+            return false;
+        }
+        uint64_t n_products = header->n_products;
+        uint64_t n_fields = header->n_fields;
+        if ((n_products > n_bytes) || (n_fields > n_bytes) ||
+                !in_file(header->strings_offset, header->strings_bytes) ||
+                !in_file(header->products_offset, n_products * sizeof(ProductRecord)) ||
+                !in_file(header->fields_offset, n_fields * sizeof(FieldRecord))) {
+            return false;
+        }
+
+        // All strings are terminated within the string table
+        const char *strings = this->_data + header->strings_offset;
+        uint64_t strings_bytes = header->strings_bytes;
+        if ((strings_bytes == 0) || (strings[strings_bytes - 1] != '\0')) {
+            return false;
+        }
+
+        const ProductRecord *products = \
+            (const ProductRecord*)(this->_data + header->products_offset);
+        for (uint64_t i = 0; i < n_products; i++) {
+            const ProductRecord &product = products[i];
+            if ((product.instrument_name >= strings_bytes) ||
+                    (product.type >= strings_bytes) ||
+                    (product.uri >= strings_bytes) ||
+                    (product.dp_id < -1) || (product.dp_id > INT_MAX) ||
+                    (product.priority_bin < INT_MIN) ||
+                    (product.priority_bin > INT_MAX) ||
+                    (product.downlink_state < UNTRANSMITTED) ||
+                    (product.downlink_state > DOWNLINKED)) {
+                return false;
+            }
+        }
+
+        const FieldRecord *fields = \
+            (const FieldRecord*)(this->_data + header->fields_offset);
+        for (uint64_t f = 0; f < n_fields; f++) {
+            const FieldRecord &field = fields[f];
+            if ((field.name >= strings_bytes) ||
+                    (field.type < INT) || (field.type > STRING) ||
+                    !in_file(field.column_offset, _column_bytes(n_products))) {
+                return false;
+            }
+            if (field.type != STRING) { continue; }
+            const char *present = this->_data + field.column_offset;
+            const char *values = present + _pad8(n_products);
+            for (uint64_t i = 0; i < n_products; i++) {
+                uint64_t value;
+                std::memcpy(&value, values + i * sizeof(value), sizeof(value));
+                if (present[i] && (value >= strings_bytes)) { return false; }
+            }
+        }
+
+        this->_n_products = n_products;
+        this->_n_fields = n_fields;
+        this->_strings = strings;
+        this->_products = products;
+        this->_fields = fields;
+        return true;
+    }
+
+
+    Status DpBundle::get_data_product(int index, DpDbMsg &msg) const {
+        if ((index < 0) || (index >= this->_n_products)) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Bundle product %d not found", index);
+            return FAILURE;
+        }
+
+        const ProductRecord &product = this->_products[index];
+        msg.set_dp_id(product.dp_id);
+        msg.set_instrument_name(this->_strings + product.instrument_name);
+        msg.set_type(this->_strings + product.type);
+        msg.set_uri(this->_strings + product.uri);
+        msg.set_dp_size(product.size);
+        msg.set_science_utility_estimate(product.science_utility_estimate);
+        msg.set_priority_bin(product.priority_bin);
+        msg.set_downlink_state((DownlinkState)product.downlink_state);
+
+        AsdpEntry metadata;
+        for (int f = 0; f < this->_n_fields; f++) {
+            const FieldRecord &field = this->_fields[f];
+            const char *present = this->_data + field.column_offset;
+            if (!present[index]) { continue; }
+
+            uint64_t bits;
+            std::memcpy(
+                &bits, present + _pad8(this->_n_products) + index * sizeof(bits),
+                sizeof(bits)
+            );
+            const char *name = this->_strings + field.name;
+            switch (field.type) {
+                case INT: {
+                    int64_t value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    metadata[name] = DpMetadataValue((int)value);
+                    break;
+                }
+                case FLOAT: {
+                    double value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    metadata[name] = DpMetadataValue(value);
+                    break;
+                }
+                default:
+                    metadata[name] = DpMetadataValue(
+                        std::string(this->_strings + bits)
+                    );
+                    break;
+            }
+        }
+        msg.set_metadata(std::move(metadata));
+
+        return SUCCESS;
+    }
+
+
+    Status DpBundle::get_data_products(std::vector<DpDbMsg> &msgs) const {
+        msgs.clear();
+        if (this->_data == nullptr) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Bundle not open");
+            return FAILURE;
+        }
+
+        msgs.resize(this->_n_products);
+        for (int i = 0; i < this->_n_products; i++) {
+            this->get_data_product(i, msgs[i]);
+        }
+        return SUCCESS;
+    }
+
+
+    DpBundleWriter::DpBundleWriter() {
+        // Offset zero holds the empty string
+        this->_intern("");
+    }
+
+
+    uint64_t DpBundleWriter::_intern(const std::string &value) {
+        auto found = this->_string_offsets.find(value);
+        if (found != this->_string_offsets.end()) {
+            return found->second;
+        }
+        uint64_t offset = this->_strings.size();
+        this->_strings.append(value.c_str(), value.size() + 1);
+        this->_string_offsets.emplace(value, offset);
+        return offset;
+    }
+
+
+    void DpBundleWriter::add_data_product(const DpDbMsg &msg) {
+        int index = this->_products.size();
+
+        DpBundle::ProductRecord product;
+        product.dp_id = msg.get_dp_id();
+        product.instrument_name = this->_intern(msg.get_instrument_name());
+        product.type = this->_intern(msg.get_type());
+        product.uri = this->_intern(msg.get_uri());
+        product.size = msg.get_dp_size();
+        product.science_utility_estimate = msg.get_science_utility_estimate();
+        product.priority_bin = msg.get_priority_bin();
+        product.downlink_state = msg.get_downlink_state();
+        this->_products.push_back(product);
+
+        for (const auto &elem : msg.get_metadata()) {
+            const DpMetadataValue &value = elem.second;
+            uint64_t bits;
+            switch (value.get_type()) {
+                case INT: {
+                    int64_t int_value = value.get_int_value();
+                    std::memcpy(&bits, &int_value, sizeof(bits));
+                    break;
+                }
+                case FLOAT: {
+                    double float_value = value.get_float_value();
+                    std::memcpy(&bits, &float_value, sizeof(bits));
+                    break;
+                }
+                default:
+                    bits = this->_intern(value.get_string_value());
+                    break;
+            }
+            auto key = std::make_pair(
+                this->_intern(elem.first), (int64_t)value.get_type()
+            );
+            this->_columns[key][index] = bits;
+        }
+    }
+
+
+    Status DpBundleWriter::write(const std::string &path, Logger *logger) const {
+        uint64_t n_products = this->_products.size();
+        uint64_t n_fields = this->_columns.size();
+
+        BundleHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, BUNDLE_MAGIC, sizeof(header.magic));
+        header.version = DpBundle::VERSION;
+        header.product_record_size = sizeof(DpBundle::ProductRecord);
+        header.field_record_size = sizeof(DpBundle::FieldRecord);
+        header.n_products = n_products;
+        header.n_fields = n_fields;
+        header.strings_offset = _pad8(sizeof(header));
+        header.strings_bytes = this->_strings.size();
+        header.products_offset = \
+            header.strings_offset + _pad8(header.strings_bytes);
+        header.fields_offset = header.products_offset + \
+            n_products * sizeof(DpBundle::ProductRecord);
+        uint64_t columns_offset = header.fields_offset + \
+            n_fields * sizeof(DpBundle::FieldRecord);
+        header.file_bytes = columns_offset + \
+            n_fields * _column_bytes(n_products);
+
+        std::vector<DpBundle::FieldRecord> fields;
+        fields.reserve(n_fields);
+        for (const auto &column : this->_columns) {
+            DpBundle::FieldRecord field;
+            field.name = column.first.first;
+            field.type = column.first.second;
+            field.column_offset = columns_offset + \
+                fields.size() * _column_bytes(n_products);
+            fields.push_back(field);
+        }
+
+        std::string tmp_path = path + ".tmp";
+        bool written;
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            const char padding[8] = {0};
+            file.write((const char*)&header, sizeof(header));
+            file.write(padding, header.strings_offset - sizeof(header));
+            file.write(this->_strings.data(), this->_strings.size());
+            file.write(padding, _pad8(header.strings_bytes) - header.strings_bytes);
+            file.write(
+                (const char*)this->_products.data(),
+                n_products * sizeof(DpBundle::ProductRecord)
+            );
+            file.write(
+                (const char*)fields.data(),
+                n_fields * sizeof(DpBundle::FieldRecord)
+            );
+
+            std::vector<char> present(_pad8(n_products));
+            std::vector<uint64_t> values(n_products);
+            for (const auto &column : this->_columns) {
+                std::fill(present.begin(), present.end(), 0);
+                std::fill(values.begin(), values.end(), 0);
+                for (const auto &entry : column.second) {
+                    present[entry.first] = 1;
+                    values[entry.first] = entry.second;
+                }
+                file.write(present.data(), present.size());
+                file.write(
+                    (const char*)values.data(),
+                    values.size() * sizeof(uint64_t)
+                );
+            }
+            file.close();
+            written = !file.fail();
+        }
+
+        if (!written || (std::rename(tmp_path.c_str(), path.c_str()) != 0)) {
+            LOG(logger, Synopsis::LogType::ERROR, "Bundle not written to %s", path.c_str());
+            std::remove(tmp_path.c_str());
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+};
@@ -4,6 +4,9 @@
  *
  * @see DpDbMsg.hpp
  */
+#include <new>
+#include <utility>
+
 #include "synopsis.hpp"
 #include "DpDbMsg.hpp"
 
@@ -12,36 +15,28 @@ namespace Synopsis {
 
     DpMetadataValue::DpMetadataValue() :
         type(INT),
-        int_value(0),
-        float_value(0.0),
-        string_value("")
+        int_value(0)
     {
 
     }
 
     DpMetadataValue::DpMetadataValue(int value) :
         type(INT),
-        int_value(value),
-        float_value(0.0),
-        string_value("")
+        int_value(value)
     {
 
     }
 
     DpMetadataValue::DpMetadataValue(double value) :
         type(FLOAT),
-        int_value(0),
-        float_value(value),
-        string_value("")
+        float_value(value)
     {
 
     }
 
     DpMetadataValue::DpMetadataValue(std::string value) :
         type(STRING),
-        int_value(0),
-        float_value(0.0),
-        string_value(value)
+        string_value(std::move(value))
     {
 
     }
@@ -52,42 +47,122 @@ namespace Synopsis {
         double float_value,
         std::string string_value
     ) :
-        type(type),
-        int_value(int_value),
-        float_value(float_value),
-        string_value(string_value)
+        type(type)
     {
+        switch (type) {
+            case INT:
+                this->int_value = int_value;
+                break;
+            case FLOAT:
+                this->float_value = float_value;
+                break;
+            default:
+                new (&this->string_value) std::string(std::move(string_value));
+                break;
+        }
+    }
+
+    DpMetadataValue::DpMetadataValue(const DpMetadataValue &other) {
+        this->_copy_from(other);
+    }
+
+    DpMetadataValue::DpMetadataValue(DpMetadataValue &&other) {
+        this->_move_from(std::move(other));
+    }
+
+    DpMetadataValue::~DpMetadataValue() {
+        this->_destroy();
+    }
+
+    DpMetadataValue &DpMetadataValue::operator=(const DpMetadataValue &other) {
+        if (this == &other) { return *this; }
+        if ((this->type == STRING) && (other.type == STRING)) {
+            this->string_value = other.string_value;
+            return *this;
+        }
+        this->_destroy();
+        this->_copy_from(other);
+        return *this;
+    }
+
+    DpMetadataValue &DpMetadataValue::operator=(DpMetadataValue &&other) {
+        if (this == &other) { return *this; }
+        if ((this->type == STRING) && (other.type == STRING)) {
+            this->string_value = std::move(other.string_value);
+            return *this;
+        }
+        this->_destroy();
+        this->_move_from(std::move(other));
+        return *this;
+    }
+
+    void DpMetadataValue::_copy_from(const DpMetadataValue &other) {
+        this->type = other.type;
+        switch (other.type) {
+            case INT:
+                this->int_value = other.int_value;
+                break;
+            case FLOAT:
+                this->float_value = other.float_value;
+                break;
+            default:
+                new (&this->string_value) std::string(other.string_value);
+                break;
+        }
+    }
+
+    void DpMetadataValue::_move_from(DpMetadataValue &&other) {
+        this->type = other.type;
+        switch (other.type) {
+            case INT:
+                this->int_value = other.int_value;
+                break;
+            case FLOAT:
+                this->float_value = other.float_value;
+                break;
+            default:
+                new (&this->string_value) std::string(std::move(other.string_value));
+                break;
+        }
+    }
 
+    void DpMetadataValue::_destroy(void) {
+        if (this->type == STRING) {
+            this->string_value.~basic_string();
+        }
     }
 
-    MetadataType DpMetadataValue::get_type(void) {
+    MetadataType DpMetadataValue::get_type(void) const {
         return this->type;
     }
 
-    int DpMetadataValue::get_int_value(void) {
-        return this->int_value;
+    int DpMetadataValue::get_int_value(void) const {
+        return (this->type == INT) ? this->int_value : 0;
     }
 
-    double DpMetadataValue::get_float_value(void) {
-        return this->float_value;
+    double DpMetadataValue::get_float_value(void) const {
+        return (this->type == FLOAT) ? this->float_value : 0.0;
     }
 
-    std::string DpMetadataValue::get_string_value(void) {
-        return this->string_value;
+    const std::string &DpMetadataValue::get_string_value(void) const {
+        static const std::string EMPTY_STRING;
+        return (this->type == STRING) ? this->string_value : EMPTY_STRING;
     }
 
 
-    bool DpMetadataValue::is_numeric(void) {
+    bool DpMetadataValue::is_numeric(void) const {
         return (this->type == INT) || (this->type == FLOAT);
     }
 
 
-    double DpMetadataValue::get_numeric(void) {
+    double DpMetadataValue::get_numeric(void) const {
         switch (this->type) {
             case INT:
                 return (double)this->int_value;
-            default:
+            case FLOAT:
                 return this->float_value;
+            default:
+                return 0.0;
         }
     }
 
@@ -118,70 +193,88 @@ namespace Synopsis {
         AsdpEntry metadata
         ) :
         dp_id(dp_id),
-        instrument_name(instrument_name),
-        dp_type(dp_type),
-        dp_uri(dp_uri),
+        instrument_name(std::move(instrument_name)),
+        dp_type(std::move(dp_type)),
+        dp_uri(std::move(dp_uri)),
         dp_size(dp_size),
         science_utility_estimate(science_utility_estimate),
         priority_bin(priority_bin),
         downlink_state(downlink_state),
-        metadata(metadata)
+        metadata(std::move(metadata))
     {
 
     }
 
-    int DpDbMsg::get_dp_id(void) {
+    int DpDbMsg::get_dp_id(void) const {
         return this->dp_id;
     }
 
-    std::string DpDbMsg::get_instrument_name(void) {
+    const std::string &DpDbMsg::get_instrument_name(void) const {
         return this->instrument_name;
     }
 
-    std::string DpDbMsg::get_type(void) {
+    const std::string &DpDbMsg::get_type(void) const {
         return this->dp_type;
     }
 
-    std::string DpDbMsg::get_uri(void) {
+    const std::string &DpDbMsg::get_uri(void) const {
         return this->dp_uri;
     }
 
-    size_t DpDbMsg::get_dp_size(void) {
+    size_t DpDbMsg::get_dp_size(void) const {
         return this->dp_size;
     }
 
-    double DpDbMsg::get_science_utility_estimate(void) {
+    double DpDbMsg::get_science_utility_estimate(void) const {
         return this->science_utility_estimate;
     }
 
-    int DpDbMsg::get_priority_bin(void) {
+    int DpDbMsg::get_priority_bin(void) const {
         return this->priority_bin;
     }
 
-    DownlinkState DpDbMsg::get_downlink_state(void) {
+    DownlinkState DpDbMsg::get_downlink_state(void) const {
         return this->downlink_state;
     }
 
-    AsdpEntry DpDbMsg::get_metadata(void) {
+    const AsdpEntry &DpDbMsg::get_metadata(void) const {
         return this->metadata;
     }
 
+    AsdpEntry DpDbMsg::take_metadata(void) {
+        AsdpEntry metadata = std::move(this->metadata);
+        this->metadata.clear();
+        return metadata;
+    }
+
     void DpDbMsg::set_dp_id(int id) {
         this->dp_id = id;
     }
 
-    void DpDbMsg::set_instrument_name(std::string name) {
+    void DpDbMsg::set_instrument_name(const std::string &name) {
         this->instrument_name = name;
     }
 
-    void DpDbMsg::set_type(std::string type) {
+    void DpDbMsg::set_instrument_name(std::string &&name) {
+        this->instrument_name = std::move(name);
+    }
+
+    void DpDbMsg::set_type(const std::string &type) {
         this->dp_type = type;
     }
 
-    void DpDbMsg::set_uri(std::string uri) {
+    void DpDbMsg::set_type(std::string &&type) {
+        this->dp_type = std::move(type);
+    }
+
+    void DpDbMsg::set_uri(const std::string &uri) {
         this->dp_uri = uri;
     }
 
+    void DpDbMsg::set_uri(std::string &&uri) {
+        this->dp_uri = std::move(uri);
+    }
+
     void DpDbMsg::set_dp_size(size_t size) {
         this->dp_size = size;
     }
@@ -198,9 +291,13 @@ namespace Synopsis {
         this->downlink_state = state;
     }
 
-    void DpDbMsg::set_metadata(AsdpEntry metadata) {
+    void DpDbMsg::set_metadata(const AsdpEntry &metadata) {
         this->metadata = metadata;
     }
 
+    void DpDbMsg::set_metadata(AsdpEntry &&metadata) {
+        this->metadata = std::move(metadata);
+    }
+
 
 };
@@ -4,6 +4,8 @@
  *
  * @see DpMsg.hpp
  */
+#include <utility>
+
 #include "synopsis.hpp"
 
 namespace Synopsis {
@@ -26,32 +28,32 @@ namespace Synopsis {
         std::string meta_uri,
         bool meta_usage
         ) :
-        instrument_name(instrument_name),
-        dp_type(dp_type),
-        dp_uri(dp_uri),
-        meta_uri(meta_uri),
+        instrument_name(std::move(instrument_name)),
+        dp_type(std::move(dp_type)),
+        dp_uri(std::move(dp_uri)),
+        meta_uri(std::move(meta_uri)),
         meta_usage(meta_usage)
     {
 
     }
 
-    std::string DpMsg::get_instrument_name(void) {
+    const std::string &DpMsg::get_instrument_name(void) const {
         return this->instrument_name;
     }
 
-    std::string DpMsg::get_type(void) {
+    const std::string &DpMsg::get_type(void) const {
         return this->dp_type;
     }
 
-    std::string DpMsg::get_uri(void) {
+    const std::string &DpMsg::get_uri(void) const {
         return this->dp_uri;
     }
 
-    std::string DpMsg::get_metadata_uri(void) {
+    const std::string &DpMsg::get_metadata_uri(void) const {
         return this->meta_uri;
     }
 
-    bool DpMsg::get_metadata_usage(void) {
+    bool DpMsg::get_metadata_usage(void) const {
         return this->meta_usage;
     }
 
@@ -0,0 +1,92 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see IngestQueue.hpp
+ */
+#include <utility>
+
+#include "IngestQueue.hpp"
+
+
+namespace Synopsis {
+
+
+    IngestQueue::IngestQueue(size_t capacity) :
+        _enqueue_position(0),
+        _dequeue_position(0)
+    {
+        size_t n_slots = 1;
+        while (n_slots < capacity) {
+            n_slots <<= 1;
+        }
+        this->_slots.reset(new Slot[n_slots]);
+        this->_mask = n_slots - 1;
+        for (size_t i = 0; i < n_slots; i++) {
+            this->_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+
+    bool IngestQueue::try_push(const DpMsg &msg) {
+        size_t position;
+        Slot *slot = this->_claim(position);
+        if (slot == nullptr) {
+            return false;
+        }
+        slot->msg = msg;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    bool IngestQueue::try_push(DpMsg &&msg) {
+        size_t position;
+        Slot *slot = this->_claim(position);
+        if (slot == nullptr) {
+            return false;
+        }
+        slot->msg = std::move(msg);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    IngestQueue::Slot *IngestQueue::_claim(size_t &position) {
+        position = this->_enqueue_position.load(std::memory_order_relaxed);
+        while (true) {
+            Slot *slot = &this->_slots[position & this->_mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence == position) {
+                // The slot is free; claim its position
+                if (this->_enqueue_position.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    return slot;
+                }
+            } else if (sequence < position) {
+                // The slot still holds the message from one lap earlier
+                return nullptr;
+            } else {
+                // Another producer claimed the position
+                position = this->_enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+
+    bool IngestQueue::try_pop(DpMsg &msg) {
+        size_t position = this->_dequeue_position;
+        Slot *slot = &this->_slots[position & this->_mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence != position + 1) {
+            // Empty, or the producer of this position has not finished
+            return false;
+        }
+        msg = std::move(slot->msg);
+        slot->sequence.store(position + this->_mask + 1, std::memory_order_release);
+        this->_dequeue_position = position + 1;
+        return true;
+    }
+
+
+};
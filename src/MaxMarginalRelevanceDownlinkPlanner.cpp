@@ -4,6 +4,11 @@
  *
  * @see MaxMarginalRelevanceDownlinkPlanner.hpp
  */
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sys/stat.h>
+
 #include "MaxMarginalRelevanceDownlinkPlanner.hpp"
 #include "Timer.hpp"
 
@@ -11,48 +16,369 @@
 namespace Synopsis {
 
 
-    Status _populate_asdp(DpDbMsg msg, AsdpEntry &asdp) {
-
-        // Initialize with existing metadata
-        asdp = msg.get_metadata();
-
-        // Add "first class" metadata fields
+    /**
+     * Adds the "first class" metadata fields of an ASDPDB message to an ASDP
+     */
+    static void _add_first_class_fields(const DpDbMsg &msg, AsdpEntry &asdp) {
         asdp["id"] = DpMetadataValue(msg.get_dp_id());
         asdp["instrument_name"] = DpMetadataValue(msg.get_instrument_name());
         asdp["type"] = DpMetadataValue(msg.get_type());
         asdp["size"] = DpMetadataValue((int)msg.get_dp_size());
         asdp["science_utility_estimate"] = DpMetadataValue(msg.get_science_utility_estimate());
         asdp["priority_bin"] = DpMetadataValue(msg.get_priority_bin());
+    }
+
+
+    Status _populate_asdp(const DpDbMsg &msg, AsdpEntry &asdp) {
+
+        // Initialize with existing metadata
+        asdp = msg.get_metadata();
+
+        _add_first_class_fields(msg, asdp);
+
+        return SUCCESS;
+    }
+
+
+    Status _populate_asdp(DpDbMsg &&msg, AsdpEntry &asdp) {
+
+        // Initialize with existing metadata, taken from the message
+        asdp = msg.take_metadata();
+
+        _add_first_class_fields(msg, asdp);
 
         return SUCCESS;
     }
 
 
+    /**
+     * Best candidate among a range of candidates scored during one greedy
+     * step. A serial scan keeps the first feasible candidate if its relative
+     * utility is NaN (since no value compares greater), and otherwise keeps
+     * the lowest-index candidate with the greatest non-NaN relative utility.
+     * Both are tracked so that ranges scored concurrently can be reduced, in
+     * index order, to the result of the serial scan.
+     */
+    struct CandidateScore {
+        int first_idx = -1;
+        double first_value = 0.0;
+        double first_sue = 0.0;
+        int best_idx = -1;
+        double best_value = 0.0;
+        double best_sue = 0.0;
+
+        // Candidates evaluated against rules and constraints, and those
+        // rejected by a violated constraint
+        long n_evaluated = 0;
+        long n_rejected = 0;
+
+        void update(int idx, double value, double sue) {
+            if (this->first_idx < 0) {
+                this->first_idx = idx;
+                this->first_value = value;
+                this->first_sue = sue;
+            }
+            if (!std::isnan(value) &&
+                    ((this->best_idx < 0) || (value > this->best_value))) {
+                this->best_idx = idx;
+                this->best_value = value;
+                this->best_sue = sue;
+            }
+        }
+
+        void reduce(const CandidateScore &later) {
+            this->n_evaluated += later.n_evaluated;
+            this->n_rejected += later.n_rejected;
+            if (this->first_idx < 0) {
+                this->first_idx = later.first_idx;
+                this->first_value = later.first_value;
+                this->first_sue = later.first_sue;
+            }
+            if ((later.best_idx >= 0) && ((this->best_idx < 0) ||
+                    (later.best_value > this->best_value))) {
+                this->best_idx = later.best_idx;
+                this->best_value = later.best_value;
+                this->best_sue = later.best_sue;
+            }
+        }
+
+        bool first_is_nan(void) const {
+            return (this->first_idx >= 0) && std::isnan(this->first_value);
+        }
+
+        int get_idx(void) const {
+            return this->first_is_nan() ? this->first_idx : this->best_idx;
+        }
+
+        double get_sue(void) const {
+            return this->first_is_nan() ? this->first_sue : this->best_sue;
+        }
+    };
+
+
+    /**
+     * Checks the processing deadline before a greedy step
+     *
+     * @param[in] timer: processing deadline, or null for no deadline
+     * @param[out] expired: if non-null, set to `true` if the deadline expired
+     *
+     * @return: `true` if the deadline expired
+     */
+    bool _check_deadline(Timer *timer, bool *expired) {
+        if ((timer == nullptr) || !timer->is_expired()) {
+            return false;
+        }
+        if (expired != nullptr) {
+            *expired = true;
+        }
+        return true;
+    }
+
+
+    /**
+     * Checks whether the ASDP chosen by a greedy step fits within the bin's
+     * budget
+     *
+     * @param[in,out] budget: bin budget, or null for no budget; its cut point
+     * is set if the ASDP does not fit
+     * @param[in] n_selected: number of ASDPs already selected
+     * @param[in] cumulative_size: total size of the ASDPs already selected
+     * @param[in] size: size of the chosen ASDP
+     * @param[in] asdp_id: identifier of the chosen ASDP
+     *
+     * @return: `true` if the ASDP does not fit
+     */
+    bool _exceeds_budget(
+        BinBudget *budget, int n_selected, long cumulative_size,
+        int size, int asdp_id
+    ) {
+        if (budget == nullptr) {
+            return false;
+        }
+        bool over_count = (budget->max_count >= 0) &&
+            (n_selected >= budget->max_count);
+        bool over_bytes = (budget->max_bytes >= 0) &&
+            (cumulative_size + size > budget->max_bytes);
+        if (over_count || over_bytes) {
+            budget->cut_asdp_id = asdp_id;
+            return true;
+        }
+        return false;
+    }
+
+
+    /**
+     * Records the counters of a bin's prioritization
+     *
+     * @param[out] stats: bin statistics to populate
+     * @param[in] counts: counters accumulated by the prioritization
+     * @param[in] n_asdps: number of candidate ASDPs
+     * @param[in] n_prioritized: number of ASDPs prioritized
+     */
+    void _record_bin_stats(
+        BinStats *stats, const BinStats &counts, int n_asdps, int n_prioritized
+    ) {
+        stats->n_asdps = n_asdps;
+        stats->n_prioritized = n_prioritized;
+        stats->n_rule_evaluations = counts.n_rule_evaluations;
+        stats->n_constraint_rejections = counts.n_constraint_rejections;
+        stats->n_similarity_hits = counts.n_similarity_hits;
+        stats->n_similarity_misses = counts.n_similarity_misses;
+    }
+
+
+    /**
+     * Returns the number of chunks into which a candidate scan is split
+     *
+     * @param[in] pool: thread pool, or null
+     * @param[in] threshold: minimum number of candidates for a parallel scan,
+     * or zero to disable parallel scans
+     * @param[in] n_candidates: number of candidates to scan
+     *
+     * @return: number of chunks
+     */
+    int _num_scan_chunks(ThreadPool *pool, int threshold, int n_candidates) {
+        if ((pool == nullptr) || (threshold <= 0) ||
+                (n_candidates < threshold)) {
+            return 1;
+        }
+        return std::min(pool->num_workers() + 1, n_candidates);
+    }
+
+
+    /**
+     * Runs a loop body over contiguous chunks of [0, n), concurrently if more
+     * than one chunk is requested
+     *
+     * @param[in] pool: thread pool used for more than one chunk
+     * @param[in] n_chunks: number of chunks
+     * @param[in] n: number of loop iterations
+     * @param[in] body: invoked with the chunk index and iteration range
+     */
+    void _parallel_for(
+        ThreadPool *pool, int n_chunks, int n,
+        const std::function<void(int, int, int)> &body
+    ) {
+        if (n_chunks <= 1) {
+            body(0, 0, n);
+            return;
+        }
+        std::vector<PoolTask> tasks;
+        for (int c = 0; c < n_chunks; c++) {
+            int lo = (int)(((long)n * c) / n_chunks);
+            int hi = (int)(((long)n * (c + 1)) / n_chunks);
+            tasks.push_back([&body, c, lo, hi]() { body(c, lo, hi); });
+        }
+        pool->run(tasks);
+    }
+
+
+    /**
+     * Number of candidates, and of transmitted ASDPs, in each tile of
+     * _transmitted_similarity
+     */
+    static const int TRANSMITTED_TILE_SIZE = 128;
+
+
+    std::vector<double> _transmitted_similarity(
+        const AsdpTable &table,
+        const AsdpRowList &rows,
+        const AsdpRowList &transmitted,
+        const std::vector<SimilarityFunction*> &functions
+    ) {
+        int n_asdps = rows.size();
+        std::vector<double> max_similarity(n_asdps, 0.0);
+
+        // Group candidate indices and transmitted rows by key
+        int n_keys = functions.size();
+        std::vector<std::vector<int>> key_candidates(n_keys);
+        std::vector<AsdpRowList> key_transmitted(n_keys);
+        for (int idx = 0; idx < n_asdps; idx++) {
+            key_candidates[table.get_key_id(rows[idx])].push_back(idx);
+        }
+        for (int row : transmitted) {
+            key_transmitted[table.get_key_id(row)].push_back(row);
+        }
+
+        // Each tile's block holds similarities among its candidates and
+        // transmitted ASDPs, of which the candidate-transmitted entries are
+        // used
+        std::vector<double> descriptors;
+        std::vector<double> block;
+        std::vector<int> tile;
+        for (int k = 0; k < n_keys; k++) {
+            SimilarityFunction *function = functions[k];
+            const std::vector<int> &candidates = key_candidates[k];
+            const AsdpRowList &context = key_transmitted[k];
+            if ((function == nullptr) || candidates.empty() || context.empty()) {
+                continue;
+            }
+            int n_candidates = candidates.size();
+            int n_context = context.size();
+            for (int c = 0; c < n_candidates; c += TRANSMITTED_TILE_SIZE) {
+                int c_end = std::min(c + TRANSMITTED_TILE_SIZE, n_candidates);
+                for (int t = 0; t < n_context; t += TRANSMITTED_TILE_SIZE) {
+                    int t_end = std::min(t + TRANSMITTED_TILE_SIZE, n_context);
+                    tile.clear();
+                    for (int i = c; i < c_end; i++) {
+                        tile.push_back(rows[candidates[i]]);
+                    }
+                    tile.insert(
+                        tile.end(), context.begin() + t, context.begin() + t_end
+                    );
+                    int n = tile.size();
+                    descriptors.resize((size_t)n * function->num_descriptors());
+                    block.resize((size_t)n * n);
+                    function->get_similarity_block(
+                        table, tile, descriptors.data(), block.data()
+                    );
+                    for (int i = 0; i < c_end - c; i++) {
+                        double &max_sim = max_similarity[candidates[c + i]];
+                        for (int j = c_end - c; j < n; j++) {
+                            max_sim = std::max(max_sim, block[(i * n) + j]);
+                        }
+                    }
+                }
+            }
+        }
+
+        return max_similarity;
+    }
+
+
     std::vector<int> _prioritize_bin(
         int bin,
         AsdpList asdps,
-        RuleSet ruleset,
-        Similarity similarity
+        RuleSet &ruleset,
+        Similarity &similarity,
+        ThreadPool *pool,
+        int scan_threshold,
+        Timer *timer,
+        bool *expired,
+        BinBudget *budget,
+        BinStats *stats,
+        Logger *logger,
+        const AsdpList *transmitted
     ) {
         AsdpList prioritized;
         int maxiter = asdps.size();
+        prioritized.reserve(maxiter + 1);
+
+        // The maximum similarity of each candidate to transmitted ASDPs is
+        // computed once and kept alongside the candidates (not in their
+        // fields, which rules and similarity functions may read)
+        std::vector<double> context;
+        if (transmitted != nullptr) {
+            context.reserve(maxiter);
+            for (auto &asdp : asdps) {
+                context.push_back(
+                    similarity.get_max_similarity(bin, *transmitted, asdp)
+                );
+            }
+        }
+
+        // Each additional chunk of a parallel scan has its own copy of the
+        // queue (to which candidates are temporarily appended) and of the
+        // similarity configuration (whose cache it updates)
+        int max_chunks = _num_scan_chunks(pool, scan_threshold, maxiter);
+        std::vector<AsdpList> chunk_queues(max_chunks - 1);
+        std::vector<Similarity> chunk_similarities(max_chunks - 1, similarity);
 
         int cumulative_size = 0;
         double cumulative_sue = 0.0;
 
-        for (int i = 0; i < maxiter; i++) {
-            std::cout <<  "Prioritize Step 2 >>>  looping over ASDP list item # " << i+1 << "/" << maxiter << std::endl;
-            int idx = -1;
-            int best_idx = -1;
-            double best_value = 0.0;
-            for (auto &asdp : asdps) {
-                idx += 1;
-                AsdpList candidate(prioritized);
-                candidate.push_back(asdp);
+        // Keys whose similarity function is indexed find maximum
+        // similarities to the queue with a spatial index, which all chunks
+        // share read-only during a scan
+        MaxSimilarityIndex index = similarity.get_index(bin);
+
+        // Counters are accumulated across steps; each chunk's copy of the
+        // similarity configuration starts from the same cache counts
+        BinStats counts;
+        size_t initial_hits = similarity.cache_hits();
+        size_t initial_misses = similarity.cache_misses();
+
+        auto score = [&](int chunk, int lo, int hi, CandidateScore &result) {
+            AsdpList &queue = (chunk == 0) ? prioritized : chunk_queues[chunk - 1];
+            Similarity &chunk_similarity = (chunk == 0) ?
+                similarity : chunk_similarities[chunk - 1];
+            for (int idx = lo; idx < hi; idx++) {
+                AsdpEntry &asdp = asdps[idx];
 
                 // Compute similarity discount factor
-                double discount_factor = similarity.get_discount_factor(
-                    bin, prioritized, asdp
+                double max_similarity;
+                if (index.is_indexed(asdp)) {
+                    max_similarity = index.get_max_similarity(asdp);
+                } else {
+                    max_similarity = chunk_similarity.get_max_similarity(
+                        bin, queue, asdp
+                    );
+                }
+                if (transmitted != nullptr) {
+                    max_similarity = std::max(max_similarity, context[idx]);
+                }
+                double discount_factor = chunk_similarity.get_discount_factor(
+                    bin, max_similarity
                 );
 
                 // Compute final SUE value
@@ -60,15 +386,21 @@ namespace Synopsis {
                     discount_factor *
                     asdp["science_utility_estimate"].get_float_value()
                 );
-                asdp["final_science_utility_estimate"] = DpMetadataValue(final_sue);
 
                 // Compute candidate cumulative utility and size
                 double candidate_utility = cumulative_sue + final_sue;
                 int candidate_size = cumulative_size + asdp["size"].get_int_value();
 
-                auto applied = ruleset.apply(bin, candidate);
+                // The candidate is temporarily appended to the queue, with
+                // its final SUE from the previous step
+                queue.push_back(asdp);
+                auto applied = ruleset.apply(bin, queue);
+                queue.pop_back();
+                asdp["final_science_utility_estimate"] = DpMetadataValue(final_sue);
+                result.n_evaluated++;
                 if (!applied.first) {
                     // Constraints violated
+                    result.n_rejected++;
                     continue;
                 }
 
@@ -76,138 +408,1659 @@ namespace Synopsis {
                 candidate_utility += applied.second;
 
                 double relative_utility = candidate_utility / candidate_size;
-                if ((best_idx < 0) || (relative_utility > best_value)) {
-                    best_idx = idx;
-                    best_value = relative_utility;
-                }
+                result.update(idx, relative_utility, final_sue);
+
+            }
+        };
 
+        if (expired != nullptr) { *expired = false; }
+        for (int i = 0; i < maxiter; i++) {
+            if (_check_deadline(timer, expired)) { break; }
+
+            LOG(logger, Synopsis::LogType::DEBUG,
+                "Prioritize Step 2 >>>  looping over ASDP list item # %d/%d",
+                i + 1, maxiter
+            );
+
+            int n_candidates = asdps.size();
+            int n_chunks = _num_scan_chunks(pool, scan_threshold, n_candidates);
+            std::vector<CandidateScore> scores(n_chunks);
+            _parallel_for(pool, n_chunks, n_candidates,
+                [&](int chunk, int lo, int hi) {
+                    score(chunk, lo, hi, scores[chunk]);
+                }
+            );
+            for (int c = 1; c < n_chunks; c++) {
+                scores[0].reduce(scores[c]);
             }
+            int best_idx = scores[0].get_idx();
+            counts.n_rule_evaluations += scores[0].n_evaluated;
+            counts.n_constraint_rejections += scores[0].n_rejected;
 
             // No valid successor was found
             if (best_idx < 0) {
                 break;
             }
 
+            // The budget is filled
+            if (_exceeds_budget(budget, prioritized.size(), cumulative_size,
+                    asdps[best_idx]["size"].get_int_value(),
+                    asdps[best_idx]["id"].get_int_value())) {
+                break;
+            }
+
             // Push best ASDP onto prioritized list
             auto best_asdp = asdps[best_idx];
             prioritized.push_back(best_asdp);
+            for (auto &queue : chunk_queues) {
+                queue.push_back(best_asdp);
+            }
+            index.add(best_asdp);
             asdps.erase(asdps.begin() + best_idx);
+            if (transmitted != nullptr) {
+                context.erase(context.begin() + best_idx);
+            }
             cumulative_size += best_asdp["size"].get_int_value();
             cumulative_sue += best_asdp["final_science_utility_estimate"].get_float_value();
 
         }
 
+        counts.n_similarity_hits = similarity.cache_hits() - initial_hits;
+        counts.n_similarity_misses = similarity.cache_misses() - initial_misses;
+        for (auto &chunk_similarity : chunk_similarities) {
+            counts.n_similarity_hits += (
+                chunk_similarity.cache_hits() - initial_hits
+            );
+            counts.n_similarity_misses += (
+                chunk_similarity.cache_misses() - initial_misses
+            );
+            similarity.merge_cache(chunk_similarity);
+        }
+        if (budget != nullptr) { budget->used_bytes = cumulative_size; }
+
         std::vector<int> prioritized_ids;
         for (auto &asdp : prioritized) {
             prioritized_ids.push_back(asdp["id"].get_int_value());
         }
 
+        if (stats != nullptr) {
+            for (auto &asdp : prioritized) {
+                stats->final_sues.push_back(
+                    asdp["final_science_utility_estimate"].get_float_value()
+                );
+            }
+            _record_bin_stats(
+                stats, counts, maxiter, prioritized_ids.size()
+            );
+        }
         return prioritized_ids;
     }
 
 
-    /*
-     * Implement DownlinkPlanner initialization
-     */
-    Status MaxMarginalRelevanceDownlinkPlanner::init(
-        size_t bytes, void* memory, Logger *logger
+    std::vector<int> _prioritize_bin_incremental(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &rows,
+        RuleSet &ruleset,
+        Similarity &similarity,
+        const SimilarityMatrix *matrix,
+        ThreadPool *pool,
+        int scan_threshold,
+        Timer *timer,
+        bool *expired,
+        BinBudget *budget,
+        BinStats *stats,
+        const std::vector<double> *initial_similarity
     ) {
-        this->_logger = logger;
-        return SUCCESS;
-    }
+        int n_asdps = rows.size();
 
+        // Rules and constraints are only evaluated if the bin has any
+        bool has_rules = (
+            !ruleset.get_rules(bin).empty() ||
+            !ruleset.get_constraints(bin).empty()
+        );
 
-    /*
-     * Implement DownlinkPlanner de-initialization
-     */
-    Status MaxMarginalRelevanceDownlinkPlanner::deinit() {
-        return SUCCESS;
-    }
+        double alpha = similarity.get_alpha(bin);
+        std::vector<SimilarityFunction*> functions = \
+            similarity.get_functions(bin, table);
 
+        // Per-candidate state; selected entries are flagged rather than
+        // erased so that indices (and hence tie-breaking) are stable
+        std::vector<bool> selected(n_asdps, false);
+        std::vector<double> max_similarity(n_asdps, 0.0);
+        if (initial_similarity != nullptr) {
+            max_similarity = *initial_similarity;
+        }
 
-    size_t MaxMarginalRelevanceDownlinkPlanner::memory_requirement(void) {
-        return 0;
-    }
+        AsdpRowList queue;
+        queue.reserve(n_asdps + 1);
+        std::vector<int> prioritized_ids;
 
+        // Each additional chunk of a parallel scan has its own copy of the
+        // queue, to which candidates are temporarily appended
+        int max_chunks = _num_scan_chunks(pool, scan_threshold, n_asdps);
+        std::vector<AsdpRowList> chunk_queues(max_chunks - 1);
 
-    Status MaxMarginalRelevanceDownlinkPlanner::prioritize(
-        std::string rule_configuration_id,
-        std::string similarity_configuration_id,
-        double max_processing_time_sec,
-        std::vector<int> &prioritized_list
-    ) {
+        int cumulative_size = 0;
+        double cumulative_sue = 0.0;
 
-        Status status;
+        // Counters are accumulated across steps; similarity updates are
+        // counted per chunk
+        BinStats counts;
+        std::vector<long> chunk_hits(max_chunks, 0);
+        std::vector<long> chunk_misses(max_chunks, 0);
 
-        Timer timer(this->_clock, max_processing_time_sec);
-        timer.start();
+        // Rule and constraint aggregates over the queue are updated once per
+        // step, so that candidates only evaluate their own contribution
+        QueueAggregates aggregates;
+        ruleset.init_aggregates(bin, aggregates);
 
-        // Parse/Load RuleSet
-        RuleSet ruleset = parse_rule_config(rule_configuration_id, this->_logger);
+        auto score = [&](int chunk, int lo, int hi, CandidateScore &result) {
+            AsdpRowList &chunk_queue = (chunk == 0) ?
+                queue : chunk_queues[chunk - 1];
+            for (int idx = lo; idx < hi; idx++) {
+                if (selected[idx]) { continue; }
+                int row = rows[idx];
 
-        // Load similarity configuration
-        Similarity similarity = \
-            parse_similarity_config(similarity_configuration_id, this->_logger);
+                // Compute final SUE value using the running max similarity
+                double discount_factor = _discount_factor(
+                    alpha, max_similarity[idx]
+                );
+                double final_sue = discount_factor * table.get_sue(row);
 
-        // Load ASDPs
-        std::vector<int> dp_ids = this->_db->list_data_product_ids();
-        std::map<int, AsdpList> binned_asdps;
-        AsdpList transmitted;
-        DpDbMsg msg;
-        
-        std::cout <<  "Prioritize Step 1 > Load ASDPs" << std::endl;
-        for (int dp_id : dp_ids) {
-            std::cout <<  "Prioritize Step 1 >> loading ASDP ID: " << dp_id << std::endl;
-            Status status = this->_db->get_data_product(dp_id, msg);
-            if (status != SUCCESS) { return status; }
+                // Compute candidate cumulative utility and size
+                double candidate_utility = cumulative_sue + final_sue;
+                int candidate_size = cumulative_size + table.get_size(row);
 
-            DownlinkState dl_state = msg.get_downlink_state();
-            if (dl_state == DOWNLINKED) { continue; }
+                if (has_rules) {
+                    // The candidate is evaluated with the field values it had
+                    // prior to this step, matching _prioritize_bin
+                    chunk_queue.push_back(row);
+                    auto applied = ruleset.apply_candidate(
+                        bin, table, chunk_queue, aggregates
+                    );
+                    chunk_queue.pop_back();
 
-            int bin = msg.get_priority_bin();
+                    AsdpValue final_value = {FLOAT, true, 0, final_sue, -1};
+                    table.set_value(
+                        row, AsdpTable::FINAL_SUE_SLOT, final_value
+                    );
+
+                    result.n_evaluated++;
+                    if (!applied.first) {
+                        // Constraints violated
+                        result.n_rejected++;
+                        continue;
+                    }
+
+                    // Apply rule adjustement
+                    candidate_utility += applied.second;
+                }
+
+                double relative_utility = candidate_utility / candidate_size;
+                result.update(idx, relative_utility, final_sue);
 
-            AsdpEntry asdp;
-            status = _populate_asdp(msg, asdp);
-            if (status != SUCCESS) {
-                LOG(this->_logger, Synopsis::LogType::ERROR, "Error populating ASDP for DP id: %ld", dp_id);
-                return status;
             }
+        };
 
-            if (dl_state == TRANSMITTED) {
-                transmitted.push_back(asdp);
-            } else {
-                if (binned_asdps.count(bin)) {
-                    binned_asdps[bin].push_back(asdp);
-                } else {
-                    AsdpList binlist = { asdp };
-                    binned_asdps[bin] = binlist;
+        if (expired != nullptr) { *expired = false; }
+        for (int step = 0; step < n_asdps; step++) {
+            if (_check_deadline(timer, expired)) { break; }
+
+            int n_chunks = _num_scan_chunks(
+                pool, scan_threshold, n_asdps - step
+            );
+            std::vector<CandidateScore> scores(n_chunks);
+            _parallel_for(pool, n_chunks, n_asdps,
+                [&](int chunk, int lo, int hi) {
+                    score(chunk, lo, hi, scores[chunk]);
+                }
+            );
+            for (int c = 1; c < n_chunks; c++) {
+                scores[0].reduce(scores[c]);
+            }
+            int best_idx = scores[0].get_idx();
+            double best_sue = scores[0].get_sue();
+            counts.n_rule_evaluations += scores[0].n_evaluated;
+            counts.n_constraint_rejections += scores[0].n_rejected;
+
+            // No valid successor was found
+            if (best_idx < 0) {
+                break;
+            }
+
+            // The budget is filled
+            int best_row = rows[best_idx];
+            if (_exceeds_budget(budget, prioritized_ids.size(),
+                    cumulative_size, table.get_size(best_row),
+                    table.get_id(best_row))) {
+                break;
+            }
+
+            // Push best ASDP onto prioritized list
+            AsdpValue best_final_value = {FLOAT, true, 0, best_sue, -1};
+            table.set_value(
+                best_row, AsdpTable::FINAL_SUE_SLOT, best_final_value
+            );
+            selected[best_idx] = true;
+            queue.push_back(best_row);
+            for (auto &chunk_queue : chunk_queues) {
+                chunk_queue.push_back(best_row);
+            }
+            if (has_rules) {
+                ruleset.commit(bin, table, queue, aggregates);
+            }
+            prioritized_ids.push_back(table.get_id(best_row));
+            cumulative_size += table.get_size(best_row);
+            cumulative_sue += best_sue;
+            if (stats != nullptr) { stats->final_sues.push_back(best_sue); }
+
+            // Update running max similarity against the newest selection only
+            int best_key = table.get_key_id(best_row);
+            SimilarityFunction *function = functions[best_key];
+            if (function == nullptr) { continue; }
+            _parallel_for(pool, n_chunks, n_asdps,
+                [&](int chunk, int lo, int hi) {
+                    for (int idx = lo; idx < hi; idx++) {
+                        if (selected[idx]) { continue; }
+                        int row = rows[idx];
+                        if (table.get_key_id(row) != best_key) { continue; }
+                        if (matrix != nullptr) {
+                            chunk_hits[chunk]++;
+                        } else {
+                            chunk_misses[chunk]++;
+                        }
+                        double sim = (matrix != nullptr) ?
+                            matrix->get_similarity(idx, best_idx) :
+                            function->get_similarity(table, row, best_row);
+                        if (sim > max_similarity[idx]) {
+                            max_similarity[idx] = sim;
+                        }
+                    }
                 }
+            );
+
+        }
+
+        if (budget != nullptr) { budget->used_bytes = cumulative_size; }
+        if (stats != nullptr) {
+            for (int c = 0; c < max_chunks; c++) {
+                counts.n_similarity_hits += chunk_hits[c];
+                counts.n_similarity_misses += chunk_misses[c];
             }
+            _record_bin_stats(stats, counts, n_asdps, prioritized_ids.size());
+        }
+        return prioritized_ids;
+    }
 
+
+    std::vector<int> _prioritize_bin_lazy(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &rows,
+        RuleSet &ruleset,
+        Similarity &similarity,
+        const SimilarityMatrix *matrix,
+        Timer *timer,
+        bool *expired,
+        BinBudget *budget,
+        BinStats *stats,
+        const std::vector<double> *initial_similarity
+    ) {
+        int n_asdps = rows.size();
+
+        // Check that stale values are valid upper bounds
+        double alpha = similarity.get_alpha(bin);
+        bool monotone = ruleset.get_rules(bin).empty() && (alpha >= 0.0);
+        for (int row : rows) {
+            double sue = table.get_sue(row);
+            monotone = monotone && std::isfinite(sue) && (sue >= 0.0);
+            monotone = monotone && (table.get_size(row) > 0);
+        }
+        if (!monotone) {
+            return _prioritize_bin_incremental(
+                bin, table, rows, ruleset, similarity, matrix,
+                nullptr, 0, timer, expired, budget, stats,
+                initial_similarity
+            );
         }
 
-        if (timer.is_expired()) {
-            return TIMEOUT;
+        bool has_constraints = !ruleset.get_constraints(bin).empty();
+        std::vector<SimilarityFunction*> functions = \
+            similarity.get_functions(bin, table);
+
+        // Per-candidate state: the number of queued ASDPs folded into the
+        // running max similarity, the most recently computed final SUE (an
+        // upper bound on its current value), and the step at which the
+        // candidate was last scored exactly
+        std::vector<bool> selected(n_asdps, false);
+        std::vector<double> max_similarity(n_asdps, 0.0);
+        if (initial_similarity != nullptr) {
+            max_similarity = *initial_similarity;
+        }
+        std::vector<int> n_folded(n_asdps, 0);
+        std::vector<double> final_sues(n_asdps);
+        std::vector<int> scored_step(n_asdps, -1);
+        for (int i = 0; i < n_asdps; i++) {
+            final_sues[i] = _discount_factor(
+                alpha, max_similarity[i]
+            ) * table.get_sue(rows[i]);
         }
 
-        // Prioritize each bin (assumes entries are traversed in bin order)
-        std::cout <<  "Prioritize Step 2 > prioritize bins" << std::endl;
-        int prioritize_loop_index = 0;
-        int num_bins_to_prioritize = binned_asdps.size();
-        for (auto &entry : binned_asdps) {
-            int bin = entry.first;
-            std::cout <<  "Prioritize Step 2 >> prioritize bin index: " << prioritize_loop_index << "/" << num_bins_to_prioritize << " (bin = " << bin << ")" << std::endl;
-            prioritize_loop_index++;
-            auto &asdps = entry.second;
-            std::vector<int> prioritized_bin = _prioritize_bin(
-                bin, asdps, ruleset, similarity
+        // Heap entries are (bound, index) pairs, ordered so that the top has
+        // the largest bound and ties go to the lowest index
+        typedef std::pair<double, int> HeapEntry;
+        auto heap_less = [](const HeapEntry &a, const HeapEntry &b) {
+            return (a.first < b.first) || (
+                (a.first == b.first) && (a.second > b.second)
             );
-            for (int asdp_id : prioritized_bin) {
-                prioritized_list.push_back(asdp_id);
+        };
+        std::vector<HeapEntry> heap;
+        heap.reserve(n_asdps);
+
+        AsdpRowList queue;
+        queue.reserve(n_asdps + 1);
+        std::vector<int> queue_idx;
+        queue_idx.reserve(n_asdps);
+        std::vector<int> prioritized_ids;
+
+        int cumulative_size = 0;
+        double cumulative_sue = 0.0;
+        BinStats counts;
+
+        QueueAggregates aggregates;
+        ruleset.init_aggregates(bin, aggregates);
+
+        if (expired != nullptr) { *expired = false; }
+        for (int step = 0; step < n_asdps; step++) {
+            if (_check_deadline(timer, expired)) { break; }
+
+            // Bounds depend on the cumulative utility and size, so the heap
+            // is rebuilt each step; this is cheap relative to re-scoring
+            heap.clear();
+            for (int idx = 0; idx < n_asdps; idx++) {
+                if (selected[idx]) { continue; }
+                double bound = (
+                    (cumulative_sue + final_sues[idx]) /
+                    (cumulative_size + table.get_size(rows[idx]))
+                );
+                heap.push_back(std::make_pair(bound, idx));
+            }
+            std::make_heap(heap.begin(), heap.end(), heap_less);
+
+            int best_idx = -1;
+            while (!heap.empty()) {
+                int idx = heap.front().second;
+                if (scored_step[idx] == step) {
+                    // Exact value dominates all remaining bounds
+                    best_idx = idx;
+                    break;
+                }
+                std::pop_heap(heap.begin(), heap.end(), heap_less);
+                heap.pop_back();
+                int row = rows[idx];
+                double sue = table.get_sue(row);
+
+                // Fold in ASDPs queued since this candidate was last scored,
+                // keeping the value from the previous step for constraint
+                // evaluation, matching _prioritize_bin
+                int key = table.get_key_id(row);
+                SimilarityFunction *function = functions[key];
+                double previous_sue = final_sues[idx];
+                while (n_folded[idx] < step) {
+                    if (n_folded[idx] == step - 1) {
+                        previous_sue = _discount_factor(
+                            alpha, max_similarity[idx]
+                        ) * sue;
+                    }
+                    int queued = queue_idx[n_folded[idx]];
+                    int queued_row = rows[queued];
+                    if ((function != nullptr) &&
+                            (table.get_key_id(queued_row) == key)) {
+                        if (matrix != nullptr) {
+                            counts.n_similarity_hits++;
+                        } else {
+                            counts.n_similarity_misses++;
+                        }
+                        double sim = (matrix != nullptr) ?
+                            matrix->get_similarity(idx, queued) :
+                            function->get_similarity(table, row, queued_row);
+                        if (sim > max_similarity[idx]) {
+                            max_similarity[idx] = sim;
+                        }
+                    }
+                    n_folded[idx]++;
+                }
+                double final_sue = _discount_factor(
+                    alpha, max_similarity[idx]
+                ) * sue;
+                final_sues[idx] = final_sue;
+                scored_step[idx] = step;
+
+                if (has_constraints) {
+                    if (step > 0) {
+                        AsdpValue previous_value = {
+                            FLOAT, true, 0, previous_sue, -1
+                        };
+                        table.set_value(
+                            row, AsdpTable::FINAL_SUE_SLOT, previous_value
+                        );
+                    }
+                    queue.push_back(row);
+                    auto applied = ruleset.apply_candidate(
+                        bin, table, queue, aggregates
+                    );
+                    queue.pop_back();
+                    counts.n_rule_evaluations++;
+                    if (!applied.first) {
+                        // Constraints violated; excluded for this step only
+                        counts.n_constraint_rejections++;
+                        continue;
+                    }
+                }
+
+                double value = (
+                    (cumulative_sue + final_sue) /
+                    (cumulative_size + table.get_size(row))
+                );
+                heap.push_back(std::make_pair(value, idx));
+                std::push_heap(heap.begin(), heap.end(), heap_less);
+            }
+
+            // No valid successor was found
+            if (best_idx < 0) {
+                break;
+            }
+
+            // The budget is filled
+            int best_row = rows[best_idx];
+            if (_exceeds_budget(budget, prioritized_ids.size(),
+                    cumulative_size, table.get_size(best_row),
+                    table.get_id(best_row))) {
+                break;
             }
+
+            // Push best ASDP onto prioritized list
+            AsdpValue best_final_value = {
+                FLOAT, true, 0, final_sues[best_idx], -1
+            };
+            table.set_value(
+                best_row, AsdpTable::FINAL_SUE_SLOT, best_final_value
+            );
+            selected[best_idx] = true;
+            queue.push_back(best_row);
+            queue_idx.push_back(best_idx);
+            if (has_constraints) {
+                ruleset.commit(bin, table, queue, aggregates);
+            }
+            prioritized_ids.push_back(table.get_id(best_row));
+            cumulative_size += table.get_size(best_row);
+            cumulative_sue += final_sues[best_idx];
+            if (stats != nullptr) {
+                stats->final_sues.push_back(final_sues[best_idx]);
+            }
+
         }
 
-        return SUCCESS;
+        if (budget != nullptr) { budget->used_bytes = cumulative_size; }
+        if (stats != nullptr) {
+            _record_bin_stats(stats, counts, n_asdps, prioritized_ids.size());
+        }
+        return prioritized_ids;
+    }
+
+
+    MaxMarginalRelevanceDownlinkPlanner::MaxMarginalRelevanceDownlinkPlanner(
+        MmrEngine engine,
+        size_t similarity_memory_bytes
+    ) :
+        _engine(engine),
+        _similarity_memory_bytes(similarity_memory_bytes)
+    {
+
+    }
+
+
+    /*
+     * Implement DownlinkPlanner initialization
+     */
+    Status MaxMarginalRelevanceDownlinkPlanner::init(
+        size_t bytes, void* memory, Logger *logger
+    ) {
+        this->_logger = logger;
+        if ((this->_similarity_memory_bytes > 0) &&
+                ((memory == NULL) || (bytes < this->_similarity_memory_bytes))) {
+            LOG(logger, Synopsis::LogType::ERROR, "Insufficient memory provided for similarity matrices");
+            return FAILURE;
+        }
+        this->_similarity_memory = memory;
+
+        // The scratch arena follows the similarity matrix memory
+        size_t scratch_offset = MemoryArena::aligned_size(
+            this->_similarity_memory_bytes
+        );
+        if ((this->_scratch_bytes > 0) &&
+                ((memory == NULL) || (bytes < scratch_offset + this->_scratch_bytes))) {
+            LOG(logger, Synopsis::LogType::ERROR, "Insufficient memory provided for planner scratch arena");
+            return FAILURE;
+        }
+        if (this->_scratch_bytes > 0) {
+            this->_scratch.reset(
+                this->_scratch_bytes, (char*)memory + scratch_offset
+            );
+        } else {
+            this->_scratch.reset(0, NULL);
+        }
+        this->_scratch_high_water = 0;
+        this->_scratch_overflows = 0;
+
+        // The calling thread also runs tasks, so one fewer worker is needed
+        this->_pool.reset();
+        if (this->_num_threads > 1) {
+            this->_pool.reset(new ThreadPool(this->_num_threads - 1));
+        }
+
+        if (this->_fallback) {
+            return this->_fallback->init(0, NULL, logger);
+        }
+        return SUCCESS;
+    }
+
+
+    MaxMarginalRelevanceDownlinkPlanner::~MaxMarginalRelevanceDownlinkPlanner() {
+        if (this->_listening_db != nullptr) {
+            this->_listening_db->remove_listener(this);
+        }
+    }
+
+
+    /*
+     * Implement DownlinkPlanner de-initialization
+     */
+    Status MaxMarginalRelevanceDownlinkPlanner::deinit() {
+        this->_pool.reset();
+        this->clear_config_cache();
+        if (this->_listening_db != nullptr) {
+            this->_listening_db->remove_listener(this);
+            this->_listening_db = nullptr;
+        }
+        this->_plan_valid = false;
+        this->_plan_bins.clear();
+        this->_plan_asdp_bins.clear();
+        this->_plan_transmitted_bins.clear();
+        this->_planned_entries.clear();
+        if (this->_fallback) {
+            return this->_fallback->deinit();
+        }
+        return SUCCESS;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::set_num_threads(int n_threads) {
+        this->_num_threads = n_threads;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::set_parallel_scan_threshold(
+        int n_candidates
+    ) {
+        this->_scan_threshold = n_candidates;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::set_scratch_memory(size_t bytes) {
+        this->_scratch_bytes = bytes;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::set_incremental(bool incremental) {
+        this->_incremental = incremental;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::set_fallback_planner(
+        std::unique_ptr<DownlinkPlanner> fallback, double sec_per_evaluation
+    ) {
+        this->_fallback = std::move(fallback);
+        this->_fallback_sec_per_evaluation = sec_per_evaluation;
+    }
+
+
+    bool MaxMarginalRelevanceDownlinkPlanner::_use_fallback(
+        const std::vector<DpDbMsg> &msgs, Timer &timer
+    ) {
+        if (!this->_fallback) {
+            return false;
+        }
+
+        std::map<int, double> bin_sizes;
+        for (auto &msg : msgs) {
+            if (msg.get_downlink_state() != TRANSMITTED) {
+                bin_sizes[msg.get_priority_bin()] += 1.0;
+            }
+        }
+        double n_evaluations = 0.0;
+        for (auto &entry : bin_sizes) {
+            double n = entry.second;
+            if (this->_engine == EXHAUSTIVE_GREEDY) {
+                n_evaluations += n * (n + 1) * (n + 2) / 6.0;
+            } else {
+                n_evaluations += n * (n + 1) / 2.0;
+            }
+        }
+        double estimate = n_evaluations * this->_fallback_sec_per_evaluation;
+        double remaining = timer.remaining();
+        if (estimate <= remaining) {
+            return false;
+        }
+
+        LOG(this->_logger, Synopsis::LogType::WARN, "Estimated prioritization time of %f s exceeds the %f s remaining; using fallback planner", estimate, remaining);
+        this->_fallback->set_database(this->_db);
+        this->_fallback->set_clock(this->_clock);
+        this->_fallback->set_stats_enabled(this->_stats_enabled);
+        return true;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::clear_config_cache(void) {
+        this->_rule_configs.clear();
+        this->_similarity_configs.clear();
+        this->_config_generation++;
+    }
+
+
+    MaxMarginalRelevanceDownlinkPlanner::ConfigStamp
+    MaxMarginalRelevanceDownlinkPlanner::_get_config_stamp(
+        const std::string &config_id
+    ) {
+        ConfigStamp stamp;
+        struct stat info;
+        if (stat(config_id.c_str(), &info) == 0) {
+            stamp.exists = true;
+            stamp.mtime_sec = info.st_mtim.tv_sec;
+            stamp.mtime_nsec = info.st_mtim.tv_nsec;
+            stamp.size = info.st_size;
+        }
+        return stamp;
+    }
+
+
+    RuleSet &MaxMarginalRelevanceDownlinkPlanner::_get_rule_config(
+        const std::string &config_id
+    ) {
+        ConfigStamp stamp = _get_config_stamp(config_id);
+        auto &cached = this->_rule_configs[config_id];
+        if (!cached.second || !(cached.first == stamp)) {
+            cached.first = stamp;
+            cached.second.reset(
+                new RuleSet(parse_rule_config(config_id, this->_logger))
+            );
+            this->_config_generation++;
+        }
+        return *cached.second;
+    }
+
+
+    Similarity &MaxMarginalRelevanceDownlinkPlanner::_get_similarity_config(
+        const std::string &config_id
+    ) {
+        ConfigStamp stamp = _get_config_stamp(config_id);
+        auto &cached = this->_similarity_configs[config_id];
+        if (!cached.second || !(cached.first == stamp)) {
+            cached.first = stamp;
+            cached.second.reset(new Similarity(
+                parse_similarity_config(config_id, this->_logger)
+            ));
+            this->_config_generation++;
+        }
+        return *cached.second;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::_run_tasks(
+        std::vector<PoolTask> &tasks
+    ) {
+        if (this->_pool) {
+            this->_pool->run(tasks);
+        } else {
+            for (auto &task : tasks) { task(); }
+        }
+    }
+
+
+    size_t MaxMarginalRelevanceDownlinkPlanner::memory_requirement(void) {
+        if (this->_scratch_bytes == 0) {
+            return this->_similarity_memory_bytes;
+        }
+        return MemoryArena::aligned_size(this->_similarity_memory_bytes) +
+            this->_scratch_bytes;
+    }
+
+
+    Status MaxMarginalRelevanceDownlinkPlanner::prioritize(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        std::vector<int> &prioritized_list
+    ) {
+
+        Status status;
+
+        // Phase timers only read the clock if statistics are enabled
+        PlannerStats *stats = this->_begin_stats();
+        PhaseTimer total_timer(
+            this->_clock, stats ? &stats->total_time_sec : nullptr
+        );
+
+        Timer timer(this->_clock, max_processing_time_sec);
+        timer.start();
+
+        // Parse/Load RuleSet, reusing the configuration parsed by a previous
+        // call if its file is unchanged
+        PhaseTimer config_timer(
+            this->_clock, stats ? &stats->config_time_sec : nullptr
+        );
+        RuleSet &ruleset = this->_get_rule_config(rule_configuration_id);
+
+        // Load similarity configuration
+        Similarity &similarity = \
+            this->_get_similarity_config(similarity_configuration_id);
+        config_timer.stop();
+
+        // With incremental replanning, only bins affected by changes since
+        // the last plan are replanned, if it used the same configurations
+        bool replan_all = true;
+        std::set<int> changed_bins;
+        if (this->_incremental) {
+            if (this->_listening_db != this->_db) {
+                if (this->_listening_db != nullptr) {
+                    this->_listening_db->remove_listener(this);
+                }
+                this->_listening_db = this->_db;
+                this->_listening_db->add_listener(this);
+                this->_plan_valid = false;
+            }
+            replan_all = !(
+                this->_plan_valid &&
+                (this->_plan_rule_id == rule_configuration_id) &&
+                (this->_plan_similarity_id == similarity_configuration_id) &&
+                (this->_plan_generation == this->_config_generation)
+            );
+            bool transmitted_context = similarity.uses_transmitted_context();
+            if (!this->_find_changed_bins(changed_bins, transmitted_context)) {
+                replan_all = true;
+            }
+            this->_plan_valid = false;
+        }
+
+        LOG(this->_logger, Synopsis::LogType::INFO, "Prioritize Step 1 > Load ASDPs");
+        PhaseTimer load_timer(
+            this->_clock, stats ? &stats->load_time_sec : nullptr
+        );
+        std::vector<DpDbMsg> msgs;
+        if (replan_all) {
+            status = this->_db->list_undownlinked_data_products(msgs);
+            if (status != SUCCESS) { return status; }
+        } else {
+            for (int bin : changed_bins) {
+                status = this->_db->list_undownlinked_data_products_in_bin(
+                    bin, msgs
+                );
+                if (status != SUCCESS) { return status; }
+            }
+        }
+        load_timer.stop();
+        size_t n_loaded = msgs.size();
+        this->_keep_loaded(msgs, replan_all);
+
+        this->_used_fallback = this->_use_fallback(msgs, timer);
+        if (this->_used_fallback) {
+            status = this->_fallback->prioritize(
+                rule_configuration_id, similarity_configuration_id,
+                timer.remaining(), prioritized_list
+            );
+            total_timer.stop();
+            if (stats != nullptr) { *stats = this->_fallback->get_stats(); }
+            return status;
+        }
+
+        // Transmitted ASDPs are tracked so that changes to them replan the
+        // bins whose similarity context they belong to
+        std::vector<std::pair<int, int>> transmitted_bins;
+        if (this->_incremental && similarity.uses_transmitted_context()) {
+            for (auto &msg : msgs) {
+                if (msg.get_downlink_state() == TRANSMITTED) {
+                    transmitted_bins.push_back(std::make_pair(
+                        msg.get_dp_id(), msg.get_priority_bin()
+                    ));
+                }
+            }
+        }
+
+        std::map<int, std::vector<int>> bin_orders;
+        std::set<int> expired_bins;
+        status = this->_prioritize_bins(
+            msgs, ruleset, similarity, timer, bin_orders, expired_bins,
+            nullptr, stats
+        );
+        if (status != SUCCESS) { return status; }
+        this->_n_replanned_bins = bin_orders.size();
+
+        // Replace the affected bins of the last plan
+        const std::map<int, std::vector<int>> *plan = &bin_orders;
+        if (this->_incremental) {
+            if (replan_all) {
+                this->_plan_bins.clear();
+                this->_plan_asdp_bins.clear();
+                this->_plan_transmitted_bins.clear();
+            } else {
+                for (auto it = this->_plan_transmitted_bins.begin();
+                        it != this->_plan_transmitted_bins.end();) {
+                    if (changed_bins.count(it->second)) {
+                        it = this->_plan_transmitted_bins.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                for (int bin : changed_bins) {
+                    auto found = this->_plan_bins.find(bin);
+                    if (found == this->_plan_bins.end()) { continue; }
+                    for (int asdp_id : found->second) {
+                        this->_plan_asdp_bins.erase(asdp_id);
+                    }
+                    this->_plan_bins.erase(found);
+                }
+            }
+            for (auto &entry : bin_orders) {
+                for (int asdp_id : entry.second) {
+                    this->_plan_asdp_bins[asdp_id] = entry.first;
+                }
+                this->_plan_bins[entry.first] = std::move(entry.second);
+            }
+            for (auto &entry : transmitted_bins) {
+                this->_plan_transmitted_bins[entry.first] = entry.second;
+            }
+            this->_plan_valid = expired_bins.empty();
+            this->_plan_rule_id = rule_configuration_id;
+            this->_plan_similarity_id = similarity_configuration_id;
+            this->_plan_generation = this->_config_generation;
+            plan = &this->_plan_bins;
+        }
+
+        // If the deadline expired, results are only kept through the first
+        // incomplete bin, so the list is a prefix of the full ordering
+        status = SUCCESS;
+        for (auto &entry : *plan) {
+            for (int asdp_id : entry.second) {
+                prioritized_list.push_back(asdp_id);
+            }
+            if (expired_bins.count(entry.first)) {
+                LOG(this->_logger, Synopsis::LogType::WARN, "Prioritization time expired; returning %lu ASDPs after loading %lu", (unsigned long)prioritized_list.size(), (unsigned long)n_loaded);
+                status = TIMEOUT;
+                break;
+            }
+        }
+
+        total_timer.stop();
+        this->_log_stats(stats);
+        return status;
+    }
+
+
+    Status MaxMarginalRelevanceDownlinkPlanner::prioritize_with_budget(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        long max_bytes, int max_count,
+        std::vector<int> &prioritized_list,
+        int &cut_asdp_id
+    ) {
+
+        // The incremental plan holds full orderings, most of which are reused
+        if (this->_incremental) {
+            return DownlinkPlanner::prioritize_with_budget(
+                rule_configuration_id, similarity_configuration_id,
+                max_processing_time_sec, max_bytes, max_count,
+                prioritized_list, cut_asdp_id
+            );
+        }
+
+        Status status;
+        cut_asdp_id = -1;
+
+        PlannerStats *stats = this->_begin_stats();
+        PhaseTimer total_timer(
+            this->_clock, stats ? &stats->total_time_sec : nullptr
+        );
+
+        Timer timer(this->_clock, max_processing_time_sec);
+        timer.start();
+
+        PhaseTimer config_timer(
+            this->_clock, stats ? &stats->config_time_sec : nullptr
+        );
+        RuleSet &ruleset = this->_get_rule_config(rule_configuration_id);
+        Similarity &similarity = \
+            this->_get_similarity_config(similarity_configuration_id);
+        config_timer.stop();
+
+        PhaseTimer load_timer(
+            this->_clock, stats ? &stats->load_time_sec : nullptr
+        );
+        std::vector<DpDbMsg> msgs;
+        status = this->_db->list_undownlinked_data_products(msgs);
+        if (status != SUCCESS) { return status; }
+        load_timer.stop();
+        this->_keep_loaded(msgs, true);
+
+        this->_used_fallback = this->_use_fallback(msgs, timer);
+        if (this->_used_fallback) {
+            status = this->_fallback->prioritize_with_budget(
+                rule_configuration_id, similarity_configuration_id,
+                timer.remaining(), max_bytes, max_count,
+                prioritized_list, cut_asdp_id
+            );
+            total_timer.stop();
+            if (stats != nullptr) { *stats = this->_fallback->get_stats(); }
+            return status;
+        }
+
+        BinBudget budget;
+        budget.max_bytes = max_bytes;
+        budget.max_count = max_count;
+        std::map<int, std::vector<int>> bin_orders;
+        std::set<int> expired_bins;
+        status = this->_prioritize_bins(
+            msgs, ruleset, similarity, timer, bin_orders, expired_bins,
+            &budget, stats
+        );
+        if (status != SUCCESS) { return status; }
+
+        status = SUCCESS;
+        for (auto &entry : bin_orders) {
+            for (int asdp_id : entry.second) {
+                prioritized_list.push_back(asdp_id);
+            }
+            if (expired_bins.count(entry.first)) {
+                LOG(this->_logger, Synopsis::LogType::WARN, "Prioritization time expired; returning %lu ASDPs within budget", (unsigned long)prioritized_list.size());
+                status = TIMEOUT;
+                break;
+            }
+        }
+        if (status == SUCCESS) {
+            cut_asdp_id = budget.cut_asdp_id;
+            LOG(this->_logger, Synopsis::LogType::INFO, "Downlink manifest holds %lu ASDPs (%ld bytes); cut at ASDP %d", (unsigned long)prioritized_list.size(), budget.used_bytes, cut_asdp_id);
+        }
+
+        total_timer.stop();
+        this->_log_stats(stats);
+        return status;
+    }
+
+
+    Status MaxMarginalRelevanceDownlinkPlanner::prioritize_streaming(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        const BinCallback &on_bin
+    ) {
+
+        // The incremental plan holds full orderings, most of which are reused
+        if (this->_incremental) {
+            return DownlinkPlanner::prioritize_streaming(
+                rule_configuration_id, similarity_configuration_id,
+                max_processing_time_sec, on_bin
+            );
+        }
+
+        Status status;
+
+        PlannerStats *stats = this->_begin_stats();
+        PhaseTimer total_timer(
+            this->_clock, stats ? &stats->total_time_sec : nullptr
+        );
+
+        Timer timer(this->_clock, max_processing_time_sec);
+        timer.start();
+
+        PhaseTimer config_timer(
+            this->_clock, stats ? &stats->config_time_sec : nullptr
+        );
+        RuleSet &ruleset = this->_get_rule_config(rule_configuration_id);
+        Similarity &similarity = \
+            this->_get_similarity_config(similarity_configuration_id);
+        config_timer.stop();
+
+        PhaseTimer load_timer(
+            this->_clock, stats ? &stats->load_time_sec : nullptr
+        );
+        std::vector<DpDbMsg> msgs;
+        status = this->_db->list_undownlinked_data_products(msgs);
+        if (status != SUCCESS) { return status; }
+        load_timer.stop();
+        this->_keep_loaded(msgs, true);
+
+        std::map<int, std::vector<int>> bin_orders;
+        std::set<int> expired_bins;
+        status = this->_prioritize_bins(
+            msgs, ruleset, similarity, timer, bin_orders, expired_bins,
+            nullptr, stats, &on_bin
+        );
+        if (status != SUCCESS) { return status; }
+
+        if (!expired_bins.empty()) {
+            LOG(this->_logger, Synopsis::LogType::WARN, "Prioritization time expired; bins after bin %d not passed", *expired_bins.begin());
+            status = TIMEOUT;
+        }
+
+        total_timer.stop();
+        this->_log_stats(stats);
+        return status;
+    }
+
+
+    Status MaxMarginalRelevanceDownlinkPlanner::sweep(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        const std::vector<SweepVariant> &variants,
+        double max_processing_time_sec,
+        std::vector<std::vector<int>> &prioritized_lists
+    ) {
+
+        Status status;
+        int n_variants = variants.size();
+        prioritized_lists.assign(n_variants, std::vector<int>());
+
+        Timer timer(this->_clock, max_processing_time_sec);
+        timer.start();
+
+        // Each variant has its own rule configuration (possibly shared with
+        // other variants), and a copy of the base similarity configuration
+        // with its parameters replaced
+        Similarity &base_similarity = \
+            this->_get_similarity_config(similarity_configuration_id);
+        Similarity sums_similarity = base_similarity.fork();
+        std::vector<RuleSet*> rulesets;
+        std::vector<Similarity> similarities;
+        for (auto &variant : variants) {
+            rulesets.push_back(&this->_get_rule_config(
+                variant.rule_configuration_id.empty() ?
+                rule_configuration_id : variant.rule_configuration_id
+            ));
+            similarities.push_back(base_similarity.fork());
+            Similarity &similarity = similarities.back();
+            if (variant.default_alpha >= 0.0) {
+                similarity.set_default_alpha(variant.default_alpha);
+            }
+            for (auto &alpha : variant.alphas) {
+                similarity.set_alpha(alpha.first, alpha.second);
+            }
+            if (variant.sigma > 0.0) {
+                similarity.set_sigma(variant.sigma);
+            }
+        }
+
+        std::vector<DpDbMsg> msgs;
+        status = this->_db->list_undownlinked_data_products(msgs);
+        if (status != SUCCESS) { return status; }
+
+        AsdpTable table;
+        table.reserve(msgs.size());
+        std::map<int, AsdpRowList> binned_rows;
+        std::map<int, AsdpRowList> binned_transmitted_rows;
+        for (auto &msg : msgs) {
+            int row = table.add_data_product(msg);
+            if (msg.get_downlink_state() == TRANSMITTED) {
+                binned_transmitted_rows[msg.get_priority_bin()].push_back(row);
+            } else {
+                binned_rows[msg.get_priority_bin()].push_back(row);
+            }
+        }
+        msgs.clear();
+
+        for (auto *ruleset : rulesets) {
+            ruleset->bind(table);
+        }
+        sums_similarity.bind(table);
+        for (auto &similarity : similarities) {
+            similarity.bind(table);
+        }
+
+        LOG(this->_logger, Synopsis::LogType::INFO, "Sweeping %d variants over %lu ASDPs in %lu bins", n_variants, (unsigned long)table.size(), (unsigned long)binned_rows.size());
+
+        // Each bin accumulates its kernel sums once, then transforms them and
+        // prioritizes the bin for each variant in turn, since variants write
+        // the final SUEs of the bin's rows in the shared table
+        int n_bins = binned_rows.size();
+        std::vector<std::vector<std::vector<int>>> orders(
+            n_bins, std::vector<std::vector<int>>(n_variants)
+        );
+        std::unique_ptr<bool[]> expired(new bool[n_bins * n_variants]());
+        std::vector<PoolTask> tasks;
+        Timer *deadline = &timer;
+        int b = 0;
+        for (auto &entry : binned_rows) {
+            int bin = entry.first;
+            const AsdpRowList *rows = &entry.second;
+            const AsdpRowList *transmitted_rows = nullptr;
+            if (binned_transmitted_rows.count(bin)) {
+                transmitted_rows = &binned_transmitted_rows.at(bin);
+            }
+            std::vector<std::vector<int>> *bin_orders = &orders[b];
+            bool *bin_expired = &expired[b * n_variants];
+            MmrEngine engine = this->_engine;
+            ThreadPool *pool = this->_pool.get();
+            int scan_threshold = this->_scan_threshold;
+            tasks.push_back([=, &table, &sums_similarity, &similarities, &rulesets]() {
+                std::vector<SimilarityFunction*> functions = \
+                    sums_similarity.get_functions(bin, table);
+                size_t n_doubles = 1 + (
+                    SimilarityMatrix::memory_requirement(
+                        table, *rows, functions
+                    ) / sizeof(double)
+                );
+                std::vector<double> sums_memory(n_doubles);
+                std::vector<double> matrix_memory(n_doubles);
+                SimilarityMatrix sums;
+                sums.accumulate(table, *rows, functions, sums_memory.data());
+
+                for (int v = 0; v < n_variants; v++) {
+                    Similarity &similarity = similarities[v];
+                    SimilarityMatrix matrix;
+                    matrix.transform(
+                        sums, similarity.get_functions(bin, table),
+                        matrix_memory.data()
+                    );
+                    std::vector<double> context;
+                    bool use_context = (
+                        (transmitted_rows != nullptr) &&
+                        similarity.uses_transmitted_context()
+                    );
+                    if (use_context) {
+                        context = _transmitted_similarity(
+                            table, *rows, *transmitted_rows,
+                            similarity.get_functions(bin, table)
+                        );
+                    }
+                    const std::vector<double> *initial_similarity = (
+                        use_context ? &context : nullptr
+                    );
+                    if (engine == LAZY_GREEDY) {
+                        (*bin_orders)[v] = _prioritize_bin_lazy(
+                            bin, table, *rows, *rulesets[v], similarity,
+                            &matrix, deadline, &bin_expired[v], nullptr,
+                            nullptr, initial_similarity
+                        );
+                    } else {
+                        (*bin_orders)[v] = _prioritize_bin_incremental(
+                            bin, table, *rows, *rulesets[v], similarity,
+                            &matrix, pool, scan_threshold, deadline,
+                            &bin_expired[v], nullptr, nullptr,
+                            initial_similarity
+                        );
+                    }
+                }
+            });
+            b++;
+        }
+        this->_run_tasks(tasks);
+
+        // As with `prioritize`, each list is kept through the first bin whose
+        // prioritization did not complete
+        status = SUCCESS;
+        for (int v = 0; v < n_variants; v++) {
+            for (b = 0; b < n_bins; b++) {
+                std::vector<int> &order = orders[b][v];
+                prioritized_lists[v].insert(
+                    prioritized_lists[v].end(), order.begin(), order.end()
+                );
+                if (expired[b * n_variants + v]) {
+                    status = TIMEOUT;
+                    break;
+                }
+            }
+        }
+        if (status == TIMEOUT) {
+            LOG(this->_logger, Synopsis::LogType::WARN, "Sweep time expired; returning partial orderings");
+        }
+        return status;
+    }
+
+
+    Status MaxMarginalRelevanceDownlinkPlanner::prioritize_bundle(
+        const DpBundle &bundle,
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        std::vector<int> &prioritized_list
+    ) {
+
+        Status status;
+
+        Timer timer(this->_clock, max_processing_time_sec);
+        timer.start();
+
+        RuleSet &ruleset = this->_get_rule_config(rule_configuration_id);
+        Similarity &similarity = \
+            this->_get_similarity_config(similarity_configuration_id);
+
+        LOG(this->_logger, Synopsis::LogType::INFO, "Prioritize Step 1 > Load ASDPs from bundle");
+        std::vector<DpDbMsg> msgs;
+        msgs.reserve(bundle.size());
+        for (int i = 0; i < bundle.size(); i++) {
+            DpDbMsg msg;
+            status = bundle.get_data_product(i, msg);
+            if (status != SUCCESS) { return status; }
+            if (msg.get_downlink_state() == DOWNLINKED) { continue; }
+            if (msg.get_dp_id() < 0) { msg.set_dp_id(i); }
+            msgs.push_back(std::move(msg));
+        }
+
+        std::map<int, std::vector<int>> bin_orders;
+        std::set<int> expired_bins;
+        status = this->_prioritize_bins(
+            msgs, ruleset, similarity, timer, bin_orders, expired_bins
+        );
+        if (status != SUCCESS) { return status; }
+
+        for (auto &entry : bin_orders) {
+            prioritized_list.insert(
+                prioritized_list.end(), entry.second.begin(), entry.second.end()
+            );
+            if (expired_bins.count(entry.first)) {
+                LOG(this->_logger, Synopsis::LogType::WARN, "Prioritization time expired; returning %lu ASDPs", (unsigned long)prioritized_list.size());
+                return TIMEOUT;
+            }
+        }
+        return SUCCESS;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::_log_stats(
+        const PlannerStats *stats
+    ) {
+        if (stats == nullptr) {
+            return;
+        }
+        LOG(this->_logger, Synopsis::LogType::INFO, "Prioritized %lu ASDPs in %lu bins in %.6f s (configuration %.6f s, loading %.6f s, planning %.6f s)", (unsigned long)stats->n_loaded, (unsigned long)stats->bins.size(), stats->total_time_sec, stats->config_time_sec, stats->load_time_sec, stats->planning_time_sec);
+        LOG(this->_logger, Synopsis::LogType::INFO, "Rule evaluations: %ld (%ld rejected by constraints); similarity cache hits: %ld, misses: %ld", stats->n_rule_evaluations, stats->n_constraint_rejections, stats->n_similarity_hits, stats->n_similarity_misses);
+    }
+
+
+    Status MaxMarginalRelevanceDownlinkPlanner::_prioritize_bins(
+        std::vector<DpDbMsg> &msgs,
+        RuleSet &ruleset, Similarity &similarity, Timer &timer,
+        std::map<int, std::vector<int>> &bin_orders,
+        std::set<int> &expired_bins,
+        BinBudget *budget,
+        PlannerStats *stats,
+        const BinCallback *on_bin
+    ) {
+
+        Status status;
+        PhaseTimer load_timer(
+            this->_clock, stats ? &stats->load_time_sec : nullptr
+        );
+        if (stats != nullptr) { stats->n_loaded += msgs.size(); }
+
+        // Load ASDPs; the legacy map-based representation is only used by
+        // the exhaustive engine
+        bool use_table = (this->_engine != EXHAUSTIVE_GREEDY);
+        std::map<int, AsdpList> binned_asdps;
+        std::map<int, AsdpRowList> binned_rows;
+
+        // Transmitted ASDPs of each bin, which are not prioritized but may
+        // serve as similarity context for the bin's other ASDPs
+        std::map<int, AsdpList> binned_transmitted;
+        std::map<int, AsdpRowList> binned_transmitted_rows;
+
+        // Tables from previous calls have been destroyed, so the scratch
+        // arena is reused from the start
+        this->_scratch.rewind(0);
+        size_t prior_overflows = this->_scratch.num_overflows();
+        AsdpTable table(
+            (this->_scratch_bytes > 0) ? &this->_scratch : nullptr
+        );
+
+        if (use_table) { table.reserve(msgs.size()); }
+
+        for (auto &msg : msgs) {
+            if (timer.is_expired()) {
+                return TIMEOUT;
+            }
+
+            int dp_id = msg.get_dp_id();
+            LOG(this->_logger, Synopsis::LogType::DEBUG, "Prioritize Step 1 >> loading ASDP ID: %d", dp_id);
+
+            DownlinkState dl_state = msg.get_downlink_state();
+            int bin = msg.get_priority_bin();
+
+            if (use_table) {
+                int row = table.add_data_product(msg);
+                if (dl_state == TRANSMITTED) {
+                    binned_transmitted_rows[bin].push_back(row);
+                } else {
+                    binned_rows[bin].push_back(row);
+                }
+                continue;
+            }
+
+            AsdpEntry asdp;
+            status = _populate_asdp(std::move(msg), asdp);
+            if (status != SUCCESS) {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "Error populating ASDP for DP id: %ld", dp_id);
+                return status;
+            }
+
+            if (dl_state == TRANSMITTED) {
+                binned_transmitted[bin].push_back(std::move(asdp));
+            } else {
+                binned_asdps[bin].push_back(std::move(asdp));
+            }
+
+        }
+
+        if (timer.is_expired()) {
+            return TIMEOUT;
+        }
+        load_timer.stop();
+
+        // Bins are prioritized independently (possibly concurrently) and
+        // their results are joined in bin order; each bin also records
+        // whether the deadline expired before it was fully prioritized
+        std::vector<int> bins;
+        std::vector<std::vector<int>> prioritized_bins;
+        std::unique_ptr<bool[]> expired;
+        std::vector<PoolTask> tasks;
+        Timer *deadline = &timer;
+
+        // With a budget, bins run in order, each with the budget left by
+        // earlier bins, until the budget is filled or the deadline expires
+        std::vector<BinBudget> bin_budgets;
+        std::vector<BinStats> bin_stats;
+        Clock *clock = this->_clock;
+        int n_run = 0;
+
+        // With a callback, each completed bin passes on the bins that are
+        // complete through the first incomplete one; the lock serializes
+        // the callbacks and keeps them in bin order
+        std::mutex emit_mutex;
+        std::vector<char> bin_done;
+        size_t n_emitted = 0;
+        bool emit_stopped = false;
+        auto emit_bins = [&](int b) {
+            if (on_bin == nullptr) { return; }
+            std::lock_guard<std::mutex> lock(emit_mutex);
+            bin_done[b] = true;
+            while (!emit_stopped && (n_emitted < bin_done.size()) &&
+                    bin_done[n_emitted]) {
+                (*on_bin)(bins[n_emitted], prioritized_bins[n_emitted]);
+                emit_stopped = expired[n_emitted];
+                n_emitted++;
+            }
+        };
+
+        auto run_bins = [&]() {
+            PhaseTimer planning_timer(
+                clock, stats ? &stats->planning_time_sec : nullptr
+            );
+            bin_done.assign(tasks.size(), false);
+            if (budget == nullptr) {
+                this->_run_tasks(tasks);
+                n_run = tasks.size();
+                return;
+            }
+            for (auto &task : tasks) {
+                BinBudget &bin_budget = bin_budgets[n_run];
+                bin_budget.max_bytes = budget->max_bytes;
+                bin_budget.max_count = budget->max_count;
+                task();
+                if (budget->max_bytes >= 0) {
+                    budget->max_bytes -= bin_budget.used_bytes;
+                }
+                if (budget->max_count >= 0) {
+                    budget->max_count -= (int)prioritized_bins[n_run].size();
+                }
+                budget->used_bytes += bin_budget.used_bytes;
+                budget->cut_asdp_id = bin_budget.cut_asdp_id;
+                n_run++;
+                if ((bin_budget.cut_asdp_id >= 0) || expired[n_run - 1]) {
+                    break;
+                }
+            }
+        };
+
+        if (use_table) {
+            ruleset.bind(table);
+            similarity.bind(table);
+
+            // Assign similarity matrix memory to bins; concurrently
+            // prioritized bins each need their own share of the budget
+            bool concurrent = (this->_pool && this->_pool->num_workers() > 0);
+            int n_bins = binned_rows.size();
+            std::vector<SimilarityMatrix> matrices(n_bins);
+            std::vector<void*> matrix_memory(n_bins, nullptr);
+            size_t memory_offset = 0;
+            int b = 0;
+            for (auto &entry : binned_rows) {
+                if (this->_similarity_memory_bytes > 0) {
+                    size_t required = SimilarityMatrix::memory_requirement(
+                        table, entry.second,
+                        similarity.get_functions(entry.first, table)
+                    );
+                    if (!concurrent) { memory_offset = 0; }
+                    if (memory_offset + required <= this->_similarity_memory_bytes) {
+                        matrix_memory[b] = (
+                            (char*)this->_similarity_memory + memory_offset
+                        );
+                        memory_offset += required;
+                    } else {
+                        LOG(this->_logger, Synopsis::LogType::INFO, "Similarity matrix for bin %d requires %lu bytes; computing similarities on demand", entry.first, (unsigned long)required);
+                    }
+                }
+                b++;
+            }
+
+            prioritized_bins.resize(n_bins);
+            expired.reset(new bool[n_bins]());
+            bin_budgets.resize(n_bins);
+            bin_stats.resize(n_bins);
+            bool use_context = similarity.uses_transmitted_context();
+            b = 0;
+            for (auto &entry : binned_rows) {
+                int bin = entry.first;
+                const AsdpRowList *rows = &entry.second;
+                const AsdpRowList *transmitted_rows = nullptr;
+                if (use_context && binned_transmitted_rows.count(bin)) {
+                    transmitted_rows = &binned_transmitted_rows.at(bin);
+                }
+                SimilarityMatrix *matrix = &matrices[b];
+                void *memory = matrix_memory[b];
+                bins.push_back(bin);
+                std::vector<int> *result = &prioritized_bins[b];
+                bool *bin_expired = &expired[b];
+                BinBudget *bin_budget = budget ? &bin_budgets[b] : nullptr;
+                BinStats *bin_stat = stats ? &bin_stats[b] : nullptr;
+                bin_stats[b].bin = bin;
+                MmrEngine engine = this->_engine;
+                ThreadPool *pool = this->_pool.get();
+                int scan_threshold = this->_scan_threshold;
+                tasks.push_back([=, &table, &ruleset, &similarity, &emit_bins]() {
+                    PhaseTimer bin_timer(
+                        clock, bin_stat ? &bin_stat->planning_time_sec : nullptr
+                    );
+                    SimilarityMatrix *bin_matrix = nullptr;
+                    if (memory != nullptr) {
+                        matrix->compute(
+                            table, *rows,
+                            similarity.get_functions(bin, table), memory
+                        );
+                        bin_matrix = matrix;
+                    }
+                    std::vector<double> context;
+                    if (transmitted_rows != nullptr) {
+                        context = _transmitted_similarity(
+                            table, *rows, *transmitted_rows,
+                            similarity.get_functions(bin, table)
+                        );
+                    }
+                    const std::vector<double> *initial_similarity = (
+                        transmitted_rows ? &context : nullptr
+                    );
+                    if (engine == LAZY_GREEDY) {
+                        *result = _prioritize_bin_lazy(
+                            bin, table, *rows, ruleset, similarity, bin_matrix,
+                            deadline, bin_expired, bin_budget, bin_stat,
+                            initial_similarity
+                        );
+                    } else {
+                        *result = _prioritize_bin_incremental(
+                            bin, table, *rows, ruleset, similarity, bin_matrix,
+                            pool, scan_threshold, deadline, bin_expired,
+                            bin_budget, bin_stat, initial_similarity
+                        );
+                    }
+                    emit_bins(b);
+                });
+                b++;
+            }
+            run_bins();
+
+            if (this->_scratch.bytes_high_water() > this->_scratch_high_water) {
+                this->_scratch_high_water = this->_scratch.bytes_high_water();
+            }
+            size_t overflows = this->_scratch.num_overflows() - prior_overflows;
+            if (overflows > 0) {
+                this->_scratch_overflows += overflows;
+                LOG(this->_logger, Synopsis::LogType::WARN, "%lu ASDP table allocations exceeded the planner scratch arena", (unsigned long)overflows);
+            }
+
+        } else {
+
+            // Each bin reads similarities cached by previous calls (for
+            // unchanged ASDPs) and caches new ones in its own copy, which are
+            // merged once all bins are prioritized
+            similarity.refresh_cache(binned_asdps);
+            std::vector<Similarity> bin_similarities;
+            for (size_t b = 0; b < binned_asdps.size(); b++) {
+                bin_similarities.push_back(similarity.fork());
+            }
+
+            // Prioritize each bin (assumes entries are traversed in bin order)
+            LOG(this->_logger, Synopsis::LogType::INFO, "Prioritize Step 2 > prioritize bins");
+            int prioritize_loop_index = 0;
+            int num_bins_to_prioritize = binned_asdps.size();
+            prioritized_bins.resize(num_bins_to_prioritize);
+            expired.reset(new bool[num_bins_to_prioritize]());
+            bin_budgets.resize(num_bins_to_prioritize);
+            bin_stats.resize(num_bins_to_prioritize);
+            for (auto &entry : binned_asdps) {
+                int bin = entry.first;
+                LOG(this->_logger, Synopsis::LogType::DEBUG, "Prioritize Step 2 >> prioritize bin index: %d/%d (bin = %d)", prioritize_loop_index, num_bins_to_prioritize, bin);
+                bins.push_back(bin);
+                const AsdpList *asdps = &entry.second;
+                const AsdpList *transmitted = nullptr;
+                if (similarity.uses_transmitted_context() &&
+                        binned_transmitted.count(bin)) {
+                    transmitted = &binned_transmitted.at(bin);
+                }
+                std::vector<int> *result = &prioritized_bins[prioritize_loop_index];
+                bool *bin_expired = &expired[prioritize_loop_index];
+                BinBudget *bin_budget = budget ?
+                    &bin_budgets[prioritize_loop_index] : nullptr;
+                BinStats *bin_stat = stats ?
+                    &bin_stats[prioritize_loop_index] : nullptr;
+                bin_stats[prioritize_loop_index].bin = bin;
+                ThreadPool *pool = this->_pool.get();
+                int scan_threshold = this->_scan_threshold;
+                Similarity *bin_similarity = &bin_similarities[prioritize_loop_index];
+                Logger *logger = this->_logger;
+                tasks.push_back([=, &ruleset, &emit_bins]() {
+                    PhaseTimer bin_timer(
+                        clock, bin_stat ? &bin_stat->planning_time_sec : nullptr
+                    );
+                    *result = _prioritize_bin(
+                        bin, *asdps, ruleset, *bin_similarity, pool,
+                        scan_threshold, deadline, bin_expired, bin_budget,
+                        bin_stat, logger, transmitted
+                    );
+                    emit_bins(prioritize_loop_index);
+                });
+                prioritize_loop_index++;
+            }
+            run_bins();
+            for (auto &bin_similarity : bin_similarities) {
+                similarity.merge_cache(bin_similarity);
+            }
+
+        }
+
+        for (int b = 0; b < n_run; b++) {
+            bin_orders[bins[b]] = std::move(prioritized_bins[b]);
+            if (expired[b]) {
+                expired_bins.insert(bins[b]);
+            }
+            if (stats != nullptr) {
+                stats->add_bin(bin_stats[b]);
+            }
+        }
+
+        return SUCCESS;
+    }
+
+
+    bool MaxMarginalRelevanceDownlinkPlanner::_find_changed_bins(
+        std::set<int> &bins, bool transmitted_context
+    ) {
+        std::set<int> changed_ids;
+        {
+            std::lock_guard<std::mutex> lock(this->_changes_mutex);
+            changed_ids.swap(this->_changed_ids);
+            if (this->_changes_reset) {
+                this->_changes_reset = false;
+                return false;
+            }
+        }
+
+        DpDbMsg msg;
+        for (int asdp_id : changed_ids) {
+            auto planned = this->_plan_asdp_bins.find(asdp_id);
+            if (planned != this->_plan_asdp_bins.end()) {
+                bins.insert(planned->second);
+            }
+            if (transmitted_context) {
+                auto context = this->_plan_transmitted_bins.find(asdp_id);
+                if (context != this->_plan_transmitted_bins.end()) {
+                    bins.insert(context->second);
+                }
+            }
+
+            // Changes that were rolled back may refer to missing ASDPs
+            if (this->_db->get_data_product(asdp_id, msg) != SUCCESS) {
+                continue;
+            }
+            DownlinkState state = msg.get_downlink_state();
+            if ((state == UNTRANSMITTED) ||
+                    (transmitted_context && (state == TRANSMITTED))) {
+                bins.insert(msg.get_priority_bin());
+            }
+        }
+        return true;
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::data_product_changed(
+        int asdp_id
+    ) {
+        std::lock_guard<std::mutex> lock(this->_changes_mutex);
+        this->_changed_ids.insert(asdp_id);
+    }
+
+
+    void MaxMarginalRelevanceDownlinkPlanner::data_products_reset(void) {
+        std::lock_guard<std::mutex> lock(this->_changes_mutex);
+        this->_changed_ids.clear();
+        this->_changes_reset = true;
     }
 
 
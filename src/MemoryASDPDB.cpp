@@ -0,0 +1,712 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see MemoryASDPDB.hpp
+ */
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+#include "MemoryASDPDB.hpp"
+
+
+namespace Synopsis {
+
+
+    const int MemoryASDPDB::SNAPSHOT_VERSION;
+
+
+    /**
+     * Identifies snapshot image files
+     */
+    static const char SNAPSHOT_MAGIC[8] = {'S', 'Y', 'N', 'S', 'N', 'A', 'P', '\0'};
+
+
+    /**
+     * Fixed header at the start of a snapshot image, which is followed by
+     * the used portions of the ASDP, metadata, field name, and string tables
+     */
+    struct SnapshotHeader {
+        char magic[8];
+        int32_t version;
+        int32_t asdp_record_size;
+        int32_t metadata_record_size;
+        int32_t n_asdps;
+        int32_t n_metadata;
+        int32_t n_fields;
+        uint64_t string_used;
+        uint64_t checksum;
+    };
+
+
+    /**
+     * A table region written to or read from a snapshot image
+     */
+    struct SnapshotRegion {
+        char *data;
+        size_t n_bytes;
+    };
+
+
+    /**
+     * Number of table regions in a snapshot image
+     */
+    static const int N_SNAPSHOT_REGIONS = 4;
+
+
+    /**
+     * Updates a 64-bit FNV-1a hash with a block of bytes
+     */
+    static uint64_t _fnv1a(uint64_t hash, const char *data, size_t n_bytes) {
+        for (size_t i = 0; i < n_bytes; i++) {
+            hash ^= (unsigned char)data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+
+    /**
+     * Computes the checksum of snapshot table regions
+     */
+    static uint64_t _snapshot_checksum(const SnapshotRegion *regions) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (int r = 0; r < N_SNAPSHOT_REGIONS; r++) {
+            hash = _fnv1a(hash, regions[r].data, regions[r].n_bytes);
+        }
+        return hash;
+    }
+
+
+    MemoryASDPDB::MemoryASDPDB(int max_asdps, int max_metadata, int max_fields,
+            size_t string_bytes) :
+        _max_asdps(max_asdps),
+        _max_metadata(max_metadata),
+        _max_fields(max_fields),
+        // One additional byte holds the empty string, shared by all empty
+        // values
+        _string_bytes(string_bytes + 1),
+        _asdps(NULL),
+        _metadata(NULL),
+        _fieldnames(NULL),
+        _strings(NULL),
+        _n_asdps(0),
+        _n_metadata(0),
+        _n_fields(0),
+        _string_used(0),
+        _batch_open(false),
+        _batch_updated(false),
+        _batch_mark(),
+        _initialized(false)
+    {
+
+    }
+
+
+    size_t MemoryASDPDB::memory_requirement(void) {
+        return (
+            MemoryArena::array_requirement<AsdpRecord>(this->_max_asdps) +
+            MemoryArena::array_requirement<MetadataRecord>(this->_max_metadata) +
+            MemoryArena::array_requirement<int>(this->_max_fields) +
+            MemoryArena::array_requirement<char>(this->_string_bytes)
+        );
+    }
+
+
+    Status MemoryASDPDB::init(size_t bytes, void* memory, Logger *logger) {
+        this->_logger = logger;
+        this->deinit();
+
+        if ((this->_max_asdps < 0) || (this->_max_metadata < 0) ||
+                (this->_max_fields < 0)) {
+            LOG(logger, Synopsis::LogType::ERROR, "Invalid in-memory ASDPDB capacity");
+            return FAILURE;
+        }
+        if ((memory == NULL) || (bytes < this->memory_requirement())) {
+            LOG(logger, Synopsis::LogType::ERROR, "Insufficient memory for in-memory ASDPDB");
+            return FAILURE;
+        }
+        if (((size_t)memory % MemoryArena::ALIGNMENT) != 0) {
+            LOG(logger, Synopsis::LogType::ERROR, "In-memory ASDPDB memory is not aligned");
+            return FAILURE;
+        }
+
+        // The memory block is aligned and the requirement includes padding
+        // for each table, so these allocations cannot fail
+        this->_arena.reset(bytes, memory);
+        this->_asdps = this->_arena.allocate_array<AsdpRecord>(this->_max_asdps);
+        this->_metadata = this->_arena.allocate_array<MetadataRecord>(this->_max_metadata);
+        this->_fieldnames = this->_arena.allocate_array<int>(this->_max_fields);
+        this->_strings = this->_arena.allocate_array<char>(this->_string_bytes);
+
+        this->_strings[0] = '\0';
+        this->_string_used = 1;
+
+        this->_initialized = true;
+        this->_notify_reset();
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::deinit(void) {
+        this->_initialized = false;
+        this->_arena.reset(0, NULL);
+        this->_asdps = NULL;
+        this->_metadata = NULL;
+        this->_fieldnames = NULL;
+        this->_strings = NULL;
+        this->_n_asdps = 0;
+        this->_n_metadata = 0;
+        this->_n_fields = 0;
+        this->_string_used = 0;
+        this->_batch_open = false;
+        this->_batch_updated = false;
+        this->_notify_reset();
+        return SUCCESS;
+    }
+
+
+    bool MemoryASDPDB::is_initialized(void) {
+        return this->_initialized;
+    }
+
+
+    bool MemoryASDPDB::_check_initialized(const std::string &operation) {
+        if (!this->_initialized) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB not initialized while %s", operation.c_str());
+        }
+        return this->_initialized;
+    }
+
+
+    MemoryASDPDB::AsdpRecord *MemoryASDPDB::_find(int asdp_id) {
+        if ((asdp_id < 1) || (asdp_id > this->_n_asdps)) {
+            return NULL;
+        }
+        return &this->_asdps[asdp_id - 1];
+    }
+
+
+    bool MemoryASDPDB::_store_string(const std::string &value, int *offset) {
+        if (value.empty()) {
+            *offset = 0;
+            return true;
+        }
+        size_t n_bytes = value.length() + 1;
+        if (n_bytes > this->_string_bytes - this->_string_used) {
+            return false;
+        }
+        std::memcpy(this->_strings + this->_string_used, value.c_str(), n_bytes);
+        *offset = this->_string_used;
+        this->_string_used += n_bytes;
+        return true;
+    }
+
+
+    int MemoryASDPDB::_find_fieldname(const std::string &fieldname) const {
+        for (int f = 0; f < this->_n_fields; f++) {
+            if (fieldname == this->_string(this->_fieldnames[f])) {
+                return f;
+            }
+        }
+        return -1;
+    }
+
+
+    bool MemoryASDPDB::_intern_fieldname(
+            const std::string &fieldname, int *fieldname_id) {
+        *fieldname_id = this->_find_fieldname(fieldname);
+        if (*fieldname_id >= 0) { return true; }
+
+        if (this->_n_fields >= this->_max_fields) { return false; }
+        int offset;
+        if (!this->_store_string(fieldname, &offset)) { return false; }
+        *fieldname_id = this->_n_fields;
+        this->_fieldnames[this->_n_fields++] = offset;
+        return true;
+    }
+
+
+    MemoryASDPDB::TableMark MemoryASDPDB::_mark(void) const {
+        TableMark mark;
+        mark.n_asdps = this->_n_asdps;
+        mark.n_metadata = this->_n_metadata;
+        mark.n_fields = this->_n_fields;
+        mark.string_used = this->_string_used;
+        return mark;
+    }
+
+
+    void MemoryASDPDB::_restore(const TableMark &mark) {
+        this->_n_asdps = mark.n_asdps;
+        this->_n_metadata = mark.n_metadata;
+        this->_n_fields = mark.n_fields;
+        this->_string_used = mark.string_used;
+    }
+
+
+    Status MemoryASDPDB::insert_data_product(DpDbMsg& msg) {
+        if (!this->_check_initialized("inserting data product")) {
+            return FAILURE;
+        }
+
+        const AsdpEntry &metadata = msg.get_metadata();
+        if ((this->_n_asdps >= this->_max_asdps) ||
+                ((int)metadata.size() > this->_max_metadata - this->_n_metadata)) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB capacity exceeded while inserting data product");
+            return FAILURE;
+        }
+
+        // Tables are only appended to, so a failed insert is undone by
+        // truncating them
+        TableMark mark = this->_mark();
+
+        AsdpRecord record;
+        bool stored = (
+            this->_store_string(msg.get_instrument_name(), &record.instrument_name) &&
+            this->_store_string(msg.get_type(), &record.type) &&
+            this->_store_string(msg.get_uri(), &record.uri)
+        );
+        record.size = msg.get_dp_size();
+        record.sue = msg.get_science_utility_estimate();
+        record.priority_bin = msg.get_priority_bin();
+        record.state = msg.get_downlink_state();
+        record.first_metadata = this->_n_metadata;
+        record.n_metadata = metadata.size();
+
+        for (auto const& pair : metadata) {
+            if (!stored) { break; }
+            MetadataRecord &value = this->_metadata[this->_n_metadata];
+            stored = (
+                this->_intern_fieldname(pair.first, &value.fieldname_id) &&
+                this->_store_string(pair.second.get_string_value(), &value.string_value)
+            );
+            value.type = pair.second.get_type();
+            value.int_value = pair.second.get_int_value();
+            value.float_value = pair.second.get_float_value();
+            this->_n_metadata++;
+        }
+
+        if (!stored) {
+            this->_restore(mark);
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB capacity exceeded while inserting data product");
+            return FAILURE;
+        }
+
+        this->_asdps[this->_n_asdps++] = record;
+        msg.set_dp_id(this->_n_asdps);
+
+        this->_notify_changed(this->_n_asdps);
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::begin_batch(void) {
+        if (!this->_check_initialized("beginning batch")) {
+            return FAILURE;
+        }
+
+        if (this->_batch_open) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB batch already open");
+            return FAILURE;
+        }
+
+        this->_batch_open = true;
+        this->_batch_updated = false;
+        this->_batch_mark = this->_mark();
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::commit_batch(void) {
+        if (!this->_check_initialized("committing batch")) {
+            return FAILURE;
+        }
+
+        if (!this->_batch_open) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB batch not open while committing");
+            return FAILURE;
+        }
+
+        this->_batch_open = false;
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::rollback_batch(void) {
+        if (!this->_check_initialized("rolling back batch")) {
+            return FAILURE;
+        }
+
+        if (!this->_batch_open) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB batch not open while rolling back");
+            return FAILURE;
+        }
+
+        this->_batch_open = false;
+        int string_used = this->_string_used;
+        this->_restore(this->_batch_mark);
+
+        if (this->_batch_updated) {
+            // Updated string values may be stored past the mark, so string
+            // storage is kept rather than freed for reuse
+            this->_string_used = string_used;
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB updates within batch not rolled back");
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+    void MemoryASDPDB::_populate_msg(int asdp_id, const AsdpRecord &record,
+            DpDbMsg &msg) const {
+        msg.set_dp_id(asdp_id);
+        msg.set_instrument_name(this->_string(record.instrument_name));
+        msg.set_type(this->_string(record.type));
+        msg.set_uri(this->_string(record.uri));
+        msg.set_dp_size(record.size);
+        msg.set_science_utility_estimate(record.sue);
+        msg.set_priority_bin(record.priority_bin);
+        msg.set_downlink_state(record.state);
+
+        AsdpEntry metadata;
+        for (int m = 0; m < record.n_metadata; m++) {
+            const MetadataRecord &value = this->_metadata[record.first_metadata + m];
+            metadata.insert({
+                this->_string(this->_fieldnames[value.fieldname_id]),
+                DpMetadataValue(
+                    value.type, value.int_value, value.float_value,
+                    this->_string(value.string_value)
+                )
+            });
+        }
+        msg.set_metadata(std::move(metadata));
+    }
+
+
+    Status MemoryASDPDB::get_data_product(int asdp_id, DpDbMsg& msg) {
+        if (!this->_check_initialized("getting data product")) {
+            return FAILURE;
+        }
+
+        AsdpRecord *record = this->_find(asdp_id);
+        if (record == NULL) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Data product not found");
+            return FAILURE;
+        }
+
+        this->_populate_msg(asdp_id, *record, msg);
+        return SUCCESS;
+    }
+
+
+    std::vector<int> MemoryASDPDB::list_data_product_ids(void) {
+        std::vector<int> result;
+        if (!this->_check_initialized("listing data product ids")) {
+            return result;
+        }
+
+        for (int asdp_id = 1; asdp_id <= this->_n_asdps; asdp_id++) {
+            result.push_back(asdp_id);
+        }
+        return result;
+    }
+
+
+    Status MemoryASDPDB::list_undownlinked_data_products(
+            std::vector<DpDbMsg> &msgs) {
+        if (!this->_check_initialized("listing data products")) {
+            return FAILURE;
+        }
+
+        for (int i = 0; i < this->_n_asdps; i++) {
+            const AsdpRecord &record = this->_asdps[i];
+            if (record.state == DOWNLINKED) { continue; }
+            DpDbMsg msg;
+            this->_populate_msg(i + 1, record, msg);
+            msgs.push_back(msg);
+        }
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::list_undownlinked_data_products_in_bin(
+            int priority_bin, std::vector<DpDbMsg> &msgs) {
+        if (!this->_check_initialized("listing data products")) {
+            return FAILURE;
+        }
+
+        for (int i = 0; i < this->_n_asdps; i++) {
+            const AsdpRecord &record = this->_asdps[i];
+            if ((record.state == DOWNLINKED) ||
+                    (record.priority_bin != priority_bin)) {
+                continue;
+            }
+            DpDbMsg msg;
+            this->_populate_msg(i + 1, record, msg);
+            msgs.push_back(msg);
+        }
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::update_science_utility(int asdp_id, double sue) {
+        if (!this->_check_initialized("updating science utility")) {
+            return FAILURE;
+        }
+
+        AsdpRecord *record = this->_find(asdp_id);
+        if (record == NULL) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB not found while updating science utility");
+            return FAILURE;
+        }
+
+        record->sue = sue;
+        if (this->_batch_open) { this->_batch_updated = true; }
+        this->_notify_changed(asdp_id);
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::update_priority_bin(int asdp_id, int bin) {
+        if (!this->_check_initialized("updating priority bin")) {
+            return FAILURE;
+        }
+
+        AsdpRecord *record = this->_find(asdp_id);
+        if (record == NULL) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB not found while updating priority bin");
+            return FAILURE;
+        }
+
+        record->priority_bin = bin;
+        if (this->_batch_open) { this->_batch_updated = true; }
+        this->_notify_changed(asdp_id);
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::update_downlink_state(int asdp_id, DownlinkState state) {
+        if (!this->_check_initialized("updating downlink state")) {
+            return FAILURE;
+        }
+
+        AsdpRecord *record = this->_find(asdp_id);
+        if (record == NULL) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB not found while updating downlink state");
+            return FAILURE;
+        }
+
+        record->state = state;
+        if (this->_batch_open) { this->_batch_updated = true; }
+        this->_notify_changed(asdp_id);
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::update_metadata(
+            int asdp_id, std::string fieldname, DpMetadataValue value) {
+        if (!this->_check_initialized("updating metadata")) {
+            return FAILURE;
+        }
+
+        AsdpRecord *record = this->_find(asdp_id);
+        int fieldname_id = this->_find_fieldname(fieldname);
+        MetadataRecord *found = NULL;
+        if ((record != NULL) && (fieldname_id >= 0)) {
+            for (int m = 0; m < record->n_metadata; m++) {
+                MetadataRecord &existing = this->_metadata[record->first_metadata + m];
+                if (existing.fieldname_id == fieldname_id) {
+                    found = &existing;
+                    break;
+                }
+            }
+        }
+        if (found == NULL) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB not found while updating metadata");
+            return FAILURE;
+        }
+
+        // Reuse the storage of the old string value when the new one fits
+        std::string string_value = value.get_string_value();
+        char *old_value = this->_strings + found->string_value;
+        if ((found->string_value != 0) &&
+                (string_value.length() <= std::strlen(old_value))) {
+            std::memcpy(old_value, string_value.c_str(), string_value.length() + 1);
+        } else if (!this->_store_string(string_value, &found->string_value)) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "In-memory DB capacity exceeded while updating metadata");
+            return FAILURE;
+        }
+
+        found->type = value.get_type();
+        found->int_value = value.get_int_value();
+        found->float_value = value.get_float_value();
+        if (this->_batch_open) { this->_batch_updated = true; }
+        this->_notify_changed(asdp_id);
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::save_snapshot(const std::string &path) {
+        if (!this->_check_initialized("saving snapshot")) {
+            return FAILURE;
+        }
+
+        if (this->_batch_open) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image not saved within a batch");
+            return FAILURE;
+        }
+
+        SnapshotRegion regions[N_SNAPSHOT_REGIONS] = {
+            {(char*)this->_asdps, this->_n_asdps * sizeof(AsdpRecord)},
+            {(char*)this->_metadata, this->_n_metadata * sizeof(MetadataRecord)},
+            {(char*)this->_fieldnames, this->_n_fields * sizeof(int)},
+            {this->_strings, this->_string_used}
+        };
+
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.asdp_record_size = sizeof(AsdpRecord);
+        header.metadata_record_size = sizeof(MetadataRecord);
+        header.n_asdps = this->_n_asdps;
+        header.n_metadata = this->_n_metadata;
+        header.n_fields = this->_n_fields;
+        header.string_used = this->_string_used;
+        header.checksum = _snapshot_checksum(regions);
+
+        std::string tmp_path = path + ".tmp";
+        bool written;
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            file.write((const char*)&header, sizeof(header));
+            for (int r = 0; r < N_SNAPSHOT_REGIONS; r++) {
+                file.write(regions[r].data, regions[r].n_bytes);
+            }
+            file.close();
+            written = !file.fail();
+        }
+
+        if (!written || (std::rename(tmp_path.c_str(), path.c_str()) != 0)) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image not written to %s", path.c_str());
+            std::remove(tmp_path.c_str());
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+    Status MemoryASDPDB::load_snapshot(const std::string &path) {
+        if (!this->_check_initialized("loading snapshot")) {
+            return FAILURE;
+        }
+
+        if (this->_batch_open) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image not loaded within a batch");
+            return FAILURE;
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        SnapshotHeader header;
+        file.read((char*)&header, sizeof(header));
+        if (!file) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image %s not read", path.c_str());
+            return FAILURE;
+        }
+
+        if ((std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) ||
+                (header.version != SNAPSHOT_VERSION) ||
+                (header.asdp_record_size != (int32_t)sizeof(AsdpRecord)) ||
+                (header.metadata_record_size != (int32_t)sizeof(MetadataRecord))) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image %s has an unsupported format", path.c_str());
+            return FAILURE;
+        }
+
+        if ((header.n_asdps < 0) || (header.n_asdps > this->_max_asdps) ||
+                (header.n_metadata < 0) || (header.n_metadata > this->_max_metadata) ||
+                (header.n_fields < 0) || (header.n_fields > this->_max_fields) ||
+                (header.string_used < 1) || (header.string_used > this->_string_bytes)) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image %s exceeds in-memory DB capacity", path.c_str());
+            return FAILURE;
+        }
+
+        // The existing contents are replaced, and discarded if the image is
+        // not valid
+        TableMark empty = {0, 0, 0, 1};
+        this->_restore(empty);
+
+        SnapshotRegion regions[N_SNAPSHOT_REGIONS] = {
+            {(char*)this->_asdps, header.n_asdps * sizeof(AsdpRecord)},
+            {(char*)this->_metadata, header.n_metadata * sizeof(MetadataRecord)},
+            {(char*)this->_fieldnames, header.n_fields * sizeof(int)},
+            {this->_strings, (size_t)header.string_used}
+        };
+        for (int r = 0; r < N_SNAPSHOT_REGIONS; r++) {
+            file.read(regions[r].data, regions[r].n_bytes);
+        }
+
+        TableMark mark = {
+            header.n_asdps, header.n_metadata, header.n_fields,
+            (size_t)header.string_used
+        };
+        this->_restore(mark);
+
+        if (!file || (_snapshot_checksum(regions) != header.checksum) ||
+                !this->_check_tables()) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Snapshot image %s is corrupt", path.c_str());
+            this->_restore(empty);
+            this->_strings[0] = '\0';
+            this->_notify_reset();
+            return FAILURE;
+        }
+
+        this->_notify_reset();
+        return SUCCESS;
+    }
+
+
+    bool MemoryASDPDB::_check_tables(void) const {
+        int string_used = this->_string_used;
+        if ((this->_strings[0] != '\0') ||
+                (this->_strings[string_used - 1] != '\0')) {
+            return false;
+        }
+        auto valid_string = [string_used](int offset) {
+            return (offset >= 0) && (offset < string_used);
+        };
+
+        for (int f = 0; f < this->_n_fields; f++) {
+            if (!valid_string(this->_fieldnames[f])) { return false; }
+        }
+
+        for (int m = 0; m < this->_n_metadata; m++) {
+            const MetadataRecord &value = this->_metadata[m];
+            if ((value.fieldname_id < 0) || (value.fieldname_id >= this->_n_fields) ||
+                    (value.type < INT) || (value.type > STRING) ||
+                    !valid_string(value.string_value)) {
+                return false;
+            }
+        }
+
+        for (int i = 0; i < this->_n_asdps; i++) {
+            const AsdpRecord &record = this->_asdps[i];
+            if (!valid_string(record.instrument_name) ||
+                    !valid_string(record.type) || !valid_string(record.uri) ||
+                    (record.state < UNTRANSMITTED) || (record.state > DOWNLINKED) ||
+                    (record.first_metadata < 0) || (record.n_metadata < 0) ||
+                    (record.n_metadata > this->_n_metadata - record.first_metadata)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+};
@@ -0,0 +1,76 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see MemoryArena.hpp
+ */
+#include <cstdint>
+
+#include "MemoryArena.hpp"
+
+
+namespace Synopsis {
+
+
+    const size_t MemoryArena::ALIGNMENT;
+
+
+    MemoryArena::MemoryArena() :
+        _memory(NULL),
+        _bytes(0),
+        _used(0),
+        _high_water(0),
+        _n_overflows(0)
+    {
+
+    }
+
+
+    MemoryArena::MemoryArena(size_t bytes, void *memory) {
+        this->reset(bytes, memory);
+    }
+
+
+    void MemoryArena::reset(size_t bytes, void *memory) {
+        this->_memory = static_cast<char*>(memory);
+        this->_bytes = (memory == NULL) ? 0 : bytes;
+        this->_used = 0;
+        this->_high_water = 0;
+        this->_n_overflows = 0;
+    }
+
+
+    void MemoryArena::rewind(size_t mark) {
+        if (mark < this->_used) {
+            this->_used = mark;
+        }
+    }
+
+
+    void *MemoryArena::allocate(size_t n_bytes) {
+        if (this->_memory == NULL) { return NULL; }
+
+        // Align the absolute address, so allocations are aligned even if the
+        // memory block itself is not
+        uintptr_t current = (uintptr_t)(this->_memory + this->_used);
+        size_t padding = (ALIGNMENT - (current % ALIGNMENT)) % ALIGNMENT;
+        if ((padding > this->bytes_available()) ||
+                (n_bytes > this->bytes_available() - padding)) {
+            return NULL;
+        }
+
+        char *region = this->_memory + this->_used + padding;
+        this->_used += padding + n_bytes;
+        if (this->_used > this->_high_water) {
+            this->_high_water = this->_used;
+        }
+        return region;
+    }
+
+
+    size_t MemoryArena::aligned_size(size_t n_bytes) {
+        return n_bytes + ((ALIGNMENT - (n_bytes % ALIGNMENT)) % ALIGNMENT);
+    }
+
+
+};
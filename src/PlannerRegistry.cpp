@@ -0,0 +1,87 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see PlannerRegistry.hpp
+ */
+#include <map>
+#include <mutex>
+
+#include "PlannerRegistry.hpp"
+#include "BaselineDownlinkPlanner.hpp"
+#include "MaxMarginalRelevanceDownlinkPlanner.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Registered planners, initialized with the built-in planners on first
+     * use, and the lock guarding them
+     */
+    static std::map<std::string, PlannerFactory> &_get_planners(void) {
+        static std::map<std::string, PlannerFactory> planners = {
+            {"mmr", []() {
+                return std::unique_ptr<DownlinkPlanner>(
+                    new MaxMarginalRelevanceDownlinkPlanner(EXHAUSTIVE_GREEDY)
+                );
+            }},
+            {"mmr_incremental", []() {
+                return std::unique_ptr<DownlinkPlanner>(
+                    new MaxMarginalRelevanceDownlinkPlanner(INCREMENTAL_GREEDY)
+                );
+            }},
+            {"mmr_lazy", []() {
+                return std::unique_ptr<DownlinkPlanner>(
+                    new MaxMarginalRelevanceDownlinkPlanner(LAZY_GREEDY)
+                );
+            }},
+            {"baseline", []() {
+                return std::unique_ptr<DownlinkPlanner>(
+                    new BaselineDownlinkPlanner()
+                );
+            }}
+        };
+        return planners;
+    }
+
+
+    static std::mutex _planners_mutex;
+
+
+    Status register_planner(const std::string &name, PlannerFactory factory) {
+        if (name.empty() || !factory) {
+            return FAILURE;
+        }
+        std::lock_guard<std::mutex> lock(_planners_mutex);
+        _get_planners()[name] = factory;
+        return SUCCESS;
+    }
+
+
+    std::unique_ptr<DownlinkPlanner> create_planner(const std::string &name) {
+        PlannerFactory factory;
+        {
+            std::lock_guard<std::mutex> lock(_planners_mutex);
+            auto &planners = _get_planners();
+            auto found = planners.find(name);
+            if (found == planners.end()) {
+                return nullptr;
+            }
+            factory = found->second;
+        }
+        return factory();
+    }
+
+
+    std::vector<std::string> list_planners(void) {
+        std::lock_guard<std::mutex> lock(_planners_mutex);
+        std::vector<std::string> names;
+        for (auto &entry : _get_planners()) {
+            names.push_back(entry.first);
+        }
+        return names;
+    }
+
+
+};
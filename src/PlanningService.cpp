@@ -0,0 +1,371 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see PlanningService.hpp
+ */
+#include <exception>
+
+#include <nlohmann/json.hpp>
+
+#include "PlanningService.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Utilities to read an optional request field of a given type
+     *
+     * @param[in] request: JSON request
+     * @param[in] key: field name
+     * @param[out] value: field value, unchanged if the field is missing
+     * @param[out] error: description of a field of the wrong type
+     *
+     * @return: false if the field is present with the wrong type
+     */
+    static bool _read_field(const nlohmann::json &request, const char *key, int &value, std::string &error) {
+        auto found = request.find(key);
+        if (found == request.end()) { return true; }
+        if (!found->is_number_integer()) {
+            error = std::string("Field ") + key + " should be an integer";
+            return false;
+        }
+        value = found->get<int>();
+        return true;
+    }
+
+    static bool _read_field(const nlohmann::json &request, const char *key, long &value, std::string &error) {
+        auto found = request.find(key);
+        if (found == request.end()) { return true; }
+        if (!found->is_number_integer()) {
+            error = std::string("Field ") + key + " should be an integer";
+            return false;
+        }
+        value = found->get<long>();
+        return true;
+    }
+
+    static bool _read_field(const nlohmann::json &request, const char *key, double &value, std::string &error) {
+        auto found = request.find(key);
+        if (found == request.end()) { return true; }
+        if (!found->is_number()) {
+            error = std::string("Field ") + key + " should be a number";
+            return false;
+        }
+        value = found->get<double>();
+        return true;
+    }
+
+    static bool _read_field(const nlohmann::json &request, const char *key, bool &value, std::string &error) {
+        auto found = request.find(key);
+        if (found == request.end()) { return true; }
+        if (!found->is_boolean()) {
+            error = std::string("Field ") + key + " should be a boolean";
+            return false;
+        }
+        value = found->get<bool>();
+        return true;
+    }
+
+    static bool _read_field(const nlohmann::json &request, const char *key, std::string &value, std::string &error) {
+        auto found = request.find(key);
+        if (found == request.end()) { return true; }
+        if (!found->is_string()) {
+            error = std::string("Field ") + key + " should be a string";
+            return false;
+        }
+        value = found->get<std::string>();
+        return true;
+    }
+
+
+    /**
+     * Reads an optional request field holding a downlink state
+     *
+     * @see _read_field
+     *
+     * @return: false if the field is present and not a downlink state
+     */
+    static bool _read_downlink_state(const nlohmann::json &request, const char *key, int &value, std::string &error) {
+        int state = value;
+        if (!_read_field(request, key, state, error)) { return false; }
+        if ((state < UNTRANSMITTED) || (state > DOWNLINKED)) {
+            error = std::string("Field ") + key + " should be a downlink state";
+            return false;
+        }
+        value = state;
+        return true;
+    }
+
+
+    /**
+     * Converts a JSON metadata value to a metadata value
+     *
+     * @param[in] j_value: JSON number or string
+     * @param[out] value: metadata value
+     *
+     * @return: false if the JSON value is neither a number nor a string
+     */
+    static bool _to_metadata_value(const nlohmann::json &j_value, DpMetadataValue &value) {
+        if (j_value.is_number_integer()) {
+            value = DpMetadataValue(j_value.get<int>());
+        } else if (j_value.is_number()) {
+            value = DpMetadataValue(j_value.get<double>());
+        } else if (j_value.is_string()) {
+            value = DpMetadataValue(j_value.get<std::string>());
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+
+    /**
+     * Formats a data product as by `synopsis_cli`
+     *
+     * @param[in] msg: data product
+     *
+     * @return: JSON data product
+     */
+    static nlohmann::json _format_data_product(const DpDbMsg &msg) {
+        nlohmann::json dp = {
+            {"dp_id", msg.get_dp_id()},
+            {"instrument_name", msg.get_instrument_name()},
+            {"dp_type", msg.get_type()},
+            {"dp_uri", msg.get_uri()},
+            {"dp_size", msg.get_dp_size()},
+            {"science_utility_estimate", msg.get_science_utility_estimate()},
+            {"priority_bin", msg.get_priority_bin()},
+            {"downlink_state", msg.get_downlink_state()}
+        };
+        for (const auto &elem : msg.get_metadata()) {
+            const DpMetadataValue &mdval = elem.second;
+            if (mdval.is_numeric()) {
+                dp["metadata"][elem.first] = mdval.get_numeric();
+            } else {
+                dp["metadata"][elem.first] = mdval.get_string_value();
+            }
+        }
+        return dp;
+    }
+
+
+    PlanningService::PlanningService(Application *app, Logger *logger) :
+        _app(app),
+        _logger(logger)
+    {
+
+    }
+
+
+    Status PlanningService::handle(
+        const std::string &request, std::string &response
+    ) {
+        nlohmann::json j_response;
+        std::string error;
+        Status status = FAILURE;
+
+        nlohmann::json j_request = nlohmann::json::parse(request, nullptr, false);
+        std::string command;
+        int asdp_id = -1;
+        // Configurations are parsed while handling the request, and a
+        // missing or malformed one fails the request rather than the service
+        try {
+            if (j_request.is_discarded() || !j_request.is_object()) {
+                error = "Request is not a JSON object";
+            } else if (!_read_field(j_request, "command", command, error) ||
+                    !_read_field(j_request, "asdp_id", asdp_id, error)) {
+                // Error already set
+            } else if (command == "prioritize") {
+                std::string rule_config;
+                std::string similarity_config;
+                double max_processing_time_sec = 1e9;
+                long max_bytes = -1;
+                int max_count = -1;
+                bool ids_only = false;
+                if (_read_field(j_request, "rule_config", rule_config, error) &&
+                        _read_field(j_request, "similarity_config", similarity_config, error) &&
+                        _read_field(j_request, "max_processing_time_sec", max_processing_time_sec, error) &&
+                        _read_field(j_request, "max_bytes", max_bytes, error) &&
+                        _read_field(j_request, "max_count", max_count, error) &&
+                        _read_field(j_request, "ids_only", ids_only, error)) {
+                    std::vector<int> prioritized_list;
+                    int cut_asdp_id = -1;
+                    bool budgeted = (max_bytes >= 0) || (max_count >= 0);
+                    if (budgeted) {
+                        status = this->_app->prioritize_with_budget(
+                            rule_config, similarity_config,
+                            max_processing_time_sec, max_bytes, max_count,
+                            prioritized_list, cut_asdp_id
+                        );
+                        j_response["cut_asdp_id"] = cut_asdp_id;
+                    } else {
+                        status = this->_app->prioritize(
+                            rule_config, similarity_config,
+                            max_processing_time_sec, prioritized_list
+                        );
+                    }
+                    j_response["prioritized_list"] = nlohmann::json::array();
+                    if (status != SUCCESS) { error = "Prioritization failed"; }
+                    for (int id : prioritized_list) {
+                        if (ids_only) {
+                            j_response["prioritized_list"].push_back(id);
+                            continue;
+                        }
+                        DpDbMsg msg;
+                        if (this->_app->get_planned_data_product(id, msg) != SUCCESS) {
+                            status = FAILURE;
+                            error = "Data product " + std::to_string(id) + " of the plan not found";
+                            break;
+                        }
+                        j_response["prioritized_list"].push_back(
+                            _format_data_product(msg)
+                        );
+                    }
+                }
+            } else if (command == "ingest") {
+                std::string instrument_name;
+                std::string type;
+                std::string uri;
+                int size = 0;
+                double sue = 0.0;
+                int bin = 0;
+                int downlink_state = UNTRANSMITTED;
+                AsdpEntry metadata;
+                if (_read_field(j_request, "instrument_name", instrument_name, error) &&
+                        _read_field(j_request, "type", type, error) &&
+                        _read_field(j_request, "uri", uri, error) &&
+                        _read_field(j_request, "size", size, error) &&
+                        _read_field(j_request, "science_utility_estimate", sue, error) &&
+                        _read_field(j_request, "priority_bin", bin, error) &&
+                        _read_downlink_state(j_request, "downlink_state", downlink_state, error)) {
+                    auto j_metadata = j_request.find("metadata");
+                    if (j_metadata != j_request.end() && !j_metadata->is_object()) {
+                        error = "Field metadata should be an object";
+                    } else if (j_metadata != j_request.end()) {
+                        for (auto &item : j_metadata->items()) {
+                            DpMetadataValue value;
+                            if (!_to_metadata_value(item.value(), value)) {
+                                error = "Metadata field " + item.key() + " should be a number or string";
+                                break;
+                            }
+                            metadata[item.key()] = value;
+                        }
+                    }
+                    if (error.empty()) {
+                        DpDbMsg msg(
+                            -1, instrument_name, type, uri, size, sue, bin,
+                            (DownlinkState)downlink_state, metadata
+                        );
+                        status = this->_app->insert_data_product(msg);
+                        if (status == SUCCESS) {
+                            j_response["asdp_id"] = msg.get_dp_id();
+                        } else {
+                            error = "Insert failed";
+                        }
+                    }
+                }
+            } else if (command == "update_science_utility") {
+                double value = 0.0;
+                if (_read_field(j_request, "value", value, error)) {
+                    status = this->_app->update_science_utility(asdp_id, value);
+                    if (status != SUCCESS) { error = "Update failed"; }
+                }
+            } else if (command == "update_priority_bin") {
+                int value = 0;
+                if (_read_field(j_request, "value", value, error)) {
+                    status = this->_app->update_priority_bin(asdp_id, value);
+                    if (status != SUCCESS) { error = "Update failed"; }
+                }
+            } else if (command == "update_downlink_state") {
+                int value = UNTRANSMITTED;
+                if (_read_downlink_state(j_request, "value", value, error)) {
+                    status = this->_app->update_downlink_state(
+                        asdp_id, (DownlinkState)value
+                    );
+                    if (status != SUCCESS) { error = "Update failed"; }
+                }
+            } else if (command == "update_metadata") {
+                std::string field;
+                DpMetadataValue value;
+                auto j_value = j_request.find("value");
+                if (!_read_field(j_request, "field", field, error)) {
+                    // Error already set
+                } else if ((j_value == j_request.end()) ||
+                        !_to_metadata_value(*j_value, value)) {
+                    error = "Field value should be a number or string";
+                } else {
+                    switch (value.get_type()) {
+                        case INT:
+                            status = this->_app->update_asdp_metadata(
+                                asdp_id, field, value.get_int_value()
+                            );
+                            break;
+                        case FLOAT:
+                            status = this->_app->update_asdp_metadata(
+                                asdp_id, field, value.get_float_value()
+                            );
+                            break;
+                        default:
+                            status = this->_app->update_asdp_metadata(
+                                asdp_id, field, value.get_string_value()
+                            );
+                            break;
+                    }
+                    if (status != SUCCESS) { error = "Update failed"; }
+                }
+            } else if (command == "get") {
+                DpDbMsg msg;
+                status = this->_app->get_data_product(asdp_id, msg);
+                if (status == SUCCESS) {
+                    j_response["data_product"] = _format_data_product(msg);
+                } else {
+                    error = "Data product not found";
+                }
+            } else if (command == "quit") {
+                this->_stopped = true;
+                status = SUCCESS;
+            } else {
+                error = "Unknown command: " + command;
+            }
+        } catch (const std::exception &e) {
+            status = FAILURE;
+            error = std::string("Request raised an exception: ") + e.what();
+        } catch (const std::string &e) {
+            // Raised by SQLite statements (e.g., on a busy or I/O error)
+            status = FAILURE;
+            error = "Request raised an exception: " + e;
+        } catch (...) {
+            status = FAILURE;
+            error = "Request raised an unknown exception";
+        }
+
+        if (!error.empty()) {
+            if (status == SUCCESS) { status = FAILURE; }
+            j_response["error"] = error;
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Request failed: %s", error.c_str());
+        }
+        j_response["status"] = status;
+        response = j_response.dump();
+        return status;
+    }
+
+
+    int PlanningService::serve(std::istream &input, std::ostream &output) {
+        int n_handled = 0;
+        std::string request;
+        std::string response;
+        while (!this->_stopped && std::getline(input, request)) {
+            if (request.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            this->handle(request, response);
+            output << response << std::endl;
+            n_handled++;
+        }
+        return n_handled;
+    }
+
+
+};
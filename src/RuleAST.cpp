@@ -5,6 +5,7 @@
  * @see RuleAST.hpp
  */
 #include <limits>
+#include <algorithm>
 #include <nlohmann/json.hpp>
 #include <fstream>
 
@@ -13,10 +14,176 @@
 
 namespace Synopsis {
 
+    /**
+     * Value of missing fields and failed numeric evaluations
+     */
+    static const AsdpValue NAN_VALUE = {
+        FLOAT, true, 0, std::numeric_limits<double>::quiet_NaN(), -1
+    };
+
+
     void RuleExpression::set_logger(Logger *logger) {
         this->_logger = logger;
     }
 
+
+    void RuleExpression::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_scope = scope;
+    }
+
+
+    int RuleExpression::compile(RuleProgram &program) {
+        return -1;
+    }
+
+
+    /**
+     * Compiles a bound expression to a rule program, clearing the program if
+     * the expression cannot be compiled
+     */
+    static void _compile_program(
+        RuleExpression *expr, RuleProgram &program, Logger *logger
+    ) {
+        program.clear();
+        program.set_logger(logger);
+        program.set_result(expr->compile(program));
+    }
+
+
+    /**
+     * Assignments and register file for evaluating rules and constraints on
+     * one thread (planner workers and parallel scan chunks each have their
+     * own). They grow to the largest evaluation and are then reused, so that
+     * evaluations in steady state do not allocate.
+     */
+    struct EvaluationScratch {
+        AsdpRowAssignments assignments;
+        std::vector<AsdpValue> registers;
+    };
+
+
+    /**
+     * @param[in] n_variables: number of variable assignments, all reset
+     * @param[in] n_registers: minimum number of registers
+     *
+     * @return: scratch storage of the calling thread
+     */
+    static EvaluationScratch &_get_scratch(int n_variables, int n_registers) {
+        static thread_local EvaluationScratch scratch;
+        scratch.assignments.assign(n_variables, 0);
+        if ((int)scratch.registers.size() < n_registers) {
+            scratch.registers.resize(n_registers);
+        }
+        return scratch;
+    }
+
+
+    /**
+     * Evaluates a bound Boolean-valued expression, using its compiled program
+     * if available
+     */
+    static inline bool _evaluate_bool(
+        BoolValueExpression *expr,
+        const RuleProgram &program,
+        AsdpTable &table,
+        AsdpRowAssignments &assignments,
+        const AsdpRowList &asdps,
+        std::vector<AsdpValue> &registers,
+        const QueueIndex *index
+    ) {
+        if (program.is_compiled()) {
+            return program.evaluate_bool(table, assignments, asdps, registers, index);
+        }
+        return expr->evaluate(table, assignments, asdps);
+    }
+
+
+    /**
+     * Evaluates a bound metadata-valued expression, using its compiled
+     * program if available
+     */
+    static inline AsdpValue _evaluate_value(
+        ValueExpression *expr,
+        const RuleProgram &program,
+        AsdpTable &table,
+        AsdpRowAssignments &assignments,
+        const AsdpRowList &asdps,
+        std::vector<AsdpValue> &registers,
+        const QueueIndex *index
+    ) {
+        if (program.is_compiled()) {
+            return program.evaluate(table, assignments, asdps, registers, index);
+        }
+        return expr->evaluate(table, assignments, asdps);
+    }
+
+
+    void RuleExpression::_materialize(
+        AsdpTable &table,
+        const AsdpRowAssignments &assignments,
+        const AsdpRowList &rows,
+        AsdpList &assigned,
+        AsdpAssignments &asdp_assignments,
+        AsdpList &asdps
+    ) {
+        int n_vars = std::min(assignments.size(), this->_scope.size());
+        for (int i = 0; i < n_vars; i++) {
+            assigned.push_back(table.get_entry(assignments[i]));
+        }
+        for (int i = 0; i < n_vars; i++) {
+            asdp_assignments.push_back(
+                std::make_pair(this->_scope[i], &assigned[i])
+            );
+        }
+        for (int row : rows) {
+            asdps.push_back(table.get_entry(row));
+        }
+    }
+
+
+    bool BoolValueExpression::evaluate(
+        AsdpTable &table,
+        const AsdpRowAssignments &assignments,
+        const AsdpRowList &asdps
+    ) {
+        AsdpList assigned;
+        AsdpAssignments asdp_assignments;
+        AsdpList asdp_list;
+        this->_materialize(
+            table, assignments, asdps, assigned, asdp_assignments, asdp_list
+        );
+        return this->get_value(asdp_assignments, asdp_list);
+    }
+
+
+    void BoolValueExpression::find_equalities(
+        int var_index, std::vector<FieldEquality> &equalities
+    ) {
+
+    }
+
+
+    AsdpValue ValueExpression::evaluate(
+        AsdpTable &table,
+        const AsdpRowAssignments &assignments,
+        const AsdpRowList &asdps
+    ) {
+        AsdpList assigned;
+        AsdpAssignments asdp_assignments;
+        AsdpList asdp_list;
+        this->_materialize(
+            table, assignments, asdps, assigned, asdp_assignments, asdp_list
+        );
+        return table.make_value(this->get_value(asdp_assignments, asdp_list));
+    }
+
+
+    int ValueExpression::get_field_slot(int var_index) {
+        return -1;
+    }
+
     /**
      * Determine the object type within the JSON AST representation using the
      * `__type__` field.
@@ -134,16 +301,16 @@ namespace Synopsis {
 
     }
 
-    double Rule::apply(AsdpList asdps) {
+    double Rule::apply(const AsdpList &asdps) {
 
         int n_applications = 0;
         double total_adj_value = 0.0;
         DpMetadataValue adj;
 
         if (_variables.size() == 1) {
-            for (auto a : asdps) {
+            for (auto &a : asdps) {
                 AsdpAssignments assignments = {
-                    {_variables[0], a}
+                    {_variables[0], &a}
                 };
                 if (_application_expression->get_value(assignments, asdps)) {
                     adj = _adjustment_expression->get_value(assignments, asdps);
@@ -162,11 +329,11 @@ namespace Synopsis {
             return total_adj_value;
 
         } else if (_variables.size() == 2) {
-            for (auto a : asdps) {
-                for (auto b : asdps) {
+            for (auto &a : asdps) {
+                for (auto &b : asdps) {
                     AsdpAssignments assignments = {
-                        {_variables[0], a},
-                        {_variables[1], b}
+                        {_variables[0], &a},
+                        {_variables[1], &b}
                     };
                     if (_application_expression->get_value(assignments, asdps)) {
                         adj = _adjustment_expression->get_value(assignments, asdps);
@@ -199,6 +366,193 @@ namespace Synopsis {
     }
 
 
+    void Rule::bind(AsdpTable &table) {
+        std::vector<std::string> scope(this->_variables);
+        _application_expression->bind(table, scope);
+        _adjustment_expression->bind(table, scope);
+
+        // Both expressions are evaluated as programs or both as trees, since
+        // programs also use assignments for existentially quantified
+        // variables
+        _compile_program(_application_expression, _application_program, this->_logger);
+        _compile_program(_adjustment_expression, _adjustment_program, this->_logger);
+        if (!this->is_compiled()) {
+            _application_program.clear();
+            _adjustment_program.clear();
+        }
+        // As `apply` stops at the first application when the limit is zero,
+        // such rules are not incremental
+        _incremental = this->is_compiled() && (_max_applications != 0) &&
+            ((_variables.size() == 1) || (_variables.size() == 2)) &&
+            !_application_program.uses_queue() &&
+            !_adjustment_program.uses_queue();
+    }
+
+
+    bool Rule::is_compiled(void) const {
+        return _application_program.is_compiled() && _adjustment_program.is_compiled();
+    }
+
+
+    void Rule::add_index_slots(std::vector<int> &slots) const {
+        for (auto *program : {&_application_program, &_adjustment_program}) {
+            auto &program_slots = program->index_slots();
+            slots.insert(slots.end(), program_slots.begin(), program_slots.end());
+        }
+    }
+
+
+    double Rule::apply(
+        AsdpTable &table, const AsdpRowList &asdps, const QueueIndex *index
+    ) {
+        int n_applications = 0;
+        return this->_apply(table, asdps, n_applications, index);
+    }
+
+
+    double Rule::_apply(
+        AsdpTable &table, const AsdpRowList &asdps, int &n_applications,
+        const QueueIndex *index
+    ) {
+
+        n_applications = 0;
+        double total_adj_value = 0.0;
+
+        // Assignments and registers are shared by all evaluations
+        int n_vars = std::max({
+            (int)_variables.size(),
+            _application_program.num_variables(),
+            _adjustment_program.num_variables()
+        });
+        EvaluationScratch &scratch = _get_scratch(n_vars, std::max(
+            _application_program.num_registers(),
+            _adjustment_program.num_registers()
+        ));
+        AsdpRowAssignments &assignments = scratch.assignments;
+        std::vector<AsdpValue> &registers = scratch.registers;
+
+        if (_variables.size() == 1) {
+            for (int a : asdps) {
+                assignments[0] = a;
+                if (this->_accumulate(table, assignments, asdps, registers,
+                        index, total_adj_value, n_applications)) {
+                    if ((_max_applications >= 0) && (n_applications >= _max_applications)) {
+                        break;
+                    }
+                }
+            }
+            return total_adj_value;
+
+        } else if (_variables.size() == 2) {
+            for (int a : asdps) {
+                assignments[0] = a;
+                for (int b : asdps) {
+                    assignments[1] = b;
+                    if (this->_accumulate(table, assignments, asdps, registers,
+                            index, total_adj_value, n_applications)) {
+                        if ((_max_applications >= 0) && (n_applications >= _max_applications)) {
+                            break;
+                        }
+                    }
+                }
+                if ((_max_applications >= 0) && (n_applications >= _max_applications)) {
+                    break;
+                }
+            }
+            return total_adj_value;
+
+        } else {
+            LOG(this->_logger, Synopsis::LogType::ERROR,"Ignoring rules with more than 2 variables specified; currently unsupported");
+            return total_adj_value;
+        }
+
+    }
+
+
+    bool Rule::_accumulate(
+        AsdpTable &table,
+        AsdpRowAssignments &assignments,
+        const AsdpRowList &asdps,
+        std::vector<AsdpValue> &registers,
+        const QueueIndex *index,
+        double &total,
+        int &n_applications
+    ) {
+        if (!_evaluate_bool(_application_expression, _application_program,
+                table, assignments, asdps, registers, index)) {
+            return false;
+        }
+        AsdpValue adj = _evaluate_value(_adjustment_expression, _adjustment_program,
+            table, assignments, asdps, registers, index);
+        if (adj.is_numeric()) {
+            total += adj.get_numeric();
+            n_applications += 1;
+        } else {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Applicaton/adjustment failed due to non-numeric adjustment value");
+        }
+        return true;
+    }
+
+
+    void Rule::extend(
+        AsdpTable &table, const AsdpRowList &asdps,
+        double &total, int &n_applications, const QueueIndex *index
+    ) {
+        if (!_incremental) {
+            total = this->_apply(table, asdps, n_applications, index);
+            return;
+        }
+        if (asdps.empty()) { return; }
+        bool limited = (_max_applications >= 0);
+
+        // Falling back to _apply below reuses the scratch, which is not used
+        // afterwards
+        EvaluationScratch &scratch = _get_scratch(std::max({
+            (int)_variables.size(),
+            _application_program.num_variables(),
+            _adjustment_program.num_variables()
+        }), std::max(
+            _application_program.num_registers(),
+            _adjustment_program.num_registers()
+        ));
+        AsdpRowAssignments &assignments = scratch.assignments;
+        std::vector<AsdpValue> &registers = scratch.registers;
+        int added = asdps.back();
+
+        if (_variables.size() == 1) {
+            // The new ASDP is last, so it is applied only if the limit was
+            // not reached by earlier ASDPs
+            if (limited && (n_applications >= _max_applications)) { return; }
+            assignments[0] = added;
+            this->_accumulate(
+                table, assignments, asdps, registers, index, total,
+                n_applications
+            );
+            return;
+        }
+
+        // Pairs involving the new ASDP are interleaved with existing pairs in
+        // the order that `apply` visits them, so the pairs applied only agree
+        // if the limit is not exceeded
+        double extended_total = total;
+        int extended_applications = n_applications;
+        int n_asdps = asdps.size();
+        for (int i = 0; i < 2 * n_asdps - 1; i++) {
+            bool in_row = (i < n_asdps - 1);
+            assignments[0] = in_row ? asdps[i] : added;
+            assignments[1] = in_row ? added : asdps[i - (n_asdps - 1)];
+            this->_accumulate(table, assignments, asdps, registers, index,
+                extended_total, extended_applications);
+            if (limited && (extended_applications > _max_applications)) {
+                total = this->_apply(table, asdps, n_applications, index);
+                return;
+            }
+        }
+        total = extended_total;
+        n_applications = extended_applications;
+    }
+
+
     Constraint::Constraint(
         std::vector<std::string> variables,
         BoolValueExpression *application_expression,
@@ -216,15 +570,15 @@ namespace Synopsis {
     }
 
 
-    bool Constraint::apply(AsdpList asdps) {
+    bool Constraint::apply(const AsdpList &asdps) {
 
         double aggregate = 0.0;
         DpMetadataValue value;
 
         if (_variables.size() == 1) {
-            for (auto a : asdps) {
+            for (auto &a : asdps) {
                 AsdpAssignments assignments = {
-                    {_variables[0], a}
+                    {_variables[0], &a}
                 };
                 if (_application_expression->get_value(assignments, asdps)) {
                     if (_sum_field) {
@@ -251,6 +605,123 @@ namespace Synopsis {
     }
 
 
+    void Constraint::bind(AsdpTable &table) {
+        std::vector<std::string> scope(this->_variables);
+        _application_expression->bind(table, scope);
+        if (_sum_field) {
+            _sum_field->bind(table, scope);
+        }
+
+        // As for rules, all expressions are evaluated as programs or all as
+        // trees
+        _compile_program(_application_expression, _application_program, this->_logger);
+        _sum_program.clear();
+        if (_sum_field) {
+            _compile_program(_sum_field, _sum_program, this->_logger);
+        }
+        if (!this->is_compiled()) {
+            _application_program.clear();
+            _sum_program.clear();
+        }
+        _incremental = (_variables.size() == 1) && this->is_compiled() &&
+            !_application_program.uses_queue() && !_sum_program.uses_queue();
+    }
+
+
+    bool Constraint::is_compiled(void) const {
+        return _application_program.is_compiled() &&
+            (!_sum_field || _sum_program.is_compiled());
+    }
+
+
+    void Constraint::add_index_slots(std::vector<int> &slots) const {
+        for (auto *program : {&_application_program, &_sum_program}) {
+            auto &program_slots = program->index_slots();
+            slots.insert(slots.end(), program_slots.begin(), program_slots.end());
+        }
+    }
+
+
+    bool Constraint::apply(
+        AsdpTable &table, const AsdpRowList &asdps, const QueueIndex *index
+    ) {
+
+        double aggregate = 0.0;
+
+        if (_variables.size() == 1) {
+            EvaluationScratch &scratch = _get_scratch(std::max({
+                1,
+                _application_program.num_variables(),
+                _sum_program.num_variables()
+            }), std::max(
+                _application_program.num_registers(),
+                _sum_program.num_registers()
+            ));
+            AsdpRowAssignments &assignments = scratch.assignments;
+            std::vector<AsdpValue> &registers = scratch.registers;
+            for (int a : asdps) {
+                assignments[0] = a;
+                this->_accumulate(
+                    table, assignments, asdps, registers, index, aggregate
+                );
+            }
+            return aggregate < _constraint_value;
+
+        } else {
+            return true;
+        }
+
+    }
+
+
+    double Constraint::contribution(
+        AsdpTable &table, int row, const AsdpRowList &asdps,
+        const QueueIndex *index
+    ) {
+        double aggregate = 0.0;
+        EvaluationScratch &scratch = _get_scratch(std::max({
+            1,
+            _application_program.num_variables(),
+            _sum_program.num_variables()
+        }), std::max(
+            _application_program.num_registers(),
+            _sum_program.num_registers()
+        ));
+        AsdpRowAssignments &assignments = scratch.assignments;
+        std::vector<AsdpValue> &registers = scratch.registers;
+        assignments[0] = row;
+        this->_accumulate(
+            table, assignments, asdps, registers, index, aggregate
+        );
+        return aggregate;
+    }
+
+
+    void Constraint::_accumulate(
+        AsdpTable &table,
+        AsdpRowAssignments &assignments,
+        const AsdpRowList &asdps,
+        std::vector<AsdpValue> &registers,
+        const QueueIndex *index,
+        double &aggregate
+    ) {
+        if (_evaluate_bool(_application_expression, _application_program,
+                table, assignments, asdps, registers, index)) {
+            if (_sum_field) {
+                AsdpValue value = _evaluate_value(_sum_field, _sum_program,
+                    table, assignments, asdps, registers, index);
+                if (value.is_numeric()) {
+                    aggregate += value.get_numeric();
+                } else {
+                    LOG(this->_logger, Synopsis::LogType::ERROR,  "Non-numeric value prevented aggregation while applying constraint");
+                }
+            } else {
+                aggregate += 1;
+            }
+        }
+    }
+
+
     RuleSet::RuleSet():
         _rule_map({}),
         _constraint_map({}),
@@ -317,22 +788,40 @@ namespace Synopsis {
     }
 
 
+    RuleList &RuleSet::_get_bin_rules(int bin) {
+        auto found = this->_rule_map.find(bin);
+        if (found != this->_rule_map.end()) {
+            return found->second;
+        }
+        return this->_default_rules;
+    }
+
+
+    ConstraintList &RuleSet::_get_bin_constraints(int bin) {
+        auto found = this->_constraint_map.find(bin);
+        if (found != this->_constraint_map.end()) {
+            return found->second;
+        }
+        return this->_default_constraints;
+    }
+
+
     std::pair<bool, double> RuleSet::apply(
         int bin,
-        AsdpList queue
+        const AsdpList &queue
     ) {
 
         // Check constraints
-        ConstraintList constraints = this->get_constraints(bin);
+        ConstraintList &constraints = this->_get_bin_constraints(bin);
         bool violated = false;
         unsigned int num_constraints = constraints.size();
         // for (auto &constraint : constraints) {
         for(unsigned int i = 0; i < num_constraints; i++){
-            Constraint constraint = constraints[i];
+            Constraint &constraint = constraints[i];
             if (!constraint.apply(queue)) {
                 violated = true;
                 //TODO: create a printable string representation of constraitns and call that here to report which constraint is violated instead logging of loop index
-                LOG(this->_logger, Synopsis::LogType::INFO,   "Violated constraint index: %ld ", i); 
+                LOG(this->_logger, Synopsis::LogType::DEBUG,  "Violated constraint index: %u", i); 
                 
                 break;
             }
@@ -342,9 +831,8 @@ namespace Synopsis {
         }
 
         // Apply rules
-        RuleList rules = this->get_rules(bin);
         double utility = 0.0;
-        for (auto &rule : rules) {
+        for (auto &rule : this->_get_bin_rules(bin)) {
             double adj = rule.apply(queue);
             utility += adj;
         }
@@ -353,6 +841,143 @@ namespace Synopsis {
     }
 
 
+    void RuleSet::bind(AsdpTable &table) {
+        for (auto &entry : this->_rule_map) {
+            for (auto &rule : entry.second) { rule.bind(table); }
+        }
+        for (auto &entry : this->_constraint_map) {
+            for (auto &constraint : entry.second) { constraint.bind(table); }
+        }
+        for (auto &rule : this->_default_rules) { rule.bind(table); }
+        for (auto &constraint : this->_default_constraints) {
+            constraint.bind(table);
+        }
+    }
+
+
+    std::pair<bool, double> RuleSet::apply(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &queue
+    ) {
+
+        // Check constraints
+        ConstraintList &constraints = this->_get_bin_constraints(bin);
+        unsigned int num_constraints = constraints.size();
+        for (unsigned int i = 0; i < num_constraints; i++) {
+            if (!constraints[i].apply(table, queue)) {
+                LOG(this->_logger, Synopsis::LogType::DEBUG,  "Violated constraint index: %u", i);
+                return std::make_pair(false, 0.0);
+            }
+        }
+
+        // Apply rules
+        double utility = 0.0;
+        for (auto &rule : this->_get_bin_rules(bin)) {
+            double adj = rule.apply(table, queue);
+            utility += adj;
+        }
+
+        return std::make_pair(true, utility);
+    }
+
+
+    void RuleSet::init_aggregates(int bin, QueueAggregates &aggregates) {
+        aggregates.constraints.assign(
+            this->_get_bin_constraints(bin).size(), 0.0
+        );
+        aggregates.rules.assign(this->_get_bin_rules(bin).size(), 0.0);
+        aggregates.rule_applications.assign(
+            this->_get_bin_rules(bin).size(), 0
+        );
+
+        std::vector<int> slots;
+        for (auto &rule : this->_get_bin_rules(bin)) {
+            rule.add_index_slots(slots);
+        }
+        for (auto &constraint : this->_get_bin_constraints(bin)) {
+            constraint.add_index_slots(slots);
+        }
+        aggregates.index.set_slots(slots);
+    }
+
+
+    std::pair<bool, double> RuleSet::apply_candidate(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &queue,
+        const QueueAggregates &aggregates
+    ) {
+
+        // Check constraints
+        ConstraintList &constraints = this->_get_bin_constraints(bin);
+        unsigned int num_constraints = constraints.size();
+        for (unsigned int i = 0; i < num_constraints; i++) {
+            Constraint &constraint = constraints[i];
+            bool satisfied;
+            if (constraint.is_incremental()) {
+                satisfied = constraint.is_satisfied(
+                    aggregates.constraints[i] +
+                    constraint.contribution(
+                        table, queue.back(), queue, &aggregates.index
+                    )
+                );
+            } else {
+                satisfied = constraint.apply(table, queue, &aggregates.index);
+            }
+            if (!satisfied) {
+                LOG(this->_logger, Synopsis::LogType::DEBUG,  "Violated constraint index: %u", i);
+                return std::make_pair(false, 0.0);
+            }
+        }
+
+        // Apply rules
+        RuleList &rules = this->_get_bin_rules(bin);
+        unsigned int num_rules = rules.size();
+        double utility = 0.0;
+        for (unsigned int i = 0; i < num_rules; i++) {
+            double adj = aggregates.rules[i];
+            int n_applications = aggregates.rule_applications[i];
+            rules[i].extend(
+                table, queue, adj, n_applications, &aggregates.index
+            );
+            utility += adj;
+        }
+
+        return std::make_pair(true, utility);
+    }
+
+
+    void RuleSet::commit(
+        int bin,
+        AsdpTable &table,
+        const AsdpRowList &queue,
+        QueueAggregates &aggregates
+    ) {
+        ConstraintList &constraints = this->_get_bin_constraints(bin);
+        unsigned int num_constraints = constraints.size();
+        for (unsigned int i = 0; i < num_constraints; i++) {
+            if (constraints[i].is_incremental()) {
+                aggregates.constraints[i] += constraints[i].contribution(
+                    table, queue.back(), queue, &aggregates.index
+                );
+            }
+        }
+        RuleList &rules = this->_get_bin_rules(bin);
+        unsigned int num_rules = rules.size();
+        for (unsigned int i = 0; i < num_rules; i++) {
+            rules[i].extend(
+                table, queue, aggregates.rules[i],
+                aggregates.rule_applications[i], &aggregates.index
+            );
+        }
+
+        // The index covers the queue without the newest ASDP while the
+        // aggregates are updated
+        aggregates.index.add(table, queue.back());
+    }
+
+
     LogicalConstant::LogicalConstant(bool value) :
         _value(value)
     {
@@ -361,13 +986,29 @@ namespace Synopsis {
 
 
     bool LogicalConstant::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         return this->_value;
     }
 
 
+    bool LogicalConstant::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        return this->_value;
+    }
+
+
+    int LogicalConstant::compile(RuleProgram &program) {
+        int result = program.add_register();
+        program.emit(OP_LOAD_BOOL, result, -1, -1, this->_value ? 1 : 0);
+        return result;
+    }
+
+
     ConstExpression::ConstExpression(double value) :
         _value(DpMetadataValue(value))
     {
@@ -375,13 +1016,33 @@ namespace Synopsis {
     }
 
     DpMetadataValue ConstExpression::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         return this->_value;
     }
 
 
+    AsdpValue ConstExpression::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        AsdpValue value = {
+            FLOAT, true, 0, this->_value.get_float_value(), -1
+        };
+        return value;
+    }
+
+
+    int ConstExpression::compile(RuleProgram &program) {
+        int result = program.add_register();
+        program.emit(OP_LOAD_NUMBER, result, -1, -1, 0,
+            this->_value.get_float_value());
+        return result;
+    }
+
+
     LogicalNot::LogicalNot(BoolValueExpression *expr) :
         _expr(expr)
     {
@@ -390,13 +1051,36 @@ namespace Synopsis {
 
 
     bool LogicalNot::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         return !(this->_expr->get_value(assignments, asdps));
     }
 
 
+    void LogicalNot::bind(AsdpTable &table, std::vector<std::string> &scope) {
+        this->_expr->bind(table, scope);
+    }
+
+
+    bool LogicalNot::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        return !(this->_expr->evaluate(table, assignments, asdps));
+    }
+
+
+    int LogicalNot::compile(RuleProgram &program) {
+        int value = this->_expr->compile(program);
+        if (value < 0) { return -1; }
+        int result = program.add_register();
+        program.emit(OP_NOT, result, value);
+        return result;
+    }
+
+
     BinaryLogicalExpression::BinaryLogicalExpression(
         std::string op,
         BoolValueExpression *left_expr,
@@ -411,8 +1095,8 @@ namespace Synopsis {
 
 
     bool BinaryLogicalExpression::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         bool left_value = this->_left_expr->get_value(assignments, asdps);
         if (this->_op == "AND") {
@@ -443,6 +1127,69 @@ namespace Synopsis {
     }
 
 
+    void BinaryLogicalExpression::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_left_expr->bind(table, scope);
+        this->_right_expr->bind(table, scope);
+    }
+
+
+    bool BinaryLogicalExpression::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        bool left_value = this->_left_expr->evaluate(table, assignments, asdps);
+        if (this->_op == "AND") {
+            // Short circuit if left-hand expression evaluates to false
+            return left_value && this->_right_expr->evaluate(table, assignments, asdps);
+        } else if (this->_op == "OR") {
+            // Short circuit if left-hand expression evaluates to true
+            return left_value || this->_right_expr->evaluate(table, assignments, asdps);
+        } else {
+            LOG(this->_logger, Synopsis::LogType::ERROR,  "invalid operator %s in binary logical expression", this->_op.c_str());
+            return false;
+        }
+    }
+
+
+    int BinaryLogicalExpression::compile(RuleProgram &program) {
+        RuleOpcode op;
+        if (this->_op == "AND") {
+            op = OP_SKIP_IF_FALSE;
+        } else if (this->_op == "OR") {
+            op = OP_SKIP_IF_TRUE;
+        } else {
+            // Invalid operators are reported when evaluated as a tree
+            return -1;
+        }
+
+        int left_value = this->_left_expr->compile(program);
+        if (left_value < 0) { return -1; }
+        int result = program.add_register();
+
+        // Short circuit by skipping right-hand expression instructions
+        int skip = program.emit(op, result, left_value);
+        int right_value = this->_right_expr->compile(program);
+        if (right_value < 0) { return -1; }
+        program.emit(OP_MOVE, result, right_value);
+        program.patch_skip(skip);
+        return result;
+    }
+
+
+    void BinaryLogicalExpression::find_equalities(
+        int var_index, std::vector<FieldEquality> &equalities
+    ) {
+        // Both operands of a conjunction must hold
+        if (this->_op == "AND") {
+            this->_left_expr->find_equalities(var_index, equalities);
+            this->_right_expr->find_equalities(var_index, equalities);
+        }
+    }
+
+
     ComparatorExpression::ComparatorExpression(
         std::string comp,
         ValueExpression *left_expr,
@@ -457,8 +1204,8 @@ namespace Synopsis {
 
 
     bool ComparatorExpression::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         DpMetadataValue left_value = this->_left_expr->get_value(assignments, asdps);
         DpMetadataValue right_value = this->_right_expr->get_value(assignments, asdps);
@@ -505,6 +1252,105 @@ namespace Synopsis {
     }
 
 
+    void ComparatorExpression::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_left_expr->bind(table, scope);
+        this->_right_expr->bind(table, scope);
+    }
+
+
+    bool ComparatorExpression::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        AsdpValue left_value = this->_left_expr->evaluate(table, assignments, asdps);
+        AsdpValue right_value = this->_right_expr->evaluate(table, assignments, asdps);
+        if (left_value.is_numeric() ^ right_value.is_numeric()) {
+            if (left_value.is_numeric()){
+                LOG(this->_logger, Synopsis::LogType::ERROR, "type mismatch in ComparatorExpression::get_value, only left value is numeric");
+            }else{
+                LOG(this->_logger, Synopsis::LogType::ERROR,  "type mismatch in ComparatorExpression::get_value, only right value is numeric");
+            }
+            return false;
+        }
+        if (left_value.is_numeric()) {
+            double left_value_dbl = left_value.get_numeric();
+            double right_value_dbl = right_value.get_numeric();
+            if (this->_comp == "==") {
+                return (left_value_dbl == right_value_dbl);
+            } else if (this->_comp == "!=") {
+                return (left_value_dbl != right_value_dbl);
+            } else if (this->_comp == ">") {
+                return (left_value_dbl > right_value_dbl);
+            } else if (this->_comp == ">=") {
+                return (left_value_dbl >= right_value_dbl);
+            } else if (this->_comp == "<") {
+                return (left_value_dbl < right_value_dbl);
+            } else if (this->_comp == "<=") {
+                return (left_value_dbl <= right_value_dbl);
+            } else {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "unknown string comparison %s in ComparatorExpression::get_value", this->_comp.c_str());
+                return false;
+            }
+        } else {
+            // Interned strings are equal if and only if their IDs are equal
+            if (this->_comp == "==") {
+                return (left_value.string_id == right_value.string_id);
+            } else if (this->_comp == "!=") {
+                return (left_value.string_id != right_value.string_id);
+            } else {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "unknown string comparision %s in ComparatorExpression::get_value", this->_comp.c_str());
+                return false;
+            }
+        }
+    }
+
+
+    int ComparatorExpression::compile(RuleProgram &program) {
+        RuleOpcode op;
+        if (this->_comp == "==") {
+            op = OP_EQ;
+        } else if (this->_comp == "!=") {
+            op = OP_NE;
+        } else if (this->_comp == ">") {
+            op = OP_GT;
+        } else if (this->_comp == ">=") {
+            op = OP_GE;
+        } else if (this->_comp == "<") {
+            op = OP_LT;
+        } else if (this->_comp == "<=") {
+            op = OP_LE;
+        } else {
+            return -1;
+        }
+
+        int left_value = this->_left_expr->compile(program);
+        if (left_value < 0) { return -1; }
+        int right_value = this->_right_expr->compile(program);
+        if (right_value < 0) { return -1; }
+        int result = program.add_register();
+        program.emit(op, result, left_value, right_value);
+        return result;
+    }
+
+
+    void ComparatorExpression::find_equalities(
+        int var_index, std::vector<FieldEquality> &equalities
+    ) {
+        if (this->_comp != "==") { return; }
+        int slot = this->_left_expr->get_field_slot(var_index);
+        if (slot >= 0) {
+            equalities.push_back(std::make_pair(slot, this->_right_expr));
+        }
+        slot = this->_right_expr->get_field_slot(var_index);
+        if (slot >= 0) {
+            equalities.push_back(std::make_pair(slot, this->_left_expr));
+        }
+    }
+
+
     StringConstant::StringConstant(std::string value) :
         _value(DpMetadataValue(value))
     {
@@ -512,13 +1358,39 @@ namespace Synopsis {
     }
 
     DpMetadataValue StringConstant::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         return this->_value;
     }
 
 
+    void StringConstant::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_string_id = table.intern_string(
+            this->_value.get_string_value()
+        );
+    }
+
+
+    AsdpValue StringConstant::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        AsdpValue value = {STRING, true, 0, 0.0, this->_string_id};
+        return value;
+    }
+
+
+    int StringConstant::compile(RuleProgram &program) {
+        int result = program.add_register();
+        program.emit(OP_LOAD_STRING, result, -1, -1, this->_string_id);
+        return result;
+    }
+
+
     MinusExpression::MinusExpression(ValueExpression *expr) :
         _expr(expr)
     {
@@ -526,8 +1398,8 @@ namespace Synopsis {
     }
 
     DpMetadataValue MinusExpression::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         DpMetadataValue value = this->_expr->get_value(assignments, asdps);
         if (value.is_numeric()) {
@@ -539,6 +1411,38 @@ namespace Synopsis {
     }
 
 
+    void MinusExpression::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_expr->bind(table, scope);
+    }
+
+
+    AsdpValue MinusExpression::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        AsdpValue value = this->_expr->evaluate(table, assignments, asdps);
+        if (value.is_numeric()) {
+            AsdpValue result = {FLOAT, true, 0, -value.get_numeric(), -1};
+            return result;
+        } else {
+            LOG(this->_logger, Synopsis::LogType::WARN, "Not a number in MinusExpression::get_value");
+            return NAN_VALUE;
+        }
+    }
+
+
+    int MinusExpression::compile(RuleProgram &program) {
+        int value = this->_expr->compile(program);
+        if (value < 0) { return -1; }
+        int result = program.add_register();
+        program.emit(OP_NEG, result, value);
+        return result;
+    }
+
+
     BinaryExpression::BinaryExpression(
         std::string op,
         ValueExpression *left_expr,
@@ -553,8 +1457,8 @@ namespace Synopsis {
 
 
     DpMetadataValue BinaryExpression::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
         DpMetadataValue left_value = this->_left_expr->get_value(assignments, asdps);
         DpMetadataValue right_value = this->_right_expr->get_value(assignments, asdps);
@@ -584,6 +1488,68 @@ namespace Synopsis {
     }
 
 
+    void BinaryExpression::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_left_expr->bind(table, scope);
+        this->_right_expr->bind(table, scope);
+    }
+
+
+    AsdpValue BinaryExpression::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        AsdpValue left_value = this->_left_expr->evaluate(table, assignments, asdps);
+        AsdpValue right_value = this->_right_expr->evaluate(table, assignments, asdps);
+        if (left_value.is_numeric() && right_value.is_numeric()) {
+            double left_value_dbl = left_value.get_numeric();
+            double right_value_dbl = right_value.get_numeric();
+            AsdpValue result = NAN_VALUE;
+            if (this->_op == "*") {
+                result.float_value = left_value_dbl * right_value_dbl;
+            } else if (this->_op == "+") {
+                result.float_value = left_value_dbl + right_value_dbl;
+            } else if (this->_op == "-") {
+                result.float_value = left_value_dbl - right_value_dbl;
+            } else {
+                LOG(this->_logger, Synopsis::LogType::WARN, "Operator %s not supported in BinaryExpression::get_value", this->_op.c_str());
+            }
+            return result;
+        } else {
+            if (left_value.is_numeric()){
+                LOG(this->_logger, Synopsis::LogType::WARN, "Right value not numeric in BinaryExpression::get_value");
+            } else {
+                LOG(this->_logger, Synopsis::LogType::WARN,  "Left value not numeric in BinaryExpression::get_value");
+            }
+            return NAN_VALUE;
+        }
+    }
+
+
+    int BinaryExpression::compile(RuleProgram &program) {
+        RuleOpcode op;
+        if (this->_op == "*") {
+            op = OP_MUL;
+        } else if (this->_op == "+") {
+            op = OP_ADD;
+        } else if (this->_op == "-") {
+            op = OP_SUB;
+        } else {
+            return -1;
+        }
+
+        int left_value = this->_left_expr->compile(program);
+        if (left_value < 0) { return -1; }
+        int right_value = this->_right_expr->compile(program);
+        if (right_value < 0) { return -1; }
+        int result = program.add_register();
+        program.emit(op, result, left_value, right_value);
+        return result;
+    }
+
+
     Field::Field(
         std::string var_name,
         std::string field_name
@@ -596,24 +1562,77 @@ namespace Synopsis {
 
 
     DpMetadataValue Field::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
-        if (assignments.count(this->_var_name) > 0) {
-            auto fields = assignments[this->_var_name];
-            if (fields.count(this->_field_name) > 0) {
-                return fields[this->_field_name];
+        // Inner-most variable of a given name takes precedence
+        for (auto it = assignments.rbegin(); it != assignments.rend(); ++it) {
+            if (it->first != this->_var_name) { continue; }
+            auto field = it->second->find(this->_field_name);
+            if (field != it->second->end()) {
+                return field->second;
             } else {
                 // TODO: Field not found
                 return DpMetadataValue(
                     std::numeric_limits<double>::quiet_NaN()
                 );
             }
+        }
+
+        // TODO: Variable not found
+        return DpMetadataValue(std::numeric_limits<double>::quiet_NaN());
+    }
+
+
+    void Field::bind(AsdpTable &table, std::vector<std::string> &scope) {
+        // Inner-most variable of a given name takes precedence
+        this->_var_index = -1;
+        for (int i = scope.size() - 1; i >= 0; i--) {
+            if (scope[i] == this->_var_name) {
+                this->_var_index = i;
+                break;
+            }
+        }
+        this->_slot = table.find_field(this->_field_name);
+    }
+
+
+    AsdpValue Field::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        if ((this->_var_index < 0) || (this->_slot < 0) ||
+                (this->_var_index >= (int)assignments.size())) {
+            // Variable or field not found
+            return NAN_VALUE;
+        }
+        const AsdpValue &value = table.get_value(
+            assignments[this->_var_index], this->_slot
+        );
+        if (!value.present) {
+            return NAN_VALUE;
+        }
+        return value;
+    }
 
+
+    int Field::compile(RuleProgram &program) {
+        int result = program.add_register();
+        if ((this->_var_index < 0) || (this->_slot < 0)) {
+            // Variable or field not found
+            program.emit(OP_LOAD_NAN, result);
         } else {
-            // TODO: Variable not found
-            return DpMetadataValue(std::numeric_limits<double>::quiet_NaN());
+            program.use_variable(this->_var_index);
+            program.emit(OP_LOAD_FIELD, result, this->_var_index, -1, this->_slot);
         }
+        return result;
+    }
+
+
+    int Field::get_field_slot(int var_index) {
+        if (this->_var_index != var_index) { return -1; }
+        return this->_slot;
     }
 
 
@@ -629,14 +1648,16 @@ namespace Synopsis {
 
 
     bool ExistentialExpression::get_value(
-            AsdpAssignments assignments,
-            AsdpList asdps
+            const AsdpAssignments &assignments,
+            const AsdpList &asdps
         ) {
-        for (auto asdp : asdps) {
-
-            // Assign asdp to variable
-            AsdpAssignments new_assignments(assignments);
-            new_assignments[this->_var] = asdp;
+        // Assign each asdp to the inner-most variable
+        AsdpAssignments new_assignments(assignments);
+        new_assignments.push_back(
+            std::make_pair(this->_var, (const AsdpEntry*)nullptr)
+        );
+        for (auto &asdp : asdps) {
+            new_assignments.back().second = &asdp;
 
             // Evaluate expression and return if true
             bool evaluation = this->_expr->get_value(new_assignments, asdps);
@@ -647,6 +1668,74 @@ namespace Synopsis {
     }
 
 
+    void ExistentialExpression::bind(
+        AsdpTable &table, std::vector<std::string> &scope
+    ) {
+        this->_var_index = scope.size();
+        scope.push_back(this->_var);
+        this->_expr->bind(table, scope);
+        scope.pop_back();
+    }
+
+
+    int ExistentialExpression::compile(RuleProgram &program) {
+        // Choose an equality whose other side depends only on enclosing
+        // variables, preferring those that depend on some variable (e.g.,
+        // y.id == x.context_image_id) to constants, which are less selective
+        std::vector<FieldEquality> equalities;
+        this->_expr->find_equalities(this->_var_index, equalities);
+        int key_slot = -1;
+        ValueExpression *key_expr = nullptr;
+        bool key_uses_variable = false;
+        for (auto &equality : equalities) {
+            RuleProgram key_program;
+            if (equality.second->compile(key_program) < 0) { continue; }
+            if (key_program.num_variables() > this->_var_index) { continue; }
+            bool uses_variable = (key_program.num_variables() > 0);
+            if ((key_expr == nullptr) || (uses_variable && !key_uses_variable)) {
+                key_slot = equality.first;
+                key_expr = equality.second;
+                key_uses_variable = uses_variable;
+            }
+        }
+        int key = -1;
+        if (key_expr != nullptr) {
+            key = key_expr->compile(program);
+        }
+
+        int result = program.add_register();
+        program.use_variable(this->_var_index);
+        int exists = program.emit(OP_EXISTS, result, this->_var_index);
+        if (key >= 0) {
+            program.set_index_key(exists, key, key_slot);
+        }
+        int body_result = this->_expr->compile(program);
+        if (body_result < 0) { return -1; }
+        program.patch_skip(exists, body_result);
+        return result;
+    }
+
+
+    bool ExistentialExpression::evaluate(
+            AsdpTable &table,
+            const AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps
+        ) {
+        // Assign each asdp to the inner-most variable
+        AsdpRowAssignments new_assignments(assignments);
+        new_assignments.push_back(-1);
+        for (int row : asdps) {
+            new_assignments.back() = row;
+
+            // Evaluate expression and return if true
+            if (this->_expr->evaluate(table, new_assignments, asdps)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
     Status _get_argument_obj(
         nlohmann::json *result, nlohmann::json &j_obj, std::string arg, Logger *logger
     ) {
@@ -0,0 +1,399 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see RuleProgram.hpp
+ */
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "RuleProgram.hpp"
+
+
+namespace Synopsis {
+
+
+    /**
+     * Value of missing fields and failed numeric evaluations
+     */
+    static const AsdpValue NAN_VALUE = {
+        FLOAT, true, 0, std::numeric_limits<double>::quiet_NaN(), -1
+    };
+
+
+    /**
+     * Boolean register values
+     */
+    static const AsdpValue TRUE_VALUE = {INT, true, 1, 0.0, -1};
+    static const AsdpValue FALSE_VALUE = {INT, true, 0, 0.0, -1};
+
+
+    /**
+     * @return: register value for a Boolean
+     */
+    static inline const AsdpValue &_bool_value(bool value) {
+        return value ? TRUE_VALUE : FALSE_VALUE;
+    }
+
+
+    /**
+     * @return: comparator of a comparison operation
+     */
+    static const char *_comparator(RuleOpcode op) {
+        switch (op) {
+            case OP_EQ: return "==";
+            case OP_NE: return "!=";
+            case OP_GT: return ">";
+            case OP_GE: return ">=";
+            case OP_LT: return "<";
+            default: return "<=";
+        }
+    }
+
+
+    void QueueIndex::set_slots(const std::vector<int> &slots) {
+        this->_slots = slots;
+        std::sort(this->_slots.begin(), this->_slots.end());
+        this->_slots.erase(
+            std::unique(this->_slots.begin(), this->_slots.end()),
+            this->_slots.end()
+        );
+        this->_indexes.assign(this->_slots.size(), {});
+        this->_size = 0;
+    }
+
+
+    void QueueIndex::clear(void) {
+        for (auto &index : this->_indexes) {
+            index.clear();
+        }
+        this->_size = 0;
+    }
+
+
+    void QueueIndex::add(const AsdpTable &table, int row) {
+        int n_slots = this->_slots.size();
+        for (int i = 0; i < n_slots; i++) {
+            const AsdpValue &value = table.get_value(row, this->_slots[i]);
+            Key key;
+            if (value.present && _make_key(value, key)) {
+                this->_indexes[i][key].push_back(row);
+            }
+        }
+        this->_size++;
+    }
+
+
+    const AsdpRowList *QueueIndex::find(int slot, const AsdpValue &value) const {
+        int i = this->_find_slot(slot);
+        Key key;
+        if ((i < 0) || !_make_key(value, key)) { return nullptr; }
+        auto found = this->_indexes[i].find(key);
+        if (found == this->_indexes[i].end()) { return nullptr; }
+        return &found->second;
+    }
+
+
+    size_t QueueIndex::KeyHash::operator()(const Key &key) const {
+        return std::hash<double>()(key.value) ^ (size_t)key.is_string;
+    }
+
+
+    bool QueueIndex::_make_key(const AsdpValue &value, Key &key) {
+        key.is_string = !value.is_numeric();
+        if (key.is_string) {
+            key.value = value.string_id;
+            return true;
+        }
+        key.value = value.get_numeric();
+        if (std::isnan(key.value)) { return false; }
+        // Negative zero compares equal to zero
+        if (key.value == 0.0) { key.value = 0.0; }
+        return true;
+    }
+
+
+    int QueueIndex::_find_slot(int slot) const {
+        auto found = std::lower_bound(
+            this->_slots.begin(), this->_slots.end(), slot
+        );
+        if ((found == this->_slots.end()) || (*found != slot)) {
+            return -1;
+        }
+        return found - this->_slots.begin();
+    }
+
+
+    RuleProgram::RuleProgram() :
+        _result(-1),
+        _n_registers(0),
+        _n_variables(0)
+    {
+
+    }
+
+
+    void RuleProgram::clear(void) {
+        this->_code.clear();
+        this->_result = -1;
+        this->_n_registers = 0;
+        this->_n_variables = 0;
+        this->_index_slots.clear();
+    }
+
+
+    int RuleProgram::add_register(void) {
+        return this->_n_registers++;
+    }
+
+
+    void RuleProgram::use_variable(int var_index) {
+        if (var_index >= this->_n_variables) {
+            this->_n_variables = var_index + 1;
+        }
+    }
+
+
+    int RuleProgram::emit(RuleOpcode op, int dst, int a, int b,
+            int arg, double number) {
+        RuleInstruction instruction = {op, dst, a, b, arg, number, -1, -1};
+        this->_code.push_back(instruction);
+        return this->_code.size() - 1;
+    }
+
+
+    void RuleProgram::patch_skip(int index, int body_result) {
+        this->_code[index].arg = this->_code.size() - index - 1;
+        if (this->_code[index].op == OP_EXISTS) {
+            this->_code[index].b = body_result;
+        }
+    }
+
+
+    void RuleProgram::set_index_key(int index, int key, int slot) {
+        this->_code[index].key = key;
+        this->_code[index].key_slot = slot;
+        if (std::find(this->_index_slots.begin(), this->_index_slots.end(),
+                slot) == this->_index_slots.end()) {
+            this->_index_slots.push_back(slot);
+        }
+    }
+
+
+    void RuleProgram::set_result(int result) {
+        this->_result = result;
+        if (result < 0) {
+            // Partially compiled programs are discarded
+            this->_code.clear();
+            this->_index_slots.clear();
+        }
+    }
+
+
+    bool RuleProgram::uses_queue(void) const {
+        for (auto &instruction : this->_code) {
+            if (instruction.op == OP_EXISTS) { return true; }
+        }
+        return false;
+    }
+
+
+    const AsdpValue &RuleProgram::evaluate(
+            const AsdpTable &table,
+            AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps,
+            std::vector<AsdpValue> &registers,
+            const QueueIndex *index
+        ) const {
+        this->_run(
+            0, this->_code.size(), table, assignments, asdps, registers, index
+        );
+        return registers[this->_result];
+    }
+
+
+    void RuleProgram::_run(
+            int begin, int end,
+            const AsdpTable &table,
+            AsdpRowAssignments &assignments,
+            const AsdpRowList &asdps,
+            std::vector<AsdpValue> &registers,
+            const QueueIndex *index
+        ) const {
+        for (int pc = begin; pc < end; pc++) {
+            const RuleInstruction &ins = this->_code[pc];
+            AsdpValue &dst = registers[ins.dst];
+            switch (ins.op) {
+
+                case OP_LOAD_BOOL:
+                    dst = _bool_value(ins.arg != 0);
+                    break;
+
+                case OP_LOAD_NUMBER:
+                    dst = NAN_VALUE;
+                    dst.float_value = ins.number;
+                    break;
+
+                case OP_LOAD_STRING:
+                    dst = {STRING, true, 0, 0.0, ins.arg};
+                    break;
+
+                case OP_LOAD_NAN:
+                    dst = NAN_VALUE;
+                    break;
+
+                case OP_LOAD_FIELD: {
+                    const AsdpValue &value = table.get_value(
+                        assignments[ins.a], ins.arg
+                    );
+                    dst = value.present ? value : NAN_VALUE;
+                    break;
+                }
+
+                case OP_NEG: {
+                    const AsdpValue &value = registers[ins.a];
+                    if (value.is_numeric()) {
+                        double negated = -value.get_numeric();
+                        dst = NAN_VALUE;
+                        dst.float_value = negated;
+                    } else {
+                        LOG(this->_logger, Synopsis::LogType::WARN, "Not a number in MinusExpression::get_value");
+                        dst = NAN_VALUE;
+                    }
+                    break;
+                }
+
+                case OP_ADD:
+                case OP_SUB:
+                case OP_MUL: {
+                    const AsdpValue &left = registers[ins.a];
+                    const AsdpValue &right = registers[ins.b];
+                    if (left.is_numeric() && right.is_numeric()) {
+                        double l = left.get_numeric();
+                        double r = right.get_numeric();
+                        dst = NAN_VALUE;
+                        dst.float_value = (
+                            (ins.op == OP_ADD) ? (l + r) :
+                            (ins.op == OP_SUB) ? (l - r) : (l * r)
+                        );
+                    } else {
+                        if (left.is_numeric()) {
+                            LOG(this->_logger, Synopsis::LogType::WARN, "Right value not numeric in BinaryExpression::get_value");
+                        } else {
+                            LOG(this->_logger, Synopsis::LogType::WARN,  "Left value not numeric in BinaryExpression::get_value");
+                        }
+                        dst = NAN_VALUE;
+                    }
+                    break;
+                }
+
+                case OP_EQ:
+                case OP_NE:
+                case OP_GT:
+                case OP_GE:
+                case OP_LT:
+                case OP_LE: {
+                    const AsdpValue &left = registers[ins.a];
+                    const AsdpValue &right = registers[ins.b];
+                    bool result = false;
+                    if (left.is_numeric() ^ right.is_numeric()) {
+                        if (left.is_numeric()) {
+                            LOG(this->_logger, Synopsis::LogType::ERROR, "type mismatch in ComparatorExpression::get_value, only left value is numeric");
+                        } else {
+                            LOG(this->_logger, Synopsis::LogType::ERROR,  "type mismatch in ComparatorExpression::get_value, only right value is numeric");
+                        }
+                    } else if (left.is_numeric()) {
+                        double l = left.get_numeric();
+                        double r = right.get_numeric();
+                        switch (ins.op) {
+                            case OP_EQ: result = (l == r); break;
+                            case OP_NE: result = (l != r); break;
+                            case OP_GT: result = (l > r); break;
+                            case OP_GE: result = (l >= r); break;
+                            case OP_LT: result = (l < r); break;
+                            default: result = (l <= r); break;
+                        }
+                    } else if (ins.op == OP_EQ) {
+                        // Interned strings are equal if and only if their IDs
+                        // are equal
+                        result = (left.string_id == right.string_id);
+                    } else if (ins.op == OP_NE) {
+                        result = (left.string_id != right.string_id);
+                    } else {
+                        LOG(this->_logger, Synopsis::LogType::ERROR, "unknown string comparision %s in ComparatorExpression::get_value", _comparator(ins.op));
+                    }
+                    dst = _bool_value(result);
+                    break;
+                }
+
+                case OP_NOT:
+                    dst = _bool_value(registers[ins.a].int_value == 0);
+                    break;
+
+                case OP_MOVE:
+                    dst = registers[ins.a];
+                    break;
+
+                case OP_SKIP_IF_FALSE:
+                    if (registers[ins.a].int_value == 0) {
+                        dst = FALSE_VALUE;
+                        pc += ins.arg;
+                    }
+                    break;
+
+                case OP_SKIP_IF_TRUE:
+                    if (registers[ins.a].int_value != 0) {
+                        dst = TRUE_VALUE;
+                        pc += ins.arg;
+                    }
+                    break;
+
+                case OP_EXISTS: {
+                    // Assign each ASDP to the quantified variable, evaluating
+                    // the body until it is true
+                    int body_end = pc + 1 + ins.arg;
+                    bool found = false;
+
+                    // The body requires the key field to equal the key, so
+                    // only the matching indexed ASDPs and the unindexed
+                    // remainder of the queue need to be assigned
+                    int n_asdps = asdps.size();
+                    int scan_begin = 0;
+                    if ((ins.key >= 0) && (index != nullptr) &&
+                            (index->size() <= n_asdps) &&
+                            index->has_slot(ins.key_slot)) {
+                        scan_begin = index->size();
+                        const AsdpRowList *matches = index->find(
+                            ins.key_slot, registers[ins.key]
+                        );
+                        if (matches != nullptr) {
+                            for (int row : *matches) {
+                                assignments[ins.a] = row;
+                                this->_run(pc + 1, body_end, table, assignments, asdps, registers, index);
+                                if (registers[ins.b].int_value != 0) {
+                                    found = true;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    for (int i = scan_begin; !found && (i < n_asdps); i++) {
+                        assignments[ins.a] = asdps[i];
+                        this->_run(pc + 1, body_end, table, assignments, asdps, registers, index);
+                        if (registers[ins.b].int_value != 0) {
+                            found = true;
+                        }
+                    }
+                    dst = _bool_value(found);
+                    pc = body_end - 1;
+                    break;
+                }
+
+            }
+        }
+    }
+
+
+};
@@ -5,6 +5,8 @@
  * @see: Similarity.hpp
  */
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include <nlohmann/json.hpp>
 #include <fstream>
 
@@ -24,8 +26,26 @@ namespace Synopsis {
     SimFuncMap _parse_function_list(nlohmann::json flist, Logger *logger);
 
 
+    /**
+     * Utility to look up a field of an ASDP entry without modifying it.
+     *
+     * @param[in] asdp: ASDP entry
+     * @param[in] key: field name
+     *
+     * @return: field value, or a default metadata value if the field is
+     * missing
+     */
+    DpMetadataValue _get_field(const AsdpEntry &asdp, const std::string &key) {
+        auto found = asdp.find(key);
+        if (found != asdp.end()) {
+            return found->second;
+        }
+        return DpMetadataValue();
+    }
+
+
     double _sq_euclidean_dist(
-        std::vector<double> dd1, std::vector<double> dd2
+        const std::vector<double> &dd1, const std::vector<double> &dd2
     ) {
         double acc = 0.0;
         int n1 = dd1.size();
@@ -43,13 +63,18 @@ namespace Synopsis {
 
     double _gaussian_similarity(
         double sigma,
-        std::vector<double> dd1, std::vector<double> dd2
+        const std::vector<double> &dd1, const std::vector<double> &dd2
     ) {
         double dist_sq = _sq_euclidean_dist(dd1, dd2);
         return exp(-(dist_sq / (sigma * sigma)));
     }
 
 
+    double _discount_factor(double alpha, double max_similarity) {
+        return (1.0 - alpha) + (alpha * (1.0 - max_similarity));
+    }
+
+
     SimilarityFunction::SimilarityFunction(
         std::vector<std::string> diversity_descriptors,
         std::vector<double> dd_factors,
@@ -63,12 +88,49 @@ namespace Synopsis {
         _similarity_params(similarity_params),
         _logger(logger)
     {
+        // Resolve the kernel and its parameters once, rather than on every
+        // similarity computation
+        this->_kernel = find_kernel(this->_similarity_type);
+        this->_kernel_function = specialize_kernel(
+            this->_kernel, this->_diversity_descriptors.size()
+        );
 
+        switch (this->_kernel) {
+            case GAUSSIAN_KERNEL:
+            case LAPLACIAN_KERNEL:
+                if (this->_similarity_params.count("sigma")) {
+                    this->_sigma = this->_similarity_params["sigma"];
+                } else {
+                    LOG(this->_logger, Synopsis::LogType::WARN, "Missing parameter sigma for %s similarity", this->_similarity_type.c_str());
+                }
+                break;
+
+            case MAHALANOBIS_DIAGONAL_KERNEL:
+                for (auto &dd : this->_diversity_descriptors) {
+                    double variance = 1.0;
+                    auto found = this->_similarity_params.find(dd);
+                    if ((found != this->_similarity_params.end()) &&
+                            (found->second > 0.0)) {
+                        variance = found->second;
+                    } else {
+                        LOG(this->_logger, Synopsis::LogType::WARN, "Missing or non-positive variance for %s; using 1.0", dd.c_str());
+                    }
+                    this->_inv_variances.push_back(1.0 / variance);
+                }
+                break;
+
+            case COSINE_KERNEL:
+                break;
+
+            default:
+                LOG(this->_logger, Synopsis::LogType::WARN, "Unknown similarity type %s", this->_similarity_type.c_str());
+                break;
+        }
     }
 
     std::vector<double> SimilarityFunction::_extract_dd(
-        AsdpEntry asdp
-    ) {
+        const AsdpEntry &asdp
+    ) const {
         std::vector<double> dd;
         int n_dd = this->_diversity_descriptors.size();
 
@@ -76,7 +138,7 @@ namespace Synopsis {
             std::string key = this->_diversity_descriptors[i];
 
             // TODO: handle missing key
-            double dd_i = asdp[key].get_float_value();
+            double dd_i = _get_field(asdp, key).get_float_value();
 
             // Multiply by factor (if provided)
             if (i < this->_dd_factors.size()) {
@@ -92,28 +154,332 @@ namespace Synopsis {
 
 
     double SimilarityFunction::get_similarity(
-        AsdpEntry asdp1,
-        AsdpEntry asdp2
+        const AsdpEntry &asdp1,
+        const AsdpEntry &asdp2
     ) {
-
-        double similarity = 0.0;
         auto dd1 = this->_extract_dd(asdp1);
         auto dd2 = this->_extract_dd(asdp2);
+        return this->_kernel_function(
+            dd1.data(), dd2.data(), dd1.size(), this->_kernel_params()
+        );
+    }
 
-        if (this->_similarity_type == "gaussian") {
-            double sigma = 1.0;
-            if (this->_similarity_params.count("sigma")) {
-                sigma = this->_similarity_params["sigma"];
-            } else {
-                LOG(this->_logger, Synopsis::LogType::WARN, "Missing parameter in get_similarity");
+
+    void SimilarityFunction::set_max_similarity_search(
+        MaxSimilaritySearch search, double epsilon
+    ) {
+        if ((search != LINEAR_SEARCH) && (this->_kernel != GAUSSIAN_KERNEL)) {
+            LOG(this->_logger, Synopsis::LogType::WARN, "Index search requires gaussian similarity; using linear search");
+            search = LINEAR_SEARCH;
+        }
+        if (epsilon < 0.0) {
+            LOG(this->_logger, Synopsis::LogType::WARN, "Negative index search epsilon; using exact search");
+            epsilon = 0.0;
+        }
+        this->_search = search;
+        this->_search_epsilon = epsilon;
+    }
+
+
+    double SimilarityFunction::similarity_from_sq_dist(double sq_dist) const {
+        if (this->_kernel != GAUSSIAN_KERNEL) {
+            return 0.0;
+        }
+        return kernel_transform<GAUSSIAN_KERNEL>(
+            sq_dist, 0.0, this->_kernel_params()
+        );
+    }
+
+
+    void SimilarityFunction::bind(const AsdpTable &table) {
+        this->_dd_slots.clear();
+        for (auto &dd : this->_diversity_descriptors) {
+            this->_dd_slots.push_back(table.find_field(dd));
+        }
+    }
+
+
+    /**
+     * Number of diversity descriptor elements of a pair of ASDPs that are
+     * gathered on the stack; longer descriptors are gathered on the heap
+     */
+    static const int STACK_DESCRIPTOR_SIZE = 32;
+
+
+    double SimilarityFunction::get_similarity(
+        const AsdpTable &table, int row1, int row2
+    ) {
+        if (this->_kernel == UNKNOWN_KERNEL) {
+            return 0.0;
+        }
+
+        int n_dd = this->_dd_slots.size();
+        double stack[2 * STACK_DESCRIPTOR_SIZE];
+        std::vector<double> heap;
+        double *dd1 = stack;
+        if (n_dd > STACK_DESCRIPTOR_SIZE) {
+            heap.resize(2 * n_dd);
+            dd1 = heap.data();
+        }
+        double *dd2 = dd1 + n_dd;
+
+        // Missing fields take the default metadata value of 0.0, matching
+        // SimilarityFunction::_extract_dd
+        int n_factors = this->_dd_factors.size();
+        for (int i = 0; i < n_dd; i++) {
+            int slot = this->_dd_slots[i];
+            dd1[i] = 0.0;
+            dd2[i] = 0.0;
+            if (slot >= 0) {
+                const AsdpValue &v1 = table.get_value(row1, slot);
+                const AsdpValue &v2 = table.get_value(row2, slot);
+                if (v1.present) { dd1[i] = v1.float_value; }
+                if (v2.present) { dd2[i] = v2.float_value; }
+            }
+            if (i < n_factors) {
+                dd1[i] *= this->_dd_factors[i];
+                dd2[i] *= this->_dd_factors[i];
             }
-            similarity = _gaussian_similarity(sigma, dd1, dd2);
-        } else {
-            LOG(this->_logger, Synopsis::LogType::WARN, "Unknown similarity type in get_similarity");
         }
 
-        // TODO: Implement
-        return similarity;
+        return this->_kernel_function(dd1, dd2, n_dd, this->_kernel_params());
+    }
+
+
+    void SimilarityFunction::get_similarity_block(
+        const AsdpTable &table,
+        const std::vector<int> &rows,
+        double *descriptors,
+        double *block
+    ) {
+        this->accumulate_block(table, rows, descriptors, block);
+        this->transform_block(rows.size(), block);
+    }
+
+
+    void SimilarityFunction::accumulate_block(
+        const AsdpTable &table,
+        const std::vector<int> &rows,
+        double *descriptors,
+        double *block
+    ) {
+        int n = rows.size();
+        if (this->_kernel == UNKNOWN_KERNEL) {
+            return;
+        }
+
+        // Extract weighted descriptors into descriptor-major order; missing
+        // fields take the default metadata value of 0.0
+        int n_dd = this->_dd_slots.size();
+        int n_factors = this->_dd_factors.size();
+        for (int d = 0; d < n_dd; d++) {
+            int slot = this->_dd_slots[d];
+            double *column = descriptors + (d * n);
+            for (int i = 0; i < n; i++) {
+                double dd_i = 0.0;
+                if (slot >= 0) {
+                    const AsdpValue &value = table.get_value(rows[i], slot);
+                    if (value.present) { dd_i = value.float_value; }
+                }
+                if (d < n_factors) {
+                    dd_i *= this->_dd_factors[d];
+                }
+                column[i] = dd_i;
+            }
+        }
+
+        KernelParams params = this->_kernel_params();
+        switch (this->_kernel) {
+            case GAUSSIAN_KERNEL:
+                kernel_accumulate_block<GAUSSIAN_KERNEL>(
+                    descriptors, n, n_dd, params, block
+                );
+                break;
+            case COSINE_KERNEL:
+                kernel_accumulate_block<COSINE_KERNEL>(
+                    descriptors, n, n_dd, params, block
+                );
+                break;
+            case LAPLACIAN_KERNEL:
+                kernel_accumulate_block<LAPLACIAN_KERNEL>(
+                    descriptors, n, n_dd, params, block
+                );
+                break;
+            case MAHALANOBIS_DIAGONAL_KERNEL:
+                kernel_accumulate_block<MAHALANOBIS_DIAGONAL_KERNEL>(
+                    descriptors, n, n_dd, params, block
+                );
+                break;
+            default:
+                break;
+        }
+    }
+
+
+    void SimilarityFunction::transform_block(int n, double *block) {
+        KernelParams params = this->_kernel_params();
+        switch (this->_kernel) {
+            case GAUSSIAN_KERNEL:
+                kernel_transform_block<GAUSSIAN_KERNEL>(n, params, block);
+                break;
+            case COSINE_KERNEL:
+                kernel_transform_block<COSINE_KERNEL>(n, params, block);
+                break;
+            case LAPLACIAN_KERNEL:
+                kernel_transform_block<LAPLACIAN_KERNEL>(n, params, block);
+                break;
+            case MAHALANOBIS_DIAGONAL_KERNEL:
+                kernel_transform_block<MAHALANOBIS_DIAGONAL_KERNEL>(
+                    n, params, block
+                );
+                break;
+            default:
+                std::fill(block, block + (n * n), 0.0);
+                break;
+        }
+    }
+
+
+    void SimilarityFunction::set_sigma(double sigma) {
+        if ((this->_kernel != GAUSSIAN_KERNEL) &&
+                (this->_kernel != LAPLACIAN_KERNEL)) {
+            return;
+        }
+        this->_similarity_params["sigma"] = sigma;
+        this->_sigma = sigma;
+    }
+
+
+    KdTree::KdTree(int n_dims) : _n_dims(n_dims) {
+
+    }
+
+
+    void KdTree::insert(const std::vector<double> &point) {
+        int node = this->_nodes.size();
+        Node leaf = {-1, -1};
+        this->_nodes.push_back(leaf);
+        this->_points.insert(
+            this->_points.end(), point.begin(), point.begin() + this->_n_dims
+        );
+        if ((node == 0) || (this->_n_dims == 0)) { return; }
+
+        // Descend from the root to the empty child where the point belongs
+        int parent = 0;
+        int depth = 0;
+        while (true) {
+            int dim = depth % this->_n_dims;
+            double split = this->_points[(parent * this->_n_dims) + dim];
+            int &child = (point[dim] < split) ?
+                this->_nodes[parent].left : this->_nodes[parent].right;
+            if (child < 0) {
+                child = node;
+                return;
+            }
+            parent = child;
+            depth++;
+        }
+    }
+
+
+    double KdTree::nearest_sq_dist(
+        const std::vector<double> &query, double epsilon
+    ) const {
+        double best = std::numeric_limits<double>::infinity();
+        if (this->_nodes.empty()) { return best; }
+
+        // Without dimensions, every point coincides with the query
+        if (this->_n_dims == 0) { return 0.0; }
+
+        double shrink = (1.0 + epsilon) * (1.0 + epsilon);
+        this->_search(0, 0, query, shrink, best);
+        return best;
+    }
+
+
+    void KdTree::_search(
+        int node, int depth, const std::vector<double> &query,
+        double shrink, double &best
+    ) const {
+        // Distances sum descriptor elements in the same order as
+        // _sq_euclidean_dist, so exact searches give identical values
+        const double *point = &this->_points[node * this->_n_dims];
+        double sq_dist = 0.0;
+        for (int d = 0; d < this->_n_dims; d++) {
+            double diff = query[d] - point[d];
+            sq_dist += (diff * diff);
+        }
+        if (sq_dist < best) { best = sq_dist; }
+
+        int dim = depth % this->_n_dims;
+        double offset = query[dim] - point[dim];
+        int near = (offset < 0.0) ?
+            this->_nodes[node].left : this->_nodes[node].right;
+        int far = (offset < 0.0) ?
+            this->_nodes[node].right : this->_nodes[node].left;
+        if (near >= 0) {
+            this->_search(near, depth + 1, query, shrink, best);
+        }
+
+        // Points beyond the splitting plane are at least `offset` away
+        if ((far >= 0) && ((offset * offset) < (best / shrink))) {
+            this->_search(far, depth + 1, query, shrink, best);
+        }
+    }
+
+
+    MaxSimilarityIndex::MaxSimilarityIndex(SimFuncMap &functions) {
+        for (auto &entry : functions) {
+            const SimilarityFunction &function = entry.second;
+            if (!function.is_indexed()) { continue; }
+            KeyIndex index = {&function, KdTree(function.num_descriptors())};
+            this->_trees.insert(std::make_pair(entry.first, index));
+        }
+    }
+
+
+    const MaxSimilarityIndex::KeyIndex *MaxSimilarityIndex::_find(
+        const AsdpEntry &asdp
+    ) const {
+        if (this->_trees.empty()) { return nullptr; }
+        auto found = this->_trees.find(std::make_pair(
+            _get_field(asdp, "instrument_name").get_string_value(),
+            _get_field(asdp, "type").get_string_value()
+        ));
+        if (found == this->_trees.end()) { return nullptr; }
+        return &(found->second);
+    }
+
+
+    bool MaxSimilarityIndex::is_indexed(const AsdpEntry &asdp) const {
+        return this->_find(asdp) != nullptr;
+    }
+
+
+    void MaxSimilarityIndex::add(const AsdpEntry &asdp) {
+        if (this->_trees.empty()) { return; }
+        auto found = this->_trees.find(std::make_pair(
+            _get_field(asdp, "instrument_name").get_string_value(),
+            _get_field(asdp, "type").get_string_value()
+        ));
+        if (found == this->_trees.end()) { return; }
+        KeyIndex &index = found->second;
+        index.tree.insert(index.function->_extract_dd(asdp));
+    }
+
+
+    double MaxSimilarityIndex::get_max_similarity(
+        const AsdpEntry &asdp
+    ) const {
+        const KeyIndex *index = this->_find(asdp);
+        if ((index == nullptr) || (index->tree.size() == 0)) {
+            return 0.0;
+        }
+        double sq_dist = index->tree.nearest_sq_dist(
+            index->function->_extract_dd(asdp),
+            index->function->search_epsilon()
+        );
+        return index->function->similarity_from_sq_dist(sq_dist);
     }
 
 
@@ -136,14 +502,14 @@ namespace Synopsis {
 
     double Similarity::_get_cached_similarity(
         SimilarityFunction &similarity_function,
-        AsdpEntry asdp1,
-        AsdpEntry asdp2
+        const AsdpEntry &asdp1,
+        const AsdpEntry &asdp2
     ) {
 
         // Make cache key
         std::pair<int, int> cache_key;
-        int aid1 = asdp1["id"].get_int_value();
-        int aid2 = asdp2["id"].get_int_value();
+        int aid1 = _get_field(asdp1, "id").get_int_value();
+        int aid2 = _get_field(asdp2, "id").get_int_value();
 
         // Smaller ASDP ID is first element
         if (aid1 < aid2) {
@@ -153,12 +519,21 @@ namespace Synopsis {
         }
 
         // Compute similarity if not in cache
+        if (this->_shared_cache != nullptr) {
+            auto shared = this->_shared_cache->find(cache_key);
+            if (shared != this->_shared_cache->end()) {
+                this->_n_cache_hits++;
+                return shared->second;
+            }
+        }
         double similarity;
         if (!this->_cache.count(cache_key)) {
             similarity = similarity_function.get_similarity(asdp1, asdp2);
             this->_cache[cache_key] = similarity;
+            this->_n_cache_misses++;
         } else {
             similarity = this->_cache[cache_key];
+            this->_n_cache_hits++;
         }
 
         return similarity;
@@ -167,8 +542,8 @@ namespace Synopsis {
 
     double Similarity::get_max_similarity(
         int bin,
-        AsdpList queue,
-        AsdpEntry asdp
+        const AsdpList &queue,
+        const AsdpEntry &asdp
     ) {
 
         if (queue.size() == 0) {
@@ -177,16 +552,11 @@ namespace Synopsis {
         }
 
         auto inst_type = std::make_pair(
-            asdp["instrument_name"].get_string_value(),
-            asdp["type"].get_string_value()
+            _get_field(asdp, "instrument_name").get_string_value(),
+            _get_field(asdp, "type").get_string_value()
         );
 
-        SimFuncMap sf;
-        if (this->_functions.count(bin)) {
-            sf = this->_functions[bin];
-        } else {
-            sf = this->_default_functions;
-        }
+        SimFuncMap &sf = this->_get_functions(bin);
 
         // Get similarity function
         if (!sf.count(inst_type)) {
@@ -196,14 +566,14 @@ namespace Synopsis {
         SimilarityFunction &sim = sf.at(inst_type);
 
         // Compute max similarity
-        int aid1 = asdp["id"].get_int_value();
+        int aid1 = _get_field(asdp, "id").get_int_value();
         double max_similarity = 0.0;
         for (auto &asdp2 : queue) {
 
             // Check for type match
             auto inst_type2 = std::make_pair(
-                asdp2["instrument_name"].get_string_value(),
-                asdp2["type"].get_string_value()
+                _get_field(asdp2, "instrument_name").get_string_value(),
+                _get_field(asdp2, "type").get_string_value()
             );
             if (inst_type != inst_type2) {
                 continue;
@@ -225,16 +595,178 @@ namespace Synopsis {
 
     double Similarity::get_discount_factor(
         int bin,
-        AsdpList queue,
-        AsdpEntry asdp
+        const AsdpList &queue,
+        const AsdpEntry &asdp
     ) {
         double max_similarity = this->get_max_similarity(bin, queue, asdp);
+        return this->get_discount_factor(bin, max_similarity);
+    }
+
+
+    double Similarity::get_discount_factor(int bin, double max_similarity) {
+        return _discount_factor(this->get_alpha(bin), max_similarity);
+    }
+
+
+    double Similarity::get_similarity(
+        int bin,
+        const AsdpEntry &asdp1,
+        const AsdpEntry &asdp2
+    ) {
+        auto inst_type = std::make_pair(
+            _get_field(asdp1, "instrument_name").get_string_value(),
+            _get_field(asdp1, "type").get_string_value()
+        );
+        auto inst_type2 = std::make_pair(
+            _get_field(asdp2, "instrument_name").get_string_value(),
+            _get_field(asdp2, "type").get_string_value()
+        );
+        if (inst_type != inst_type2) {
+            return 0.0;
+        }
+
+        SimFuncMap &sf = this->_get_functions(bin);
+        if (!sf.count(inst_type)) {
+            // No similarity function specified for this ASDP
+            return 0.0;
+        }
+
+        return this->_get_cached_similarity(sf.at(inst_type), asdp1, asdp2);
+    }
+
+
+    double Similarity::get_alpha(int bin) {
         double alpha = this->_default_alpha;
-        if (this->_alpha.count(bin)) {
+        auto found = this->_alpha.find(bin);
+        if (found != this->_alpha.end()) {
             // If alpha specified, overwrite default 1.0 value
-            alpha = this->_alpha[bin];
+            alpha = found->second;
         }
-        return (1.0 - alpha) + (alpha * (1.0 - max_similarity));
+        return alpha;
+    }
+
+
+    void Similarity::set_alpha(int bin, double alpha) {
+        this->_alpha[bin] = alpha;
+    }
+
+
+    void Similarity::set_default_alpha(double alpha) {
+        this->_default_alpha = alpha;
+    }
+
+
+    void Similarity::set_sigma(double sigma) {
+        for (auto &entry : this->_functions) {
+            for (auto &function : entry.second) {
+                function.second.set_sigma(sigma);
+            }
+        }
+        for (auto &function : this->_default_functions) {
+            function.second.set_sigma(sigma);
+        }
+    }
+
+
+    void Similarity::bind(const AsdpTable &table) {
+        for (auto &entry : this->_functions) {
+            for (auto &function : entry.second) {
+                function.second.bind(table);
+            }
+        }
+        for (auto &function : this->_default_functions) {
+            function.second.bind(table);
+        }
+    }
+
+
+    std::vector<SimilarityFunction*> Similarity::get_functions(
+        int bin, const AsdpTable &table
+    ) {
+        SimFuncMap &sf = this->_get_functions(bin);
+        int n_keys = table.num_keys();
+        std::vector<SimilarityFunction*> functions(n_keys, nullptr);
+        for (int k = 0; k < n_keys; k++) {
+            auto found = sf.find(table.get_key(k));
+            if (found != sf.end()) {
+                functions[k] = &(found->second);
+            }
+        }
+        return functions;
+    }
+
+
+    MaxSimilarityIndex Similarity::get_index(int bin) {
+        return MaxSimilarityIndex(this->_get_functions(bin));
+    }
+
+
+    Similarity Similarity::fork(void) const {
+        Similarity forked(
+            this->_alpha, this->_default_alpha,
+            this->_functions, this->_default_functions, this->_logger
+        );
+        forked._shared_cache = &this->_cache;
+        forked._transmitted_context = this->_transmitted_context;
+        return forked;
+    }
+
+
+    void Similarity::merge_cache(const Similarity &other) {
+        for (auto &entry : other._cache) {
+            this->_cache.insert(entry);
+        }
+    }
+
+
+    void Similarity::refresh_cache(
+        const std::map<int, AsdpList> &binned_asdps
+    ) {
+        std::map<int, CachedDescriptor> descriptors;
+        for (auto &entry : binned_asdps) {
+            SimFuncMap &sf = this->_get_functions(entry.first);
+            for (auto &asdp : entry.second) {
+                auto inst_type = std::make_pair(
+                    _get_field(asdp, "instrument_name").get_string_value(),
+                    _get_field(asdp, "type").get_string_value()
+                );
+                CachedDescriptor descriptor = {nullptr, {}};
+                auto found = sf.find(inst_type);
+                if (found != sf.end()) {
+                    descriptor.function = &(found->second);
+                    descriptor.dd = found->second._extract_dd(asdp);
+                }
+                int aid = _get_field(asdp, "id").get_int_value();
+                descriptors[aid] = descriptor;
+            }
+        }
+
+        // Similarities are kept only if both ASDPs are unchanged
+        auto unchanged = [&](int aid) {
+            auto current = descriptors.find(aid);
+            auto previous = this->_descriptors.find(aid);
+            return (current != descriptors.end()) &&
+                (previous != this->_descriptors.end()) &&
+                (current->second.function == previous->second.function) &&
+                (current->second.dd == previous->second.dd);
+        };
+        for (auto it = this->_cache.begin(); it != this->_cache.end(); ) {
+            if (unchanged(it->first.first) && unchanged(it->first.second)) {
+                ++it;
+            } else {
+                it = this->_cache.erase(it);
+            }
+        }
+        this->_descriptors.swap(descriptors);
+    }
+
+
+    SimFuncMap &Similarity::_get_functions(int bin) {
+        auto found = this->_functions.find(bin);
+        if (found != this->_functions.end()) {
+            return found->second;
+        }
+        return this->_default_functions;
     }
 
 
@@ -336,6 +868,26 @@ namespace Synopsis {
             SimilarityFunction func = SimilarityFunction(
                 dds, dd_factors, similarity_type, similarity_params, logger
             );
+
+            // Parse optional max similarity index
+            if (j_func.contains("max_similarity_index")) {
+                auto j_index = j_func["max_similarity_index"];
+                auto j_epsilon = j_func["max_similarity_epsilon"];
+                std::string index = j_index.is_string() ?
+                    j_index.get<std::string>() : "";
+                double epsilon = j_epsilon.is_number() ?
+                    j_epsilon.get<double>() : 0.1;
+                if (index == "exact") {
+                    func.set_max_similarity_search(EXACT_INDEX_SEARCH);
+                } else if (index == "approximate") {
+                    func.set_max_similarity_search(
+                        APPROXIMATE_INDEX_SEARCH, epsilon
+                    );
+                } else if (index != "none") {
+                    LOG(logger, Synopsis::LogType::ERROR, "Bad max_similarity_index in parse_function_list, should be \"none\", \"exact\", or \"approximate\"");
+                }
+            }
+
             functions.insert(std::make_pair(key, func));
 
         }
@@ -344,6 +896,156 @@ namespace Synopsis {
     }
 
 
+    /**
+     * Number of doubles to which similarity blocks are aligned within a
+     * SimilarityMatrix memory block (32 bytes)
+     */
+    static const size_t SIMILARITY_BLOCK_ALIGNMENT = 4;
+
+
+    /**
+     * Rounds a count of doubles up to the similarity block alignment
+     */
+    size_t _aligned_count(size_t count) {
+        return (
+            (count + SIMILARITY_BLOCK_ALIGNMENT - 1) /
+            SIMILARITY_BLOCK_ALIGNMENT
+        ) * SIMILARITY_BLOCK_ALIGNMENT;
+    }
+
+
+    size_t SimilarityMatrix::memory_requirement(
+        const AsdpTable &table,
+        const std::vector<int> &rows,
+        const std::vector<SimilarityFunction*> &functions
+    ) {
+        std::vector<size_t> counts(table.num_keys(), 0);
+        for (int row : rows) {
+            counts[table.get_key_id(row)]++;
+        }
+
+        // Blocks are stored for every key with a function; descriptor
+        // scratch space is shared across keys
+        size_t n_doubles = 0;
+        size_t n_scratch = 0;
+        int n_keys = counts.size();
+        for (int k = 0; k < n_keys; k++) {
+            if ((functions[k] == nullptr) || (counts[k] == 0)) { continue; }
+            n_doubles += _aligned_count(counts[k] * counts[k]);
+            n_scratch = std::max(n_scratch, _aligned_count(
+                counts[k] * functions[k]->num_descriptors()
+            ));
+        }
+
+        return (n_doubles + n_scratch) * sizeof(double);
+    }
+
+
+    void SimilarityMatrix::compute(
+        const AsdpTable &table,
+        const std::vector<int> &rows,
+        const std::vector<SimilarityFunction*> &functions,
+        void *memory
+    ) {
+        std::vector<std::vector<int>> members;
+        this->_group(table, rows, members);
+        double *descriptors = this->_assign_blocks(members, functions, memory);
+
+        int n_groups = members.size();
+        for (int g = 0; g < n_groups; g++) {
+            if (this->_blocks[g] == nullptr) { continue; }
+            functions[g]->get_similarity_block(
+                table, members[g], descriptors, this->_blocks[g]
+            );
+        }
+    }
+
+
+    void SimilarityMatrix::accumulate(
+        const AsdpTable &table,
+        const std::vector<int> &rows,
+        const std::vector<SimilarityFunction*> &functions,
+        void *memory
+    ) {
+        std::vector<std::vector<int>> members;
+        this->_group(table, rows, members);
+        double *descriptors = this->_assign_blocks(members, functions, memory);
+
+        int n_groups = members.size();
+        for (int g = 0; g < n_groups; g++) {
+            if (this->_blocks[g] == nullptr) { continue; }
+            functions[g]->accumulate_block(
+                table, members[g], descriptors, this->_blocks[g]
+            );
+        }
+    }
+
+
+    void SimilarityMatrix::transform(
+        const SimilarityMatrix &sums,
+        const std::vector<SimilarityFunction*> &functions,
+        void *memory
+    ) {
+        this->_groups = sums._groups;
+        this->_positions = sums._positions;
+        this->_group_sizes = sums._group_sizes;
+
+        double *buffer = (double*)memory;
+        int n_groups = sums._blocks.size();
+        this->_blocks.assign(n_groups, nullptr);
+        for (int g = 0; g < n_groups; g++) {
+            const double *source = sums._blocks[g];
+            if (source == nullptr) { continue; }
+            int n = this->_group_sizes[g];
+            this->_blocks[g] = buffer;
+            std::copy(source, source + (n * n), buffer);
+            functions[g]->transform_block(n, buffer);
+            buffer += _aligned_count(n * n);
+        }
+    }
+
+
+    double *SimilarityMatrix::_assign_blocks(
+        const std::vector<std::vector<int>> &members,
+        const std::vector<SimilarityFunction*> &functions,
+        void *memory
+    ) {
+        // Place blocks at the start of the memory, followed by scratch space
+        double *buffer = (double*)memory;
+        size_t offset = 0;
+        int n_groups = members.size();
+        this->_blocks.assign(n_groups, nullptr);
+        for (int g = 0; g < n_groups; g++) {
+            if ((functions[g] == nullptr) || members[g].empty()) { continue; }
+            this->_blocks[g] = buffer + offset;
+            offset += _aligned_count(members[g].size() * members[g].size());
+        }
+        return buffer + offset;
+    }
+
+
+    void SimilarityMatrix::_group(
+        const AsdpTable &table,
+        const std::vector<int> &rows,
+        std::vector<std::vector<int>> &members
+    ) {
+        int n_asdps = rows.size();
+        members.assign(table.num_keys(), std::vector<int>());
+        this->_groups.resize(n_asdps);
+        this->_positions.resize(n_asdps);
+        for (int i = 0; i < n_asdps; i++) {
+            int key = table.get_key_id(rows[i]);
+            this->_groups[i] = key;
+            this->_positions[i] = members[key].size();
+            members[key].push_back(rows[i]);
+        }
+        this->_group_sizes.clear();
+        for (auto &group : members) {
+            this->_group_sizes.push_back(group.size());
+        }
+    }
+
+
     Similarity parse_similarity_config(std::string config_file, Logger *logger) {
 
         // If no config file provided, return default configuration
@@ -433,6 +1135,17 @@ namespace Synopsis {
         Similarity similarity(
             alpha, default_alpha, functions, default_functions, logger
         );
+
+        // Parse optional use of transmitted ASDPs as similarity context
+        if (j.contains("transmitted_context")) {
+            auto j_context = j["transmitted_context"];
+            if (j_context.is_boolean()) {
+                similarity.set_transmitted_context(j_context.get<bool>());
+            } else {
+                LOG(logger, Synopsis::LogType::ERROR, "Bad transmitted_context type in parse_similarity_config, should be boolean");
+            }
+        }
+
         return similarity;
     }
 
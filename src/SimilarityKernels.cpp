@@ -0,0 +1,68 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see: SimilarityKernels.hpp
+ */
+#include <map>
+
+#include "SimilarityKernels.hpp"
+
+
+namespace Synopsis {
+
+
+    SimilarityKernel find_kernel(const std::string &name) {
+        static const std::map<std::string, SimilarityKernel> registry = {
+            {"gaussian", GAUSSIAN_KERNEL},
+            {"cosine", COSINE_KERNEL},
+            {"laplacian", LAPLACIAN_KERNEL},
+            {"mahalanobis_diagonal", MAHALANOBIS_DIAGONAL_KERNEL}
+        };
+        auto found = registry.find(name);
+        if (found == registry.end()) {
+            return UNKNOWN_KERNEL;
+        }
+        return found->second;
+    }
+
+
+    /**
+     * Selects the specialization of a kernel for a number of descriptor
+     * elements; counts without a specialization use the runtime count
+     */
+    template <SimilarityKernel K>
+    KernelFunction _specialize(int n_dims) {
+        switch (n_dims) {
+            case 1: return &kernel_similarity<K, 1>;
+            case 2: return &kernel_similarity<K, 2>;
+            case 3: return &kernel_similarity<K, 3>;
+            case 4: return &kernel_similarity<K, 4>;
+            case 8: return &kernel_similarity<K, 8>;
+            case 16: return &kernel_similarity<K, 16>;
+            case 32: return &kernel_similarity<K, 32>;
+            case 64: return &kernel_similarity<K, 64>;
+            case 128: return &kernel_similarity<K, 128>;
+            case 256: return &kernel_similarity<K, 256>;
+            default: return &kernel_similarity<K, 0>;
+        }
+    }
+
+
+    KernelFunction specialize_kernel(SimilarityKernel kernel, int n_dims) {
+        switch (kernel) {
+            case GAUSSIAN_KERNEL:
+                return _specialize<GAUSSIAN_KERNEL>(n_dims);
+            case COSINE_KERNEL:
+                return _specialize<COSINE_KERNEL>(n_dims);
+            case LAPLACIAN_KERNEL:
+                return _specialize<LAPLACIAN_KERNEL>(n_dims);
+            case MAHALANOBIS_DIAGONAL_KERNEL:
+                return _specialize<MAHALANOBIS_DIAGONAL_KERNEL>(n_dims);
+            default:
+                return &kernel_similarity<UNKNOWN_KERNEL, 0>;
+        }
+    }
+
+
+};
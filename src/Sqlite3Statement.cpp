@@ -53,7 +53,9 @@ namespace Synopsis {
   void Sqlite3Statement::bind(int pos, const std::string& val)
   {
     int rc;
-    rc = sqlite3_bind_text(_stmt, pos+1, val.c_str(), val.length()+1, SQLITE_TRANSIENT);
+    // The length excludes the NUL terminator, which would otherwise be
+    // stored as part of the value and break comparisons with SQL literals
+    rc = sqlite3_bind_text(_stmt, pos+1, val.c_str(), val.length(), SQLITE_TRANSIENT);
     throwIfError(rc);
   }
 
@@ -4,6 +4,8 @@
  *
  * @see SqliteASDPDB.hpp
  */
+#include <utility>
+
 #include "SqliteASDPDB.hpp"
 #include "Sqlite3Statement.hpp"
 #include "synopsis_sql.hpp"
@@ -12,8 +14,38 @@
 namespace Synopsis {
 
 
-    SqliteASDPDB::SqliteASDPDB(std::string asdpdb_file) :
+    /**
+     * Resets a prepared statement when it goes out of scope, so that it can be
+     * reused and does not hold a read transaction open
+     */
+    class StatementReset {
+
+        public:
+
+            StatementReset(Sqlite3Statement &stmt) : _stmt(stmt) {}
+
+            ~StatementReset() {
+                try {
+                    this->_stmt.reset();
+                } catch (...) {
+                    // The statement is reset even if its last step failed
+                }
+            }
+
+        private:
+
+            Sqlite3Statement &_stmt;
+
+    };
+
+
+    const int SqliteASDPDB::LOOKASIDE_SLOT_SIZE;
+    const int SqliteASDPDB::SCHEMA_VERSION;
+
+
+    SqliteASDPDB::SqliteASDPDB(std::string asdpdb_file, size_t lookaside_bytes) :
         asdpdb_file(asdpdb_file),
+        _lookaside_bytes(lookaside_bytes),
         _db(NULL),
         _initialized(false)
     {
@@ -25,11 +57,27 @@ namespace Synopsis {
     }
 
 
+    void SqliteASDPDB::set_profile(const SqliteProfile &profile) {
+        this->_profile = profile;
+    }
+
+
     Status SqliteASDPDB::init(size_t bytes, void* memory, Logger *logger) {
         int status;
 
         this->_logger = logger;
 
+        if (this->_lookaside_bytes > 0) {
+            if ((memory == NULL) || (bytes < this->_lookaside_bytes)) {
+                LOG(logger, Synopsis::LogType::ERROR, "Insufficient memory for SQLite lookaside buffer");
+                return FAILURE;
+            }
+            if (((size_t)memory % 8) != 0) {
+                LOG(logger, Synopsis::LogType::ERROR, "SQLite lookaside buffer is not 8-byte aligned");
+                return FAILURE;
+            }
+        }
+
         // Open database
         status= sqlite3_open(this->asdpdb_file.c_str(), &this->_db);
         if (status != SQLITE_OK) {
@@ -37,22 +85,194 @@ namespace Synopsis {
             return FAILURE;
         }
 
-        // Initialize schema
-        status = sqlite3_exec(this->_db, SQL_SCHEMA, NULL, NULL, NULL);
-        if (status != SQLITE_OK) {
-            LOG(logger, Synopsis::LogType::ERROR, "SQLite DB schema not initialized");
+        // Use the provided memory for small allocations; this must be
+        // configured before any statements are prepared
+        if (this->_lookaside_bytes > 0) {
+            status = sqlite3_db_config(
+                this->_db, SQLITE_DBCONFIG_LOOKASIDE, memory,
+                LOOKASIDE_SLOT_SIZE,
+                (int)(this->_lookaside_bytes / LOOKASIDE_SLOT_SIZE)
+            );
+            if (status != SQLITE_OK) {
+                LOG(logger, Synopsis::LogType::ERROR, "SQLite lookaside buffer not configured");
+                return FAILURE;
+            }
+        }
+
+        if (this->_apply_profile() != SUCCESS) {
+            return FAILURE;
+        }
+
+        // Initialize or migrate schema
+        if (this->_init_schema() != SUCCESS) {
+            return FAILURE;
+        }
+
+        if (this->_prepare_statements() != SUCCESS) {
             return FAILURE;
         }
 
         this->_initialized = true;
+        this->_notify_reset();
         return SUCCESS;
     }
 
 
+    Status SqliteASDPDB::_init_schema(void) {
+        int version;
+        bool has_tables;
+        try {
+            Sqlite3Statement version_stmt(this->_db, SQL_GET_SCHEMA_VERSION);
+            version_stmt.step();
+            version = version_stmt.fetch<int>(0);
+
+            Sqlite3Statement exists_stmt(this->_db, SQL_ASDP_TABLE_EXISTS);
+            exists_stmt.step();
+            has_tables = (exists_stmt.fetch<int>(0) > 0);
+        } catch (...) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite DB schema version not read: %s", sqlite3_errmsg(this->_db));
+            return FAILURE;
+        }
+
+        // Databases created prior to schema versioning have version zero
+        if ((version == 0) && has_tables) {
+            version = 1;
+        }
+
+        if (version > SCHEMA_VERSION) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite DB schema version %d is newer than supported version %d", version, SCHEMA_VERSION);
+            return FAILURE;
+        }
+        if (version == SCHEMA_VERSION) {
+            return SUCCESS;
+        }
+
+        // Create or migrate the schema, and record its version, atomically
+        std::string sql = std::string(SQL_BEGIN);
+        if (version == 0) {
+            sql += SQL_SCHEMA;
+        } else {
+            LOG(this->_logger, Synopsis::LogType::INFO, "Migrating SQLite DB schema from version %d to %d", version, SCHEMA_VERSION);
+            sql += SQL_MIGRATE_V1_V2;
+        }
+        sql += SQL_SET_SCHEMA_VERSION + std::to_string(SCHEMA_VERSION) + ";";
+        sql += SQL_COMMIT;
+
+        if (sqlite3_exec(this->_db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite DB schema not initialized: %s", sqlite3_errmsg(this->_db));
+            if (!sqlite3_get_autocommit(this->_db)) {
+                sqlite3_exec(this->_db, SQL_ROLLBACK, NULL, NULL, NULL);
+            }
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+    Status SqliteASDPDB::_apply_profile(void) {
+        try {
+
+            if (this->_profile.wal_journal) {
+                // The journal mode actually used is returned; in-memory
+                // databases, for example, do not support WAL
+                Sqlite3Statement stmt(this->_db, SQL_PRAGMA_JOURNAL_MODE_WAL);
+                std::string mode;
+                if (stmt.step() == SQLITE_ROW) {
+                    mode = stmt.fetch<std::string>(0);
+                }
+                if (mode != "wal") {
+                    LOG(this->_logger, Synopsis::LogType::WARN, "SQLite WAL journaling not enabled; journal mode: %s", mode.c_str());
+                }
+            }
+
+            Sqlite3Statement mmap_stmt(this->_db,
+                SQL_PRAGMA_MMAP_SIZE + std::to_string(this->_profile.mmap_size_bytes)
+            );
+            mmap_stmt.step();
+
+            if (this->_profile.cache_size_kib > 0) {
+                // Negative values are interpreted as a size in KiB
+                Sqlite3Statement cache_stmt(this->_db,
+                    SQL_PRAGMA_CACHE_SIZE + std::to_string(-this->_profile.cache_size_kib)
+                );
+                cache_stmt.step();
+            }
+
+            Sqlite3Statement sync_stmt(this->_db,
+                SQL_PRAGMA_SYNCHRONOUS + std::to_string((int)this->_profile.synchronous)
+            );
+            sync_stmt.step();
+
+        } catch (...) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite DB profile not applied: %s", sqlite3_errmsg(this->_db));
+            return FAILURE;
+        }
+        return SUCCESS;
+    }
+
+
+    Status SqliteASDPDB::_prepare_statements(void) {
+        try {
+            this->_asdp_insert.reset(new Sqlite3Statement(this->_db, SQL_ASDP_INSERT));
+            this->_fieldname_insert.reset(new Sqlite3Statement(this->_db, SQL_FIELDNAME_INSERT));
+            this->_asdp_metadata_insert.reset(new Sqlite3Statement(this->_db, SQL_ASDP_METADATA_INSERT));
+            this->_asdp_select.reset(new Sqlite3Statement(this->_db, SQL_ASDP_SELECT));
+            this->_asdp_get.reset(new Sqlite3Statement(this->_db, SQL_ASDP_GET));
+            this->_asdp_metadata_get.reset(new Sqlite3Statement(this->_db, SQL_ASDP_METADATA_GET));
+            this->_asdp_select_state.reset(new Sqlite3Statement(this->_db, SQL_ASDP_SELECT_STATE));
+            this->_asdp_metadata_select_state.reset(new Sqlite3Statement(this->_db, SQL_ASDP_METADATA_SELECT_STATE));
+            this->_asdp_select_bin_state.reset(new Sqlite3Statement(this->_db, SQL_ASDP_SELECT_BIN_STATE));
+            this->_asdp_metadata_select_bin_state.reset(new Sqlite3Statement(this->_db, SQL_ASDP_METADATA_SELECT_BIN_STATE));
+            this->_update_sue.reset(new Sqlite3Statement(this->_db, SQL_UPDATE_SUE));
+            this->_update_bin.reset(new Sqlite3Statement(this->_db, SQL_UPDATE_BIN));
+            this->_update_dl_state.reset(new Sqlite3Statement(this->_db, SQL_UPDATE_DL_STATE));
+            this->_update_metadata.reset(new Sqlite3Statement(this->_db, SQL_UPDATE_METADATA));
+        } catch (...) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite statements not prepared");
+            this->_finalize_statements();
+            return FAILURE;
+        }
+        return SUCCESS;
+    }
+
+
+    bool SqliteASDPDB::_check_initialized(const std::string &operation) {
+        if (!this->_initialized) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite DB not initialized while %s", operation.c_str());
+        }
+        return this->_initialized;
+    }
+
+
+    void SqliteASDPDB::_finalize_statements(void) {
+        this->_asdp_insert.reset();
+        this->_fieldname_insert.reset();
+        this->_asdp_metadata_insert.reset();
+        this->_asdp_select.reset();
+        this->_asdp_get.reset();
+        this->_asdp_metadata_get.reset();
+        this->_asdp_select_state.reset();
+        this->_asdp_metadata_select_state.reset();
+        this->_asdp_select_bin_state.reset();
+        this->_asdp_metadata_select_bin_state.reset();
+        this->_update_sue.reset();
+        this->_update_bin.reset();
+        this->_update_dl_state.reset();
+        this->_update_metadata.reset();
+    }
+
+
     Status SqliteASDPDB::deinit() {
-        // Close database connection
+        // Statements must be finalized before the connection is closed
         this->_initialized = false;
+        this->_finalize_statements();
+
+        // Close database connection; deinit may be called again by the
+        // destructor, so the handle is cleared
         sqlite3_close(this->_db);
+        this->_db = NULL;
+        this->_notify_reset();
         return SUCCESS;
     }
 
@@ -61,20 +281,30 @@ namespace Synopsis {
     }
 
     size_t SqliteASDPDB::memory_requirement(void) {
-        return 0;
+        return this->_lookaside_bytes;
     }
 
 
     Status SqliteASDPDB::insert_data_product(DpDbMsg& msg) {
+        if (!this->_check_initialized("inserting data product")) {
+            return FAILURE;
+        }
+
         int dp_id;
 
-        // Begin Transaction
-        sqlite3_exec(this->_db, "BEGIN", NULL, NULL, NULL);
+        // Begin Transaction; a savepoint is used so that the insert may be
+        // part of a batch, in which case only this product is rolled back
+        // upon failure
+        if (sqlite3_exec(this->_db, SQL_INSERT_SAVEPOINT, NULL, NULL, NULL) != SQLITE_OK) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Error beginning data product insert");
+            return FAILURE;
+        }
 
         try {
 
             // Insert ASDP
-            Sqlite3Statement stmt(this->_db, SQL_ASDP_INSERT);
+            Sqlite3Statement &stmt = *this->_asdp_insert;
+            StatementReset stmt_reset(stmt);
             stmt.bind(0, msg.get_instrument_name());
             stmt.bind(1, msg.get_type());
             stmt.bind(2, msg.get_uri());
@@ -92,7 +322,14 @@ namespace Synopsis {
             for (auto const& pair : msg.get_metadata()) {
                 std::string key = pair.first;
                 DpMetadataValue value = pair.second;
-                Sqlite3Statement stmt2(this->_db, SQL_ASDP_METADATA_INSERT);
+
+                Sqlite3Statement &field_stmt = *this->_fieldname_insert;
+                StatementReset field_stmt_reset(field_stmt);
+                field_stmt.bind(0, key);
+                field_stmt.step();
+
+                Sqlite3Statement &stmt2 = *this->_asdp_metadata_insert;
+                StatementReset stmt2_reset(stmt2);
                 stmt2.bind(0, dp_id);
                 stmt2.bind(1, key);
                 stmt2.bind(2, (int) value.get_type());
@@ -102,25 +339,78 @@ namespace Synopsis {
                 stmt2.step();
             }
 
-            // Commit transaction
-            sqlite3_exec(this->_db, "COMMIT", NULL, NULL, NULL);
+            // Commit transaction (or release into the enclosing batch)
+            Sqlite3Statement::throwIfError(
+                this->_db,
+                sqlite3_exec(this->_db, SQL_INSERT_RELEASE, NULL, NULL, NULL)
+            );
 
         } catch (...) {
 
             // Rollback transaction and return error
-            sqlite3_exec(this->_db, "ROLLBACK", NULL, NULL, NULL);
+            sqlite3_exec(this->_db, SQL_INSERT_ROLLBACK, NULL, NULL, NULL);
 
             LOG(this->_logger, Synopsis::LogType::ERROR, "Error inserting data product"); 
             return FAILURE;
         }
 
+        this->_notify_changed(dp_id);
+        return SUCCESS;
+    }
+
+
+    Status SqliteASDPDB::begin_batch(void) {
+        if (!this->_check_initialized("beginning batch")) {
+            return FAILURE;
+        }
+
+        if (sqlite3_exec(this->_db, SQL_BEGIN, NULL, NULL, NULL) != SQLITE_OK) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite transaction not started: %s", sqlite3_errmsg(this->_db));
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+    Status SqliteASDPDB::commit_batch(void) {
+        if (!this->_check_initialized("committing batch")) {
+            return FAILURE;
+        }
+
+        if (sqlite3_exec(this->_db, SQL_COMMIT, NULL, NULL, NULL) != SQLITE_OK) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite transaction not committed: %s", sqlite3_errmsg(this->_db));
+            if (!sqlite3_get_autocommit(this->_db)) {
+                sqlite3_exec(this->_db, SQL_ROLLBACK, NULL, NULL, NULL);
+            }
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
+    Status SqliteASDPDB::rollback_batch(void) {
+        if (!this->_check_initialized("rolling back batch")) {
+            return FAILURE;
+        }
+
+        if (sqlite3_exec(this->_db, SQL_ROLLBACK, NULL, NULL, NULL) != SQLITE_OK) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "SQLite transaction not rolled back: %s", sqlite3_errmsg(this->_db));
+            return FAILURE;
+        }
+
         return SUCCESS;
     }
 
 
     Status SqliteASDPDB::get_data_product(int asdp_id, DpDbMsg& msg) {
-        
-        Sqlite3Statement stmt(this->_db, SQL_ASDP_GET);
+        if (!this->_check_initialized("getting data product")) {
+            return FAILURE;
+        }
+
+        Sqlite3Statement &stmt = *this->_asdp_get;
+        StatementReset stmt_reset(stmt);
 
         stmt.bind(0, asdp_id);
 
@@ -140,7 +430,8 @@ namespace Synopsis {
         msg.set_downlink_state((DownlinkState)stmt.fetch<int>(7));
 
 
-        Sqlite3Statement stmt2(this->_db, SQL_ASDP_METADATA_GET);
+        Sqlite3Statement &stmt2 = *this->_asdp_metadata_get;
+        StatementReset stmt2_reset(stmt2);
         stmt2.bind(0, asdp_id);
 
         AsdpEntry metadata;
@@ -156,7 +447,7 @@ namespace Synopsis {
         }
 
 
-        msg.set_metadata(metadata);
+        msg.set_metadata(std::move(metadata));
 
 
         return SUCCESS;
@@ -164,8 +455,12 @@ namespace Synopsis {
 
 
     std::vector<int> SqliteASDPDB::list_data_product_ids(void) {
+        if (!this->_check_initialized("listing data product ids")) {
+            return std::vector<int>();
+        }
 
-        Sqlite3Statement stmt(this->_db, SQL_ASDP_SELECT);
+        Sqlite3Statement &stmt = *this->_asdp_select;
+        StatementReset stmt_reset(stmt);
 
         std::vector<int> result;
         for (int rc = stmt.step(); rc == SQLITE_ROW; rc = stmt.step()) {
@@ -176,8 +471,120 @@ namespace Synopsis {
     }
 
 
+    Status SqliteASDPDB::list_undownlinked_data_products(
+            std::vector<DpDbMsg> &msgs) {
+        if (!this->_check_initialized("listing data products")) {
+            return FAILURE;
+        }
+
+        Sqlite3Statement &stmt = *this->_asdp_select_state;
+        StatementReset stmt_reset(stmt);
+        Sqlite3Statement &stmt2 = *this->_asdp_metadata_select_state;
+        StatementReset stmt2_reset(stmt2);
+        try {
+            stmt.bind(0, (int)UNTRANSMITTED);
+            stmt.bind(1, (int)TRANSMITTED);
+            stmt2.bind(0, (int)UNTRANSMITTED);
+            stmt2.bind(1, (int)TRANSMITTED);
+        } catch (...) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Error listing data products");
+            return FAILURE;
+        }
+
+        return this->_fetch_data_products(stmt, stmt2, msgs);
+    }
+
+
+    Status SqliteASDPDB::list_undownlinked_data_products_in_bin(
+            int priority_bin, std::vector<DpDbMsg> &msgs) {
+        if (!this->_check_initialized("listing data products")) {
+            return FAILURE;
+        }
+
+        Sqlite3Statement &stmt = *this->_asdp_select_bin_state;
+        StatementReset stmt_reset(stmt);
+        Sqlite3Statement &stmt2 = *this->_asdp_metadata_select_bin_state;
+        StatementReset stmt2_reset(stmt2);
+        try {
+            stmt.bind(0, priority_bin);
+            stmt.bind(1, (int)UNTRANSMITTED);
+            stmt.bind(2, (int)TRANSMITTED);
+            stmt2.bind(0, priority_bin);
+            stmt2.bind(1, (int)UNTRANSMITTED);
+            stmt2.bind(2, (int)TRANSMITTED);
+        } catch (...) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Error listing data products");
+            return FAILURE;
+        }
+
+        return this->_fetch_data_products(stmt, stmt2, msgs);
+    }
+
+
+    Status SqliteASDPDB::_fetch_data_products(
+            Sqlite3Statement &stmt, Sqlite3Statement &stmt2,
+            std::vector<DpDbMsg> &msgs) {
+
+        size_t first = msgs.size();
+
+        try {
+
+            for (int rc = stmt.step(); rc == SQLITE_ROW; rc = stmt.step()) {
+                DpDbMsg msg;
+                msg.set_dp_id(stmt.fetch<int>(0));
+                msg.set_instrument_name(stmt.fetch<std::string>(1));
+                msg.set_type(stmt.fetch<std::string>(2));
+                msg.set_uri(stmt.fetch<std::string>(3));
+                msg.set_dp_size(stmt.fetch<int>(4));
+                msg.set_science_utility_estimate(stmt.fetch<double>(5));
+                msg.set_priority_bin(stmt.fetch<int>(6));
+                msg.set_downlink_state((DownlinkState)stmt.fetch<int>(7));
+                msgs.push_back(msg);
+            }
+
+            // Both scans are ordered by ASDP id, so metadata rows are merged
+            // into the corresponding messages in a single pass
+            size_t current = first;
+            AsdpEntry metadata;
+            for (int rc = stmt2.step(); rc == SQLITE_ROW; rc = stmt2.step()) {
+                int dp_id = stmt2.fetch<int>(0);
+                while ((current < msgs.size()) &&
+                        (msgs[current].get_dp_id() != dp_id)) {
+                    msgs[current].set_metadata(std::move(metadata));
+                    metadata.clear();
+                    current++;
+                }
+                if (current == msgs.size()) { break; }
+                std::string key = stmt2.fetch<std::string>(1);
+                DpMetadataValue value(
+                    (MetadataType)stmt2.fetch<int>(2),
+                    stmt2.fetch<int>(3),
+                    stmt2.fetch<double>(4),
+                    stmt2.fetch<std::string>(5)
+                );
+                metadata.insert({key, value});
+            }
+            if (current < msgs.size()) {
+                msgs[current].set_metadata(std::move(metadata));
+            }
+
+        } catch (...) {
+            msgs.resize(first);
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Error listing data products");
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+
+
     Status SqliteASDPDB::update_science_utility(int asdp_id, double sue) {
-        Sqlite3Statement stmt(this->_db, SQL_UPDATE_SUE);
+        if (!this->_check_initialized("updating science utility")) {
+            return FAILURE;
+        }
+
+        Sqlite3Statement &stmt = *this->_update_sue;
+        StatementReset stmt_reset(stmt);
         stmt.bind(0, sue);
         stmt.bind(1, asdp_id);
 
@@ -191,12 +598,18 @@ namespace Synopsis {
             return FAILURE;
         }
 
+        this->_notify_changed(asdp_id);
         return SUCCESS;
     }
 
 
     Status SqliteASDPDB::update_priority_bin(int asdp_id, int bin) {
-        Sqlite3Statement stmt(this->_db, SQL_UPDATE_BIN);
+        if (!this->_check_initialized("updating priority bin")) {
+            return FAILURE;
+        }
+
+        Sqlite3Statement &stmt = *this->_update_bin;
+        StatementReset stmt_reset(stmt);
         stmt.bind(0, bin);
         stmt.bind(1, asdp_id);
 
@@ -210,12 +623,18 @@ namespace Synopsis {
             return FAILURE;
         }
 
+        this->_notify_changed(asdp_id);
         return SUCCESS;
     }
 
 
     Status SqliteASDPDB::update_downlink_state(int asdp_id, DownlinkState state) {
-        Sqlite3Statement stmt(this->_db, SQL_UPDATE_DL_STATE);
+        if (!this->_check_initialized("updating downlink state")) {
+            return FAILURE;
+        }
+
+        Sqlite3Statement &stmt = *this->_update_dl_state;
+        StatementReset stmt_reset(stmt);
         stmt.bind(0, (int)state);
         stmt.bind(1, asdp_id);
 
@@ -229,6 +648,7 @@ namespace Synopsis {
             return FAILURE;
         }
 
+        this->_notify_changed(asdp_id);
         return SUCCESS;
     }
 
@@ -241,8 +661,12 @@ namespace Synopsis {
 
     Status SqliteASDPDB::update_metadata(
             int asdp_id, std::string fieldname, DpMetadataValue value) {
+        if (!this->_check_initialized("updating metadata")) {
+            return FAILURE;
+        }
 
-        Sqlite3Statement stmt(this->_db, SQL_UPDATE_METADATA);
+        Sqlite3Statement &stmt = *this->_update_metadata;
+        StatementReset stmt_reset(stmt);
         stmt.bind(0, value.get_type());
         stmt.bind(1, value.get_int_value());
         stmt.bind(2, value.get_float_value());
@@ -260,6 +684,7 @@ namespace Synopsis {
             return FAILURE;
         }
 
+        this->_notify_changed(asdp_id);
         return SUCCESS;
     }
 
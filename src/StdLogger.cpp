@@ -6,6 +6,7 @@
  */
 #include <iostream>
 #include <cstdarg>
+#include <mutex>
 
 #include "StdLogger.hpp"
 
@@ -13,6 +14,13 @@
 namespace Synopsis {
 
 
+    /**
+     * Serializes output across all StdLogger instances, which share the
+     * standard streams, so that concurrent messages are not interleaved
+     */
+    static std::mutex _std_logger_mutex;
+
+
     StdLogger::StdLogger(
         bool output_all_to_stderr
     ) :
@@ -30,6 +38,11 @@ namespace Synopsis {
 
         switch (type) {
 
+            case LogType::DEBUG:
+                out = stdout;
+                prefix = "[DEBUG]";
+                break;
+
             case LogType::INFO:
                 out = stdout;
                 prefix = "[INFO]";
@@ -51,6 +64,8 @@ namespace Synopsis {
             out = stderr;
         }
 
+        std::lock_guard<std::mutex> lock(_std_logger_mutex);
+
         // fprintf(out, "%s", prefix.c_str());
         // fprintf(out, " ");
         // fprintf(out, "%s", file);
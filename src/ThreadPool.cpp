@@ -0,0 +1,88 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see ThreadPool.hpp
+ */
+#include "ThreadPool.hpp"
+
+
+namespace Synopsis {
+
+
+    ThreadPool::ThreadPool(int n_workers) {
+        for (int i = 0; i < n_workers; i++) {
+            this->_workers.push_back(std::thread(&ThreadPool::_work, this));
+        }
+    }
+
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_stop = true;
+        }
+        this->_task_available.notify_all();
+        for (auto &worker : this->_workers) {
+            worker.join();
+        }
+    }
+
+
+    void ThreadPool::run(std::vector<PoolTask> &tasks) {
+        int remaining = tasks.size();
+        if (remaining == 0) { return; }
+
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        for (auto &task : tasks) {
+            QueuedTask queued = {&task, &remaining};
+            this->_queue.push_back(queued);
+        }
+        this->_task_available.notify_all();
+        this->_task_done.notify_all();
+
+        // Help with queued tasks (of this or any other batch) until this
+        // batch is complete
+        while (remaining > 0) {
+            if (!this->_queue.empty()) {
+                QueuedTask queued = this->_queue.front();
+                this->_queue.pop_front();
+                this->_run_task(lock, queued);
+            } else {
+                this->_task_done.wait(lock);
+            }
+        }
+    }
+
+
+    void ThreadPool::_work(void) {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        while (true) {
+            while (!this->_stop && this->_queue.empty()) {
+                this->_task_available.wait(lock);
+            }
+            if (this->_queue.empty()) {
+                // Stopped with no remaining work
+                return;
+            }
+            QueuedTask queued = this->_queue.front();
+            this->_queue.pop_front();
+            this->_run_task(lock, queued);
+        }
+    }
+
+
+    void ThreadPool::_run_task(
+        std::unique_lock<std::mutex> &lock, QueuedTask queued
+    ) {
+        lock.unlock();
+        (*queued.task)();
+        lock.lock();
+        *queued.remaining -= 1;
+        if (*queued.remaining == 0) {
+            this->_task_done.notify_all();
+        }
+    }
+
+
+};
@@ -36,5 +36,34 @@ namespace Synopsis {
 
     }
 
+    double Timer::remaining(void) {
+        if (this->start_time < 0) {
+            return this->duration;
+        }
+        return this->duration - (this->_clock->get_time() - this->start_time);
+    }
+
+
+    PhaseTimer::PhaseTimer(Clock *clock, double *elapsed_sec) :
+        _clock(clock),
+        _elapsed_sec(elapsed_sec)
+    {
+        if (this->_elapsed_sec != nullptr) {
+            this->_start_time = this->_clock->get_time();
+        }
+    }
+
+    PhaseTimer::~PhaseTimer() {
+        this->stop();
+    }
+
+    void PhaseTimer::stop(void) {
+        if (this->_elapsed_sec == nullptr) {
+            return;
+        }
+        *this->_elapsed_sec += this->_clock->get_time() - this->_start_time;
+        this->_elapsed_sec = nullptr;
+    }
+
 
 };
@@ -5,8 +5,11 @@
  * @see synopsis.hpp
  */
 #include <cstddef>
+#include <deque>
+#include <exception>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "synopsis.hpp"
@@ -23,9 +26,26 @@ namespace Synopsis {
         _planner(planner),
         _logger(logger),
         _clock(clock),
-        n_asds(0)
+        _group_commit_size(0),
+        _group_commit_delay(0.0),
+        _group_open(false),
+        _n_pending_dps(0),
+        _group_start_time(0.0),
+        _ingest_capacity(0),
+        _n_ingested(0),
+        _ingest_status(SUCCESS),
+        _ingest_waiting(false),
+        _ingest_stop(false)
     {
+        if (MAX_SYNOPSIS_APP_ASDS > 0) {
+            this->asds.reserve(MAX_SYNOPSIS_APP_ASDS);
+            this->_dispatch.reserve(MAX_SYNOPSIS_APP_ASDS);
+        }
+    }
+
 
+    Application::~Application() {
+        this->_stop_ingest_worker();
     }
 
 
@@ -36,14 +56,39 @@ namespace Synopsis {
 
     Status Application::add_asds(std::string instrument_name,
             std::string dp_type, ASDS *asds) {
-        if (this->n_asds >= MAX_SYNOPSIS_APP_ASDS) {
+        if ((MAX_SYNOPSIS_APP_ASDS > 0) &&
+                (this->asds.size() >= MAX_SYNOPSIS_APP_ASDS)) {
             return FAILURE;
         }
 
         // Add ASDS to application list
-        this->asds[this->n_asds] =
-            std::make_tuple(instrument_name, dp_type, asds);
-        this->n_asds += 1;
+        this->asds.push_back(std::make_tuple(instrument_name, dp_type, asds));
+
+        // Add ASDS to dispatch index; an ASDS for any type also processes
+        // each registered type, after those registered before it
+        AsdsDispatch &dispatch = this->_dispatch[instrument_name];
+        if ((MAX_SYNOPSIS_APP_ASDS > 0) && dispatch.any_type.empty() &&
+                dispatch.by_type.empty()) {
+            dispatch.any_type.reserve(MAX_SYNOPSIS_APP_ASDS);
+            dispatch.by_type.reserve(MAX_SYNOPSIS_APP_ASDS);
+        }
+        if (dp_type == "") {
+            dispatch.any_type.push_back(asds);
+            for (auto &entry : dispatch.by_type) {
+                entry.second.push_back(asds);
+            }
+        } else {
+            auto found = dispatch.by_type.find(dp_type);
+            if (found == dispatch.by_type.end()) {
+                found = dispatch.by_type.insert(
+                    std::make_pair(dp_type, dispatch.any_type)
+                ).first;
+                if (MAX_SYNOPSIS_APP_ASDS > 0) {
+                    found->second.reserve(MAX_SYNOPSIS_APP_ASDS);
+                }
+            }
+            found->second.push_back(asds);
+        }
 
         // Set the DB instance to be used by the ASDS
         asds->set_database(this->_db);
@@ -73,8 +118,8 @@ namespace Synopsis {
         }
 
         // Init ASDSs
-        for (int i = 0; i < this->n_asds; i++) {
-            ASDS *asds = std::get<2>(this->asds[i]);
+        for (auto &entry : this->asds) {
+            ASDS *asds = std::get<2>(entry);
             mem = asds->memory_requirement();
             mem += Application::padding_nbytes(mem);
 
@@ -107,6 +152,17 @@ namespace Synopsis {
         this->_planner->set_database(this->_db);
         this->_planner->set_clock(this->_clock);
 
+        // Start ingest worker
+        if ((this->_ingest_capacity > 0) && !this->_ingest_worker.joinable()) {
+            this->_ingest_queue.reset(new IngestQueue(this->_ingest_capacity));
+            this->_n_ingested = 0;
+            this->_ingest_status = SUCCESS;
+            this->_ingest_stop = false;
+            this->_ingest_worker = std::thread(
+                &Application::_run_ingest_worker, this
+            );
+        }
+
         return SUCCESS;
     }
 
@@ -114,6 +170,14 @@ namespace Synopsis {
     Status Application::deinit(void) {
         Status status;
 
+        // Process all queued products, then commit products pending due to
+        // group commit
+        this->_stop_ingest_worker();
+        status = this->commit_dp_batch();
+        if (status != SUCCESS) {
+            return status;
+        }
+
         // De-initialize in the reverse order as initialized
 
         // De-init Planner
@@ -123,8 +187,8 @@ namespace Synopsis {
         }
 
         // De-init ASDSs
-        for (int i = 0; i < this->n_asds; i++) {
-            ASDS *asds = std::get<2>(this->asds[i]);
+        for (auto &entry : this->asds) {
+            ASDS *asds = std::get<2>(entry);
             status = asds->deinit();
             if (status != SUCCESS) {
                 return status;
@@ -146,8 +210,8 @@ namespace Synopsis {
         size_t mem = 0;
 
         // Get ASDS memory requirement
-        for (int i = 0; i < this->n_asds; i++) {
-            ASDS *asds = std::get<2>(this->asds[i]);
+        for (auto &entry : this->asds) {
+            ASDS *asds = std::get<2>(entry);
             mem = asds->memory_requirement();
             mem += Application::padding_nbytes(mem);
             base_memory_req += mem;
@@ -158,6 +222,11 @@ namespace Synopsis {
         mem += Application::padding_nbytes(mem);
         base_memory_req += mem;
 
+        // Get planner memory requirement
+        mem = _planner->memory_requirement();
+        mem += Application::padding_nbytes(mem);
+        base_memory_req += mem;
+
         return base_memory_req;
     }
 
@@ -169,41 +238,332 @@ namespace Synopsis {
         );
     }
 
-    Status Application::accept_dp(DpMsg msg) {
+    Status Application::accept_dp(const DpMsg &msg) {
+        if (this->_ingest_queue) {
+            if (!this->_ingest_queue->try_push(msg)) {
+                return BUSY;
+            }
+            this->_notify_ingest_worker();
+            return SUCCESS;
+        }
+        return this->accept_dp(DpMsg(msg));
+    }
 
-        std::string iname = msg.get_instrument_name();
-        std::string dp_type = msg.get_type();
 
-        Status status = SUCCESS;
-        Status status_i;
-        for (int i = 0; i < this->n_asds; i++) {
+    Status Application::accept_dp(DpMsg &&msg) {
+        Status status;
+
+        if (this->_ingest_queue) {
+            if (!this->_ingest_queue->try_push(std::move(msg))) {
+                return BUSY;
+            }
+            this->_notify_ingest_worker();
+            return SUCCESS;
+        }
 
-            std::string iname_i = std::get<0>(this->asds[i]);
-            if (iname == iname_i) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
+        if (this->_group_commit_size <= 0) {
+            return this->_route_dp(msg);
+        }
 
-                std::string dp_type_i = std::get<1>(this->asds[i]);
-                if ((dp_type_i == "") || (dp_type_i == dp_type)) {
+        // Commit the open batch if it has expired
+        if (this->_group_open && (this->_group_commit_delay > 0.0)) {
+            double elapsed = this->_clock->get_time() - this->_group_start_time;
+            if (elapsed >= this->_group_commit_delay) {
+                status = this->_commit_dp_batch();
+                if (status != SUCCESS) {
+                    return status;
+                }
+            }
+        }
 
-                    ASDS *asds = std::get<2>(this->asds[i]);
-                    status_i = asds->process_data_product(msg);
-                    if (status_i != SUCCESS) {
-                        status = status_i;
-                        LOG(this->_logger, Synopsis::LogType::ERROR, "ASDS processing failed with status: %ld", status);
-                    }
+        if (!this->_group_open) {
+            status = this->_db->begin_batch();
+            if (status != SUCCESS) {
+                return status;
+            }
+            this->_group_open = true;
+            this->_n_pending_dps = 0;
+            this->_group_start_time = this->_clock->get_time();
+        }
 
+        // A failed product is rolled back individually, so the batch remains
+        // open for other products
+        status = this->_route_dp(msg);
+        this->_n_pending_dps += 1;
+
+        if (this->_n_pending_dps >= this->_group_commit_size) {
+            Status commit_status = this->_commit_dp_batch();
+            if (commit_status != SUCCESS) {
+                return commit_status;
+            }
+        }
+
+        return status;
+    }
+
+
+    Status Application::accept_dp_batch(const std::vector<DpMsg> &msgs) {
+        std::unique_lock<std::mutex> lock(this->_db_mutex);
+        this->_wait_for_ingest(lock);
+        Status status = this->_commit_dp_batch();
+        if (status != SUCCESS) {
+            return status;
+        }
+
+        status = this->_db->begin_batch();
+        if (status != SUCCESS) {
+            return status;
+        }
+
+        for (const auto &msg : msgs) {
+            // Routing consumes the message, so only routed messages are copied
+            if (this->_dispatch.find(msg.get_instrument_name()) == this->_dispatch.end()) {
+                continue;
+            }
+            DpMsg routed(msg);
+            status = this->_route_dp(routed);
+            if (status != SUCCESS) {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "Rolling back batch of %lu data products", (unsigned long)msgs.size());
+                if (this->_db->rollback_batch() != SUCCESS) {
+                    LOG(this->_logger, Synopsis::LogType::ERROR, "Batch of data products not rolled back");
                 }
+                return status;
             }
         }
+
+        return this->_db->commit_batch();
+    }
+
+
+    void Application::set_group_commit(int max_products, double max_delay_sec) {
+        this->_group_commit_size = max_products;
+        this->_group_commit_delay = max_delay_sec;
+    }
+
+
+    Status Application::commit_dp_batch(void) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
+        return this->_commit_dp_batch();
+    }
+
+
+    Status Application::_commit_dp_batch(void) {
+        if (!this->_group_open) {
+            return SUCCESS;
+        }
+
+        this->_group_open = false;
+        Status status = this->_db->commit_batch();
+        if (status != SUCCESS) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Group commit failed; %d pending data products rolled back", this->_n_pending_dps);
+        }
+        this->_n_pending_dps = 0;
+        return status;
+    }
+
+
+    void Application::set_async_ingest(size_t queue_capacity) {
+        this->_ingest_capacity = queue_capacity;
+    }
+
+
+    Status Application::flush_dp_queue(void) {
+        std::unique_lock<std::mutex> lock(this->_db_mutex);
+        this->_wait_for_ingest(lock);
+        Status status = this->_ingest_status;
+        this->_ingest_status = SUCCESS;
         return status;
     }
 
 
+    void Application::_notify_ingest_worker(void) {
+        // Wake the worker if it is waiting; the fence orders the push before
+        // the flag is read, as the worker sets the flag before it checks the
+        // queue a final time
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->_ingest_waiting.load()) {
+            std::lock_guard<std::mutex> lock(this->_wake_mutex);
+            this->_ingest_wake.notify_one();
+        }
+    }
+
+
+    void Application::_run_ingest_worker(void) {
+        DpMsg msg;
+        while (true) {
+            if (this->_ingest_queue->try_pop(msg)) {
+                std::lock_guard<std::mutex> lock(this->_db_mutex);
+                this->_ingest_batch(msg);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->_wake_mutex);
+            this->_ingest_waiting.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool queued = this->_ingest_queue->try_pop(msg);
+            if (!queued && !this->_ingest_stop) {
+                this->_ingest_wake.wait(lock);
+            }
+            this->_ingest_waiting.store(false);
+            bool stop = this->_ingest_stop;
+            lock.unlock();
+
+            if (queued) {
+                std::lock_guard<std::mutex> db_lock(this->_db_mutex);
+                this->_ingest_batch(msg);
+            } else if (stop) {
+                // A product may be queued while the stop flag is set
+                if (this->_ingest_queue->try_pop(msg)) {
+                    std::lock_guard<std::mutex> db_lock(this->_db_mutex);
+                    this->_ingest_batch(msg);
+                    continue;
+                }
+                return;
+            }
+        }
+    }
+
+
+    void Application::_ingest_batch(DpMsg &msg) {
+        Status status;
+        bool batched = (this->_db->begin_batch() == SUCCESS);
+        if (!batched) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Ingesting queued data products without a batch");
+        }
+
+        // A failed product is rolled back individually, as with group commit
+        size_t n_products = 0;
+        size_t max_products = (this->_group_commit_size > 0) ?
+            this->_group_commit_size : this->_ingest_queue->capacity();
+        do {
+            status = this->_route_dp(msg);
+            if (status != SUCCESS) {
+                this->_ingest_status = status;
+            }
+            n_products++;
+        } while ((n_products < max_products) && this->_ingest_queue->try_pop(msg));
+
+        if (batched) {
+            status = this->_db->commit_batch();
+            if (status != SUCCESS) {
+                LOG(this->_logger, Synopsis::LogType::ERROR, "Ingest commit failed; %lu queued data products rolled back", (unsigned long)n_products);
+                this->_ingest_status = status;
+            }
+        }
+
+        this->_n_ingested += n_products;
+        this->_ingest_done.notify_all();
+    }
+
+
+    void Application::_wait_for_ingest(std::unique_lock<std::mutex> &lock) {
+        if (!this->_ingest_queue || !this->_ingest_worker.joinable()) {
+            return;
+        }
+        size_t n_enqueued = this->_ingest_queue->num_enqueued();
+        while (this->_n_ingested < n_enqueued) {
+            this->_ingest_done.wait(lock);
+        }
+    }
+
+
+    void Application::_stop_ingest_worker(void) {
+        if (!this->_ingest_worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->_wake_mutex);
+            this->_ingest_stop = true;
+        }
+        this->_ingest_wake.notify_one();
+        this->_ingest_worker.join();
+        this->_ingest_queue.reset();
+    }
+
+
+    Status Application::_route_dp(DpMsg &msg) {
+
+        Status status = SUCCESS;
+        auto dispatch = this->_dispatch.find(msg.get_instrument_name());
+        if (dispatch == this->_dispatch.end()) {
+            return status;
+        }
+
+        const std::vector<ASDS*> *asds_list = &dispatch->second.any_type;
+        auto by_type = dispatch->second.by_type.find(msg.get_type());
+        if (by_type != dispatch->second.by_type.end()) {
+            asds_list = &by_type->second;
+        }
+
+        // The last ASDS takes the message, since it is not used afterwards
+        Status status_i;
+        size_t n_asds = asds_list->size();
+        for (size_t i = 0; i < n_asds; i++) {
+            ASDS *asds = (*asds_list)[i];
+            if (i + 1 < n_asds) {
+                status_i = asds->process_data_product(msg);
+            } else {
+                status_i = asds->process_data_product(std::move(msg));
+            }
+            if (status_i != SUCCESS) {
+                status = status_i;
+                LOG(this->_logger, Synopsis::LogType::ERROR, "ASDS processing failed with status: %ld", status);
+            }
+        }
+        return status;
+    }
+
+
+    Status Application::insert_data_product(DpDbMsg &msg) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
+        return _db->insert_data_product(msg);
+    }
+
+
+    Status Application::ingest_bundle(
+        const DpBundle &bundle, std::vector<int> *asdp_ids
+    ) {
+        std::vector<DpDbMsg> msgs;
+        Status status = bundle.get_data_products(msgs);
+        if (status != SUCCESS) {
+            return status;
+        }
+        for (auto &msg : msgs) {
+            msg.set_dp_id(-1);
+        }
+
+        std::unique_lock<std::mutex> lock(this->_db_mutex);
+        this->_wait_for_ingest(lock);
+        status = this->_commit_dp_batch();
+        if (status != SUCCESS) {
+            return status;
+        }
+
+        status = this->_db->insert_data_products(msgs);
+        if (status != SUCCESS) {
+            LOG(this->_logger, Synopsis::LogType::ERROR, "Bundle of %lu data products not inserted", (unsigned long)msgs.size());
+            return status;
+        }
+
+        if (asdp_ids != nullptr) {
+            asdp_ids->clear();
+            for (const auto &msg : msgs) {
+                asdp_ids->push_back(msg.get_dp_id());
+            }
+        }
+        return SUCCESS;
+    }
+
+
     Status Application::update_science_utility(int asdp_id, double sue) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->update_science_utility(asdp_id, sue);
     }
 
 
     Status Application::update_priority_bin(int asdp_id, int bin) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->update_priority_bin(asdp_id, bin);
     }
 
@@ -211,6 +571,7 @@ namespace Synopsis {
     Status Application::update_downlink_state(
         int asdp_id, DownlinkState state
     ) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->update_downlink_state(asdp_id, state);
     }
 
@@ -219,6 +580,7 @@ namespace Synopsis {
     Status Application::update_asdp_metadata(
         int asdp_id, std::string fieldname, int value
     ) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->update_metadata(asdp_id, fieldname, value);
     }
 
@@ -227,6 +589,7 @@ namespace Synopsis {
     Status Application::update_asdp_metadata(
         int asdp_id, std::string fieldname, double value
     ) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->update_metadata(asdp_id, fieldname, value);
     }
 
@@ -235,14 +598,27 @@ namespace Synopsis {
     Status Application::update_asdp_metadata(
         int asdp_id, std::string fieldname, std::string value
     ) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->update_metadata(asdp_id, fieldname, value);
     }
 
     std::vector<int> Application::list_data_product_ids(void) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
         return _db->list_data_product_ids();
     }
 
     Status Application::get_data_product(int asdp_id, DpDbMsg& msg) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
+        return _db->get_data_product(asdp_id, msg);
+    }
+
+    Status Application::get_planned_data_product(int asdp_id, DpDbMsg& msg) {
+        std::lock_guard<std::mutex> lock(this->_db_mutex);
+        const DpDbMsg *entry = _planner->get_planned_entry(asdp_id);
+        if (entry != nullptr) {
+            msg = *entry;
+            return SUCCESS;
+        }
         return _db->get_data_product(asdp_id, msg);
     }
 
@@ -252,6 +628,13 @@ namespace Synopsis {
         double max_processing_time_sec,
         std::vector<int> &prioritized_list
     ) {
+        std::unique_lock<std::mutex> lock(this->_db_mutex);
+        this->_wait_for_ingest(lock);
+        Status status = this->_commit_dp_batch();
+        if (status != SUCCESS) {
+            return status;
+        }
+
         return _planner->prioritize(
             rule_configuration_id,
             similarity_configuration_id,
@@ -260,5 +643,95 @@ namespace Synopsis {
         );
     }
 
+    Status Application::prioritize_with_budget(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        long max_bytes, int max_count,
+        std::vector<int> &prioritized_list,
+        int &cut_asdp_id
+    ) {
+        std::unique_lock<std::mutex> lock(this->_db_mutex);
+        this->_wait_for_ingest(lock);
+        Status status = this->_commit_dp_batch();
+        if (status != SUCCESS) {
+            return status;
+        }
+
+        return _planner->prioritize_with_budget(
+            rule_configuration_id,
+            similarity_configuration_id,
+            max_processing_time_sec,
+            max_bytes, max_count,
+            prioritized_list,
+            cut_asdp_id
+        );
+    }
+
+
+    Status Application::prioritize_streaming(
+        std::string rule_configuration_id,
+        std::string similarity_configuration_id,
+        double max_processing_time_sec,
+        const BinCallback &on_bin
+    ) {
+        // Bins are queued by a planning thread holding the ASDP DB lock, and
+        // passed to the callback from this thread without the lock
+        std::mutex queue_mutex;
+        std::condition_variable queue_ready;
+        std::deque<std::pair<int, std::vector<int>>> queue;
+        bool planned = false;
+        Status status = FAILURE;
+        std::exception_ptr planning_error;
+
+        std::thread planning([&]() {
+            try {
+                std::unique_lock<std::mutex> lock(this->_db_mutex);
+                this->_wait_for_ingest(lock);
+                status = this->_commit_dp_batch();
+                if (status == SUCCESS) {
+                    status = _planner->prioritize_streaming(
+                        rule_configuration_id,
+                        similarity_configuration_id,
+                        max_processing_time_sec,
+                        [&](int bin, const std::vector<int> &bin_order) {
+                            std::lock_guard<std::mutex> queue_lock(queue_mutex);
+                            queue.emplace_back(bin, bin_order);
+                            queue_ready.notify_one();
+                        }
+                    );
+                }
+            } catch (...) {
+                planning_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> queue_lock(queue_mutex);
+            planned = true;
+            queue_ready.notify_one();
+        });
+
+        std::exception_ptr callback_error;
+        try {
+            std::unique_lock<std::mutex> queue_lock(queue_mutex);
+            while (true) {
+                queue_ready.wait(queue_lock, [&]() {
+                    return planned || !queue.empty();
+                });
+                if (queue.empty()) { break; }
+                std::pair<int, std::vector<int>> entry = std::move(queue.front());
+                queue.pop_front();
+                queue_lock.unlock();
+                on_bin(entry.first, entry.second);
+                queue_lock.lock();
+            }
+        } catch (...) {
+            callback_error = std::current_exception();
+        }
+
+        planning.join();
+        if (callback_error) { std::rethrow_exception(callback_error); }
+        if (planning_error) { std::rethrow_exception(planning_error); }
+        return status;
+    }
+
 
 };
@@ -0,0 +1,216 @@
+/**
+ * @author Gary Doran (Gary.B.Doran.Jr@jpl.nasa.gov)
+ * @date 2022.11.07
+ *
+ * @see synopsis_c.h
+ */
+#include <vector>
+
+#include "synopsis_c.h"
+#include "synopsis.hpp"
+#include "SqliteASDPDB.hpp"
+#include "StdLogger.hpp"
+#include "LinuxClock.hpp"
+#include "MaxMarginalRelevanceDownlinkPlanner.hpp"
+
+
+/**
+ * Session state: the application, its modules, and the last results
+ *
+ * C++ exceptions must not cross the C interface, so each entry point that may
+ * raise one catches all exceptions and reports failure instead.
+ */
+struct synopsis_session {
+
+    synopsis_session(
+        const char *asdpdb_file, Synopsis::MmrEngine engine
+    ) :
+        logger(true),
+        db(asdpdb_file),
+        planner(engine),
+        app(&db, &planner, &logger, &clock)
+    {
+        // Final SUEs are read from the per-bin statistics, and sizes from the
+        // entries loaded for prioritization
+        planner.set_stats_enabled(true);
+        planner.set_keep_entries(true);
+    }
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app;
+
+    std::vector<int> ids;
+    std::vector<double> sues;
+    std::vector<long> sizes;
+    int cut_asdp_id = -1;
+
+    /**
+     * Clears the results of the last prioritization
+     */
+    void clear_results(void) {
+        this->ids.clear();
+        this->sues.clear();
+        this->sizes.clear();
+        this->cut_asdp_id = -1;
+    }
+
+};
+
+
+synopsis_session_t *synopsis_session_open(
+    const char *asdpdb_file, int engine, int n_threads, int log_level
+) {
+    if (asdpdb_file == NULL) { return NULL; }
+    synopsis_session_t *session = NULL;
+    try {
+        session = new synopsis_session(
+            asdpdb_file, (Synopsis::MmrEngine)engine
+        );
+        session->logger.set_level((Synopsis::LogType)log_level);
+        session->planner.set_num_threads(n_threads);
+        if (session->app.init(0, NULL) != Synopsis::Status::SUCCESS) {
+            delete session;
+            return NULL;
+        }
+    } catch (...) {
+        delete session;
+        return NULL;
+    }
+    return session;
+}
+
+
+void synopsis_session_close(synopsis_session_t *session) {
+    if (session == NULL) { return; }
+    try {
+        session->app.deinit();
+    } catch (...) {
+        // The session is freed regardless
+    }
+    delete session;
+}
+
+
+/**
+ * Fills the final SUEs and sizes of the prioritized ASDPs from the planner's
+ * per-bin statistics and the entries it loaded, without querying the ASDPDB
+ *
+ * @param[in,out] session: session holding the prioritized ASDP identifiers
+ *
+ * @return: whether every prioritized ASDP has a final SUE and an entry
+ */
+static bool _fill_results(synopsis_session_t *session) {
+    // Bins are concatenated in order, and a budget or deadline keeps a prefix
+    // of their orderings
+    size_t n_ids = session->ids.size();
+    session->sues.reserve(n_ids);
+    session->sizes.reserve(n_ids);
+    for (const auto &bin_stats : session->planner.get_stats().bins) {
+        for (double final_sue : bin_stats.final_sues) {
+            if (session->sues.size() >= n_ids) { break; }
+            session->sues.push_back(final_sue);
+        }
+    }
+    if (session->sues.size() != n_ids) { return false; }
+
+    for (int id : session->ids) {
+        const Synopsis::DpDbMsg *entry = session->planner.get_planned_entry(id);
+        if (entry == NULL) { return false; }
+        session->sizes.push_back((long)entry->get_dp_size());
+    }
+    return true;
+}
+
+
+int synopsis_session_prioritize(
+    synopsis_session_t *session,
+    const char *rule_config, const char *similarity_config,
+    double max_processing_time_sec, long max_bytes, int max_count
+) {
+    session->clear_results();
+
+    try {
+        Synopsis::Status status = session->app.prioritize_with_budget(
+            (rule_config == NULL) ? "" : rule_config,
+            (similarity_config == NULL) ? "" : similarity_config,
+            max_processing_time_sec, max_bytes, max_count,
+            session->ids, session->cut_asdp_id
+        );
+        if (((status == Synopsis::Status::SUCCESS) ||
+                (status == Synopsis::Status::TIMEOUT)) &&
+                !_fill_results(session)) {
+            status = Synopsis::Status::FAILURE;
+        }
+        if ((status != Synopsis::Status::SUCCESS) &&
+                (status != Synopsis::Status::TIMEOUT)) {
+            session->clear_results();
+        }
+        return status;
+    } catch (...) {
+        session->clear_results();
+        return Synopsis::Status::FAILURE;
+    }
+}
+
+
+int synopsis_session_result_count(const synopsis_session_t *session) {
+    return (int)session->ids.size();
+}
+
+
+const int *synopsis_session_result_ids(const synopsis_session_t *session) {
+    return session->ids.data();
+}
+
+
+const double *synopsis_session_result_sues(const synopsis_session_t *session) {
+    return session->sues.data();
+}
+
+
+const long *synopsis_session_result_sizes(const synopsis_session_t *session) {
+    return session->sizes.data();
+}
+
+
+int synopsis_session_result_cut_asdp_id(const synopsis_session_t *session) {
+    return session->cut_asdp_id;
+}
+
+
+int synopsis_session_update_science_utility(
+    synopsis_session_t *session, int asdp_id, double value
+) {
+    try {
+        return session->app.update_science_utility(asdp_id, value);
+    } catch (...) {
+        return Synopsis::Status::FAILURE;
+    }
+}
+
+
+int synopsis_session_update_priority_bin(
+    synopsis_session_t *session, int asdp_id, int value
+) {
+    try {
+        return session->app.update_priority_bin(asdp_id, value);
+    } catch (...) {
+        return Synopsis::Status::FAILURE;
+    }
+}
+
+
+int synopsis_session_update_downlink_state(
+    synopsis_session_t *session, int asdp_id, int value
+) {
+    try {
+        return session->app.update_downlink_state(
+            asdp_id, (Synopsis::DownlinkState)value
+        );
+    } catch (...) {
+        return Synopsis::Status::FAILURE;
+    }
+}
@@ -119,6 +119,64 @@ def synopsis(path_to_synopsis_cli, asdpdb_file, rule_config_file, similarity_con
         return logs, prioritized_dps
 
 
+class SynopsisServer(object):
+    '''
+    Client for a persistent planning service (synopsis_cli --serve), which
+    keeps the ASDP DB, parsed configurations, and caches warm across requests
+
+    Each request is a dictionary with a "command" field; see
+    include/PlanningService.hpp for the commands and their fields. Logs from
+    the service are written to its stderr, which is inherited.
+    '''
+
+    def __init__(self, path_to_synopsis_cli, asdpdb_file):
+        if not os.path.exists(path_to_synopsis_cli):
+            raise ValueError("Invalid synopsis_cli: " + str(path_to_synopsis_cli))
+        if not os.path.exists(asdpdb_file):
+            raise ValueError("Invalid asdpdb_file: " + str(asdpdb_file))
+        self.process = subprocess.Popen(
+            [path_to_synopsis_cli, '--serve', asdpdb_file],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            encoding='utf-8',
+            errors='replace'
+        )
+
+    def request(self, command, **fields):
+        '''
+        Sends one request and returns the service's response dictionary
+        '''
+        fields['command'] = command
+        self.process.stdin.write(json.dumps(fields) + '\n')
+        self.process.stdin.flush()
+        line = self.process.stdout.readline()
+        if line == '':
+            raise RuntimeError("SYNOPSIS service exited")
+        return json.loads(line)
+
+    def prioritize(self, rule_config_file, similarity_config_file, **fields):
+        '''
+        Returns the response to a prioritization request; its
+        "prioritized_list" holds dictionaries as returned by `synopsis`
+        '''
+        return self.request(
+            'prioritize', rule_config=rule_config_file,
+            similarity_config=similarity_config_file, **fields
+        )
+
+    def close(self):
+        if self.process.poll() is None:
+            self.request('quit')
+            self.process.stdin.close()
+            self.process.wait()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+
 if __name__ == "__main__":
 
     path_to_synopsis_cli = './build/synopsis_cli'
@@ -1,13 +1,31 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <cstdio>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <sstream>
+#include <algorithm>
 
 #include <synopsis.hpp>
 #include <SqliteASDPDB.hpp>
+#include <MemoryASDPDB.hpp>
 #include <StdLogger.hpp>
+#include <AsyncLogger.hpp>
 #include <LinuxClock.hpp>
 #include <Timer.hpp>
 #include <RuleAST.hpp>
 #include <MaxMarginalRelevanceDownlinkPlanner.hpp>
+#include <BaselineDownlinkPlanner.hpp>
+#include <PlannerRegistry.hpp>
+#include <ThreadPool.hpp>
+#include <PlanningService.hpp>
+#include <DpBundle.hpp>
+#include <synopsis_c.h>
+
+#include <nlohmann/json.hpp>
 
 
 class TestASDS : public Synopsis::ASDS {
@@ -38,6 +56,137 @@ class TestASDS : public Synopsis::ASDS {
 };
 
 
+/*
+ * ASDS that submits each data product directly to the ASDPDB, failing for
+ * data products with the URI "fail"; processing waits while `blocked` is set
+ */
+class SubmittingASDS : public Synopsis::ASDS {
+
+    public:
+
+        std::atomic<bool> blocked{false};
+        std::atomic<int> invocations{0};
+
+        Synopsis::Status init(size_t bytes, void* memory, Synopsis::Logger *logger) override {
+            this->_logger = logger;
+            return Synopsis::SUCCESS;
+        }
+
+        Synopsis::Status deinit() override {
+            return Synopsis::SUCCESS;
+        }
+
+        Synopsis::Status process_data_product(Synopsis::DpMsg msg) override {
+            this->invocations++;
+            while (this->blocked.load()) {
+                std::this_thread::yield();
+            }
+            if (msg.get_uri() == "fail") {
+                return Synopsis::FAILURE;
+            }
+            Synopsis::DpDbMsg dbmsg(
+                -1, msg.get_instrument_name(), msg.get_type(), msg.get_uri(),
+                1, 0.5, 0, Synopsis::DownlinkState::UNTRANSMITTED,
+                Synopsis::AsdpEntry()
+            );
+            return this->submit_data_product(dbmsg);
+        }
+
+        size_t memory_requirement(void) override {
+            return 0;
+        }
+};
+
+
+/*
+ * ASDS that appends its identifier to a shared log for each data product
+ */
+class RecordingASDS : public Synopsis::ASDS {
+
+    public:
+
+        RecordingASDS(int id, std::vector<int> *log) : id(id), log(log) {}
+
+        int id;
+        std::vector<int> *log;
+
+        Synopsis::Status init(size_t bytes, void* memory, Synopsis::Logger *logger) override {
+            return Synopsis::SUCCESS;
+        }
+
+        Synopsis::Status deinit() override {
+            return Synopsis::SUCCESS;
+        }
+
+        Synopsis::Status process_data_product(Synopsis::DpMsg msg) override {
+            this->log->push_back(this->id);
+            return Synopsis::SUCCESS;
+        }
+
+        size_t memory_requirement(void) override {
+            return 0;
+        }
+};
+
+
+/*
+ * Clock that advances by one second each time it is read, so that timer
+ * expiry depends only on the number of deadline checks
+ */
+class CountingClock : public Synopsis::Clock {
+
+    public:
+
+        double get_time(void) override {
+            return (double)(++this->ticks);
+        }
+
+    private:
+
+        std::atomic<int> ticks{0};
+};
+
+
+/*
+ * Clock with sub-second resolution, for timing planner runs
+ */
+class SteadyClock : public Synopsis::Clock {
+
+    public:
+
+        double get_time(void) override {
+            return 1.0 + std::chrono::duration<double>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count();
+        }
+};
+
+
+/*
+ * SQLite ASDPDB whose single-product lookups can be made to raise the
+ * exception thrown by a failed SQLite statement
+ */
+class FailingLookupASDPDB : public Synopsis::SqliteASDPDB {
+
+    public:
+
+        FailingLookupASDPDB(std::string db_path) :
+            Synopsis::SqliteASDPDB(db_path)
+        {
+
+        }
+
+        Synopsis::Status get_data_product(int asdp_id, Synopsis::DpDbMsg& msg) override {
+            if (this->fail_lookups) {
+                throw std::string("database is locked");
+            }
+            return Synopsis::SqliteASDPDB::get_data_product(asdp_id, msg);
+        }
+
+        bool fail_lookups = false;
+};
+
+
 std::string get_absolute_data_path(std::string relative_path_str) {
     char sep = '/';
     const char* env_p = std::getenv("SYNOPSIS_TEST_DATA");
@@ -131,6 +280,76 @@ TEST(SynopsisTest, TestDpMsg) {
 }
 
 
+// Test copying and moving metadata values and messages
+TEST(SynopsisTest, TestDpDbMsgMove) {
+
+    // Values of each type hold only their own value
+    Synopsis::DpMetadataValue int_value(3);
+    Synopsis::DpMetadataValue float_value(2.5);
+    Synopsis::DpMetadataValue string_value(std::string("a long string value, beyond any small-string buffer"));
+    EXPECT_EQ(0.0, int_value.get_float_value());
+    EXPECT_EQ("", int_value.get_string_value());
+    EXPECT_EQ(0, float_value.get_int_value());
+    EXPECT_EQ(0, string_value.get_int_value());
+    EXPECT_EQ(0.0, string_value.get_numeric());
+    Synopsis::DpMetadataValue generic(Synopsis::FLOAT, 7, 1.5, "ignored");
+    EXPECT_EQ(Synopsis::FLOAT, generic.get_type());
+    EXPECT_EQ(1.5, generic.get_float_value());
+    EXPECT_EQ("", generic.get_string_value());
+
+    // Assignment between types
+    Synopsis::DpMetadataValue value = string_value;
+    EXPECT_EQ(string_value.get_string_value(), value.get_string_value());
+    value = int_value;
+    EXPECT_EQ(Synopsis::INT, value.get_type());
+    EXPECT_EQ(3, value.get_int_value());
+    value = Synopsis::DpMetadataValue(std::string("moved"));
+    EXPECT_EQ("moved", value.get_string_value());
+    value = string_value;
+    Synopsis::DpMetadataValue moved(std::move(value));
+    EXPECT_EQ(string_value.get_string_value(), moved.get_string_value());
+    moved = std::move(float_value);
+    EXPECT_EQ(2.5, moved.get_float_value());
+
+    // Metadata may be moved out of a message
+    Synopsis::AsdpEntry metadata = {
+        {"x", int_value}, {"name", string_value}
+    };
+    Synopsis::DpDbMsg msg;
+    msg.set_metadata(metadata);
+    msg.set_uri(std::string("file::///data/file.dat"));
+    EXPECT_EQ("file::///data/file.dat", msg.get_uri());
+    EXPECT_EQ(metadata.size(), msg.get_metadata().size());
+    Synopsis::AsdpEntry taken = msg.take_metadata();
+    EXPECT_EQ(0, msg.get_metadata().size());
+    EXPECT_EQ(2, taken.size());
+    EXPECT_EQ(string_value.get_string_value(), taken["name"].get_string_value());
+
+    // A moved message reaches every ASDS registered for it
+    Synopsis::SqliteASDPDB db(":memory:");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    SubmittingASDS asds1, asds2;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", &asds1));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", &asds2));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+
+    Synopsis::DpMsg dp_msg("cam", "img", "file::///data/file.dat", "", false);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(std::move(dp_msg)));
+    std::vector<int> ids = app.list_data_product_ids();
+    EXPECT_EQ(2, ids.size());
+    for (int id : ids) {
+        Synopsis::DpDbMsg db_msg;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, app.get_data_product(id, db_msg));
+        EXPECT_EQ("file::///data/file.dat", db_msg.get_uri());
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+}
+
+
 // Test ASDPDB interfaces and functionality
 /*
  * Tests SYNOPSIS-IR-05
@@ -584,6 +803,69 @@ TEST(SynopsisTest, TestBadPriorityBin) {
 }
 
 
+// Test that data products are dispatched to ASDSs registered for their
+// instrument and type, or any type, in registration order
+TEST(SynopsisTest, TestAsdsDispatch) {
+    Synopsis::SqliteASDPDB db(":memory:");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+
+    std::vector<int> log;
+    std::vector<std::unique_ptr<RecordingASDS>> asds;
+    for (int i = 0; i < 40; i++) {
+        asds.emplace_back(new RecordingASDS(i, &log));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", asds[0].get()));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", "img", asds[1].get()));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", asds[2].get()));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", "raw", asds[3].get()));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", "img", asds[4].get()));
+    for (int i = 5; i < 40; i++) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS,
+            app.add_asds("inst" + std::to_string(i), asds[i].get()));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+
+    auto dispatch = [&](std::string instrument, std::string type) {
+        log.clear();
+        Synopsis::DpMsg msg(instrument, type, "", "", false);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(msg));
+        return log;
+    };
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 4}), dispatch("cam", "img"));
+    EXPECT_EQ(std::vector<int>({0, 2, 3}), dispatch("cam", "raw"));
+    EXPECT_EQ(std::vector<int>({0, 2}), dispatch("cam", "other"));
+    EXPECT_EQ(std::vector<int>({0, 2}), dispatch("cam", ""));
+    EXPECT_EQ(std::vector<int>({39}), dispatch("inst39", "img"));
+    EXPECT_EQ(std::vector<int>(), dispatch("inst", "img"));
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+}
+
+
+#if MAX_SYNOPSIS_APP_ASDS > 0
+// Test that registrations beyond a configured ASDS limit are rejected
+TEST(SynopsisTest, TestAsdsLimit) {
+    Synopsis::SqliteASDPDB db(":memory:");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+
+    std::vector<int> log;
+    RecordingASDS asds(0, &log);
+    for (int i = 0; i < MAX_SYNOPSIS_APP_ASDS; i++) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS,
+            app.add_asds("inst" + std::to_string(i % 3), &asds));
+    }
+    EXPECT_EQ(Synopsis::Status::FAILURE, app.add_asds("inst0", &asds));
+    EXPECT_EQ(Synopsis::Status::FAILURE, app.add_asds("new", "img", &asds));
+}
+#endif
+
+
 // Test pass-through ASDS
 TEST(SynopsisTest, TestPassThroughASDS) {
 
@@ -661,6 +943,82 @@ TEST(SynopsisTest, TestPassThroughASDS) {
 }
 
 
+// Test metadata JSON features handled by the streaming metadata parser
+TEST(SynopsisTest, TestStreamingMetaData) {
+    std::string data_path = get_absolute_data_path("example_dp.dat");
+    std::string metadata_path = "/tmp/synopsis_test_streaming_metadata.json";
+
+    Synopsis::SqliteASDPDB db(":memory:");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    Synopsis::PassthroughASDS pt_asds;
+    EXPECT_EQ(Synopsis::Status::SUCCESS,
+        app.add_asds("test_instrument", "test_type", &pt_asds));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+
+    auto submit = [&](std::string contents) {
+        std::ofstream(metadata_path) << contents;
+        Synopsis::DpMsg msg(
+            "test_instrument", "test_type", data_path, metadata_path, true
+        );
+        return app.accept_dp(msg);
+    };
+
+    // Unsupported and nested metadata fields are skipped, other top-level
+    // keys are ignored, and repeated keys take the last value
+    EXPECT_EQ(Synopsis::Status::SUCCESS, submit(
+        "{\"extra\": {\"a\": 1, \"b\": [2, {\"c\": 3}]},"
+        " \"science_utility_estimate\": 1, \"priority_bin\": 0,"
+        " \"priority_bin\": 3,"
+        " \"metadata\": {\"b\": true, \"c\": [1, 2], \"d\": {\"e\": 1},"
+        " \"f\": null, \"g\": 5, \"g\": \"five\", \"h\": 2.5},"
+        " \"after\": {\"x\": 9}}"
+    ));
+    std::vector<int> asdp_ids = db.list_data_product_ids();
+    ASSERT_EQ(1, asdp_ids.size());
+    Synopsis::DpDbMsg db_msg;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(asdp_ids[0], db_msg));
+    EXPECT_EQ(53, db_msg.get_dp_size());
+    EXPECT_EQ(1.0, db_msg.get_science_utility_estimate());
+    EXPECT_EQ(3, db_msg.get_priority_bin());
+    auto meta = db_msg.get_metadata();
+    EXPECT_EQ(2, meta.size());
+    EXPECT_EQ(Synopsis::MetadataType::STRING, meta["g"].get_type());
+    EXPECT_EQ("five", meta["g"].get_string_value());
+    EXPECT_EQ(Synopsis::MetadataType::FLOAT, meta["h"].get_type());
+    EXPECT_EQ(2.5, meta["h"].get_float_value());
+
+    // Malformed, non-object, and incomplete documents are rejected
+    EXPECT_EQ(Synopsis::Status::FAILURE, submit(
+        "{\"science_utility_estimate\": 1, \"priority_bin\": 3, \"metadata\": {"
+    ));
+    EXPECT_EQ(Synopsis::Status::FAILURE, submit("[1, 2, 3]"));
+    EXPECT_EQ(Synopsis::Status::FAILURE, submit(
+        "{\"science_utility_estimate\": 1, \"priority_bin\": 3}"
+    ));
+    EXPECT_EQ(Synopsis::Status::FAILURE, submit(
+        "{\"science_utility_estimate\": 1, \"priority_bin\": 3.5, \"metadata\": {}}"
+    ));
+    EXPECT_EQ(Synopsis::Status::FAILURE, submit(
+        "{\"science_utility_estimate\": [1], \"priority_bin\": 3, \"metadata\": {}}"
+    ));
+    EXPECT_EQ(Synopsis::Status::FAILURE, submit(
+        "{\"science_utility_estimate\": 1, \"priority_bin\": 3,"
+        " \"metadata\": {\"a\": 1}, \"metadata\": 2}"
+    ));
+    std::remove(metadata_path.c_str());
+    Synopsis::DpMsg missing(
+        "test_instrument", "test_type", data_path, metadata_path, true
+    );
+    EXPECT_EQ(Synopsis::Status::FAILURE, app.accept_dp(missing));
+    EXPECT_EQ(1, db.list_data_product_ids().size());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+}
+
+
 TEST(SynopsisTest, TestStdLogger) {
 
     Synopsis::StdLogger logger, *logger_ptr;
@@ -672,6 +1030,105 @@ TEST(SynopsisTest, TestStdLogger) {
     // TODO: try capturing stdout/stderr streams and checking if the text is as expected
 }
 
+
+class CapturingLogger : public Synopsis::Logger {
+
+    public:
+
+        void log(Synopsis::LogType type, const char* file, const int line, const char* fmt, ...) override {
+            char message[512];
+            va_list args;
+            va_start(args, fmt);
+            vsnprintf(message, sizeof(message), fmt, args);
+            va_end(args);
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->types.push_back(type);
+            this->messages.push_back(message);
+        }
+
+        std::mutex mutex;
+        std::vector<Synopsis::LogType> types;
+        std::vector<std::string> messages;
+
+};
+
+
+TEST(SynopsisTest, TestLoggerLevel) {
+
+    CapturingLogger logger, *logger_ptr;
+    logger_ptr = &logger;
+    EXPECT_EQ(Synopsis::LogType::INFO, logger.get_level());
+
+    // Arguments of discarded messages are not evaluated
+    int n_evaluated = 0;
+    LOG(logger_ptr, Synopsis::LogType::DEBUG, "debug %d", ++n_evaluated);
+    LOG(logger_ptr, Synopsis::LogType::INFO, "info %d", ++n_evaluated);
+    EXPECT_EQ(1, n_evaluated);
+
+    logger.set_level(Synopsis::LogType::WARN);
+    LOG(logger_ptr, Synopsis::LogType::INFO, "info %d", ++n_evaluated);
+    LOG(logger_ptr, Synopsis::LogType::ERROR, "error %d", ++n_evaluated);
+
+    logger.set_level(Synopsis::LogType::DEBUG);
+    LOG_OBJECT(logger, Synopsis::LogType::DEBUG, "debug %d", ++n_evaluated);
+
+    std::vector<std::string> expected = {"info 1", "error 2", "debug 3"};
+    EXPECT_EQ(expected, logger.messages);
+
+}
+
+
+TEST(SynopsisTest, TestAsyncLogger) {
+
+    CapturingLogger sink;
+    sink.set_level(Synopsis::LogType::DEBUG);
+    {
+        Synopsis::AsyncLogger logger(&sink, 16), *logger_ptr;
+        logger_ptr = &logger;
+        logger.set_level(Synopsis::LogType::DEBUG);
+
+        // Messages from concurrent threads are all written, in per-thread
+        // order
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.push_back(std::thread([logger_ptr, t]() {
+                for (int i = 0; i < 8; i++) {
+                    LOG(logger_ptr, Synopsis::LogType::DEBUG, "%d %d", t, i);
+                    std::this_thread::yield();
+                }
+            }));
+        }
+        for (auto &thread : threads) { thread.join(); }
+        logger.flush();
+
+        size_t n_written = sink.messages.size();
+        EXPECT_EQ(32, n_written + logger.dropped());
+        std::vector<int> last(4, -1);
+        for (auto &message : sink.messages) {
+            int t, i;
+            ASSERT_EQ(2, sscanf(message.c_str(), "%d %d", &t, &i));
+            EXPECT_LT(last[t], i);
+            last[t] = i;
+        }
+
+        // Long messages are truncated rather than overflowing a slot
+        std::string long_message(1000, 'x');
+        LOG(logger_ptr, Synopsis::LogType::WARN, "%s", long_message.c_str());
+        logger.flush();
+        EXPECT_EQ(
+            Synopsis::AsyncLogger::MAX_MESSAGE_LENGTH - 1,
+            sink.messages.back().size()
+        );
+        EXPECT_EQ(Synopsis::LogType::WARN, sink.types.back());
+
+        // Queued messages are written when the logger is destroyed
+        LOG(logger_ptr, Synopsis::LogType::INFO, "last");
+    }
+    EXPECT_EQ("last", sink.messages.back());
+
+}
+
 TEST(SynopsisTest, TestLinuxClock) {
 
     Synopsis::LinuxClock clock;
@@ -902,9 +1359,9 @@ TEST(SynopsisTest, TestRuleAST) {
     EXPECT_TRUE(std::isnan(one_plus_a_expr.get_value({}, {}).get_numeric()));
     EXPECT_TRUE(std::isnan(one_div_one_expr.get_value({}, {}).get_numeric()));
 
-    std::map<std::string, std::map<std::string, Synopsis::DpMetadataValue>> assignments = {
-        {"x", asdps[0]},
-        {"y", asdps[1]}
+    Synopsis::AsdpAssignments assignments = {
+        {"x", &asdps[0]},
+        {"y", &asdps[1]}
     };
 
     Synopsis::Field x_id_field("x", "asdp_id");
@@ -1024,3 +1481,3113 @@ TEST(SynopsisTest, TestPrioritizeDD) {
     EXPECT_EQ(Synopsis::Status::SUCCESS, status);
 
 }
+
+
+/*
+ * Populates a database with pseudo-random ASDPs across two priority bins,
+ * including descriptor fields used by the DD similarity configuration and
+ * context image pairs used by the instrument pair rules.
+ */
+void populate_random_asdps(
+    Synopsis::ASDPDB &db, int n_asdps, unsigned seed, bool quantize=false
+) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int> size_dist(1, 5);
+
+    // Quantized values produce many exact ties between candidates
+    auto unit = [&]() {
+        double u = uniform(rng);
+        return quantize ? std::floor(4.0 * u) / 4.0 : u;
+    };
+
+    for (int i = 0; i < n_asdps; i++) {
+        int bin = (unit() < 0.5) ? 0 : 7;
+        Synopsis::AsdpEntry metadata;
+        std::string instrument = "OWLS";
+        std::string type = "ACME";
+        if (unit() < 0.3) {
+            instrument = "SFI";
+            type = (i % 2) ? "CTX" : "ZOOM";
+            metadata["context_image_id"] = Synopsis::DpMetadataValue(i + 2);
+        } else {
+            metadata["background_avg"] = Synopsis::DpMetadataValue(2.0 * unit());
+            metadata["unique_masses"] = Synopsis::DpMetadataValue(4.0 * unit());
+        }
+        Synopsis::DpDbMsg msg(
+            -1, instrument, type, "", size_dist(rng), unit(), bin,
+            Synopsis::DownlinkState::UNTRANSMITTED, metadata
+        );
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(msg));
+    }
+}
+
+
+/*
+ * Runs the MMR planner directly against an initialized database using the
+ * specified greedy selection engine, similarity matrix memory budget, and
+ * number of threads.
+ */
+std::vector<int> prioritize_with_engine(
+    Synopsis::ASDPDB &db, Synopsis::MmrEngine engine,
+    std::string rules_path, std::string similarity_path,
+    size_t similarity_memory_bytes = 0, int n_threads = 1,
+    int scan_threshold = 0
+) {
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+        engine, similarity_memory_bytes
+    );
+    planner.set_database(&db);
+    planner.set_clock(&clock);
+    planner.set_num_threads(n_threads);
+    planner.set_parallel_scan_threshold(scan_threshold);
+    EXPECT_EQ(similarity_memory_bytes, planner.memory_requirement());
+    std::vector<double> memory(similarity_memory_bytes / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(
+        similarity_memory_bytes, memory.data(), &logger
+    ));
+
+    std::vector<int> prioritized_list;
+    Synopsis::Status status = planner.prioritize(
+        rules_path, similarity_path, 100, prioritized_list
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, status);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    return prioritized_list;
+}
+
+
+// Test that all greedy selection engines produce identical orderings
+TEST(SynopsisTest, TestPlannerEnginesAgree) {
+    std::string dd_config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::vector<std::string> rule_paths = {
+        "",
+        get_absolute_data_path("dd_example_rules.json"),
+        get_absolute_data_path("instrument_pair_rules.json")
+    };
+    std::vector<Synopsis::MmrEngine> engines = {
+        Synopsis::INCREMENTAL_GREEDY,
+        Synopsis::LAZY_GREEDY
+    };
+
+    Synopsis::StdLogger logger;
+    for (bool quantize : {false, true}) {
+        Synopsis::SqliteASDPDB db(":memory:");
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+        populate_random_asdps(db, 40, 1234, quantize);
+
+        for (auto &rules_path : rule_paths) {
+            std::vector<int> expected = prioritize_with_engine(
+                db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, dd_config_path
+            );
+            EXPECT_GT(expected.size(), 0);
+            EXPECT_EQ(expected, prioritize_with_engine(
+                db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, dd_config_path,
+                0, 4
+            ));
+            // With candidate scans split across threads within each step
+            EXPECT_EQ(expected, prioritize_with_engine(
+                db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, dd_config_path,
+                0, 4, 2
+            ));
+            for (auto engine : engines) {
+                // Without precomputed similarities, with matrices for only
+                // the smaller bins/keys, and with matrices for all bins
+                for (size_t bytes : {0, 512, 1 << 16}) {
+                    for (int n_threads : {1, 4}) {
+                        EXPECT_EQ(expected, prioritize_with_engine(
+                            db, engine, rules_path, dd_config_path, bytes,
+                            n_threads
+                        ));
+                        EXPECT_EQ(expected, prioritize_with_engine(
+                            db, engine, rules_path, dd_config_path, bytes,
+                            n_threads, 2
+                        ));
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    }
+
+    // Check against the fixture databases
+    Synopsis::SqliteASDPDB dd_db(get_absolute_data_path("dd_example.db"));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, dd_db.init(0, NULL, &logger));
+    Synopsis::SqliteASDPDB pair_db(get_absolute_data_path("instrument_pair.db"));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, pair_db.init(0, NULL, &logger));
+    for (auto engine : engines) {
+        std::vector<int> dd_expected = {1, 3};
+        EXPECT_EQ(dd_expected, prioritize_with_engine(
+            dd_db, engine, rule_paths[1], dd_config_path
+        ));
+        std::vector<int> pair_expected = {3, 4};
+        EXPECT_EQ(pair_expected, prioritize_with_engine(
+            pair_db, engine, rule_paths[2], ""
+        ));
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, dd_db.deinit());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, pair_db.deinit());
+}
+
+
+// Test that prepared statements are reused with caller-provided memory
+TEST(SynopsisTest, TestSqliteASDPDBPreparedStatements) {
+    Synopsis::StdLogger logger;
+    size_t bytes = 1 << 16;
+    Synopsis::SqliteASDPDB db(":memory:", bytes);
+    EXPECT_EQ(bytes, db.memory_requirement());
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.init(0, NULL, &logger));
+    EXPECT_FALSE(db.is_initialized());
+
+    std::vector<double> memory(bytes / sizeof(double));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(bytes, memory.data(), &logger));
+    populate_random_asdps(db, 20, 99);
+
+    std::vector<int> ids = db.list_data_product_ids();
+    EXPECT_EQ(20, (int)ids.size());
+    Synopsis::DpDbMsg msg;
+    for (int dp_id : ids) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_science_utility(dp_id, 0.5 * dp_id));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_priority_bin(dp_id, dp_id % 3));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(dp_id, msg));
+        EXPECT_EQ(dp_id, msg.get_dp_id());
+        EXPECT_EQ(0.5 * dp_id, msg.get_science_utility_estimate());
+        EXPECT_EQ(dp_id % 3, msg.get_priority_bin());
+    }
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.get_data_product(100, msg));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.update_science_utility(100, 1.0));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(ids[0], msg));
+    EXPECT_EQ(ids[0], msg.get_dp_id());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.get_data_product(ids[0], msg));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.insert_data_product(msg));
+    EXPECT_EQ(0, (int)db.list_data_product_ids().size());
+}
+
+
+// Test batched and group-committed data product ingest
+TEST(SynopsisTest, TestBatchIngest) {
+    std::string db_path = testing::TempDir() + "synopsis_batch_ingest.db";
+    std::remove(db_path.c_str());
+
+    Synopsis::StdLogger logger;
+    CountingClock clock;
+    Synopsis::SqliteASDPDB db(db_path);
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    SubmittingASDS asds;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", &asds));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+
+    // A second connection only sees committed data products
+    Synopsis::SqliteASDPDB reader(db_path);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.init(0, NULL, &logger));
+    auto committed = [&]() { return (int)reader.list_data_product_ids().size(); };
+
+    Synopsis::DpMsg ok("cam", "img", "ok", "", false);
+    Synopsis::DpMsg fail("cam", "img", "fail", "", false);
+
+    // Batches are all-or-nothing
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp_batch({ok, ok, ok}));
+    EXPECT_EQ(3, committed());
+    EXPECT_EQ(Synopsis::Status::FAILURE, app.accept_dp_batch({ok, ok, fail, ok}));
+    EXPECT_EQ(3, committed());
+
+    std::vector<Synopsis::DpDbMsg> dbmsgs(2);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_products(dbmsgs));
+    EXPECT_EQ(4, dbmsgs[0].get_dp_id());
+    EXPECT_EQ(5, dbmsgs[1].get_dp_id());
+    EXPECT_EQ(5, committed());
+
+    // Count-bounded group commit; failed products do not abort the group
+    app.set_group_commit(3, 0.0);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(Synopsis::Status::FAILURE, app.accept_dp(fail));
+    EXPECT_EQ(5, committed());
+    EXPECT_EQ(6, (int)db.list_data_product_ids().size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(7, committed());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(7, committed());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.commit_dp_batch());
+    EXPECT_EQ(8, committed());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.commit_dp_batch());
+
+    // Time-bounded group commit; the clock advances by one second per read
+    app.set_group_commit(100, 2.0);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(8, committed());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(10, committed());
+
+    // Pending products are committed before prioritization and at deinit
+    std::vector<int> prioritized_list;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.prioritize("", "", 1e9, prioritized_list));
+    EXPECT_EQ(11, committed());
+    EXPECT_EQ(11, (int)prioritized_list.size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+    EXPECT_EQ(12, committed());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.deinit());
+    std::remove(db_path.c_str());
+}
+
+
+// Test that asynchronously accepted data products are queued, processed by
+// the ingest worker, and flushed before they are read
+TEST(SynopsisTest, TestAsyncIngest) {
+    std::string db_path = testing::TempDir() + "synopsis_async_ingest.db";
+    std::remove(db_path.c_str());
+
+    Synopsis::StdLogger logger;
+    CountingClock clock;
+    Synopsis::SqliteASDPDB db(db_path);
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    SubmittingASDS asds;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.add_asds("cam", &asds));
+    app.set_async_ingest(3);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+
+    Synopsis::DpMsg ok("cam", "img", "ok", "", false);
+    Synopsis::DpMsg fail("cam", "img", "fail", "", false);
+    auto accept_when_ready = [&](Synopsis::DpMsg &msg) {
+        Synopsis::Status status;
+        while ((status = app.accept_dp(msg)) == Synopsis::Status::BUSY) {
+            std::this_thread::yield();
+        }
+        return status;
+    };
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, accept_when_ready(ok));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.flush_dp_queue());
+    EXPECT_EQ(10, (int)app.list_data_product_ids().size());
+
+    // A full queue is reported while the worker is busy; the capacity is
+    // rounded up to four, and the worker may hold one more product
+    asds.blocked = true;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    while (asds.invocations < 11) {
+        std::this_thread::yield();
+    }
+    int n_accepted = 1;
+    while (app.accept_dp(ok) == Synopsis::Status::SUCCESS) {
+        n_accepted++;
+    }
+    EXPECT_EQ(5, n_accepted);
+    EXPECT_EQ(Synopsis::Status::BUSY, app.accept_dp(ok));
+    asds.blocked = false;
+
+    // Processing errors are reported once by the next flush
+    EXPECT_EQ(Synopsis::Status::SUCCESS, accept_when_ready(fail));
+    EXPECT_EQ(Synopsis::Status::FAILURE, app.flush_dp_queue());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.flush_dp_queue());
+    EXPECT_EQ(15, (int)app.list_data_product_ids().size());
+
+    // Concurrent producers; prioritization and deinit flush the queue
+    std::vector<std::thread> producers;
+    std::atomic<int> n_produced(0);
+    for (int t = 0; t < 4; t++) {
+        producers.push_back(std::thread([&]() {
+            for (int i = 0; i < 25; i++) {
+                if (accept_when_ready(ok) == Synopsis::Status::SUCCESS) {
+                    n_produced++;
+                }
+            }
+        }));
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(100, n_produced.load());
+    std::vector<int> prioritized_list;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.prioritize("", "", 1e9, prioritized_list));
+    EXPECT_EQ(115, (int)prioritized_list.size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.accept_dp(ok));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+
+    Synopsis::SqliteASDPDB reader(db_path);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.init(0, NULL, &logger));
+    EXPECT_EQ(116, (int)reader.list_data_product_ids().size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.deinit());
+    std::remove(db_path.c_str());
+}
+
+
+// Test that databases with the version 1 schema are migrated in place
+TEST(SynopsisTest, TestSqliteSchemaMigration) {
+    std::string db_path = testing::TempDir() + "synopsis_migration.db";
+    std::remove(db_path.c_str());
+    Synopsis::StdLogger logger;
+
+    // Create a database with the version 1 schema, as written by earlier
+    // versions of SqliteASDPDB
+    sqlite3 *legacy;
+    EXPECT_EQ(SQLITE_OK, sqlite3_open(db_path.c_str(), &legacy));
+    EXPECT_EQ(SQLITE_OK, sqlite3_exec(legacy, R"(
+        CREATE TABLE ASDP (
+            asdp_id INTEGER PRIMARY KEY, instrument_name TEXT, type TEXT,
+            uri TEXT, size INTEGER, science_utility_estimate REAL,
+            priority_bin INTEGER, downlink_state INTEGER
+        );
+        CREATE TABLE METADATA (
+            asdp_id INTEGER, fieldname TEXT NOT NULL, type INTEGER,
+            value_int INTEGER, value_float REAL, value_string TEXT,
+            FOREIGN KEY(asdp_id) REFERENCES ASDP(asdp_id)
+            CONSTRAINT UNIQUE_META UNIQUE (asdp_id,fieldname)
+        );
+        INSERT INTO ASDP VALUES (1, 'cam', 'img', 'a.dat', 10, 0.5, 0, 0);
+        INSERT INTO ASDP VALUES (2, 'cam', 'img', 'b.dat', 20, 0.25, 1, 2);
+        INSERT INTO ASDP VALUES (3, 'spec', 'raw', 'c.dat', 30, 0.75, 1, 1);
+        INSERT INTO METADATA VALUES (1, 'exposure', 1, 0, 1.5, '');
+        INSERT INTO METADATA VALUES (1, 'target', 2, 0, 0.0, 'rock');
+        INSERT INTO METADATA VALUES (2, 'exposure', 1, 0, 2.5, '');
+        INSERT INTO METADATA VALUES (3, 'count', 0, 7, 0.0, '');
+        INSERT INTO METADATA VALUES (2, CAST(X'6761696E00' AS TEXT), 0, 5, 0.0, '');
+    )", NULL, NULL, NULL));
+    EXPECT_EQ(SQLITE_OK, sqlite3_close(legacy));
+
+    for (int pass = 0; pass < 2; pass++) {
+        Synopsis::SqliteASDPDB db(db_path);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+
+        Synopsis::DpDbMsg msg;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(1, msg));
+        EXPECT_EQ("cam", msg.get_instrument_name());
+        EXPECT_EQ(10, (int)msg.get_dp_size());
+        Synopsis::AsdpEntry metadata = msg.get_metadata();
+        EXPECT_EQ(2, (int)metadata.size());
+        EXPECT_EQ(1.5, metadata["exposure"].get_float_value());
+        EXPECT_EQ("rock", metadata["target"].get_string_value());
+
+        std::vector<Synopsis::DpDbMsg> msgs;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+        EXPECT_EQ(2 + pass, (int)msgs.size());
+        EXPECT_EQ(3, msgs[1].get_dp_id());
+        EXPECT_EQ(7 + pass, msgs[1].get_metadata().at("count").get_int_value());
+
+        // Legacy field names with a trailing NUL byte are normalized
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(2, msg));
+        EXPECT_EQ(5, msg.get_metadata().at("gain").get_int_value());
+
+        // New and existing field names are shared across ASDPs
+        if (pass == 0) {
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_metadata(3, "count", Synopsis::DpMetadataValue(8)));
+            Synopsis::AsdpEntry new_metadata;
+            new_metadata["exposure"] = Synopsis::DpMetadataValue(3.5);
+            new_metadata["gain"] = Synopsis::DpMetadataValue(2);
+            Synopsis::DpDbMsg new_msg(
+                -1, "cam", "img", "d.dat", 40, 0.1, 0,
+                Synopsis::DownlinkState::UNTRANSMITTED, new_metadata
+            );
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(new_msg));
+        } else {
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(4, msg));
+            EXPECT_EQ(3.5, msg.get_metadata().at("exposure").get_float_value());
+            EXPECT_EQ(2, msg.get_metadata().at("gain").get_int_value());
+        }
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    }
+
+    // Check the stored schema version and interned field names
+    EXPECT_EQ(SQLITE_OK, sqlite3_open(db_path.c_str(), &legacy));
+    sqlite3_stmt *stmt;
+    EXPECT_EQ(SQLITE_OK, sqlite3_prepare_v2(legacy, "PRAGMA user_version;", -1, &stmt, NULL));
+    EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+    EXPECT_EQ(Synopsis::SqliteASDPDB::SCHEMA_VERSION, sqlite3_column_int(stmt, 0));
+    sqlite3_finalize(stmt);
+    EXPECT_EQ(SQLITE_OK, sqlite3_prepare_v2(legacy, "SELECT count(*) FROM FIELDNAME;", -1, &stmt, NULL));
+    EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+    EXPECT_EQ(4, sqlite3_column_int(stmt, 0));
+    sqlite3_finalize(stmt);
+    EXPECT_EQ(SQLITE_OK, sqlite3_close(legacy));
+
+    // Schemas newer than supported are rejected
+    EXPECT_EQ(SQLITE_OK, sqlite3_open(db_path.c_str(), &legacy));
+    EXPECT_EQ(SQLITE_OK, sqlite3_exec(legacy, "PRAGMA user_version=99;", NULL, NULL, NULL));
+    EXPECT_EQ(SQLITE_OK, sqlite3_close(legacy));
+    Synopsis::SqliteASDPDB newer_db(db_path);
+    EXPECT_EQ(Synopsis::Status::FAILURE, newer_db.init(0, NULL, &logger));
+    newer_db.deinit();
+
+    std::remove(db_path.c_str());
+}
+
+
+// Test that the SQLite profile is applied at initialization
+TEST(SynopsisTest, TestSqliteProfile) {
+    std::string db_path = testing::TempDir() + "synopsis_profile.db";
+    std::remove(db_path.c_str());
+    Synopsis::StdLogger logger;
+
+    Synopsis::SqliteProfile profile;
+    profile.wal_journal = true;
+    profile.mmap_size_bytes = 1 << 20;
+    profile.cache_size_kib = 512;
+    profile.synchronous = Synopsis::SYNCHRONOUS_NORMAL;
+
+    Synopsis::SqliteASDPDB db(db_path);
+    db.set_profile(profile);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 5, 17);
+    EXPECT_TRUE(std::ifstream(db_path + "-wal").good());
+
+    // Readers see the last committed state while a batch is being written
+    Synopsis::SqliteASDPDB reader(db_path);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.init(0, NULL, &logger));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.begin_batch());
+    populate_random_asdps(db, 5, 18);
+    EXPECT_EQ(5, (int)reader.list_data_product_ids().size());
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.list_undownlinked_data_products(msgs));
+    EXPECT_EQ(5, (int)msgs.size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.commit_batch());
+    EXPECT_EQ(10, (int)reader.list_data_product_ids().size());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, reader.deinit());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    std::remove((db_path + "-wal").c_str());
+    std::remove((db_path + "-shm").c_str());
+    std::remove(db_path.c_str());
+
+    // In-memory databases do not support WAL, but are still usable
+    Synopsis::SqliteASDPDB memory_db(":memory:");
+    memory_db.set_profile(profile);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, memory_db.init(0, NULL, &logger));
+    populate_random_asdps(memory_db, 5, 19);
+    EXPECT_EQ(5, (int)memory_db.list_data_product_ids().size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, memory_db.deinit());
+}
+
+
+// Test that the bulk ASDP query matches per-ASDP lookups
+TEST(SynopsisTest, TestListUndownlinkedDataProducts) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 30, 4321);
+    for (int dp_id : {1, 5, 6, 30}) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS,
+            db.update_downlink_state(dp_id, Synopsis::DownlinkState::DOWNLINKED));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS,
+        db.update_downlink_state(2, Synopsis::DownlinkState::TRANSMITTED));
+
+    // The default implementation used by other databases
+    std::vector<Synopsis::DpDbMsg> expected;
+    EXPECT_EQ(Synopsis::Status::SUCCESS,
+        db.Synopsis::ASDPDB::list_undownlinked_data_products(expected));
+    EXPECT_EQ(26, (int)expected.size());
+
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+    EXPECT_EQ(expected.size(), msgs.size());
+    for (size_t i = 0; i < msgs.size(); i++) {
+        EXPECT_EQ(expected[i].get_dp_id(), msgs[i].get_dp_id());
+        EXPECT_EQ(expected[i].get_instrument_name(), msgs[i].get_instrument_name());
+        EXPECT_EQ(expected[i].get_type(), msgs[i].get_type());
+        EXPECT_EQ(expected[i].get_uri(), msgs[i].get_uri());
+        EXPECT_EQ(expected[i].get_dp_size(), msgs[i].get_dp_size());
+        EXPECT_EQ(expected[i].get_science_utility_estimate(),
+            msgs[i].get_science_utility_estimate());
+        EXPECT_EQ(expected[i].get_priority_bin(), msgs[i].get_priority_bin());
+        EXPECT_EQ(expected[i].get_downlink_state(), msgs[i].get_downlink_state());
+
+        Synopsis::AsdpEntry expected_metadata = expected[i].get_metadata();
+        Synopsis::AsdpEntry metadata = msgs[i].get_metadata();
+        EXPECT_EQ(expected_metadata.size(), metadata.size());
+        for (auto &field : expected_metadata) {
+            EXPECT_EQ(1, (int)metadata.count(field.first));
+            Synopsis::DpMetadataValue &value = metadata[field.first];
+            EXPECT_EQ(field.second.get_type(), value.get_type());
+            EXPECT_EQ(field.second.get_int_value(), value.get_int_value());
+            EXPECT_EQ(field.second.get_float_value(), value.get_float_value());
+            EXPECT_EQ(field.second.get_string_value(), value.get_string_value());
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+TEST(SynopsisTest, TestMemoryASDPDB) {
+    std::string dd_config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::string dd_rules_path = get_absolute_data_path("dd_example_rules.json");
+    Synopsis::StdLogger logger;
+
+    // Tables are allocated within the provided (aligned) memory block
+    Synopsis::MemoryASDPDB db(40, 80, 4, 512);
+    size_t bytes = db.memory_requirement();
+    EXPECT_GT(bytes, 0);
+    std::vector<double> memory(bytes / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.init(bytes - 1, memory.data(), &logger));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.init(bytes, (char*)memory.data() + 1, &logger));
+    std::vector<Synopsis::DpDbMsg> no_msgs;
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.insert_data_products(no_msgs));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(bytes, memory.data(), &logger));
+    EXPECT_TRUE(db.is_initialized());
+
+    // The planner produces the same ordering as with a SQLite DB
+    Synopsis::SqliteASDPDB sqlite_db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, sqlite_db.init(0, NULL, &logger));
+    populate_random_asdps(sqlite_db, 38, 1234);
+    populate_random_asdps(db, 38, 1234);
+    EXPECT_EQ(38, db.num_data_products());
+    EXPECT_EQ(sqlite_db.list_data_product_ids(), db.list_data_product_ids());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_metadata(3, "unique_masses", Synopsis::DpMetadataValue(1.25)));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, sqlite_db.update_metadata(3, "unique_masses", Synopsis::DpMetadataValue(1.25)));
+    for (auto &rules_path : {std::string(""), dd_rules_path}) {
+        std::vector<int> expected = prioritize_with_engine(
+            sqlite_db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, dd_config_path
+        );
+        EXPECT_GT(expected.size(), 0);
+        EXPECT_EQ(expected, prioritize_with_engine(
+            db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, dd_config_path
+        ));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS, sqlite_db.deinit());
+
+    // Strings are stored and updated within string storage
+    Synopsis::AsdpEntry metadata;
+    metadata["target"] = Synopsis::DpMetadataValue(std::string("rock"));
+    Synopsis::DpDbMsg msg(
+        -1, "cam", "img", "a.dat", 10, 0.5, 1,
+        Synopsis::DownlinkState::TRANSMITTED, metadata
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(msg));
+    EXPECT_EQ(39, msg.get_dp_id());
+    size_t string_bytes = db.string_bytes_used();
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_metadata(39, "target", Synopsis::DpMetadataValue(std::string("ice"))));
+    EXPECT_EQ(string_bytes, db.string_bytes_used());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_metadata(39, "target", Synopsis::DpMetadataValue(std::string("basalt"))));
+    EXPECT_EQ(string_bytes + 7, db.string_bytes_used());
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.update_metadata(39, "missing", Synopsis::DpMetadataValue(1)));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.update_metadata(40, "target", Synopsis::DpMetadataValue(1)));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.update_downlink_state(0, Synopsis::DownlinkState::DOWNLINKED));
+
+    Synopsis::DpDbMsg result;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(39, result));
+    EXPECT_EQ("cam", result.get_instrument_name());
+    EXPECT_EQ("img", result.get_type());
+    EXPECT_EQ("a.dat", result.get_uri());
+    EXPECT_EQ(10, (int)result.get_dp_size());
+    EXPECT_EQ(0.5, result.get_science_utility_estimate());
+    EXPECT_EQ(1, result.get_priority_bin());
+    EXPECT_EQ(Synopsis::DownlinkState::TRANSMITTED, result.get_downlink_state());
+    EXPECT_EQ("basalt", result.get_metadata().at("target").get_string_value());
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.get_data_product(40, result));
+
+    // Insertions beyond capacity fail without modifying the DB; a new field
+    // name exceeds the field capacity
+    metadata["new_field"] = Synopsis::DpMetadataValue(1);
+    Synopsis::DpDbMsg full_msg(
+        -1, "cam", "img", "b.dat", 10, 0.5, 1,
+        Synopsis::DownlinkState::UNTRANSMITTED, metadata
+    );
+    size_t used = db.string_bytes_used();
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.insert_data_product(full_msg));
+    EXPECT_EQ(39, db.num_data_products());
+    EXPECT_EQ(used, db.string_bytes_used());
+
+    // Batches of insertions are rolled back together
+    std::vector<Synopsis::DpDbMsg> batch = {msg, msg};
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.insert_data_products(batch));
+    EXPECT_EQ(39, db.num_data_products());
+    EXPECT_EQ(used, db.string_bytes_used());
+    batch.pop_back();
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_products(batch));
+    EXPECT_EQ(40, batch[0].get_dp_id());
+
+    // Rollback cannot undo updates
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.begin_batch());
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.begin_batch());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_priority_bin(40, 3));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.rollback_batch());
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.commit_batch());
+
+    // String values updated within a rolled-back batch remain valid
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.begin_batch());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_metadata(39, "target", Synopsis::DpMetadataValue(std::string("regolith"))));
+    EXPECT_EQ(Synopsis::Status::FAILURE, db.rollback_batch());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_metadata(40, "target", Synopsis::DpMetadataValue(std::string("ZZZZZZZZZ"))));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(39, result));
+    EXPECT_EQ("regolith", result.get_metadata().at("target").get_string_value());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    EXPECT_FALSE(db.is_initialized());
+    EXPECT_EQ(0, (int)db.list_data_product_ids().size());
+}
+
+
+// Test restoring an in-memory DB from a snapshot image
+TEST(SynopsisTest, TestMemoryASDPDBSnapshot) {
+    std::string dd_config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::string dd_rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string image_path = testing::TempDir() + "synopsis_snapshot.img";
+    std::remove(image_path.c_str());
+    Synopsis::StdLogger logger;
+
+    Synopsis::MemoryASDPDB db(40, 80, 4, 512);
+    std::vector<double> memory(db.memory_requirement() / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(db.memory_requirement(), memory.data(), &logger));
+    populate_random_asdps(db, 30, 1234);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_downlink_state(2, Synopsis::DownlinkState::DOWNLINKED));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.save_snapshot(image_path));
+
+    // Restoring replaces existing contents and preserves identifiers
+    Synopsis::MemoryASDPDB restored(40, 80, 4, 512);
+    std::vector<double> restored_memory(restored.memory_requirement() / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::FAILURE, restored.load_snapshot(image_path));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, restored.init(restored.memory_requirement(), restored_memory.data(), &logger));
+    populate_random_asdps(restored, 5, 4321);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, restored.load_snapshot(image_path));
+    EXPECT_EQ(30, restored.num_data_products());
+    EXPECT_EQ(db.string_bytes_used(), restored.string_bytes_used());
+
+    std::vector<Synopsis::DpDbMsg> expected, msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(expected));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, restored.list_undownlinked_data_products(msgs));
+    EXPECT_EQ(29, (int)msgs.size());
+    for (size_t i = 0; i < msgs.size(); i++) {
+        EXPECT_EQ(expected[i].get_dp_id(), msgs[i].get_dp_id());
+        EXPECT_EQ(expected[i].get_instrument_name(), msgs[i].get_instrument_name());
+        EXPECT_EQ(expected[i].get_science_utility_estimate(),
+            msgs[i].get_science_utility_estimate());
+        EXPECT_EQ(expected[i].get_metadata().size(), msgs[i].get_metadata().size());
+    }
+    EXPECT_EQ(
+        prioritize_with_engine(db, Synopsis::EXHAUSTIVE_GREEDY, dd_rules_path, dd_config_path),
+        prioritize_with_engine(restored, Synopsis::EXHAUSTIVE_GREEDY, dd_rules_path, dd_config_path)
+    );
+
+    // Restored DBs accept new products
+    Synopsis::DpDbMsg msg(
+        -1, "cam", "img", "a.dat", 10, 0.5, 1,
+        Synopsis::DownlinkState::UNTRANSMITTED, Synopsis::AsdpEntry()
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, restored.insert_data_product(msg));
+    EXPECT_EQ(31, msg.get_dp_id());
+
+    // Images that exceed capacity are rejected
+    Synopsis::MemoryASDPDB small(20, 80, 4, 512);
+    std::vector<double> small_memory(small.memory_requirement() / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, small.init(small.memory_requirement(), small_memory.data(), &logger));
+    EXPECT_EQ(Synopsis::Status::FAILURE, small.load_snapshot(image_path));
+
+    // Corrupt images leave the DB empty
+    {
+        std::fstream image(image_path, std::ios::binary | std::ios::in | std::ios::out);
+        image.seekp(-3, std::ios::end);
+        image.put('x');
+    }
+    EXPECT_EQ(Synopsis::Status::FAILURE, restored.load_snapshot(image_path));
+    EXPECT_EQ(0, restored.num_data_products());
+    EXPECT_EQ(Synopsis::Status::FAILURE, restored.load_snapshot(image_path + ".missing"));
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, restored.deinit());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, small.deinit());
+    std::remove(image_path.c_str());
+}
+
+
+// Test that prioritization stops at the deadline with a partial ordering
+TEST(SynopsisTest, TestPlannerDeadline) {
+    std::string rules_path = "";
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::vector<Synopsis::MmrEngine> engines = {
+        Synopsis::EXHAUSTIVE_GREEDY,
+        Synopsis::INCREMENTAL_GREEDY,
+        Synopsis::LAZY_GREEDY
+    };
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    int n_asdps = 40;
+    populate_random_asdps(db, n_asdps, 1234);
+
+    for (auto engine : engines) {
+        std::vector<int> expected = prioritize_with_engine(
+            db, engine, rules_path, config_path
+        );
+        EXPECT_EQ(n_asdps, (int)expected.size());
+
+        // The timer is read once when started, once per loaded ASDP, once
+        // after loading, and once before each greedy step, and expires once
+        // the elapsed time reaches the deadline
+        for (int n_steps : {0, 5, 30}) {
+            for (int n_threads : {1, 4}) {
+                CountingClock clock;
+                Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+                planner.set_database(&db);
+                planner.set_clock(&clock);
+                planner.set_num_threads(n_threads);
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+                std::vector<int> prioritized_list;
+                EXPECT_EQ(Synopsis::Status::TIMEOUT, planner.prioritize(
+                    rules_path, config_path, n_asdps + 2 + n_steps,
+                    prioritized_list
+                ));
+                EXPECT_LT(prioritized_list.size(), expected.size());
+                if (n_threads == 1) {
+                    EXPECT_EQ(n_steps, (int)prioritized_list.size());
+                }
+                std::vector<int> prefix(
+                    expected.begin(),
+                    expected.begin() + prioritized_list.size()
+                );
+                EXPECT_EQ(prefix, prioritized_list);
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+            }
+        }
+
+        // Expiry while ASDPs are loaded
+        CountingClock clock;
+        Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+        planner.set_database(&db);
+        planner.set_clock(&clock);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+        std::vector<int> prioritized_list;
+        EXPECT_EQ(Synopsis::Status::TIMEOUT, planner.prioritize(
+            rules_path, config_path, 3, prioritized_list
+        ));
+        EXPECT_EQ(0, (int)prioritized_list.size());
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that budgeted prioritization returns the longest prefix of the full
+// prioritization that fits within the budget, and stops once it is filled
+TEST(SynopsisTest, TestPlannerBudget) {
+    std::string rules_path = "";
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::vector<Synopsis::MmrEngine> engines = {
+        Synopsis::EXHAUSTIVE_GREEDY,
+        Synopsis::INCREMENTAL_GREEDY,
+        Synopsis::LAZY_GREEDY
+    };
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    int n_asdps = 40;
+    populate_random_asdps(db, n_asdps, 4321);
+
+    std::map<int, long> sizes;
+    long total_bytes = 0;
+    for (int asdp_id : db.list_data_product_ids()) {
+        Synopsis::DpDbMsg msg;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(asdp_id, msg));
+        sizes[asdp_id] = msg.get_dp_size();
+        total_bytes += msg.get_dp_size();
+    }
+
+    std::vector<std::pair<long, int>> budgets = {
+        {-1, -1}, {0, -1}, {-1, 0}, {1, -1}, {10, -1}, {total_bytes / 2, -1},
+        {total_bytes, -1}, {-1, 5}, {-1, 25}, {-1, n_asdps}, {30, 12}
+    };
+
+    for (auto engine : engines) {
+        std::vector<int> expected = prioritize_with_engine(
+            db, engine, rules_path, config_path
+        );
+        EXPECT_EQ(n_asdps, (int)expected.size());
+
+        for (bool incremental : {false, true}) {
+            for (int n_threads : {1, 4}) {
+                Synopsis::LinuxClock clock;
+                Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+                planner.set_database(&db);
+                planner.set_clock(&clock);
+                planner.set_num_threads(n_threads);
+                planner.set_incremental(incremental);
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+                for (auto &budget : budgets) {
+                    // Expected manifest and cut point
+                    std::vector<int> manifest;
+                    int expected_cut = -1;
+                    long used_bytes = 0;
+                    for (int asdp_id : expected) {
+                        if (((budget.second >= 0) &&
+                                ((int)manifest.size() >= budget.second)) ||
+                                ((budget.first >= 0) &&
+                                (used_bytes + sizes[asdp_id] > budget.first))) {
+                            expected_cut = asdp_id;
+                            break;
+                        }
+                        manifest.push_back(asdp_id);
+                        used_bytes += sizes[asdp_id];
+                    }
+
+                    std::vector<int> prioritized_list;
+                    int cut_asdp_id = 0;
+                    EXPECT_EQ(Synopsis::Status::SUCCESS,
+                        planner.prioritize_with_budget(
+                            rules_path, config_path, 100,
+                            budget.first, budget.second,
+                            prioritized_list, cut_asdp_id
+                        )
+                    );
+                    EXPECT_EQ(manifest, prioritized_list);
+                    EXPECT_EQ(expected_cut, cut_asdp_id);
+                }
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+            }
+        }
+
+        // Greedy steps stop at the cut point: the timer is read once when
+        // started, once per loaded ASDP, once after loading, and once before
+        // each greedy step, including the step that finds the cut point
+        CountingClock clock;
+        Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+        planner.set_database(&db);
+        planner.set_clock(&clock);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+        std::vector<int> prioritized_list;
+        int cut_asdp_id = -1;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize_with_budget(
+            rules_path, config_path, n_asdps + 2 + 7, -1, 5,
+            prioritized_list, cut_asdp_id
+        ));
+        EXPECT_EQ(std::vector<int>(expected.begin(), expected.begin() + 5),
+            prioritized_list);
+        EXPECT_EQ(expected[5], cut_asdp_id);
+        prioritized_list.clear();
+        EXPECT_EQ(Synopsis::Status::TIMEOUT, planner.prioritize(
+            rules_path, config_path, n_asdps + 2 + 7, prioritized_list
+        ));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that streaming prioritization passes each bin's ordering once, in bin
+// order, with the same orderings as prioritize
+TEST(SynopsisTest, TestPlannerStreaming) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::vector<Synopsis::MmrEngine> engines = {
+        Synopsis::EXHAUSTIVE_GREEDY,
+        Synopsis::INCREMENTAL_GREEDY,
+        Synopsis::LAZY_GREEDY
+    };
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    int n_asdps = 40;
+    populate_random_asdps(db, n_asdps, 1357);
+
+    for (auto engine : engines) {
+        std::vector<int> expected = prioritize_with_engine(
+            db, engine, rules_path, config_path
+        );
+
+        for (bool incremental : {false, true}) {
+            for (int n_threads : {1, 4}) {
+                Synopsis::LinuxClock clock;
+                Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+                planner.set_database(&db);
+                planner.set_clock(&clock);
+                planner.set_num_threads(n_threads);
+                planner.set_incremental(incremental);
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+                std::vector<int> bins;
+                std::vector<int> streamed;
+                std::atomic<int> n_active(0);
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize_streaming(
+                    rules_path, config_path, 100,
+                    [&](int bin, const std::vector<int> &bin_order) {
+                        EXPECT_EQ(1, ++n_active);
+                        bins.push_back(bin);
+                        streamed.insert(streamed.end(), bin_order.begin(), bin_order.end());
+                        n_active--;
+                    }
+                ));
+                EXPECT_EQ(std::vector<int>({0, 7}), bins);
+                EXPECT_EQ(expected, streamed);
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+            }
+        }
+
+        // Bins after an expired bin are not passed
+        CountingClock clock;
+        Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+        planner.set_database(&db);
+        planner.set_clock(&clock);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+        std::vector<std::vector<int>> bin_orders;
+        EXPECT_EQ(Synopsis::Status::TIMEOUT, planner.prioritize_streaming(
+            rules_path, config_path, n_asdps + 2 + 7,
+            [&](int bin, const std::vector<int> &bin_order) {
+                EXPECT_EQ(0, bin);
+                bin_orders.push_back(bin_order);
+            }
+        ));
+        ASSERT_EQ(1, (int)bin_orders.size());
+        EXPECT_LT(bin_orders[0].size(), expected.size());
+        EXPECT_TRUE(std::equal(
+            bin_orders[0].begin(), bin_orders[0].end(), expected.begin()
+        ));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that application streaming passes bins to a callback that may read the
+// ASDP DB through the application
+TEST(SynopsisTest, TestApplicationStreaming) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    Synopsis::SqliteASDPDB db(":memory:");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+    populate_random_asdps(db, 40, 1357);
+
+    std::vector<int> expected;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.prioritize(
+        rules_path, config_path, 100, expected
+    ));
+
+    std::vector<int> bins;
+    std::vector<int> streamed;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.prioritize_streaming(
+        rules_path, config_path, 100,
+        [&](int bin, const std::vector<int> &bin_order) {
+            bins.push_back(bin);
+            for (int asdp_id : bin_order) {
+                Synopsis::DpDbMsg msg;
+                EXPECT_EQ(Synopsis::Status::SUCCESS, app.get_data_product(asdp_id, msg));
+                EXPECT_EQ(bin, msg.get_priority_bin());
+                streamed.push_back(asdp_id);
+            }
+        }
+    ));
+    EXPECT_EQ(std::vector<int>({0, 7}), bins);
+    EXPECT_EQ(expected, streamed);
+
+    // Exceptions raised by the callback reach the caller
+    EXPECT_THROW(app.prioritize_streaming(
+        rules_path, config_path, 100,
+        [&](int bin, const std::vector<int> &bin_order) {
+            throw std::runtime_error("callback failed");
+        }
+    ), std::runtime_error);
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+}
+
+
+// Test that planner statistics are collected only when enabled
+TEST(SynopsisTest, TestPlannerStats) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::vector<Synopsis::MmrEngine> engines = {
+        Synopsis::EXHAUSTIVE_GREEDY,
+        Synopsis::INCREMENTAL_GREEDY,
+        Synopsis::LAZY_GREEDY
+    };
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    int n_asdps = 40;
+    populate_random_asdps(db, n_asdps, 1234);
+
+    for (auto engine : engines) {
+        for (size_t similarity_memory_bytes : {0, 1 << 20}) {
+            CountingClock clock;
+            Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+                engine, similarity_memory_bytes
+            );
+            planner.set_database(&db);
+            planner.set_clock(&clock);
+            std::vector<double> memory(similarity_memory_bytes / sizeof(double) + 1);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(
+                similarity_memory_bytes, memory.data(), &logger
+            ));
+
+            // Disabled by default
+            std::vector<int> prioritized_list;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                rules_path, config_path, 1e9, prioritized_list
+            ));
+            EXPECT_EQ(0, (int)planner.get_stats().n_loaded);
+            EXPECT_EQ(0, (int)planner.get_stats().bins.size());
+            EXPECT_EQ(0.0, planner.get_stats().total_time_sec);
+
+            planner.set_stats_enabled(true);
+            std::vector<int> expected = prioritized_list;
+            prioritized_list.clear();
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                rules_path, config_path, 1e9, prioritized_list
+            ));
+            EXPECT_EQ(expected, prioritized_list);
+
+            const Synopsis::PlannerStats &stats = planner.get_stats();
+            EXPECT_EQ(n_asdps, (int)stats.n_loaded);
+            EXPECT_EQ(2, (int)stats.bins.size());
+            EXPECT_GT(stats.config_time_sec, 0.0);
+            EXPECT_GT(stats.load_time_sec, 0.0);
+            EXPECT_GT(stats.planning_time_sec, 0.0);
+            EXPECT_GT(stats.total_time_sec,
+                stats.config_time_sec + stats.load_time_sec +
+                stats.planning_time_sec
+            );
+
+            int n_bin_asdps = 0;
+            int n_prioritized = 0;
+            long n_rule_evaluations = 0;
+            long n_similarities = 0;
+            for (auto &bin_stats : stats.bins) {
+                n_bin_asdps += bin_stats.n_asdps;
+                n_prioritized += bin_stats.n_prioritized;
+                n_rule_evaluations += bin_stats.n_rule_evaluations;
+                n_similarities += (
+                    bin_stats.n_similarity_hits + bin_stats.n_similarity_misses
+                );
+                EXPECT_GT(bin_stats.planning_time_sec, 0.0);
+                EXPECT_LE(bin_stats.planning_time_sec, stats.planning_time_sec);
+            }
+            EXPECT_EQ(0, stats.bins[0].bin);
+            EXPECT_EQ(7, stats.bins[1].bin);
+            EXPECT_EQ(n_asdps, n_bin_asdps);
+            EXPECT_EQ((int)prioritized_list.size(), n_prioritized);
+            EXPECT_EQ(n_rule_evaluations, stats.n_rule_evaluations);
+            EXPECT_EQ(n_similarities,
+                stats.n_similarity_hits + stats.n_similarity_misses
+            );
+
+            // Only bin 0 has a constraint, which rejects non-OWLS ASDPs
+            EXPECT_GT(stats.bins[0].n_rule_evaluations, 0);
+            EXPECT_GT(stats.bins[0].n_constraint_rejections, 0);
+            EXPECT_LE(stats.n_constraint_rejections, stats.n_rule_evaluations);
+            EXPECT_EQ(0, stats.bins[1].n_constraint_rejections);
+            EXPECT_LT(stats.bins[0].n_prioritized, stats.bins[0].n_asdps);
+            EXPECT_EQ(stats.bins[1].n_prioritized, stats.bins[1].n_asdps);
+
+            // Similarities are computed on demand unless a matrix is
+            // precomputed; the exhaustive engine reuses its cache
+            EXPECT_GT(n_similarities, 0);
+            if (engine == Synopsis::EXHAUSTIVE_GREEDY) {
+                EXPECT_GT(stats.n_similarity_hits, 0);
+            } else if (similarity_memory_bytes > 0) {
+                EXPECT_EQ(0, stats.n_similarity_misses);
+            } else {
+                EXPECT_EQ(0, stats.n_similarity_hits);
+            }
+
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that the columnar ASDP table round-trips ASDPDB entries
+TEST(SynopsisTest, TestAsdpTable) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(get_absolute_data_path("dd_example.db"));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+
+    Synopsis::AsdpTable table;
+    Synopsis::DpDbMsg msg;
+    std::vector<Synopsis::AsdpEntry> expected;
+    for (int dp_id : db.list_data_product_ids()) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(dp_id, msg));
+        Synopsis::AsdpEntry asdp;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, Synopsis::_populate_asdp(msg, asdp));
+        expected.push_back(asdp);
+        EXPECT_EQ((int)expected.size() - 1, table.add_data_product(msg));
+    }
+    EXPECT_EQ((int)expected.size(), table.size());
+
+    for (int row = 0; row < table.size(); row++) {
+        Synopsis::AsdpEntry entry = table.get_entry(row);
+        EXPECT_EQ(expected[row].size(), entry.size());
+        for (auto &field : expected[row]) {
+            EXPECT_EQ(1, entry.count(field.first));
+            Synopsis::DpMetadataValue &value = entry[field.first];
+            EXPECT_EQ(field.second.get_type(), value.get_type());
+            EXPECT_EQ(field.second.get_int_value(), value.get_int_value());
+            EXPECT_EQ(field.second.get_float_value(), value.get_float_value());
+            EXPECT_EQ(field.second.get_string_value(), value.get_string_value());
+        }
+        EXPECT_EQ(expected[row]["id"].get_int_value(), table.get_id(row));
+        EXPECT_EQ(
+            expected[row]["science_utility_estimate"].get_float_value(),
+            table.get_sue(row)
+        );
+    }
+
+    // Strings and fields are interned
+    EXPECT_EQ(table.intern_string("OWLS"), table.intern_string("OWLS"));
+    EXPECT_EQ(Synopsis::AsdpTable::SUE_SLOT,
+        table.find_field("science_utility_estimate"));
+    EXPECT_EQ(-1, table.find_field("no_such_field"));
+    EXPECT_FALSE(table.get_value(0, table.intern_field("no_such_field")).present);
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that rules compiled to programs agree with tree evaluation
+TEST(SynopsisTest, TestRuleProgram) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 12, 4321, true);
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+
+    Synopsis::AsdpTable table;
+    Synopsis::AsdpList asdps;
+    Synopsis::AsdpRowList rows;
+    for (auto &msg : msgs) {
+        Synopsis::AsdpEntry asdp;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, Synopsis::_populate_asdp(msg, asdp));
+        asdps.push_back(asdp);
+        rows.push_back(table.add_data_product(msg));
+    }
+
+    // (x.instrument_name == "SFI") AND NOT (x.id == y.id) AND
+    // EXISTS z: (z.sue > y.sue OR z.missing == 1)
+    Synopsis::Field x_instrument("x", "instrument_name");
+    Synopsis::StringConstant sfi("SFI");
+    Synopsis::ComparatorExpression is_sfi("==", &x_instrument, &sfi);
+    Synopsis::Field x_id("x", "id");
+    Synopsis::Field y_id("y", "id");
+    Synopsis::ComparatorExpression same_id("==", &x_id, &y_id);
+    Synopsis::LogicalNot different_id(&same_id);
+    Synopsis::Field z_sue("z", "science_utility_estimate");
+    Synopsis::Field y_sue("y", "science_utility_estimate");
+    Synopsis::ComparatorExpression greater_sue(">", &z_sue, &y_sue);
+    Synopsis::Field z_missing("z", "missing");
+    Synopsis::ConstExpression one(1.0);
+    Synopsis::ComparatorExpression has_missing("==", &z_missing, &one);
+    Synopsis::BinaryLogicalExpression either("OR", &greater_sue, &has_missing);
+    Synopsis::ExistentialExpression exists_greater("z", &either);
+    Synopsis::BinaryLogicalExpression sfi_and_different("AND", &is_sfi, &different_id);
+    Synopsis::BinaryLogicalExpression application("AND", &sfi_and_different, &exists_greater);
+
+    // -(x.sue * 2 - y.size)
+    Synopsis::Field x_sue("x", "science_utility_estimate");
+    Synopsis::ConstExpression two(2.0);
+    Synopsis::BinaryExpression doubled("*", &x_sue, &two);
+    Synopsis::Field y_size("y", "size");
+    Synopsis::BinaryExpression difference("-", &doubled, &y_size);
+    Synopsis::MinusExpression adjustment(&difference);
+
+    // Expressions with invalid operators are evaluated as trees
+    Synopsis::BinaryLogicalExpression invalid("XOR", &is_sfi, &different_id);
+
+    // x.instrument_name != "OWLS", summing x.size
+    Synopsis::StringConstant owls("OWLS");
+    Synopsis::ComparatorExpression not_owls("!=", &x_instrument, &owls);
+    Synopsis::Field x_size("x", "size");
+
+    std::vector<std::string> xy = {"x", "y"};
+    std::vector<std::string> x = {"x"};
+    Synopsis::Rule rule(xy, &application, &adjustment, -1, &logger);
+    Synopsis::Rule limited_rule(xy, &application, &adjustment, 3, &logger);
+    Synopsis::Rule invalid_rule(x, &invalid, &x_sue, -1, &logger);
+    Synopsis::Constraint constraint(x, &not_owls, &x_size, 8.0, &logger);
+    Synopsis::Constraint count_constraint(x, &is_sfi, nullptr, 3.0, &logger);
+
+    rule.bind(table);
+    limited_rule.bind(table);
+    invalid_rule.bind(table);
+    constraint.bind(table);
+    count_constraint.bind(table);
+    EXPECT_TRUE(rule.is_compiled());
+    EXPECT_TRUE(limited_rule.is_compiled());
+    EXPECT_FALSE(invalid_rule.is_compiled());
+    EXPECT_TRUE(constraint.is_compiled());
+    EXPECT_TRUE(count_constraint.is_compiled());
+
+    for (size_t n = 0; n <= asdps.size(); n++) {
+        Synopsis::AsdpList queue(asdps.begin(), asdps.begin() + n);
+        Synopsis::AsdpRowList queue_rows(rows.begin(), rows.begin() + n);
+        EXPECT_DOUBLE_EQ(rule.apply(queue), rule.apply(table, queue_rows));
+        EXPECT_DOUBLE_EQ(limited_rule.apply(queue), limited_rule.apply(table, queue_rows));
+        EXPECT_EQ(invalid_rule.apply(queue), invalid_rule.apply(table, queue_rows));
+        EXPECT_EQ(constraint.apply(queue), constraint.apply(table, queue_rows));
+        EXPECT_EQ(count_constraint.apply(queue), count_constraint.apply(table, queue_rows));
+    }
+    EXPECT_NE(0.0, rule.apply(table, rows));
+
+    // Compiled rule sets from configuration files
+    for (auto &rules_file : {"dd_example_rules.json", "instrument_pair_rules.json"}) {
+        Synopsis::RuleSet rule_set = Synopsis::parse_rule_config(
+            get_absolute_data_path(rules_file), &logger
+        );
+        rule_set.bind(table);
+        for (int bin : {0, 7}) {
+            for (auto &bin_rule : rule_set.get_rules(bin)) {
+                EXPECT_TRUE(bin_rule.is_compiled());
+            }
+            for (auto &bin_constraint : rule_set.get_constraints(bin)) {
+                EXPECT_TRUE(bin_constraint.is_compiled());
+            }
+            EXPECT_EQ(rule_set.apply(bin, asdps), rule_set.apply(bin, table, rows));
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that constraints checked against running aggregates agree with
+// evaluation over the entire queue
+TEST(SynopsisTest, TestIncrementalConstraints) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 20, 2468, true);
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+
+    Synopsis::AsdpTable table;
+    Synopsis::AsdpRowList rows;
+    for (auto &msg : msgs) {
+        rows.push_back(table.add_data_product(msg));
+    }
+
+    // Sum of x.size where x.instrument_name == "OWLS" is less than 20
+    Synopsis::Field x_instrument("x", "instrument_name");
+    Synopsis::StringConstant owls("OWLS");
+    Synopsis::ComparatorExpression is_owls("==", &x_instrument, &owls);
+    Synopsis::Field x_size("x", "size");
+
+    // Count of x where x.instrument_name == "SFI" is less than 3
+    Synopsis::StringConstant sfi("SFI");
+    Synopsis::ComparatorExpression is_sfi("==", &x_instrument, &sfi);
+
+    // Count of x where EXISTS y: y.sue > x.sue is less than 8; the
+    // contribution of queued ASDPs changes as the queue grows
+    Synopsis::Field x_sue("x", "science_utility_estimate");
+    Synopsis::Field y_sue("y", "science_utility_estimate");
+    Synopsis::ComparatorExpression greater_sue(">", &y_sue, &x_sue);
+    Synopsis::ExistentialExpression exists_greater("y", &greater_sue);
+
+    std::vector<std::string> x = {"x"};
+    Synopsis::ConstraintList constraints = {
+        Synopsis::Constraint(x, &is_owls, &x_size, 20.0, &logger),
+        Synopsis::Constraint(x, &is_sfi, nullptr, 3.0, &logger),
+        Synopsis::Constraint(x, &exists_greater, nullptr, 8.0, &logger)
+    };
+    std::map<int, Synopsis::ConstraintList> constraint_map;
+    for (int n_constraints = 1; n_constraints <= 3; n_constraints++) {
+        Synopsis::ConstraintList bin_constraints(
+            constraints.begin(), constraints.begin() + n_constraints
+        );
+        constraint_map[n_constraints] = bin_constraints;
+    }
+    Synopsis::RuleSet rule_set(
+        {}, constraint_map, {}, {}, &logger
+    );
+    rule_set.bind(table);
+    auto bin_constraints = rule_set.get_constraints(3);
+    EXPECT_TRUE(bin_constraints[0].is_incremental());
+    EXPECT_TRUE(bin_constraints[1].is_incremental());
+    EXPECT_FALSE(bin_constraints[2].is_incremental());
+
+    for (int bin = 0; bin <= 3; bin++) {
+        Synopsis::QueueAggregates aggregates;
+        rule_set.init_aggregates(bin, aggregates);
+        Synopsis::AsdpRowList queue;
+        int n_violated = 0;
+        for (int row : rows) {
+            queue.push_back(row);
+            auto expected = rule_set.apply(bin, table, queue);
+            EXPECT_EQ(expected, rule_set.apply_candidate(
+                bin, table, queue, aggregates
+            ));
+            if (expected.first) {
+                rule_set.commit(bin, table, queue, aggregates);
+            } else {
+                n_violated++;
+                queue.pop_back();
+            }
+        }
+        if (bin > 0) { EXPECT_GT(n_violated, 0); }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that rule adjustments extended from running totals agree with
+// evaluation over the entire queue
+TEST(SynopsisTest, TestIncrementalRules) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 20, 1357, true);
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+
+    Synopsis::AsdpTable table;
+    Synopsis::AsdpRowList rows;
+    for (auto &msg : msgs) {
+        rows.push_back(table.add_data_product(msg));
+    }
+
+    // x.instrument_name == "SFI", adjusting by x.sue
+    Synopsis::Field x_instrument("x", "instrument_name");
+    Synopsis::StringConstant sfi("SFI");
+    Synopsis::ComparatorExpression is_sfi("==", &x_instrument, &sfi);
+    Synopsis::Field x_sue("x", "science_utility_estimate");
+
+    // x.instrument_name == y.instrument_name, adjusting by x.sue - y.size
+    Synopsis::Field y_instrument("y", "instrument_name");
+    Synopsis::ComparatorExpression same_instrument("==", &x_instrument, &y_instrument);
+    Synopsis::Field y_size("y", "size");
+    Synopsis::BinaryExpression difference("-", &x_sue, &y_size);
+
+    // EXISTS z: z.sue > x.sue; applications change as the queue grows
+    Synopsis::Field z_sue("z", "science_utility_estimate");
+    Synopsis::ComparatorExpression greater_sue(">", &z_sue, &x_sue);
+    Synopsis::ExistentialExpression exists_greater("z", &greater_sue);
+
+    std::vector<std::string> x = {"x"};
+    std::vector<std::string> xy = {"x", "y"};
+    Synopsis::RuleList rules = {
+        Synopsis::Rule(x, &is_sfi, &x_sue, -1, &logger),
+        Synopsis::Rule(x, &is_sfi, &x_sue, 3, &logger),
+        Synopsis::Rule(xy, &same_instrument, &difference, -1, &logger),
+        Synopsis::Rule(xy, &same_instrument, &difference, 40, &logger),
+        Synopsis::Rule(x, &exists_greater, &x_sue, 4, &logger),
+        Synopsis::Rule(x, &is_sfi, &x_sue, 0, &logger)
+    };
+    std::vector<bool> incremental = {true, true, true, true, false, false};
+    Synopsis::RuleSet rule_set({}, {}, rules, {}, &logger);
+    rule_set.bind(table);
+    auto bound_rules = rule_set.get_rules(0);
+    for (size_t i = 0; i < rules.size(); i++) {
+        EXPECT_EQ(incremental[i], bound_rules[i].is_incremental());
+    }
+
+    Synopsis::QueueAggregates aggregates;
+    rule_set.init_aggregates(0, aggregates);
+    Synopsis::AsdpRowList queue;
+    for (int row : rows) {
+        queue.push_back(row);
+        auto expected = rule_set.apply(0, table, queue);
+        auto applied = rule_set.apply_candidate(0, table, queue, aggregates);
+        EXPECT_TRUE(applied.first);
+        EXPECT_NEAR(expected.second, applied.second, 1e-9);
+        rule_set.commit(0, table, queue, aggregates);
+        for (size_t i = 0; i < rules.size(); i++) {
+            EXPECT_NEAR(
+                bound_rules[i].apply(table, queue), aggregates.rules[i], 1e-9
+            );
+        }
+    }
+
+    // Limits are respected once reached
+    EXPECT_EQ(3, aggregates.rule_applications[1]);
+    EXPECT_EQ(40, aggregates.rule_applications[3]);
+    EXPECT_EQ(4, aggregates.rule_applications[4]);
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that existential expressions answered with queue indexes agree with
+// scanning the queue
+TEST(SynopsisTest, TestIndexedExists) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 30, 9753, true);
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+
+    Synopsis::AsdpTable table;
+    Synopsis::AsdpRowList rows;
+    for (auto &msg : msgs) {
+        rows.push_back(table.add_data_product(msg));
+    }
+
+    // EXISTS y: (y.instrument_name == "SFI" AND x.context_image_id == y.id)
+    Synopsis::Field x_context("x", "context_image_id");
+    Synopsis::Field y_id("y", "id");
+    Synopsis::Field y_instrument("y", "instrument_name");
+    Synopsis::StringConstant sfi("SFI");
+    Synopsis::ComparatorExpression y_sfi("==", &y_instrument, &sfi);
+    Synopsis::ComparatorExpression context_match("==", &x_context, &y_id);
+    Synopsis::BinaryLogicalExpression paired("AND", &y_sfi, &context_match);
+    Synopsis::ExistentialExpression exists_pair("y", &paired);
+
+    // EXISTS y: (y.instrument_name == "SFI"), indexed by a constant
+    Synopsis::ExistentialExpression exists_sfi("y", &y_sfi);
+
+    // EXISTS y: (y.id == y.context_image_id OR y.instrument_name == "SFI"),
+    // neither of which can be indexed
+    Synopsis::Field y_context("y", "context_image_id");
+    Synopsis::ComparatorExpression self_match("==", &y_id, &y_context);
+    Synopsis::BinaryLogicalExpression either("OR", &self_match, &y_sfi);
+    Synopsis::ExistentialExpression exists_either("y", &either);
+
+    Synopsis::Field x_sue("x", "science_utility_estimate");
+    std::vector<std::string> x = {"x"};
+    Synopsis::RuleList rules = {
+        Synopsis::Rule(x, &exists_pair, &x_sue, -1, &logger),
+        Synopsis::Rule(x, &exists_sfi, &x_sue, -1, &logger),
+        Synopsis::Rule(x, &exists_either, &x_sue, -1, &logger)
+    };
+    Synopsis::RuleSet rule_set({}, {}, rules, {}, &logger);
+    rule_set.bind(table);
+    auto bound_rules = rule_set.get_rules(0);
+    std::vector<int> expected_slots = {
+        table.find_field("id"), table.find_field("instrument_name")
+    };
+    for (size_t i = 0; i < bound_rules.size(); i++) {
+        std::vector<int> slots;
+        bound_rules[i].add_index_slots(slots);
+        if (i < expected_slots.size()) {
+            EXPECT_EQ(std::vector<int>({expected_slots[i]}), slots);
+        } else {
+            EXPECT_TRUE(slots.empty());
+        }
+    }
+
+    // Matches are found both in the indexed prefix and the candidate
+    Synopsis::QueueAggregates aggregates;
+    rule_set.init_aggregates(0, aggregates);
+    Synopsis::AsdpRowList queue;
+    for (auto it = rows.rbegin(); it != rows.rend(); ++it) {
+        queue.push_back(*it);
+        EXPECT_EQ(
+            rule_set.apply(0, table, queue),
+            rule_set.apply_candidate(0, table, queue, aggregates)
+        );
+        rule_set.commit(0, table, queue, aggregates);
+        EXPECT_EQ((int)queue.size(), aggregates.index.size());
+    }
+    EXPECT_NE(0.0, bound_rules[0].apply(table, queue, &aggregates.index));
+
+    // Parsed rules pairing instruments are indexed by ASDP id
+    Synopsis::RuleSet pair_rules = Synopsis::parse_rule_config(
+        get_absolute_data_path("instrument_pair_rules.json"), &logger
+    );
+    pair_rules.bind(table);
+    std::vector<int> slots;
+    for (auto &rule : pair_rules.get_rules(0)) {
+        rule.add_index_slots(slots);
+    }
+    EXPECT_EQ(std::vector<int>({table.find_field("id")}), slots);
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that precomputed similarity matrices match pairwise similarities
+TEST(SynopsisTest, TestSimilarityMatrix) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 30, 4321);
+
+    std::string source_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::ifstream source(source_path);
+    std::string config((std::istreambuf_iterator<char>(source)),
+        std::istreambuf_iterator<char>());
+
+    // Each kernel's pairwise and block forms agree
+    for (std::string kernel : {"gaussian", "cosine", "laplacian", "mahalanobis_diagonal"}) {
+        std::string modified = config;
+        std::string type = "\"gaussian\"";
+        std::string sigma = "\"sigma\": 1.34289567767";
+        std::string params = (kernel == "mahalanobis_diagonal") ?
+            "\"background_avg\": 0.5, \"unique_masses\": 2.0" : sigma;
+        for (size_t pos = modified.find(type); pos != std::string::npos;
+                pos = modified.find(type, pos + 1)) {
+            modified.replace(pos, type.size(), "\"" + kernel + "\"");
+        }
+        for (size_t pos = modified.find(sigma); pos != std::string::npos;
+                pos = modified.find(sigma, pos + params.size())) {
+            modified.replace(pos, sigma.size(), params);
+        }
+        std::string config_path = "/tmp/synopsis_test_kernel_" + kernel + ".json";
+        std::ofstream(config_path) << modified;
+
+        Synopsis::Similarity similarity = Synopsis::parse_similarity_config(
+            config_path, &logger
+        );
+
+        Synopsis::AsdpTable table;
+        Synopsis::DpDbMsg msg;
+        std::map<int, Synopsis::AsdpRowList> binned_rows;
+        std::vector<Synopsis::AsdpEntry> asdps;
+        for (int dp_id : db.list_data_product_ids()) {
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(dp_id, msg));
+            Synopsis::AsdpEntry asdp;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, Synopsis::_populate_asdp(msg, asdp));
+            asdps.push_back(asdp);
+            binned_rows[msg.get_priority_bin()].push_back(
+                table.add_data_product(msg)
+            );
+        }
+        similarity.bind(table);
+
+        for (auto &entry : binned_rows) {
+            int bin = entry.first;
+            Synopsis::AsdpRowList &rows = entry.second;
+            auto functions = similarity.get_functions(bin, table);
+            size_t bytes = Synopsis::SimilarityMatrix::memory_requirement(
+                table, rows, functions
+            );
+            EXPECT_GT(bytes, 0);
+            std::vector<double> memory(bytes / sizeof(double));
+
+            Synopsis::SimilarityMatrix matrix;
+            matrix.compute(table, rows, functions, memory.data());
+            int n_rows = rows.size();
+            for (int i = 0; i < n_rows; i++) {
+                for (int j = 0; j < n_rows; j++) {
+                    EXPECT_EQ(
+                        similarity.get_similarity(bin, asdps[rows[i]], asdps[rows[j]]),
+                        matrix.get_similarity(i, j)
+                    );
+                    EXPECT_GE(matrix.get_similarity(i, j), 0.0);
+                    EXPECT_LE(matrix.get_similarity(i, j), 1.0);
+                }
+            }
+        }
+    }
+
+    // A budget that is not provided to init is an error
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+        Synopsis::INCREMENTAL_GREEDY, 1024
+    );
+    EXPECT_EQ(1024, planner.memory_requirement());
+    EXPECT_EQ(Synopsis::Status::FAILURE, planner.init(0, NULL, &logger));
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that similarity kernels give expected values, and that compile-time
+// specializations and block forms match the runtime pairwise form
+TEST(SynopsisTest, TestSimilarityKernels) {
+    EXPECT_EQ(Synopsis::GAUSSIAN_KERNEL, Synopsis::find_kernel("gaussian"));
+    EXPECT_EQ(Synopsis::COSINE_KERNEL, Synopsis::find_kernel("cosine"));
+    EXPECT_EQ(Synopsis::LAPLACIAN_KERNEL, Synopsis::find_kernel("laplacian"));
+    EXPECT_EQ(
+        Synopsis::MAHALANOBIS_DIAGONAL_KERNEL,
+        Synopsis::find_kernel("mahalanobis_diagonal")
+    );
+    EXPECT_EQ(Synopsis::UNKNOWN_KERNEL, Synopsis::find_kernel("unknown"));
+
+    std::vector<double> inv_variances(256, 0.5);
+    Synopsis::KernelParams params = {2.0, inv_variances.data()};
+    double x[] = {1.0, 2.0};
+    double y[] = {2.0, 4.0};
+    double z[] = {-2.0, 1.0};
+    auto gaussian = Synopsis::specialize_kernel(Synopsis::GAUSSIAN_KERNEL, 2);
+    auto cosine = Synopsis::specialize_kernel(Synopsis::COSINE_KERNEL, 2);
+    auto laplacian = Synopsis::specialize_kernel(Synopsis::LAPLACIAN_KERNEL, 2);
+    auto mahalanobis = Synopsis::specialize_kernel(
+        Synopsis::MAHALANOBIS_DIAGONAL_KERNEL, 2
+    );
+    EXPECT_DOUBLE_EQ(exp(-5.0 / 4.0), gaussian(x, y, 2, params));
+    EXPECT_DOUBLE_EQ(1.0, cosine(x, y, 2, params));
+    EXPECT_DOUBLE_EQ(0.0, cosine(x, z, 2, params));
+    EXPECT_DOUBLE_EQ(exp(-3.0 / 2.0), laplacian(x, y, 2, params));
+    EXPECT_DOUBLE_EQ(exp(-2.5), mahalanobis(x, y, 2, params));
+    EXPECT_EQ(0.0, Synopsis::specialize_kernel(
+        Synopsis::UNKNOWN_KERNEL, 2)(x, y, 2, params)
+    );
+
+    // Opposite and zero vectors have zero cosine similarity
+    double neg_x[] = {-1.0, -2.0};
+    double zero[] = {0.0, 0.0};
+    EXPECT_EQ(0.0, cosine(x, neg_x, 2, params));
+    EXPECT_EQ(0.0, cosine(x, zero, 2, params));
+
+    std::mt19937 rng(1357);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<Synopsis::SimilarityKernel> kernels = {
+        Synopsis::GAUSSIAN_KERNEL, Synopsis::COSINE_KERNEL,
+        Synopsis::LAPLACIAN_KERNEL, Synopsis::MAHALANOBIS_DIAGONAL_KERNEL
+    };
+    for (int n_dims : {1, 3, 5, 128, 130}) {
+        int n = 6;
+        std::vector<double> descriptors(n * n_dims);
+        for (auto &value : descriptors) { value = uniform(rng); }
+
+        // Pairwise forms take descriptors in row-major order
+        std::vector<double> rows(n * n_dims);
+        for (int i = 0; i < n; i++) {
+            for (int d = 0; d < n_dims; d++) {
+                rows[(i * n_dims) + d] = descriptors[(d * n) + i];
+            }
+        }
+
+        for (auto kernel : kernels) {
+            auto specialized = Synopsis::specialize_kernel(kernel, n_dims);
+            auto runtime = Synopsis::specialize_kernel(kernel, 0);
+            std::vector<double> block(n * n);
+            switch (kernel) {
+                case Synopsis::GAUSSIAN_KERNEL:
+                    Synopsis::kernel_similarity_block<Synopsis::GAUSSIAN_KERNEL>(
+                        descriptors.data(), n, n_dims, params, block.data()
+                    );
+                    break;
+                case Synopsis::COSINE_KERNEL:
+                    Synopsis::kernel_similarity_block<Synopsis::COSINE_KERNEL>(
+                        descriptors.data(), n, n_dims, params, block.data()
+                    );
+                    break;
+                case Synopsis::LAPLACIAN_KERNEL:
+                    Synopsis::kernel_similarity_block<Synopsis::LAPLACIAN_KERNEL>(
+                        descriptors.data(), n, n_dims, params, block.data()
+                    );
+                    break;
+                default:
+                    Synopsis::kernel_similarity_block<Synopsis::MAHALANOBIS_DIAGONAL_KERNEL>(
+                        descriptors.data(), n, n_dims, params, block.data()
+                    );
+                    break;
+            }
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    const double *a = &rows[i * n_dims];
+                    const double *b = &rows[j * n_dims];
+                    double expected = runtime(a, b, n_dims, params);
+                    EXPECT_EQ(expected, specialized(a, b, n_dims, params));
+                    EXPECT_EQ(expected, block[(i * n) + j]);
+                }
+            }
+        }
+    }
+}
+
+
+// Test that k-d tree searches match a brute-force search, and that the planner
+// finds identical maximum similarities with an exact index
+TEST(SynopsisTest, TestMaxSimilarityIndex) {
+    std::mt19937 rng(2468);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    auto random_point = [&]() {
+        std::vector<double> point;
+        for (int d = 0; d < 3; d++) { point.push_back(uniform(rng)); }
+        return point;
+    };
+
+    Synopsis::KdTree tree(3);
+    std::vector<std::vector<double>> points;
+    EXPECT_TRUE(std::isinf(tree.nearest_sq_dist(random_point())));
+    for (int i = 0; i < 200; i++) {
+        std::vector<double> query = random_point();
+        if (!points.empty()) {
+            double expected = INFINITY;
+            for (auto &point : points) {
+                expected = std::min(expected, Synopsis::_sq_euclidean_dist(query, point));
+            }
+            EXPECT_EQ(expected, tree.nearest_sq_dist(query));
+            double approximate = tree.nearest_sq_dist(query, 0.5);
+            EXPECT_GE(approximate, expected);
+            EXPECT_LE(approximate, 1.5 * 1.5 * expected);
+        }
+        points.push_back(random_point());
+        tree.insert(points.back());
+    }
+    EXPECT_EQ(200, tree.size());
+
+    // Index searches are only used for Gaussian similarities
+    Synopsis::SimilarityFunction unknown({"x"}, {1.0}, "unknown", {}, nullptr);
+    unknown.set_max_similarity_search(Synopsis::EXACT_INDEX_SEARCH);
+    EXPECT_FALSE(unknown.is_indexed());
+
+    std::string source_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::ifstream source(source_path);
+    std::string config((std::istreambuf_iterator<char>(source)),
+        std::istreambuf_iterator<char>());
+    auto with_index = [&](std::string index, std::string path) {
+        std::string modified = config;
+        std::string type = "\"similarity_type\": \"gaussian\",";
+        std::string replacement = type + " \"max_similarity_index\": \"" +
+            index + "\", \"max_similarity_epsilon\": 0.5,";
+        for (size_t pos = modified.find(type); pos != std::string::npos;
+                pos = modified.find(type, pos + replacement.size())) {
+            modified.replace(pos, type.size(), replacement);
+        }
+        std::ofstream(path) << modified;
+        return path;
+    };
+    std::string exact_path = with_index(
+        "exact", "/tmp/synopsis_test_exact_index.json"
+    );
+    std::string approximate_path = with_index(
+        "approximate", "/tmp/synopsis_test_approximate_index.json"
+    );
+
+    Synopsis::StdLogger logger;
+    Synopsis::Similarity similarity = Synopsis::parse_similarity_config(
+        approximate_path, &logger
+    );
+    EXPECT_FALSE(similarity.get_index(0).empty());
+
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    for (bool quantize : {false, true}) {
+        Synopsis::SqliteASDPDB db(":memory:");
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+        populate_random_asdps(db, 60, 8642, quantize);
+
+        std::vector<int> expected = prioritize_with_engine(
+            db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, source_path
+        );
+        EXPECT_GT(expected.size(), 0);
+        EXPECT_EQ(expected, prioritize_with_engine(
+            db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, exact_path
+        ));
+        EXPECT_EQ(expected, prioritize_with_engine(
+            db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, exact_path, 0, 4, 2
+        ));
+
+        // Approximate maximum similarities may change the ordering
+        std::vector<int> approximate = prioritize_with_engine(
+            db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, approximate_path
+        );
+        EXPECT_GT(approximate.size(), 0);
+        std::set<int> unique(approximate.begin(), approximate.end());
+        EXPECT_EQ(approximate.size(), unique.size());
+
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    }
+}
+
+
+// Test that planner ASDP tables are drawn from a preallocated scratch arena
+TEST(SynopsisTest, TestScratchArena) {
+    // Arena bookkeeping and the allocator adapter
+    std::vector<double> block(32);
+    Synopsis::MemoryArena arena(block.size() * sizeof(double), block.data());
+    EXPECT_NE(nullptr, arena.allocate(10));
+    size_t mark = arena.bytes_used();
+    EXPECT_EQ(10, mark);
+    EXPECT_NE(nullptr, arena.allocate(40));
+    arena.rewind(mark);
+    EXPECT_EQ(mark, arena.bytes_used());
+    EXPECT_EQ(56, arena.bytes_high_water());
+    {
+        Synopsis::ArenaAllocator<int> allocator(&arena);
+        Synopsis::ArenaVector<int> values(allocator);
+        values.reserve(8);
+        EXPECT_TRUE(arena.contains(values.data()));
+        EXPECT_EQ(0, arena.num_overflows());
+
+        // Growth beyond the block falls back to the heap
+        for (int i = 0; i < 100; i++) { values.push_back(i); }
+        EXPECT_FALSE(arena.contains(values.data()));
+        EXPECT_GT(arena.num_overflows(), 0);
+        EXPECT_EQ(99, values.back());
+    }
+    arena.reset(block.size() * sizeof(double), block.data());
+    EXPECT_EQ(0, arena.bytes_high_water());
+    EXPECT_EQ(0, arena.num_overflows());
+
+    // Prioritization with scratch memory matches the heap-allocated tables
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 40, 2468);
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+
+    for (auto engine : {Synopsis::INCREMENTAL_GREEDY, Synopsis::LAZY_GREEDY}) {
+        std::vector<int> expected = prioritize_with_engine(
+            db, engine, rules_path, config_path
+        );
+        EXPECT_GT(expected.size(), 0);
+
+        for (size_t scratch_bytes : {64, 1 << 16}) {
+            Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine, 512);
+            planner.set_database(&db);
+            planner.set_clock(&clock);
+            planner.set_scratch_memory(scratch_bytes);
+            EXPECT_EQ(512 + scratch_bytes, planner.memory_requirement());
+            EXPECT_EQ(Synopsis::Status::FAILURE, planner.init(
+                512, block.data(), &logger
+            ));
+            std::vector<double> memory(planner.memory_requirement() / sizeof(double));
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(
+                planner.memory_requirement(), memory.data(), &logger
+            ));
+
+            std::vector<int> prioritized_list;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                rules_path, config_path, 100, prioritized_list
+            ));
+            EXPECT_EQ(expected, prioritized_list);
+            size_t high_water = planner.scratch_high_water();
+            size_t overflows = planner.scratch_overflows();
+            EXPECT_GT(high_water, 0);
+            if (scratch_bytes < 1024) {
+                EXPECT_GT(overflows, 0);
+            } else {
+                EXPECT_EQ(0, overflows);
+            }
+
+            // The arena is reused by later calls
+            prioritized_list.clear();
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                rules_path, config_path, 100, prioritized_list
+            ));
+            EXPECT_EQ(expected, prioritized_list);
+            EXPECT_EQ(high_water, planner.scratch_high_water());
+            if (overflows == 0) {
+                EXPECT_EQ(0, planner.scratch_overflows());
+            }
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+        }
+    }
+
+    // The application accounts for the planner's memory
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner heap_planner;
+    Synopsis::Application heap_app(&db, &heap_planner, &logger, &clock);
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+        Synopsis::INCREMENTAL_GREEDY, 1024
+    );
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    EXPECT_EQ(heap_app.memory_requirement() + 1024, app.memory_requirement());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that cached configurations are reused until their files change, and
+// that cached similarities are kept only for unchanged ASDPs
+TEST(SynopsisTest, TestConfigCache) {
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 30, 1357);
+
+    std::string source_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::ifstream source(source_path);
+    std::string config((std::istreambuf_iterator<char>(source)),
+        std::istreambuf_iterator<char>());
+    std::string config_path = "/tmp/synopsis_test_config_cache.json";
+    std::ofstream(config_path) << config;
+
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    planner.set_database(&db);
+    planner.set_clock(&clock);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+    std::vector<int> expected = prioritize_with_engine(
+        db, Synopsis::EXHAUSTIVE_GREEDY, "", config_path
+    );
+    for (int i = 0; i < 2; i++) {
+        std::vector<int> prioritized_list;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+            "", config_path, 100, prioritized_list
+        ));
+        EXPECT_EQ(expected, prioritized_list);
+    }
+
+    // Rewriting the file (here, with a different size) invalidates the cache
+    std::string modified = config;
+    std::string default_alpha = "\"default\": 1.0";
+    size_t alpha = modified.find(default_alpha);
+    ASSERT_NE(std::string::npos, alpha);
+    modified.replace(alpha, default_alpha.size(), "\"default\": 0.25");
+    std::ofstream(config_path) << modified;
+    expected = prioritize_with_engine(
+        db, Synopsis::EXHAUSTIVE_GREEDY, "", config_path
+    );
+    std::vector<int> prioritized_list;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+        "", config_path, 100, prioritized_list
+    ));
+    EXPECT_EQ(expected, prioritized_list);
+    planner.clear_config_cache();
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    std::remove(config_path.c_str());
+
+    // Similarities involving an ASDP are dropped when its descriptor changes
+    Synopsis::Similarity similarity = Synopsis::parse_similarity_config(
+        source_path, &logger
+    );
+    std::map<int, Synopsis::AsdpList> binned_asdps;
+    Synopsis::DpDbMsg msg;
+    for (int dp_id : db.list_data_product_ids()) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(dp_id, msg));
+        Synopsis::AsdpEntry asdp;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, Synopsis::_populate_asdp(msg, asdp));
+        binned_asdps[msg.get_priority_bin()].push_back(asdp);
+    }
+    auto compute_all = [&]() {
+        for (auto &entry : binned_asdps) {
+            for (auto &asdp1 : entry.second) {
+                for (auto &asdp2 : entry.second) {
+                    similarity.get_similarity(entry.first, asdp1, asdp2);
+                }
+            }
+        }
+    };
+    similarity.refresh_cache(binned_asdps);
+    compute_all();
+    size_t n_cached = similarity.cache_size();
+    EXPECT_GT(n_cached, 0);
+    similarity.refresh_cache(binned_asdps);
+    EXPECT_EQ(n_cached, similarity.cache_size());
+
+    Synopsis::AsdpEntry *changed = nullptr;
+    for (auto &asdp : binned_asdps[0]) {
+        if (asdp["instrument_name"].get_string_value() == "OWLS") {
+            changed = &asdp;
+            break;
+        }
+    }
+    ASSERT_NE(nullptr, changed);
+    (*changed)["background_avg"] = Synopsis::DpMetadataValue(
+        (*changed)["background_avg"].get_float_value() + 1.0
+    );
+    similarity.refresh_cache(binned_asdps);
+    EXPECT_LT(similarity.cache_size(), n_cached);
+    for (auto &asdp : binned_asdps[0]) {
+        Synopsis::Similarity fresh = Synopsis::parse_similarity_config(
+            source_path, &logger
+        );
+        EXPECT_EQ(
+            fresh.get_similarity(0, *changed, asdp),
+            similarity.get_similarity(0, *changed, asdp)
+        );
+    }
+    compute_all();
+    EXPECT_EQ(n_cached, similarity.cache_size());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that a parameter sweep gives, for each variant, the ordering of a
+// prioritization with the variant's configuration files
+TEST(SynopsisTest, TestSweep) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 40, 24680);
+
+    std::vector<Synopsis::SweepVariant> variants(5);
+    variants[1].default_alpha = 0.0;
+    variants[2].alphas[7] = 0.0;
+    variants[3].sigma = 0.3;
+    variants[4].rule_configuration_id = "";
+    variants[4].sigma = 2.0;
+    variants[4].default_alpha = 0.75;
+
+    // Expected orderings are those of full prioritizations with rewritten
+    // similarity configurations
+    std::ifstream source(config_path);
+    nlohmann::json base = nlohmann::json::parse(source);
+    std::vector<std::vector<int>> expected;
+    std::string variant_path = "/tmp/synopsis_test_sweep.json";
+    for (auto &variant : variants) {
+        nlohmann::json config = base;
+        if (variant.default_alpha >= 0.0) {
+            config["alphas"]["default"] = variant.default_alpha;
+        }
+        for (auto &alpha : variant.alphas) {
+            config["alphas"][std::to_string(alpha.first)] = alpha.second;
+        }
+        if (variant.sigma > 0.0) {
+            for (auto &bin : config["functions"]) {
+                for (auto &function : bin) {
+                    function["function"]["similarity_parameters"]["sigma"] = variant.sigma;
+                }
+            }
+        }
+        std::ofstream(variant_path) << config.dump();
+        expected.push_back(prioritize_with_engine(
+            db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, variant_path
+        ));
+    }
+    std::remove(variant_path.c_str());
+    EXPECT_NE(expected[0], expected[1]);
+    EXPECT_NE(expected[0], expected[3]);
+
+    // The sweep's base rule configuration is replaced by a variant's own
+    variants.push_back(Synopsis::SweepVariant());
+    variants.back().rule_configuration_id = get_absolute_data_path("instrument_pair_rules.json");
+    expected.push_back(prioritize_with_engine(
+        db, Synopsis::EXHAUSTIVE_GREEDY,
+        variants.back().rule_configuration_id, config_path
+    ));
+
+    for (auto engine : {Synopsis::INCREMENTAL_GREEDY, Synopsis::LAZY_GREEDY}) {
+        for (int n_threads : {1, 3}) {
+            Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+            planner.set_database(&db);
+            planner.set_clock(&clock);
+            planner.set_num_threads(n_threads);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+            std::vector<std::vector<int>> prioritized_lists;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.sweep(
+                rules_path, config_path, variants, 100, prioritized_lists
+            ));
+            EXPECT_EQ(expected, prioritized_lists);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+/*
+ * Planner configuration for plan replays
+ */
+struct ReplayConfig {
+    std::string name;
+    Synopsis::MmrEngine engine;
+    int n_threads;
+    size_t similarity_memory_bytes;
+};
+
+
+/*
+ * Ordering, final SUEs, and fastest processing time of replayed plans
+ */
+struct ReplayResult {
+    std::vector<int> ordering;
+    std::vector<double> final_sues;
+    double time_sec;
+};
+
+
+/*
+ * Prioritizes a database repeatedly with one planner configuration, checking
+ * that each repetition produces the same plan
+ */
+ReplayResult replay_plan(
+    Synopsis::ASDPDB &db, const ReplayConfig &config,
+    std::string rules_path, std::string similarity_path, int n_repeats
+) {
+    Synopsis::StdLogger logger;
+    logger.set_level(Synopsis::LogType::WARN);
+    SteadyClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+        config.engine, config.similarity_memory_bytes
+    );
+    planner.set_database(&db);
+    planner.set_clock(&clock);
+    planner.set_num_threads(config.n_threads);
+    planner.set_stats_enabled(true);
+    std::vector<double> memory(config.similarity_memory_bytes / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(
+        config.similarity_memory_bytes, memory.data(), &logger
+    ));
+
+    ReplayResult result;
+    for (int r = 0; r < n_repeats; r++) {
+        std::vector<int> ordering;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+            rules_path, similarity_path, 100, ordering
+        ));
+        const Synopsis::PlannerStats &stats = planner.get_stats();
+        std::vector<double> final_sues;
+        for (auto &bin_stats : stats.bins) {
+            final_sues.insert(final_sues.end(),
+                bin_stats.final_sues.begin(), bin_stats.final_sues.end()
+            );
+        }
+        EXPECT_EQ(ordering.size(), final_sues.size());
+        if (r == 0) {
+            result.ordering = ordering;
+            result.final_sues = final_sues;
+            result.time_sec = stats.total_time_sec;
+        } else {
+            EXPECT_EQ(result.ordering, ordering) << config.name;
+            EXPECT_EQ(result.final_sues, final_sues) << config.name;
+            result.time_sec = std::min(result.time_sec, stats.total_time_sec);
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    return result;
+}
+
+
+/*
+ * Replays a workload with each planner configuration, diffs each plan
+ * against that of the first configuration (orderings exactly, final SUEs
+ * within a tolerance), and reports each configuration's speedup
+ */
+void expect_same_plans(
+    std::string workload, Synopsis::ASDPDB &db,
+    const std::vector<ReplayConfig> &configs,
+    std::string rules_path, std::string similarity_path,
+    double tolerance = 1e-9, int n_repeats = 2
+) {
+    std::vector<ReplayResult> results;
+    for (auto &config : configs) {
+        results.push_back(replay_plan(
+            db, config, rules_path, similarity_path, n_repeats
+        ));
+    }
+
+    const ReplayResult &reference = results[0];
+    std::printf("%s: %lu ASDPs prioritized\n", workload.c_str(),
+        (unsigned long)reference.ordering.size());
+    for (size_t c = 0; c < configs.size(); c++) {
+        const ReplayResult &result = results[c];
+        EXPECT_EQ(reference.ordering, result.ordering)
+            << workload << ": " << configs[c].name;
+        size_t n = std::min(reference.final_sues.size(), result.final_sues.size());
+        for (size_t i = 0; i < n; i++) {
+            EXPECT_NEAR(reference.final_sues[i], result.final_sues[i], tolerance)
+                << workload << ": " << configs[c].name << " at position " << i;
+        }
+        double speedup = (result.time_sec > 0.0) ?
+            (reference.time_sec / result.time_sec) : 0.0;
+        std::printf("  %-28s %10.6f s %8.2fx\n", configs[c].name.c_str(),
+            result.time_sec, speedup);
+    }
+}
+
+
+/*
+ * Prioritizes a database with a planner from the registry
+ */
+std::vector<int> prioritize_with_planner(
+    Synopsis::ASDPDB &db, std::string planner_name,
+    std::string rules_path, std::string similarity_path
+) {
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    std::unique_ptr<Synopsis::DownlinkPlanner> planner = \
+        Synopsis::create_planner(planner_name);
+    EXPECT_NE(nullptr, planner.get());
+    std::vector<int> prioritized_list;
+    if (!planner) { return prioritized_list; }
+    planner->set_database(&db);
+    planner->set_clock(&clock);
+    EXPECT_EQ(0, (int)planner->memory_requirement());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner->init(0, NULL, &logger));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner->prioritize(
+        rules_path, similarity_path, 100, prioritized_list
+    ));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner->deinit());
+    return prioritized_list;
+}
+
+
+// Test that planners are created by name, and that the baseline planner
+// orders each bin by utility per byte while honoring constraints
+TEST(SynopsisTest, TestPlannerRegistry) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+
+    std::vector<std::string> names = Synopsis::list_planners();
+    for (auto name : {"baseline", "mmr", "mmr_incremental", "mmr_lazy"}) {
+        EXPECT_NE(names.end(), std::find(names.begin(), names.end(), name));
+    }
+    EXPECT_EQ(nullptr, Synopsis::create_planner("unknown").get());
+    EXPECT_EQ(Synopsis::Status::FAILURE, Synopsis::register_planner(
+        "", []() { return Synopsis::create_planner("baseline"); }
+    ));
+    EXPECT_EQ(Synopsis::Status::FAILURE, Synopsis::register_planner(
+        "custom", nullptr
+    ));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, Synopsis::register_planner(
+        "custom", []() {
+            return std::unique_ptr<Synopsis::DownlinkPlanner>(
+                new Synopsis::MaxMarginalRelevanceDownlinkPlanner(
+                    Synopsis::LAZY_GREEDY
+                )
+            );
+        }
+    ));
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 60, 97531);
+    for (int asdp_id = 3; asdp_id <= 60; asdp_id += 7) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_downlink_state(
+            asdp_id, Synopsis::DownlinkState::TRANSMITTED
+        ));
+    }
+
+    // Registered MMR planners match the engines they wrap
+    std::vector<int> expected = prioritize_with_engine(
+        db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, config_path
+    );
+    for (auto name : {"mmr", "mmr_incremental", "mmr_lazy", "custom"}) {
+        EXPECT_EQ(expected, prioritize_with_planner(
+            db, name, rules_path, config_path
+        ));
+    }
+
+    // The baseline takes each bin in order of utility per byte, skipping
+    // OWLS ASDPs once the bin's constraint admits no more; the MMR planner
+    // also fills the constraint
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.list_undownlinked_data_products(msgs));
+    std::map<int, std::vector<Synopsis::DpDbMsg>> binned;
+    for (auto &msg : msgs) {
+        if (msg.get_downlink_state() != Synopsis::DownlinkState::TRANSMITTED) {
+            binned[msg.get_priority_bin()].push_back(msg);
+        }
+    }
+    int n_owls = 0;
+    Synopsis::DpDbMsg msg;
+    for (int asdp_id : expected) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(asdp_id, msg));
+        if ((msg.get_priority_bin() == 0) &&
+                (msg.get_instrument_name() == "OWLS")) {
+            n_owls++;
+        }
+    }
+    EXPECT_GT(n_owls, 0);
+    std::vector<int> baseline_expected;
+    for (auto &entry : binned) {
+        auto &bin_msgs = entry.second;
+        std::stable_sort(bin_msgs.begin(), bin_msgs.end(),
+            [](const Synopsis::DpDbMsg &a, const Synopsis::DpDbMsg &b) {
+                return (a.get_science_utility_estimate() / a.get_dp_size()) >
+                    (b.get_science_utility_estimate() / b.get_dp_size());
+            }
+        );
+        int n_bin_owls = 0;
+        for (auto &bin_msg : bin_msgs) {
+            if ((entry.first == 0) && (bin_msg.get_instrument_name() == "OWLS")) {
+                if (n_bin_owls == n_owls) { continue; }
+                n_bin_owls++;
+            }
+            baseline_expected.push_back(bin_msg.get_dp_id());
+        }
+    }
+    EXPECT_NE(expected, baseline_expected);
+    EXPECT_EQ(baseline_expected, prioritize_with_planner(
+        db, "baseline", rules_path, config_path
+    ));
+
+    // Final SUEs are not discounted
+    Synopsis::LinuxClock clock;
+    Synopsis::BaselineDownlinkPlanner baseline;
+    baseline.set_database(&db);
+    baseline.set_clock(&clock);
+    baseline.set_stats_enabled(true);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, baseline.init(0, NULL, &logger));
+    std::vector<int> prioritized_list;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, baseline.prioritize(
+        rules_path, config_path, 100, prioritized_list
+    ));
+    const Synopsis::PlannerStats &stats = baseline.get_stats();
+    EXPECT_EQ(msgs.size(), stats.n_loaded);
+    ASSERT_EQ(2, (int)stats.bins.size());
+    size_t position = 0;
+    for (auto &bin_stats : stats.bins) {
+        EXPECT_EQ(bin_stats.n_prioritized, (int)bin_stats.final_sues.size());
+        for (double final_sue : bin_stats.final_sues) {
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(
+                prioritized_list[position++], msg
+            ));
+            EXPECT_EQ(msg.get_science_utility_estimate(), final_sue);
+        }
+    }
+    EXPECT_EQ(prioritized_list.size(), position);
+    EXPECT_GT(stats.bins[0].n_constraint_rejections, 0);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, baseline.deinit());
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that the MMR planner falls back to the baseline planner when its
+// estimated processing time exceeds the time limit
+TEST(SynopsisTest, TestPlannerFallback) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 40, 8642);
+
+    std::vector<int> mmr_expected = prioritize_with_engine(
+        db, Synopsis::LAZY_GREEDY, rules_path, config_path
+    );
+    std::vector<int> baseline_expected = prioritize_with_planner(
+        db, "baseline", rules_path, config_path
+    );
+    ASSERT_NE(mmr_expected, baseline_expected);
+
+    // With 40 ASDPs, the lazy engine's estimate is at most 820 evaluations
+    for (double sec_per_evaluation : {1e-6, 1.0}) {
+        bool fallback = (sec_per_evaluation * 820 > 100);
+        Synopsis::LinuxClock clock;
+        Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(
+            Synopsis::LAZY_GREEDY
+        );
+        planner.set_database(&db);
+        planner.set_clock(&clock);
+        planner.set_stats_enabled(true);
+        planner.set_fallback_planner(
+            Synopsis::create_planner("baseline"), sec_per_evaluation
+        );
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+        std::vector<int> prioritized_list;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+            rules_path, config_path, 100, prioritized_list
+        ));
+        EXPECT_EQ(fallback, planner.used_fallback());
+        EXPECT_EQ(
+            fallback ? baseline_expected : mmr_expected, prioritized_list
+        );
+        EXPECT_EQ(2, (int)planner.get_stats().bins.size());
+
+        // Budgeted manifests are prefixes of the plan that would be used
+        prioritized_list.clear();
+        int cut_asdp_id;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize_with_budget(
+            rules_path, config_path, 100, -1, 5, prioritized_list, cut_asdp_id
+        ));
+        EXPECT_EQ(fallback, planner.used_fallback());
+        const std::vector<int> &full = fallback ?
+            baseline_expected : mmr_expected;
+        EXPECT_EQ(std::vector<int>(full.begin(), full.begin() + 5), prioritized_list);
+        EXPECT_EQ(full[5], cut_asdp_id);
+
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+}
+
+
+// Test that planner engines replay identical plans on the fixture databases
+// and on synthetic workloads, reporting their relative speeds
+TEST(SynopsisTest, TestPlanReplay) {
+    std::string dd_rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string dd_config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::string pair_rules_path = get_absolute_data_path("instrument_pair_rules.json");
+    size_t memory_bytes = 1 << 20;
+    std::vector<ReplayConfig> configs = {
+        {"exhaustive", Synopsis::EXHAUSTIVE_GREEDY, 1, 0},
+        {"exhaustive, 4 threads", Synopsis::EXHAUSTIVE_GREEDY, 4, 0},
+        {"incremental", Synopsis::INCREMENTAL_GREEDY, 1, 0},
+        {"incremental, matrix", Synopsis::INCREMENTAL_GREEDY, 1, memory_bytes},
+        {"incremental, 4 threads", Synopsis::INCREMENTAL_GREEDY, 4, memory_bytes},
+        {"lazy", Synopsis::LAZY_GREEDY, 1, 0},
+        {"lazy, matrix", Synopsis::LAZY_GREEDY, 1, memory_bytes},
+        {"lazy, 4 threads", Synopsis::LAZY_GREEDY, 4, memory_bytes}
+    };
+
+    Synopsis::StdLogger logger;
+    logger.set_level(Synopsis::LogType::WARN);
+
+    Synopsis::SqliteASDPDB dd_db(get_absolute_data_path("dd_example.db"));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, dd_db.init(0, NULL, &logger));
+    expect_same_plans(
+        "dd_example.db", dd_db, configs, dd_rules_path, dd_config_path
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, dd_db.deinit());
+
+    Synopsis::SqliteASDPDB pair_db(get_absolute_data_path("instrument_pair.db"));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, pair_db.init(0, NULL, &logger));
+    expect_same_plans(
+        "instrument_pair.db", pair_db, configs, pair_rules_path, ""
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, pair_db.deinit());
+
+    // Synthetic workloads, with and without many exact ties
+    for (bool quantize : {false, true}) {
+        Synopsis::SqliteASDPDB db(":memory:");
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+        populate_random_asdps(db, 120, 4321, quantize);
+        std::string workload = quantize ?
+            "synthetic (quantized)" : "synthetic";
+        expect_same_plans(workload, db, configs, dd_rules_path, dd_config_path);
+        expect_same_plans(
+            workload + ", no rules", db, configs, "", dd_config_path
+        );
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    }
+}
+
+
+// Test that transmitted ASDPs discount similar ASDPs when enabled, with all
+// engines agreeing
+TEST(SynopsisTest, TestTransmittedContext) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string source_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::vector<Synopsis::MmrEngine> engines = {
+        Synopsis::EXHAUSTIVE_GREEDY,
+        Synopsis::INCREMENTAL_GREEDY,
+        Synopsis::LAZY_GREEDY
+    };
+
+    std::ifstream source(source_path);
+    std::string config((std::istreambuf_iterator<char>(source)),
+        std::istreambuf_iterator<char>());
+    std::string context_path = "/tmp/synopsis_test_transmitted_context.json";
+    std::ofstream(context_path) << (
+        "{\"transmitted_context\": true," + config.substr(config.find('{') + 1)
+    );
+
+    Synopsis::StdLogger logger;
+    Synopsis::SqliteASDPDB db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 40, 2468);
+    for (int asdp_id = 1; asdp_id <= 40; asdp_id += 5) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_downlink_state(
+            asdp_id, Synopsis::DownlinkState::TRANSMITTED
+        ));
+    }
+
+    // A high-utility ASDP with the same descriptor as a transmitted one
+    Synopsis::AsdpEntry metadata;
+    metadata["background_avg"] = Synopsis::DpMetadataValue(10.0);
+    metadata["unique_masses"] = Synopsis::DpMetadataValue(10.0);
+    Synopsis::DpDbMsg duplicate(
+        -1, "OWLS", "ACME", "", 1, 5.0, 0,
+        Synopsis::DownlinkState::UNTRANSMITTED, metadata
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(duplicate));
+    Synopsis::DpDbMsg original(
+        -1, "OWLS", "ACME", "", 1, 5.0, 0,
+        Synopsis::DownlinkState::TRANSMITTED, metadata
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(original));
+
+    std::vector<int> without_context = prioritize_with_engine(
+        db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, source_path
+    );
+    std::vector<int> with_context = prioritize_with_engine(
+        db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, context_path
+    );
+    ASSERT_GT(without_context.size(), 0);
+    EXPECT_EQ(duplicate.get_dp_id(), without_context[0]);
+    EXPECT_NE(with_context, without_context);
+    auto position = [&](const std::vector<int> &order) {
+        return std::find(
+            order.begin(), order.end(), duplicate.get_dp_id()
+        ) - order.begin();
+    };
+    EXPECT_GT(position(with_context), position(without_context));
+
+    for (auto engine : engines) {
+        for (int n_threads : {1, 4}) {
+            EXPECT_EQ(without_context, prioritize_with_engine(
+                db, engine, rules_path, source_path, 0, n_threads
+            ));
+            EXPECT_EQ(with_context, prioritize_with_engine(
+                db, engine, rules_path, context_path, 0, n_threads
+            ));
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+
+    // Similarities to transmitted ASDPs are not stored in ASDP fields, so a
+    // field of any name is compared as loaded
+    std::string field_path = "/tmp/synopsis_test_transmitted_field.json";
+    std::string field_config = config.substr(config.find('{') + 1);
+    std::string descriptor = "\"unique_masses\"";
+    size_t pos;
+    while ((pos = field_config.find(descriptor)) != std::string::npos) {
+        field_config.replace(pos, descriptor.size(), "\"transmitted_max_similarity\"");
+    }
+    std::ofstream(field_path) << "{\"transmitted_context\": true," + field_config;
+
+    Synopsis::SqliteASDPDB field_db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, field_db.init(0, NULL, &logger));
+    std::mt19937 rng(1357);
+    std::uniform_real_distribution<double> uniform(0.0, 3.0);
+    for (int i = 0; i < 30; i++) {
+        Synopsis::AsdpEntry field_metadata;
+        field_metadata["background_avg"] = Synopsis::DpMetadataValue(uniform(rng));
+        field_metadata["transmitted_max_similarity"] = Synopsis::DpMetadataValue(uniform(rng));
+        Synopsis::DpDbMsg field_msg(
+            -1, "OWLS", "ACME", "", 1 + i, uniform(rng), 0,
+            (i % 4 == 0) ? Synopsis::DownlinkState::TRANSMITTED :
+                Synopsis::DownlinkState::UNTRANSMITTED,
+            field_metadata
+        );
+        EXPECT_EQ(Synopsis::Status::SUCCESS, field_db.insert_data_product(field_msg));
+    }
+    std::vector<int> field_expected = prioritize_with_engine(
+        field_db, Synopsis::LAZY_GREEDY, "", field_path
+    );
+    EXPECT_GT(field_expected.size(), 0);
+    for (auto engine : engines) {
+        EXPECT_EQ(field_expected, prioritize_with_engine(
+            field_db, engine, "", field_path
+        ));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS, field_db.deinit());
+}
+
+
+// Test that incremental replanning matches full replanning after changes,
+// and only replans the affected bins
+TEST(SynopsisTest, TestIncrementalReplanning) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+
+    Synopsis::SqliteASDPDB sqlite_db(":memory:");
+    EXPECT_EQ(Synopsis::Status::SUCCESS, sqlite_db.init(0, NULL, &logger));
+    Synopsis::MemoryASDPDB memory_db(60, 120, 4, 512);
+    std::vector<double> db_memory(memory_db.memory_requirement() / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, memory_db.init(
+        memory_db.memory_requirement(), db_memory.data(), &logger
+    ));
+
+    for (Synopsis::ASDPDB *db : std::vector<Synopsis::ASDPDB*>({&sqlite_db, &memory_db})) {
+        populate_random_asdps(*db, 40, 8642);
+
+        // Bins are also listed individually
+        std::vector<Synopsis::DpDbMsg> all_msgs, bin_msgs;
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db->list_undownlinked_data_products(all_msgs));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db->list_undownlinked_data_products_in_bin(7, bin_msgs));
+        EXPECT_GT(bin_msgs.size(), 0);
+        EXPECT_LT(bin_msgs.size(), all_msgs.size());
+        for (auto &msg : bin_msgs) {
+            EXPECT_EQ(7, msg.get_priority_bin());
+        }
+
+        for (auto engine : {Synopsis::EXHAUSTIVE_GREEDY, Synopsis::INCREMENTAL_GREEDY, Synopsis::LAZY_GREEDY}) {
+            Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+            planner.set_database(db);
+            planner.set_clock(&clock);
+            planner.set_incremental(true);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+            auto check = [&](int n_bins) {
+                std::vector<int> prioritized_list;
+                EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                    rules_path, config_path, 100, prioritized_list
+                ));
+                EXPECT_EQ(prioritize_with_engine(*db, engine, rules_path, config_path),
+                    prioritized_list);
+                EXPECT_EQ(n_bins, planner.num_replanned_bins());
+            };
+            check(2);
+            check(0);
+
+            // Each change replans only the bins that held or hold the ASDP
+            std::vector<int> ids = db->list_data_product_ids();
+            Synopsis::DpDbMsg msg;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->get_data_product(ids[3], msg));
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_science_utility(
+                ids[3], msg.get_science_utility_estimate() + 0.5
+            ));
+            check(1);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_priority_bin(
+                ids[3], (msg.get_priority_bin() == 0) ? 7 : 0
+            ));
+            check(2);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_downlink_state(
+                ids[5], Synopsis::DownlinkState::TRANSMITTED
+            ));
+            check(1);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_downlink_state(
+                ids[5], Synopsis::DownlinkState::UNTRANSMITTED
+            ));
+            check(1);
+            Synopsis::DpDbMsg new_msg(
+                -1, "OWLS", "ACME", "", 2, 0.9, 3,
+                Synopsis::DownlinkState::UNTRANSMITTED, Synopsis::AsdpEntry()
+            );
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->insert_data_product(new_msg));
+            check(1);
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_downlink_state(
+                new_msg.get_dp_id(), Synopsis::DownlinkState::DOWNLINKED
+            ));
+            check(0);
+
+            // A different configuration replans all bins
+            std::vector<int> prioritized_list;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                "", config_path, 100, prioritized_list
+            ));
+            EXPECT_EQ(2, planner.num_replanned_bins());
+            check(2);
+
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_downlink_state(
+                ids[5], Synopsis::DownlinkState::TRANSMITTED
+            ));
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+            EXPECT_EQ(Synopsis::Status::SUCCESS, db->update_downlink_state(
+                ids[5], Synopsis::DownlinkState::UNTRANSMITTED
+            ));
+        }
+    }
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, memory_db.deinit());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, sqlite_db.deinit());
+}
+
+
+// Test that incremental replanning with transmitted context replans the bins of
+// changed transmitted ASDPs, which discount the untransmitted ASDPs of their bin
+TEST(SynopsisTest, TestIncrementalReplanningTransmittedContext) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string source_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::ifstream source(source_path);
+    std::string config((std::istreambuf_iterator<char>(source)),
+        std::istreambuf_iterator<char>());
+    std::string context_path = "/tmp/synopsis_test_incremental_context.json";
+    std::ofstream(context_path) << (
+        "{\"transmitted_context\": true," + config.substr(config.find('{') + 1)
+    );
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+
+    for (auto engine : {Synopsis::EXHAUSTIVE_GREEDY, Synopsis::INCREMENTAL_GREEDY, Synopsis::LAZY_GREEDY}) {
+        Synopsis::SqliteASDPDB db(":memory:");
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+        populate_random_asdps(db, 40, 8642);
+
+        Synopsis::AsdpEntry metadata;
+        metadata["background_avg"] = Synopsis::DpMetadataValue(10.0);
+        metadata["unique_masses"] = Synopsis::DpMetadataValue(10.0);
+        Synopsis::DpDbMsg original(
+            -1, "OWLS", "ACME", "", 1, 5.0, 0,
+            Synopsis::DownlinkState::UNTRANSMITTED, metadata
+        );
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(original));
+
+        Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(engine);
+        planner.set_database(&db);
+        planner.set_clock(&clock);
+        planner.set_incremental(true);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+
+        auto check = [&](int n_bins) {
+            std::vector<int> prioritized_list;
+            EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+                rules_path, context_path, 100, prioritized_list
+            ));
+            EXPECT_EQ(prioritize_with_engine(db, engine, rules_path, context_path),
+                prioritized_list);
+            EXPECT_EQ(n_bins, planner.num_replanned_bins());
+            return prioritized_list;
+        };
+        std::vector<int> before = check(2);
+        check(0);
+
+        // A transmitted twin discounts the original in its bin
+        Synopsis::DpDbMsg twin(
+            -1, "OWLS", "ACME", "", 1, 5.0, 0,
+            Synopsis::DownlinkState::TRANSMITTED, metadata
+        );
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(twin));
+        EXPECT_NE(before, check(1));
+
+        // Moving, rescoring, and downlinking the twin replan its bins
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_priority_bin(
+            twin.get_dp_id(), 7
+        ));
+        EXPECT_EQ(before, check(2));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_priority_bin(
+            twin.get_dp_id(), 0
+        ));
+        check(2);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_science_utility(
+            twin.get_dp_id(), 1.0
+        ));
+        check(1);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_downlink_state(
+            twin.get_dp_id(), Synopsis::DownlinkState::DOWNLINKED
+        ));
+        EXPECT_EQ(before, check(1));
+
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+    }
+}
+
+
+// Test that the planning service handles a session of line requests against a
+// warm application, and reports malformed requests without stopping
+TEST(SynopsisTest, TestPlanningService) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    FailingLookupASDPDB db(":memory:");
+    Synopsis::StdLogger logger;
+    Synopsis::LinuxClock clock;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner;
+    planner.set_keep_entries(true);
+    Synopsis::Application app(&db, &planner, &logger, &clock);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+    populate_random_asdps(db, 20, 2468);
+
+    std::vector<int> expected;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.prioritize(
+        rules_path, config_path, 100, expected
+    ));
+
+    Synopsis::PlanningService service(&app, &logger);
+    std::string response;
+    nlohmann::json j_prioritize = {
+        {"command", "prioritize"},
+        {"rule_config", rules_path},
+        {"similarity_config", config_path},
+        {"ids_only", true}
+    };
+    EXPECT_EQ(Synopsis::Status::SUCCESS, service.handle(j_prioritize.dump(), response));
+    nlohmann::json j_response = nlohmann::json::parse(response);
+    EXPECT_EQ(expected, j_response["prioritized_list"].get<std::vector<int>>());
+
+    // Ingest a product, update it, and read it back
+    nlohmann::json j_ingest = {
+        {"command", "ingest"},
+        {"instrument_name", "CAM"},
+        {"type", "image"},
+        {"uri", "file:///data/image.png"},
+        {"size", 1024},
+        {"science_utility_estimate", 0.5},
+        {"priority_bin", 3},
+        {"metadata", {{"count", 4}, {"mean", 0.25}, {"label", "dust"}}}
+    };
+    EXPECT_EQ(Synopsis::Status::SUCCESS, service.handle(j_ingest.dump(), response));
+    int asdp_id = nlohmann::json::parse(response)["asdp_id"];
+    EXPECT_GE(asdp_id, 0);
+
+    std::ostringstream output;
+    std::istringstream input(
+        "{\"command\": \"update_priority_bin\", \"asdp_id\": " + std::to_string(asdp_id) + ", \"value\": 5}\n"
+        "\n"
+        "not json\n"
+        "{\"command\": \"update_metadata\", \"asdp_id\": " + std::to_string(asdp_id) + ", \"field\": \"count\", \"value\": 7}\n"
+        "{\"command\": \"update_science_utility\", \"asdp_id\": 1, \"value\": \"high\"}\n"
+        "{\"command\": \"get\", \"asdp_id\": " + std::to_string(asdp_id) + "}\n"
+        "{\"command\": \"quit\"}\n"
+        "{\"command\": \"get\", \"asdp_id\": 1}\n"
+    );
+    EXPECT_EQ(6, service.serve(input, output));
+    EXPECT_TRUE(service.is_stopped());
+
+    std::vector<nlohmann::json> responses;
+    std::istringstream lines(output.str());
+    std::string line;
+    while (std::getline(lines, line)) {
+        responses.push_back(nlohmann::json::parse(line));
+    }
+    ASSERT_EQ(6, responses.size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, responses[0]["status"]);
+    EXPECT_EQ(Synopsis::Status::FAILURE, responses[1]["status"]);
+    EXPECT_TRUE(responses[1].contains("error"));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, responses[2]["status"]);
+    EXPECT_EQ(Synopsis::Status::FAILURE, responses[3]["status"]);
+    EXPECT_TRUE(responses[3].contains("error"));
+    nlohmann::json dp = responses[4]["data_product"];
+    EXPECT_EQ(5, dp["priority_bin"]);
+    EXPECT_EQ(7, dp["metadata"]["count"]);
+    EXPECT_EQ(0.25, dp["metadata"]["mean"]);
+    EXPECT_EQ("dust", dp["metadata"]["label"]);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, responses[5]["status"]);
+
+    // A missing configuration or invalid downlink state fails only the request
+    j_prioritize["rule_config"] = get_absolute_data_path("missing_rules.json");
+    EXPECT_EQ(Synopsis::Status::FAILURE, service.handle(j_prioritize.dump(), response));
+    EXPECT_TRUE(nlohmann::json::parse(response).contains("error"));
+    j_ingest["downlink_state"] = 7;
+    EXPECT_EQ(Synopsis::Status::FAILURE, service.handle(j_ingest.dump(), response));
+    nlohmann::json j_update = {
+        {"command", "update_downlink_state"}, {"asdp_id", asdp_id}, {"value", -1}
+    };
+    EXPECT_EQ(Synopsis::Status::FAILURE, service.handle(j_update.dump(), response));
+    Synopsis::DpDbMsg msg;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.get_data_product(asdp_id, msg));
+    EXPECT_EQ(Synopsis::DownlinkState::UNTRANSMITTED, msg.get_downlink_state());
+
+    // Prioritized data products are formatted from the plan, without ASDP DB
+    // lookups, and a failed lookup fails only its request
+    db.fail_lookups = true;
+    j_prioritize["rule_config"] = rules_path;
+    j_prioritize["ids_only"] = false;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, service.handle(j_prioritize.dump(), response));
+    j_response = nlohmann::json::parse(response);
+    ASSERT_EQ(expected.size() + 1, j_response["prioritized_list"].size());
+    for (auto &j_dp : j_response["prioritized_list"]) {
+        EXPECT_NE("", j_dp["instrument_name"]);
+    }
+    nlohmann::json j_get = {{"command", "get"}, {"asdp_id", asdp_id}};
+    EXPECT_EQ(Synopsis::Status::FAILURE, service.handle(j_get.dump(), response));
+    EXPECT_NE(std::string::npos, nlohmann::json::parse(response)["error"].get<std::string>().find("database is locked"));
+    db.fail_lookups = false;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, service.handle(j_get.dump(), response));
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+}
+
+
+// Test that the C interface prioritizes as the application does, and holds
+// the identifiers, SUEs, and sizes of the prioritized ASDPs
+TEST(SynopsisTest, TestCInterface) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::string db_path = "/tmp/synopsis_test_c_interface.db";
+    std::remove(db_path.c_str());
+
+    Synopsis::SqliteASDPDB db(db_path);
+    Synopsis::StdLogger logger;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(0, NULL, &logger));
+    populate_random_asdps(db, 25, 97531);
+    std::vector<int> expected;
+    std::vector<double> expected_sues;
+    {
+        Synopsis::LinuxClock clock;
+        Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(Synopsis::LAZY_GREEDY);
+        planner.set_database(&db);
+        planner.set_clock(&clock);
+        planner.set_stats_enabled(true);
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize(
+            rules_path, config_path, 100, expected
+        ));
+        for (const auto &bin_stats : planner.get_stats().bins) {
+            expected_sues.insert(expected_sues.end(),
+                bin_stats.final_sues.begin(), bin_stats.final_sues.end()
+            );
+        }
+        EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    }
+    ASSERT_EQ(expected.size(), expected_sues.size());
+    std::vector<Synopsis::DpDbMsg> expected_msgs(expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(
+            expected[i], expected_msgs[i]
+        ));
+    }
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.deinit());
+
+    EXPECT_EQ(nullptr, synopsis_session_open(NULL, 0, 1, Synopsis::LogType::WARN));
+    synopsis_session_t *session = synopsis_session_open(
+        db_path.c_str(), Synopsis::LAZY_GREEDY, 2, Synopsis::LogType::WARN
+    );
+    ASSERT_NE(nullptr, session);
+
+    EXPECT_EQ(Synopsis::Status::SUCCESS, synopsis_session_prioritize(
+        session, rules_path.c_str(), config_path.c_str(), 100, -1, -1
+    ));
+    int count = synopsis_session_result_count(session);
+    const int *ids = synopsis_session_result_ids(session);
+    EXPECT_EQ(expected, std::vector<int>(ids, ids + count));
+    EXPECT_EQ(-1, synopsis_session_result_cut_asdp_id(session));
+    const double *sues = synopsis_session_result_sues(session);
+    const long *sizes = synopsis_session_result_sizes(session);
+    bool discounted = false;
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(expected_sues[i], sues[i]);
+        EXPECT_LE(sues[i], expected_msgs[i].get_science_utility_estimate());
+        discounted |= (sues[i] < expected_msgs[i].get_science_utility_estimate());
+        EXPECT_EQ((long)expected_msgs[i].get_dp_size(), sizes[i]);
+    }
+    EXPECT_TRUE(discounted);
+
+    // A count budget truncates the results and reports the cut point
+    EXPECT_EQ(Synopsis::Status::SUCCESS, synopsis_session_prioritize(
+        session, rules_path.c_str(), config_path.c_str(), 100, -1, 3
+    ));
+    EXPECT_EQ(3, synopsis_session_result_count(session));
+    EXPECT_EQ(expected[3], synopsis_session_result_cut_asdp_id(session));
+    sues = synopsis_session_result_sues(session);
+    sizes = synopsis_session_result_sizes(session);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(expected_sues[i], sues[i]);
+        EXPECT_EQ((long)expected_msgs[i].get_dp_size(), sizes[i]);
+    }
+
+    // Updates are seen by the next prioritization
+    EXPECT_EQ(Synopsis::Status::SUCCESS, synopsis_session_update_downlink_state(
+        session, expected[0], Synopsis::DownlinkState::DOWNLINKED
+    ));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, synopsis_session_prioritize(
+        session, rules_path.c_str(), config_path.c_str(), 100, -1, -1
+    ));
+    ids = synopsis_session_result_ids(session);
+    count = synopsis_session_result_count(session);
+    EXPECT_GT(count, 0);
+    EXPECT_EQ(std::find(ids, ids + count, expected[0]), ids + count);
+
+    // A missing configuration fails without raising an exception
+    std::string missing_path = get_absolute_data_path("missing_rules.json");
+    EXPECT_EQ(Synopsis::Status::FAILURE, synopsis_session_prioritize(
+        session, missing_path.c_str(), config_path.c_str(), 100, -1, -1
+    ));
+    EXPECT_EQ(0, synopsis_session_result_count(session));
+
+    synopsis_session_close(session);
+    synopsis_session_close(NULL);
+    std::remove(db_path.c_str());
+}
+
+
+// Test that bundles round-trip products and are ingested and prioritized
+// as the products they hold
+TEST(SynopsisTest, TestDpBundle) {
+    std::string rules_path = get_absolute_data_path("dd_example_rules.json");
+    std::string config_path = get_absolute_data_path("dd_example_similarity_config.json");
+    std::string bundle_path = testing::TempDir() + "synopsis_bundle.bin";
+    std::remove(bundle_path.c_str());
+    Synopsis::StdLogger logger;
+
+    Synopsis::MemoryASDPDB db(40, 80, 4, 512);
+    std::vector<double> memory(db.memory_requirement() / sizeof(double) + 1);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.init(db.memory_requirement(), memory.data(), &logger));
+    populate_random_asdps(db, 29, 8642);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.update_downlink_state(4, Synopsis::DownlinkState::DOWNLINKED));
+    Synopsis::AsdpEntry metadata;
+    metadata["site"] = Synopsis::DpMetadataValue(std::string("north"));
+    Synopsis::DpDbMsg msg(
+        -1, "cam", "img", "a.dat", 10, 0.5, 0,
+        Synopsis::DownlinkState::TRANSMITTED, metadata
+    );
+    EXPECT_EQ(Synopsis::Status::SUCCESS, db.insert_data_product(msg));
+
+    Synopsis::DpBundleWriter writer;
+    std::vector<Synopsis::DpDbMsg> expected(30);
+    for (int i = 0; i < 30; i++) {
+        EXPECT_EQ(Synopsis::Status::SUCCESS, db.get_data_product(i + 1, expected[i]));
+        writer.add_data_product(expected[i]);
+    }
+    EXPECT_EQ(30, writer.size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, writer.write(bundle_path, &logger));
+
+    Synopsis::DpBundle bundle(&logger);
+    EXPECT_EQ(0, bundle.size());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, bundle.open(bundle_path));
+    ASSERT_EQ(30, bundle.size());
+    std::vector<Synopsis::DpDbMsg> msgs;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, bundle.get_data_products(msgs));
+    ASSERT_EQ(expected.size(), msgs.size());
+    for (size_t i = 0; i < msgs.size(); i++) {
+        EXPECT_EQ(expected[i].get_dp_id(), msgs[i].get_dp_id());
+        EXPECT_EQ(expected[i].get_instrument_name(), msgs[i].get_instrument_name());
+        EXPECT_EQ(expected[i].get_type(), msgs[i].get_type());
+        EXPECT_EQ(expected[i].get_uri(), msgs[i].get_uri());
+        EXPECT_EQ(expected[i].get_dp_size(), msgs[i].get_dp_size());
+        EXPECT_EQ(expected[i].get_science_utility_estimate(), msgs[i].get_science_utility_estimate());
+        EXPECT_EQ(expected[i].get_priority_bin(), msgs[i].get_priority_bin());
+        EXPECT_EQ(expected[i].get_downlink_state(), msgs[i].get_downlink_state());
+        ASSERT_EQ(expected[i].get_metadata().size(), msgs[i].get_metadata().size());
+        for (const auto &elem : expected[i].get_metadata()) {
+            const Synopsis::DpMetadataValue &value = msgs[i].get_metadata().at(elem.first);
+            EXPECT_EQ(elem.second.get_type(), value.get_type());
+            EXPECT_EQ(elem.second.get_int_value(), value.get_int_value());
+            EXPECT_EQ(elem.second.get_float_value(), value.get_float_value());
+            EXPECT_EQ(elem.second.get_string_value(), value.get_string_value());
+        }
+    }
+    EXPECT_EQ(Synopsis::Status::FAILURE, bundle.get_data_product(30, msg));
+
+    // Bundles are prioritized as the DB holding their products
+    std::vector<int> prioritized_list;
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner planner(Synopsis::LAZY_GREEDY);
+    Synopsis::LinuxClock clock;
+    planner.set_clock(&clock);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.init(0, NULL, &logger));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.prioritize_bundle(
+        bundle, rules_path, config_path, 100, prioritized_list
+    ));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, planner.deinit());
+    EXPECT_EQ(
+        prioritize_with_engine(db, Synopsis::EXHAUSTIVE_GREEDY, rules_path, config_path),
+        prioritized_list
+    );
+
+    // Ingested products are assigned new identifiers
+    Synopsis::SqliteASDPDB ingest_db(":memory:");
+    Synopsis::MaxMarginalRelevanceDownlinkPlanner ingest_planner;
+    Synopsis::Application app(&ingest_db, &ingest_planner, &logger, &clock);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.init(0, NULL));
+    std::vector<int> asdp_ids;
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.ingest_bundle(bundle, &asdp_ids));
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.ingest_bundle(bundle, &asdp_ids));
+    ASSERT_EQ(30, (int)asdp_ids.size());
+    EXPECT_EQ(31, asdp_ids[0]);
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.get_data_product(asdp_ids[29], msg));
+    EXPECT_EQ("north", msg.get_metadata().at("site").get_string_value());
+    EXPECT_EQ(Synopsis::DownlinkState::TRANSMITTED, msg.get_downlink_state());
+    EXPECT_EQ(Synopsis::Status::SUCCESS, app.deinit());
+
+    // Unsupported and corrupt bundles are rejected
+    Synopsis::DpBundle closed;
+    EXPECT_EQ(Synopsis::Status::FAILURE, closed.get_data_products(msgs));
+    EXPECT_EQ(Synopsis::Status::FAILURE, bundle.open(bundle_path + ".missing"));
+    EXPECT_EQ(0, bundle.size());
+    {
+        std::fstream image(bundle_path, std::ios::binary | std::ios::in | std::ios::out);
+        image.seekp(8);
+        image.put(99);
+    }
+    EXPECT_EQ(Synopsis::Status::FAILURE, bundle.open(bundle_path));
+    {
+        std::ofstream image(bundle_path, std::ios::binary | std::ios::app);
+        image.put('x');
+    }
+    EXPECT_EQ(Synopsis::Status::FAILURE, bundle.open(bundle_path));
+    std::remove(bundle_path.c_str());
+}
+
+
+// Test that thread pool batches (including nested batches) run to completion
+TEST(SynopsisTest, TestThreadPool) {
+    for (int n_workers : {0, 1, 3}) {
+        Synopsis::ThreadPool pool(n_workers);
+        EXPECT_EQ(n_workers, pool.num_workers());
+
+        std::vector<int> counts(8, 0);
+        std::vector<Synopsis::PoolTask> tasks;
+        for (int i = 0; i < 8; i++) {
+            tasks.push_back([&pool, &counts, i]() {
+                std::vector<Synopsis::PoolTask> subtasks;
+                std::vector<int> sub_counts(4, 0);
+                for (int j = 0; j < 4; j++) {
+                    subtasks.push_back([&sub_counts, j]() { sub_counts[j] = j; });
+                }
+                pool.run(subtasks);
+                for (int j = 0; j < 4; j++) { counts[i] += sub_counts[j]; }
+            });
+        }
+        pool.run(tasks);
+        for (int i = 0; i < 8; i++) {
+            EXPECT_EQ(6, counts[i]);
+        }
+
+        std::vector<Synopsis::PoolTask> empty;
+        pool.run(empty);
+    }
+}